@@ -37,6 +37,7 @@ import unittest
 from functools import partial
 
 import numpy as np
+import requests
 import test_util as tu
 import tritonclient.grpc as grpcclient
 import tritonclient.http as httpclient
@@ -590,6 +591,136 @@ class DecoupledTest(tu.TestResultCollector):
             "expected IN and DELAY shape to match, got [1] and [2]", str(cm.exception)
         )
 
+    def test_cancel_during_write_delay(self):
+        # The server holds back the write of a lone response of an
+        # incomplete request by the write coalescing delay, which is
+        # longer than the test. The stream is cancelled and the request
+        # completes while the write is held back, the server must keep
+        # serving streams.
+        self.inputs_[0].set_shape([2])
+        self.inputs_[0].set_data_from_numpy(np.array([100, 101], dtype=np.int32))
+        self.inputs_[1].set_shape([2])
+        self.inputs_[1].set_data_from_numpy(np.array([0, 3000], dtype=np.uint32))
+        self.inputs_[2].set_data_from_numpy(np.array([0], dtype=np.uint32))
+
+        user_data = UserData()
+        with grpcclient.InferenceServerClient(
+            url="localhost:8001", verbose=True
+        ) as triton_client:
+            triton_client.start_stream(callback=partial(callback, user_data))
+            triton_client.async_stream_infer(
+                model_name=self.model_name_,
+                inputs=self.inputs_,
+                request_id="0",
+                outputs=self.requested_outputs_,
+            )
+            time.sleep(1)
+            triton_client.stop_stream(cancel_requests=True)
+
+            # Wait for the request to complete while its write is held.
+            time.sleep(4)
+            self.assertTrue(triton_client.is_server_live())
+
+            # A new stream gets the responses of a complete request.
+            user_data = UserData()
+            self.inputs_[0].set_shape([1])
+            self.inputs_[0].set_data_from_numpy(np.array([100], dtype=np.int32))
+            self.inputs_[1].set_shape([1])
+            self.inputs_[1].set_data_from_numpy(np.array([0], dtype=np.uint32))
+            triton_client.start_stream(callback=partial(callback, user_data))
+            triton_client.async_stream_infer(
+                model_name=self.model_name_,
+                inputs=self.inputs_,
+                request_id="1",
+                outputs=self.requested_outputs_,
+                enable_empty_final_response=True,
+            )
+            data_item = user_data._response_queue.get(timeout=30)
+            if type(data_item) == InferenceServerException:
+                raise data_item
+            self.assertEqual(data_item.as_numpy("OUT")[0], 100)
+            triton_client.stop_stream()
+
+    def _get_metric_value(self, metric):
+        r = requests.get("http://localhost:8002/metrics")
+        r.raise_for_status()
+        for line in r.text.splitlines():
+            if line.startswith(metric + " "):
+                return float(line.split()[1])
+        return None
+
+    def test_response_buffer_budget(self):
+        # The server delays the write of each response and the stream
+        # may buffer 2 responses. The responses of the first request
+        # exceed the budget by the time the second request is read, so
+        # the stream stops reading requests until enough responses are
+        # written. Every request must still be read and answered.
+        self.assertTrue("TRITONSERVER_DELAY_GRPC_RESPONSE" in os.environ)
+
+        request_count = 3
+        repeat_count = 5
+        self.inputs_[0].set_shape([repeat_count])
+        self.inputs_[1].set_shape([repeat_count])
+        self.inputs_[1].set_data_from_numpy(np.zeros([repeat_count], dtype=np.uint32))
+        self.inputs_[2].set_data_from_numpy(np.array([0], dtype=np.uint32))
+
+        user_data = UserData()
+        result_dict = {}
+        with grpcclient.InferenceServerClient(
+            url="localhost:8001", verbose=True
+        ) as triton_client:
+            triton_client.start_stream(callback=partial(callback, user_data))
+            for i in range(request_count):
+                self.inputs_[0].set_data_from_numpy(
+                    np.arange(100 * i, 100 * i + repeat_count, dtype=np.int32)
+                )
+                triton_client.async_stream_infer(
+                    model_name=self.model_name_,
+                    inputs=self.inputs_,
+                    request_id=str(i),
+                    outputs=self.requested_outputs_,
+                )
+                # Let the responses of the request be buffered before
+                # sending the next one.
+                time.sleep(0.5)
+
+            for _ in range(request_count * repeat_count):
+                data_item = user_data._response_queue.get(timeout=60)
+                if type(data_item) == InferenceServerException:
+                    raise data_item
+                this_id = data_item.get_response().id
+                result_dict.setdefault(this_id, []).append(data_item)
+            triton_client.stop_stream()
+
+        for i in range(request_count):
+            result_list = result_dict[str(i)]
+            self.assertEqual(len(result_list), repeat_count)
+            for j in range(repeat_count):
+                self.assertEqual(result_list[j].as_numpy("OUT")[0], 100 * i + j)
+                self.assertEqual(result_list[j].as_numpy("IDX")[0], j)
+
+        self.assertGreater(
+            self._get_metric_value("nv_grpc_stream_buffer_budget_exceeded"), 0
+        )
+        # Nothing is left buffered once the stream is done.
+        self.assertEqual(self._get_metric_value("nv_grpc_stream_buffered_responses"), 0)
+        self.assertEqual(
+            self._get_metric_value("nv_grpc_stream_buffered_response_bytes"), 0
+        )
+
+    def test_unbounded_stream_metrics(self):
+        # Without a response buffer budget the streams skip the
+        # accounting, so the buffering metrics are not reported.
+        self._decoupled_infer(
+            request_count=2, repeat_count=3, delay_time=0, wait_time=0
+        )
+        for metric in [
+            "nv_grpc_stream_buffer_budget_exceeded",
+            "nv_grpc_stream_buffered_responses",
+            "nv_grpc_stream_buffered_response_bytes",
+        ]:
+            self.assertIsNone(self._get_metric_value(metric))
+
 
 if __name__ == "__main__":
     unittest.main()
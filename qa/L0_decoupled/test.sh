@@ -81,6 +81,7 @@ for trial in $TRIALS; do
               test_one_to_many \
               test_no_streaming \
               test_response_order \
+              test_unbounded_stream_metrics \
 	      test_wrong_shape; do
 
       echo "Test: $i" >>$CLIENT_LOG
@@ -129,6 +130,86 @@ for trial in $TRIALS; do
   wait $SERVER_PID
 done
 
+# Cancel a stream while the server holds back the write of a response
+# to coalesce it with later ones.
+SERVER_ARGS="--model-repository=`pwd`/models --grpc-stream-write-coalescing=true \
+             --grpc-stream-write-coalescing-delay-us=10000000"
+SERVER_LOG="./inference_server_write_coalescing.log"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+echo "Test: test_cancel_during_write_delay" >>$CLIENT_LOG
+set +e
+python $DECOUPLED_TEST DecoupledTest.test_cancel_during_write_delay >>$CLIENT_LOG 2>&1
+if [ $? -ne 0 ]; then
+    echo -e "\n***\n*** Test test_cancel_during_write_delay Failed\n***" >>$CLIENT_LOG
+    echo -e "\n***\n*** Test test_cancel_during_write_delay Failed\n***"
+    RET=1
+else
+    check_test_results $TEST_RESULT_FILE 1
+    if [ $? -ne 0 ]; then
+        cat $CLIENT_LOG
+        echo -e "\n***\n*** Test Result Verification Failed\n***"
+        RET=1
+    fi
+fi
+set -e
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+# Bound the responses a stream may buffer while each write is delayed
+# like for a slow reader, the stream must stop reading requests and
+# resume once enough responses are written.
+export TRITONSERVER_DELAY_GRPC_RESPONSE=500
+
+SERVER_ARGS="--model-repository=`pwd`/models --log-verbose=1 \
+             --grpc-stream-response-buffer-count=2"
+SERVER_LOG="./inference_server_buffer_budget.log"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+echo "Test: test_response_buffer_budget" >>$CLIENT_LOG
+set +e
+python $DECOUPLED_TEST DecoupledTest.test_response_buffer_budget >>$CLIENT_LOG 2>&1
+if [ $? -ne 0 ]; then
+    echo -e "\n***\n*** Test test_response_buffer_budget Failed\n***" >>$CLIENT_LOG
+    echo -e "\n***\n*** Test test_response_buffer_budget Failed\n***"
+    RET=1
+else
+    check_test_results $TEST_RESULT_FILE 1
+    if [ $? -ne 0 ]; then
+        cat $CLIENT_LOG
+        echo -e "\n***\n*** Test Result Verification Failed\n***"
+        RET=1
+    fi
+fi
+
+if [ `grep -c "response buffer budget exceeded" $SERVER_LOG` == "0" ]; then
+    cat $SERVER_LOG
+    echo -e "\n***\n*** Failed. Expected reads to be paused\n***"
+    RET=1
+fi
+if [ `grep -c "Resuming reads" $SERVER_LOG` == "0" ]; then
+    cat $SERVER_LOG
+    echo -e "\n***\n*** Failed. Expected reads to be resumed\n***"
+    RET=1
+fi
+set -e
+
+unset TRITONSERVER_DELAY_GRPC_RESPONSE
+
+kill $SERVER_PID
+wait $SERVER_PID
+
 if [ $RET -eq 0 ]; then
   echo -e "\n***\n*** Test Passed\n***"
 else
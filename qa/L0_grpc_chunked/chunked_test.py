@@ -0,0 +1,249 @@
+#!/usr/bin/env python3
+
+# Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+
+import sys
+
+sys.path.append("../common")
+
+import unittest
+
+import grpc
+import numpy as np
+import test_util as tu
+from google.protobuf import descriptor_pb2, descriptor_pool, message_factory
+from tritonclient.grpc import service_pb2
+
+# The maximum input byte size the server is started with.
+MAX_INPUT_BYTE_SIZE = 8192
+
+
+def chunked_service_messages():
+    # The chunked service of src/grpc/grpc_chunked_service.proto isn't
+    # part of the client library, its messages are described on top of
+    # the messages of the inference service.
+    field = descriptor_pb2.FieldDescriptorProto
+    file_proto = descriptor_pb2.FileDescriptorProto(
+        name="grpc_chunked_service.proto",
+        package="inference",
+        syntax="proto3",
+        dependency=[service_pb2.DESCRIPTOR.name],
+    )
+    chunk = file_proto.message_type.add(name="InferTensorChunk")
+    chunk.field.add(
+        name="index", number=1, label=field.LABEL_OPTIONAL, type=field.TYPE_UINT32
+    )
+    chunk.field.add(
+        name="offset", number=2, label=field.LABEL_OPTIONAL, type=field.TYPE_UINT64
+    )
+    chunk.field.add(
+        name="data", number=3, label=field.LABEL_OPTIONAL, type=field.TYPE_BYTES
+    )
+    request = file_proto.message_type.add(name="ModelInferChunkedRequest")
+    request.field.add(
+        name="request",
+        number=1,
+        label=field.LABEL_OPTIONAL,
+        type=field.TYPE_MESSAGE,
+        type_name=".inference.ModelInferRequest",
+    )
+    request.field.add(
+        name="chunk",
+        number=2,
+        label=field.LABEL_OPTIONAL,
+        type=field.TYPE_MESSAGE,
+        type_name=".inference.InferTensorChunk",
+    )
+    request.field.add(
+        name="output_chunk_byte_size",
+        number=3,
+        label=field.LABEL_OPTIONAL,
+        type=field.TYPE_UINT64,
+    )
+    response = file_proto.message_type.add(name="ModelInferChunkedResponse")
+    response.field.add(
+        name="response",
+        number=1,
+        label=field.LABEL_OPTIONAL,
+        type=field.TYPE_MESSAGE,
+        type_name=".inference.ModelInferResponse",
+    )
+    response.field.add(
+        name="chunk",
+        number=2,
+        label=field.LABEL_OPTIONAL,
+        type=field.TYPE_MESSAGE,
+        type_name=".inference.InferTensorChunk",
+    )
+
+    pool = descriptor_pool.Default()
+    pool.AddSerializedFile(file_proto.SerializeToString())
+    return tuple(
+        message_factory.GetMessageClass(pool.FindMessageTypeByName("inference." + name))
+        for name in (
+            "InferTensorChunk",
+            "ModelInferChunkedRequest",
+            "ModelInferChunkedResponse",
+        )
+    )
+
+
+(
+    InferTensorChunk,
+    ModelInferChunkedRequest,
+    ModelInferChunkedResponse,
+) = chunked_service_messages()
+
+
+class ChunkedInferTest(tu.TestResultCollector):
+    def setUp(self):
+        self.model_name_ = "identity_int32"
+        self.input_data_ = np.arange(1000, dtype=np.int32).tobytes()
+
+    def _infer_chunked(self, messages):
+        # Returns the response messages of the ModelInferChunked RPC that
+        # sends 'messages'.
+        with grpc.insecure_channel("localhost:8001") as channel:
+            model_infer_chunked = channel.stream_stream(
+                "/inference.GRPCInferenceChunkedService/ModelInferChunked",
+                request_serializer=ModelInferChunkedRequest.SerializeToString,
+                response_deserializer=ModelInferChunkedResponse.FromString,
+            )
+            return list(model_infer_chunked(iter(messages)))
+
+    def _header(self, inputs, output_chunk_byte_size=0):
+        # 'inputs' are the names and element counts of the INT32 inputs.
+        request = service_pb2.ModelInferRequest(model_name=self.model_name_)
+        for name, element_count in inputs:
+            request.inputs.add(name=name, datatype="INT32", shape=[1, element_count])
+        request.outputs.add(name="OUTPUT0")
+        return ModelInferChunkedRequest(
+            request=request, output_chunk_byte_size=output_chunk_byte_size
+        )
+
+    def _chunk(self, offset, data, index=0):
+        return ModelInferChunkedRequest(
+            chunk=InferTensorChunk(index=index, offset=offset, data=data)
+        )
+
+    def _assert_rpc_error(self, messages, message):
+        with self.assertRaises(grpc.RpcError) as cm:
+            self._infer_chunked(messages)
+        self.assertEqual(cm.exception.code(), grpc.StatusCode.INVALID_ARGUMENT)
+        self.assertIn(message, cm.exception.details())
+
+    def test_reassembly(self):
+        # The input is sent in chunks of uneven sizes and the output is
+        # received in chunks of at most 512 bytes, the output must match
+        # the input once reassembled.
+        messages = [self._header([("INPUT0", 1000)], output_chunk_byte_size=512)]
+        offset = 0
+        for size in [1000, 1, 2999]:
+            messages.append(
+                self._chunk(offset, self.input_data_[offset : offset + size])
+            )
+            offset += size
+        responses = self._infer_chunked(messages)
+
+        self.assertTrue(responses[0].HasField("response"))
+        header = responses[0].response
+        self.assertEqual(len(header.outputs), 1)
+        self.assertEqual(header.outputs[0].name, "OUTPUT0")
+        self.assertEqual(len(header.raw_output_contents), 0)
+        self.assertEqual(
+            header.outputs[0].parameters["byte_size"].int64_param,
+            len(self.input_data_),
+        )
+
+        output_data = b""
+        for response in responses[1:]:
+            self.assertTrue(response.HasField("chunk"))
+            self.assertEqual(response.chunk.index, 0)
+            self.assertEqual(response.chunk.offset, len(output_data))
+            self.assertLessEqual(len(response.chunk.data), 512)
+            output_data += response.chunk.data
+        self.assertEqual(len(responses), 1 + len(self.input_data_) // 512 + 1)
+        self.assertEqual(output_data, self.input_data_)
+
+    def test_out_of_order_chunk(self):
+        self._assert_rpc_error(
+            [
+                self._header([("INPUT0", 1000)]),
+                self._chunk(1000, self.input_data_[1000:2000]),
+                self._chunk(0, self.input_data_[0:1000]),
+            ],
+            "expected chunk of input 0 at offset 0, got input 0 at offset 1000",
+        )
+        self._assert_rpc_error(
+            [
+                self._header([("INPUT0", 1000)]),
+                self._chunk(0, self.input_data_[0:1000], index=1),
+            ],
+            "expected chunk of input 0 at offset 0, got input 1 at offset 0",
+        )
+
+    def test_oversized_chunk(self):
+        # The chunk exceeds the input by 4 bytes.
+        self._assert_rpc_error(
+            [
+                self._header([("INPUT0", 1000)]),
+                self._chunk(0, self.input_data_[0:2000]),
+                self._chunk(2000, self.input_data_[2000:] + b"\x00" * 4),
+            ],
+            "chunk of input 0 exceeds the byte size of the input, 4000",
+        )
+
+    def test_input_bound(self):
+        # A single input exceeding the bound, and inputs exceeding it
+        # together, are rejected before any chunk is read.
+        bound = "maximum input size of {} bytes".format(MAX_INPUT_BYTE_SIZE)
+        self._assert_rpc_error(
+            [self._header([("INPUT0", MAX_INPUT_BYTE_SIZE // 4 + 1)])], bound
+        )
+        self._assert_rpc_error(
+            [
+                self._header(
+                    [
+                        ("INPUT0", MAX_INPUT_BYTE_SIZE // 8),
+                        ("INPUT1", MAX_INPUT_BYTE_SIZE // 8 + 1),
+                    ]
+                )
+            ],
+            "the inputs of the ModelInferChunked request exceed the " + bound,
+        )
+
+    def test_stream_ends_mid_tensor(self):
+        self._assert_rpc_error(
+            [
+                self._header([("INPUT0", 1000)]),
+                self._chunk(0, self.input_data_[0:2000]),
+            ],
+            "stream closed before all input contents were received",
+        )
+
+
+if __name__ == "__main__":
+    unittest.main()
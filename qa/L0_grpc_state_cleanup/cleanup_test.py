@@ -37,9 +37,12 @@ import time
 import unittest
 from functools import partial
 
+import grpc
 import numpy as np
 import test_util as tu
 import tritonclient.grpc as grpcclient
+from google.protobuf import descriptor_pb2, descriptor_pool, message_factory
+from tritonclient.grpc import service_pb2
 from tritonclient.utils import InferenceServerException
 
 
@@ -55,6 +58,63 @@ def callback(user_data, result, error):
         user_data._response_queue.put(result)
 
 
+def batch_service_messages():
+    # The batch service of src/grpc/grpc_batch_service.proto isn't part
+    # of the client library, its messages are described on top of the
+    # messages of the inference service.
+    field = descriptor_pb2.FieldDescriptorProto
+    file_proto = descriptor_pb2.FileDescriptorProto(
+        name="grpc_batch_service.proto",
+        package="inference",
+        syntax="proto3",
+        dependency=[service_pb2.DESCRIPTOR.name],
+    )
+    request = file_proto.message_type.add(name="ModelInferBatchRequest")
+    request.field.add(
+        name="requests",
+        number=1,
+        label=field.LABEL_REPEATED,
+        type=field.TYPE_MESSAGE,
+        type_name=".inference.ModelInferRequest",
+    )
+    response = file_proto.message_type.add(name="ModelInferBatchResponse")
+    item = response.nested_type.add(name="Item")
+    item.field.add(
+        name="code", number=1, label=field.LABEL_OPTIONAL, type=field.TYPE_INT32
+    )
+    item.field.add(
+        name="message", number=2, label=field.LABEL_OPTIONAL, type=field.TYPE_STRING
+    )
+    item.field.add(
+        name="response",
+        number=3,
+        label=field.LABEL_OPTIONAL,
+        type=field.TYPE_MESSAGE,
+        type_name=".inference.ModelInferResponse",
+    )
+    response.field.add(
+        name="responses",
+        number=1,
+        label=field.LABEL_REPEATED,
+        type=field.TYPE_MESSAGE,
+        type_name=".inference.ModelInferBatchResponse.Item",
+    )
+
+    pool = descriptor_pool.Default()
+    pool.AddSerializedFile(file_proto.SerializeToString())
+    return (
+        message_factory.GetMessageClass(
+            pool.FindMessageTypeByName("inference.ModelInferBatchRequest")
+        ),
+        message_factory.GetMessageClass(
+            pool.FindMessageTypeByName("inference.ModelInferBatchResponse")
+        ),
+    )
+
+
+ModelInferBatchRequest, ModelInferBatchResponse = batch_service_messages()
+
+
 # These state cleanup tests relies on the test.sh
 # to check whether all the created request objects
 # were properly deleted by the sever.
@@ -401,6 +461,28 @@ class CleanUpTest(tu.TestResultCollector):
                         self.assertEqual(this_idx[0], j)
                         expected_data += 1
 
+    def _batch_item(self, model_name, request_id):
+        request = service_pb2.ModelInferRequest(model_name=model_name, id=request_id)
+        request.inputs.add(name="INPUT0", datatype="FP32", shape=[1, 1])
+        request.raw_input_contents.append(np.array([[1.0]], dtype=np.float32).tobytes())
+        request.outputs.add(name="OUTPUT0")
+        return request
+
+    def _batch_infer(self, channel, requests):
+        # Returns the future of the ModelInferBatch RPC of 'requests'.
+        model_infer_batch = channel.unary_unary(
+            "/inference.GRPCInferenceBatchService/ModelInferBatch",
+            request_serializer=ModelInferBatchRequest.SerializeToString,
+            response_deserializer=ModelInferBatchResponse.FromString,
+        )
+        return model_infer_batch.future(ModelInferBatchRequest(requests=requests))
+
+    def _check_batch_item(self, item, request_id):
+        self.assertEqual(item.code, grpc.StatusCode.OK.value[0], item.message)
+        self.assertEqual(item.response.id, request_id)
+        self.assertEqual(len(item.response.outputs), 1)
+        self.assertEqual(item.response.outputs[0].name, "OUTPUT0")
+
     ###
     ### Non-Streaming Tests
     ###
@@ -434,6 +516,58 @@ class CleanUpTest(tu.TestResultCollector):
             str(cm.exception),
         )
 
+    def test_batch_infer(self):
+        # This test case sends a batch with a failing request, the
+        # failure is reported in its item and the other requests of the
+        # batch complete.
+        with grpc.insecure_channel("localhost:8001") as channel:
+            response = self._batch_infer(
+                channel,
+                [
+                    self._batch_item(self.identity_model_name_, "0"),
+                    self._batch_item("unknown_model", "1"),
+                    self._batch_item(self.identity_model_name_, "2"),
+                ],
+            ).result()
+
+        self.assertEqual(len(response.responses), 3)
+        self._check_batch_item(response.responses[0], "0")
+        self._check_batch_item(response.responses[2], "2")
+        failed = response.responses[1]
+        self.assertNotEqual(failed.code, grpc.StatusCode.OK.value[0])
+        self.assertIn("unknown_model", failed.message)
+        self.assertEqual(len(failed.response.outputs), 0)
+
+    def test_batch_infer_empty(self):
+        # This test case checks that a batch without request completes
+        # with an empty response.
+        with grpc.insecure_channel("localhost:8001") as channel:
+            response = self._batch_infer(channel, []).result()
+        self.assertEqual(len(response.responses), 0)
+
+    def test_batch_infer_cancellation(self):
+        # This test case is used to check whether the state of a batch
+        # and the outputs of its requests are released when the RPC is
+        # cancelled while the requests are executed.
+        with grpc.insecure_channel("localhost:8001") as channel:
+            future = self._batch_infer(
+                channel,
+                [self._batch_item(self.identity_model_name_, str(i)) for i in range(4)],
+            )
+            time.sleep(0.5)
+            self.assertTrue(future.cancel())
+            with self.assertRaises(grpc.FutureCancelledError):
+                future.result()
+
+            # The requests of the cancelled batch are executed before
+            # this one, so the cancelled batch is complete once this one
+            # returns.
+            response = self._batch_infer(
+                channel, [self._batch_item(self.identity_model_name_, "4")]
+            ).result()
+            self.assertEqual(len(response.responses), 1)
+            self._check_batch_item(response.responses[0], "4")
+
     def test_simple_infer_shutdownserver(self):
         # This test case is used to check whether all the state objects are
         # released when the server is interrupted to shutdown in middle of
@@ -76,6 +76,9 @@ rm -fr ./models/custom_zero_1_float32 && \
 for i in test_simple_infer \
             test_simple_infer_cancellation \
             test_simple_infer_timeout \
+            test_batch_infer \
+            test_batch_infer_empty \
+            test_batch_infer_cancellation \
             test_streaming_infer \
             test_streaming_timeout \
             test_streaming_cancellation \
@@ -30,7 +30,11 @@ import sys
 
 sys.path.append("../common")
 
+import json
+import mmap
 import os
+import socket
+import time
 import unittest
 
 import numpy as np
@@ -324,10 +328,251 @@ class SharedMemoryTest(tu.TestResultCollector):
         self._cleanup_server(shm_handles)
 
 
+    def _register_fd(self, sock, name, fd, byte_size, offset=0, **options):
+        request = {
+            "action": "register",
+            "name": name,
+            "offset": offset,
+            "byte_size": byte_size,
+        }
+        request.update(options)
+        socket.send_fds(sock, [json.dumps(request).encode()], [fd])
+        return json.loads(sock.recv(4096))
+
+    def _system_shared_memory_count(self, triton_client):
+        shm_status = triton_client.get_system_shared_memory_status()
+        if _protocol == "http":
+            return len(shm_status)
+        return len(shm_status.regions)
+
+    def test_fd_register_inference(self):
+        # Register memfd regions over the shared memory socket and use
+        # them for inference
+        if _protocol == "http":
+            triton_client = httpclient.InferenceServerClient(_url, verbose=True)
+            InferInput, InferRequestedOutput = (
+                httpclient.InferInput,
+                httpclient.InferRequestedOutput,
+            )
+        else:
+            triton_client = grpcclient.InferenceServerClient(_url, verbose=True)
+            InferInput, InferRequestedOutput = (
+                grpcclient.InferInput,
+                grpcclient.InferRequestedOutput,
+            )
+        fd = os.memfd_create("shm_fd_test")
+        os.ftruncate(fd, 4 * 64)
+        buffer = mmap.mmap(fd, 4 * 64)
+        input0_data = np.arange(start=0, stop=16, dtype=np.int32)
+        input1_data = np.ones(shape=16, dtype=np.int32)
+        buffer[0:64] = input0_data.tobytes()
+        buffer[64:128] = input1_data.tobytes()
+
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_SEQPACKET)
+        sock.connect(_socket_path)
+        names = ["input0_data", "input1_data", "output0_data", "output1_data"]
+        for idx, name in enumerate(names):
+            response = self._register_fd(sock, name, fd, 64, offset=idx * 64)
+            self.assertIn("handle", response, str(response))
+        os.close(fd)
+        self.assertEqual(self._system_shared_memory_count(triton_client), 4)
+
+        inputs = [
+            InferInput("INPUT0", [1, 16], "INT32"),
+            InferInput("INPUT1", [1, 16], "INT32"),
+        ]
+        outputs = [InferRequestedOutput("OUTPUT0"), InferRequestedOutput("OUTPUT1")]
+        inputs[0].set_shared_memory("input0_data", 64)
+        inputs[1].set_shared_memory("input1_data", 64)
+        outputs[0].set_shared_memory("output0_data", 64)
+        outputs[1].set_shared_memory("output1_data", 64)
+        triton_client.infer("simple", inputs, outputs=outputs)
+        output0_data = np.frombuffer(buffer[128:192], dtype=np.int32)
+        self.assertTrue(
+            (output0_data == (input0_data + input1_data)).all(),
+            "Model output does not match expected output",
+        )
+
+        sock.close()
+        buffer.close()
+
+    def test_fd_unregister_on_close(self):
+        # Regions registered over the shared memory socket are unregistered
+        # when the connection closes
+        if _protocol == "http":
+            triton_client = httpclient.InferenceServerClient(_url, verbose=True)
+        else:
+            triton_client = grpcclient.InferenceServerClient(_url, verbose=True)
+        fd = os.memfd_create("shm_fd_test")
+        os.ftruncate(fd, 64)
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_SEQPACKET)
+        sock.connect(_socket_path)
+        response = self._register_fd(sock, "fd_data", fd, 128)
+        self.assertIn("exceed", response.get("error", ""), str(response))
+        response = self._register_fd(sock, "fd_data", fd, 64)
+        self.assertIn("handle", response, str(response))
+        os.close(fd)
+        self.assertEqual(self._system_shared_memory_count(triton_client), 1)
+
+        sock.close()
+        for _ in range(50):
+            if self._system_shared_memory_count(triton_client) == 0:
+                break
+            time.sleep(0.1)
+        self.assertEqual(self._system_shared_memory_count(triton_client), 0)
+
+    def test_fd_unread_replies(self):
+        # A connection whose client doesn't read its replies is closed,
+        # and its regions unregistered, without stalling the service of
+        # the other connections
+        if _protocol == "http":
+            triton_client = httpclient.InferenceServerClient(_url, verbose=True)
+        else:
+            triton_client = grpcclient.InferenceServerClient(_url, verbose=True)
+        fd = os.memfd_create("shm_fd_test")
+        os.ftruncate(fd, 64)
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_SEQPACKET)
+        sock.connect(_socket_path)
+        response = self._register_fd(sock, "fd_data", fd, 64)
+        self.assertIn("handle", response, str(response))
+
+        request = json.dumps({"action": "unregister", "name": "fd_missing"})
+        sock.settimeout(0.1)
+        closed = False
+        for _ in range(100000):
+            try:
+                sock.send(request.encode())
+            except socket.timeout:
+                continue
+            except (BrokenPipeError, ConnectionResetError):
+                closed = True
+                break
+        self.assertTrue(closed, "connection with unread replies not closed")
+        sock.close()
+
+        other_sock = socket.socket(socket.AF_UNIX, socket.SOCK_SEQPACKET)
+        other_sock.connect(_socket_path)
+        response = self._register_fd(other_sock, "fd_other", fd, 64)
+        self.assertIn("handle", response, str(response))
+        os.close(fd)
+        for _ in range(50):
+            if self._system_shared_memory_count(triton_client) == 1:
+                break
+            time.sleep(0.1)
+        self.assertEqual(self._system_shared_memory_count(triton_client), 1)
+        other_sock.close()
+
+    def _pool_allocation(self, output):
+        if _protocol == "http":
+            parameters = output["parameters"]
+            return (
+                parameters["shared_memory_offset"],
+                parameters["shared_memory_byte_size"],
+                parameters["shared_memory_pool_lease"],
+            )
+        parameters = output.parameters
+        return (
+            parameters["shared_memory_offset"].int64_param,
+            parameters["shared_memory_byte_size"].int64_param,
+            parameters["shared_memory_pool_lease"].int64_param,
+        )
+
+    def test_output_pool(self):
+        # Outputs naming a region registered as a pool are allocated in
+        # it by the server, and released by the client
+        if _protocol == "http":
+            triton_client = httpclient.InferenceServerClient(_url, verbose=True)
+            InferInput, InferRequestedOutput = (
+                httpclient.InferInput,
+                httpclient.InferRequestedOutput,
+            )
+        else:
+            triton_client = grpcclient.InferenceServerClient(_url, verbose=True)
+            InferInput, InferRequestedOutput = (
+                grpcclient.InferInput,
+                grpcclient.InferRequestedOutput,
+            )
+        input_fd = os.memfd_create("shm_pool_test_input")
+        os.ftruncate(input_fd, 128)
+        input_buffer = mmap.mmap(input_fd, 128)
+        input0_data = np.arange(start=0, stop=16, dtype=np.int32)
+        input1_data = np.ones(shape=16, dtype=np.int32)
+        input_buffer[0:64] = input0_data.tobytes()
+        input_buffer[64:128] = input1_data.tobytes()
+        pool_fd = os.memfd_create("shm_pool_test_pool")
+        os.ftruncate(pool_fd, 4096)
+        pool_buffer = mmap.mmap(pool_fd, 4096)
+
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_SEQPACKET)
+        sock.connect(_socket_path)
+        for idx, name in enumerate(["input0_data", "input1_data"]):
+            response = self._register_fd(sock, name, input_fd, 64, offset=idx * 64)
+            self.assertIn("handle", response, str(response))
+        response = self._register_fd(
+            sock, "output_pool", pool_fd, 4096, pool=True, pool_block_size=256
+        )
+        self.assertIn("handle", response, str(response))
+        os.close(input_fd)
+        os.close(pool_fd)
+
+        inputs = [
+            InferInput("INPUT0", [1, 16], "INT32"),
+            InferInput("INPUT1", [1, 16], "INT32"),
+        ]
+        inputs[0].set_shared_memory("input0_data", 64)
+        inputs[1].set_shared_memory("input1_data", 64)
+        outputs = [InferRequestedOutput("OUTPUT0"), InferRequestedOutput("OUTPUT1")]
+        outputs[0].set_shared_memory("output_pool", 0)
+        outputs[1].set_shared_memory("output_pool", 0)
+
+        # The pool holds 16 blocks, of which each inference takes 2, so
+        # inferences fail once the outputs are not released.
+        allocations = []
+        for _ in range(8):
+            results = triton_client.infer("simple", inputs, outputs=outputs)
+            offset, byte_size, lease = self._pool_allocation(
+                results.get_output("OUTPUT0")
+            )
+            self.assertEqual(byte_size, 64)
+            output0_data = np.frombuffer(
+                pool_buffer[offset : offset + byte_size], dtype=np.int32
+            )
+            self.assertTrue(
+                (output0_data == (input0_data + input1_data)).all(),
+                "Model output does not match expected output",
+            )
+            allocations.append((offset, lease))
+            output1_allocation = self._pool_allocation(results.get_output("OUTPUT1"))
+            allocations.append((output1_allocation[0], output1_allocation[2]))
+        self.assertEqual(len(set(offset for offset, _ in allocations)), 16)
+        with self.assertRaisesRegex(utils.InferenceServerException, "no free"):
+            triton_client.infer("simple", inputs, outputs=outputs)
+
+        for offset, lease in allocations:
+            request = {
+                "action": "release",
+                "name": "output_pool",
+                "offset": offset,
+                "lease": lease,
+            }
+            sock.send(json.dumps(request).encode())
+            response = json.loads(sock.recv(4096))
+            self.assertNotIn("error", response, str(response))
+        sock.send(json.dumps(request).encode())
+        response = json.loads(sock.recv(4096))
+        self.assertIn("error", response, str(response))
+        triton_client.infer("simple", inputs, outputs=outputs)
+
+        sock.close()
+        input_buffer.close()
+        pool_buffer.close()
+
+
 if __name__ == "__main__":
     _protocol = os.environ.get("CLIENT_TYPE", "http")
     if _protocol == "http":
         _url = "localhost:8000"
     else:
         _url = "localhost:8001"
+    _socket_path = os.environ.get("SHM_SOCKET", "/tmp/triton_shm.sock")
     unittest.main()
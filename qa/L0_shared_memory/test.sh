@@ -33,7 +33,8 @@ TEST_RESULT_FILE='test_results.txt'
 TRITON_DIR=${TRITON_DIR:="/opt/tritonserver"}
 SERVER=${TRITON_DIR}/bin/tritonserver
 BACKEND_DIR=${TRITON_DIR}/backends
-SERVER_ARGS_EXTRA="--backend-directory=${BACKEND_DIR}"
+SHM_SOCKET=/tmp/triton_shm.sock
+SERVER_ARGS_EXTRA="--backend-directory=${BACKEND_DIR} --shared-memory-socket=${SHM_SOCKET}"
 source ../common/util.sh
 
 RET=0
@@ -49,7 +50,11 @@ for i in \
         test_register_after_inference \
         test_too_big_shm \
         test_mixed_raw_shm \
-        test_unregisterall; do
+        test_unregisterall \
+        test_fd_register_inference \
+        test_fd_unregister_on_close \
+        test_fd_unread_replies \
+        test_output_pool; do
     for client_type in http grpc; do
         SERVER_ARGS="--model-repository=`pwd`/models --log-verbose=1 ${SERVER_ARGS_EXTRA}"
         SERVER_LOG="./$i.$client_type.server.log"
@@ -61,6 +66,7 @@ for i in \
         fi
 
         export CLIENT_TYPE=$client_type
+        export SHM_SOCKET
         echo "Test: $i, client type: $client_type" >>$CLIENT_LOG
 
         set +e
@@ -0,0 +1,94 @@
+#!/bin/bash
+# Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# Compares inferences through a shared memory ring with inferences
+# through the GRPC endpoint with system shared memory.
+
+CLIENT_LOG="./client.log"
+PERF_ANALYZER=../clients/perf_analyzer
+RING_PERF=../clients/shared_memory_ring_perf
+MODEL_NAME=identity_fp32
+
+TRITON_DIR=${TRITON_DIR:="/opt/tritonserver"}
+SERVER=${TRITON_DIR}/bin/tritonserver
+BACKEND_DIR=${TRITON_DIR}/backends
+SERVER_ARGS="--model-repository=`pwd`/models --backend-directory=${BACKEND_DIR} --allow-shared-memory-ring=true"
+SERVER_LOG="./server.log"
+source ../common/util.sh
+
+RET=0
+rm -fr *.log models && mkdir models
+cp -r ../python_models/${MODEL_NAME} models/ && \
+    mkdir -p models/${MODEL_NAME}/1 && \
+    mv models/${MODEL_NAME}/model.py models/${MODEL_NAME}/1/
+
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+set +e
+for CONCURRENCY in 1 4; do
+    echo "Shared memory ring, concurrency ${CONCURRENCY}" >>$CLIENT_LOG
+    $RING_PERF -m $MODEL_NAME -c $CONCURRENCY -n 20000 >>$CLIENT_LOG 2>&1
+    if [ $? -ne 0 ]; then
+        echo -e "\n***\n*** Shared memory ring benchmark failed\n***"
+        RET=1
+    fi
+
+    echo "GRPC with system shared memory, concurrency ${CONCURRENCY}" >>$CLIENT_LOG
+    $PERF_ANALYZER -m $MODEL_NAME -i grpc --shared-memory system \
+        --shape INPUT0:16 --concurrency-range $CONCURRENCY >>$CLIENT_LOG 2>&1
+    if [ $? -ne 0 ]; then
+        echo -e "\n***\n*** perf_analyzer failed\n***"
+        RET=1
+    fi
+done
+
+# Attaching a region that is not a ring must fail.
+code=`curl -s -w %{http_code} -o ./curl.out -X POST \
+    localhost:8000/v2/sharedmemoryring/region/not_registered/attach`
+if [ "$code" == "200" ]; then
+    cat ./curl.out
+    echo -e "\n***\n*** Attaching an unregistered region should fail\n***"
+    RET=1
+fi
+set -e
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+cat $CLIENT_LOG
+if [ $RET -eq 0 ]; then
+    echo -e "\n***\n*** Test Passed\n***"
+else
+    echo -e "\n***\n*** Test Failed\n***"
+fi
+
+exit $RET
@@ -28,6 +28,8 @@
 SIMPLE_HTTP_CLIENT=../clients/simple_http_infer_client
 SIMPLE_GRPC_CLIENT=../clients/simple_grpc_infer_client
 TRACE_SUMMARY=../common/trace_summary.py
+TRACE_CONVERT=../common/trace_convert.py
+TRACE_TENSORS=../common/trace_tensors.py
 
 CLIENT_TEST=trace_endpoint_test.py
 CLIENT_LOG="client.log"
@@ -147,6 +149,26 @@ function send_inference_requests {
     done
 }
 
+function send_concurrent_inference_requests {
+    log_file="${1}"
+    concurrency="${2}"
+    upper_bound="${3}"
+    pids=""
+    for (( c = 1; c <= $concurrency; c++ )) do
+        (for (( p = 1; p <= $upper_bound; p++ )) do
+            $SIMPLE_HTTP_CLIENT >> ${log_file} 2>&1 || exit 1
+            $SIMPLE_GRPC_CLIENT >> ${log_file} 2>&1 || exit 1
+        done) &
+        pids="$pids $!"
+    done
+    for pid in $pids; do
+        wait $pid
+        if [ $? -ne 0 ]; then
+            RET=1
+        fi
+    done
+}
+
 #=======================================
 
 # start with trace-level=OFF
@@ -695,6 +717,372 @@ wait $SERVER_PID
 
 set +e
 
+# Check the binary trace format, the converted traces must be the same
+# as the traces of the JSON format
+SERVER_ARGS="--trace-config triton,file=binary_trace.log --trace-config triton,format=binary \
+                --trace-config triton,compression=zlib --trace-config level=TIMESTAMPS \
+                --trace-config rate=1 --model-repository=$MODELSDIR"
+SERVER_LOG="./inference_server_binary.log"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+send_inference_requests "client_binary.log" 10
+
+set -e
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+set +e
+
+$TRACE_CONVERT -f triton -o binary_trace.json binary_trace.log
+$TRACE_SUMMARY -t binary_trace.json > summary_binary.log
+
+if [ `grep -c "COMPUTE_INPUT_END" summary_binary.log` != "20" ]; then
+    cat summary_binary.log
+    echo -e "\n***\n*** Test Failed: Unexpected number of traces in binary format.\n***"
+    RET=1
+fi
+
+if [ `grep -c ^simple summary_binary.log` != "20" ]; then
+    cat summary_binary.log
+    echo -e "\n***\n*** Test Failed: Unexpected number of traces in binary format.\n***"
+    RET=1
+fi
+
+$TRACE_CONVERT -o binary_trace_chrome.json binary_trace.log
+if [ `grep -o '"name": "REQUEST"' binary_trace_chrome.json | wc -l` != "20" ]; then
+    echo -e "\n***\n*** Test Failed: Unexpected number of spans in Chrome trace.\n***"
+    RET=1
+fi
+
+# Check the binary tensor format, the tensors are written to the tensor
+# file and read back with the trace tensor tool
+SERVER_ARGS="--trace-config triton,file=tensor_trace.log --trace-config level=TENSORS \
+                --trace-config rate=1 --trace-config triton,tensor-format=binary \
+                --trace-config triton,tensor-segment-size=4096 \
+                --model-repository=$MODELSDIR"
+SERVER_LOG="./inference_server_tensor.log"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+send_inference_requests "client_tensor.log" 10
+
+set -e
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+set +e
+
+if [ `grep -c '"data"' tensor_trace.log` != "0" ]; then
+    echo -e "\n***\n*** Test Failed: Tensor data found in the trace file.\n***"
+    RET=1
+fi
+
+$TRACE_TENSORS tensor_trace.log > tensors.log
+if [ $? -ne 0 ]; then
+    cat tensors.log
+    echo -e "\n***\n*** Test Failed: Failed to read the traced tensors.\n***"
+    RET=1
+fi
+
+# The INPUT0 of the simple clients holds 0 to 15
+if [ `grep -c "TENSOR_QUEUE_INPUT_INPUT0: INT32 (1, 16)" tensors.log` != "20" ] || \
+        [ `grep -c "\[\[ 0  1  2  3  4  5  6  7  8  9 10 11 12 13 14 15\]\]" tensors.log` == "0" ] || \
+        [ `grep -c "dropped" tensors.log` != "0" ]; then
+    cat tensors.log
+    echo -e "\n***\n*** Test Failed: Unexpected traced tensors.\n***"
+    RET=1
+fi
+
+# Check tail sampling, only the traces of the requests slower than the
+# threshold are written
+SERVER_ARGS="--trace-config triton,file=tail_trace_slow.log --trace-config level=TIMESTAMPS \
+                --trace-config rate=1 --trace-config tail-latency-us=60000000 \
+                --model-repository=$MODELSDIR"
+SERVER_LOG="./inference_server_tail_slow.log"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+send_inference_requests "client_tail_slow.log" 10
+
+set -e
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+set +e
+
+if [ -f tail_trace_slow.log ]; then
+    cat tail_trace_slow.log
+    echo -e "\n***\n*** Test Failed: Unexpected traces below the tail latency.\n***"
+    RET=1
+fi
+
+SERVER_ARGS="--trace-config triton,file=tail_trace.log --trace-config level=TIMESTAMPS \
+                --trace-config rate=1 --trace-config tail-latency-us=1 \
+                --model-repository=$MODELSDIR"
+SERVER_LOG="./inference_server_tail.log"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+send_inference_requests "client_tail.log" 10
+
+set -e
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+set +e
+
+$TRACE_SUMMARY -t tail_trace.log > summary_tail.log
+
+if [ `grep -c "COMPUTE_INPUT_END" summary_tail.log` != "20" ]; then
+    cat summary_tail.log
+    echo -e "\n***\n*** Test Failed: Unexpected number of tail sampled traces.\n***"
+    RET=1
+fi
+
+# Check that the trace count, the rate and the log frequency are applied
+# exactly when the setting is shared by concurrent requests
+SERVER_ARGS="--trace-config triton,file=concurrent_count.log --trace-config level=TIMESTAMPS \
+                --trace-config rate=1 --trace-config count=7 \
+                --model-repository=$MODELSDIR"
+SERVER_LOG="./inference_server_concurrent_count.log"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+send_concurrent_inference_requests "client_concurrent_count.log" 4 10
+
+get_trace_setting "simple"
+assert_curl_success "Failed to obtain trace settings for 'simple' model"
+
+if [ `grep -c "\"trace_count\":\"0\"" ./curl.out` != "1" ]; then
+    cat ./curl.out
+    echo -e "\n***\n*** Test Failed: Trace count not exhausted.\n***"
+    RET=1
+fi
+
+set -e
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+set +e
+
+$TRACE_SUMMARY -t concurrent_count.log.0 > summary_concurrent_count.log
+
+if [ `grep -c "COMPUTE_INPUT_END" summary_concurrent_count.log` != "7" ]; then
+    cat summary_concurrent_count.log
+    echo -e "\n***\n*** Test Failed: Unexpected number of counted traces.\n***"
+    RET=1
+fi
+
+if [ -f concurrent_count.log.1 ]; then
+    echo -e "\n***\n*** Test Failed: Unexpected concurrent_count.log.1\n***"
+    RET=1
+fi
+
+# 80 requests sampled at a rate of 2 are written as 8 files of 5 traces
+SERVER_ARGS="--trace-config triton,file=concurrent_frequency.log --trace-config level=TIMESTAMPS \
+                --trace-config rate=2 --trace-config triton,log-frequency=5 \
+                --model-repository=$MODELSDIR"
+SERVER_LOG="./inference_server_concurrent_frequency.log"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+send_concurrent_inference_requests "client_concurrent_frequency.log" 4 10
+
+set -e
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+set +e
+
+for (( i = 0; i < 8; i++ )) do
+    $TRACE_SUMMARY -t concurrent_frequency.log.$i > summary_concurrent_frequency.log.$i
+    if [ `grep -c "COMPUTE_INPUT_END" summary_concurrent_frequency.log.$i` != "5" ]; then
+        cat summary_concurrent_frequency.log.$i
+        echo -e "\n***\n*** Test Failed: Unexpected number of traces in concurrent_frequency.log.$i\n***"
+        RET=1
+    fi
+done
+
+if [ -f concurrent_frequency.log.8 ]; then
+    echo -e "\n***\n*** Test Failed: Unexpected concurrent_frequency.log.8\n***"
+    RET=1
+fi
+
+# Check the flight recorder, the timelines of the requests are kept
+# with tracing disabled and returned by the recorder endpoint or logged
+# on SIGUSR2
+SERVER_ARGS="--trace-config recorder-size=256 --model-repository=$MODELSDIR"
+SERVER_LOG="./inference_server_recorder.log"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+send_inference_requests "client_recorder.log" 10
+
+rm -f ./curl.out
+set +e
+code=`curl -s -w %{http_code} -o ./curl.out localhost:8000/v2/trace/recorder`
+set -e
+assert_curl_success "Failed to obtain the flight recorder timelines"
+
+if [ `grep -o "\"COMPUTE_INPUT_END\"" curl.out | wc -l` != "20" ]; then
+    cat curl.out
+    echo -e "\n***\n*** Test Failed: Unexpected number of recorded timelines.\n***"
+    RET=1
+fi
+
+kill -USR2 $SERVER_PID
+sleep 2
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+set +e
+
+if [ `grep -c "Flight recorder: \[{" $SERVER_LOG` != "1" ]; then
+    cat $SERVER_LOG
+    echo -e "\n***\n*** Test Failed: Flight recorder not logged on SIGUSR2.\n***"
+    RET=1
+fi
+
+# The flight recorder is disabled by default
+SERVER_ARGS="--model-repository=$MODELSDIR"
+SERVER_LOG="./inference_server_recorder_disabled.log"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+rm -f ./curl.out
+set +e
+code=`curl -s -w %{http_code} -o ./curl.out localhost:8000/v2/trace/recorder`
+set -e
+assert_curl_failure "Server returned timelines with the flight recorder disabled"
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+set +e
+
+# Check the server timing breakdown returned to the client, and that the
+# frontend stages are recorded in the request timelines
+SERVER_ARGS="--trace-config server-timing=true --trace-config recorder-size=256 \
+             --model-repository=$MODELSDIR"
+SERVER_LOG="./inference_server_server_timing.log"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+INFER_REQUEST='{"inputs":[{"name":"INPUT0","datatype":"INT32","shape":[1,16],"data":[1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16]},{"name":"INPUT1","datatype":"INT32","shape":[1,16],"data":[1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1]}]}'
+rm -f ./curl.out ./headers.out
+set +e
+code=`curl -s -w %{http_code} -D ./headers.out -o ./curl.out -d "$INFER_REQUEST" localhost:8000/v2/models/simple/infer`
+set -e
+assert_curl_success "Failed to run inference with server timing"
+
+for metric in parse input infer output; do
+    if [ `grep -ci "^server-timing:.*$metric;dur=" headers.out` != "1" ]; then
+        cat headers.out
+        echo -e "\n***\n*** Test Failed: $metric missing from server timing.\n***"
+        RET=1
+    fi
+done
+
+rm -f ./curl.out
+set +e
+code=`curl -s -w %{http_code} -o ./curl.out localhost:8000/v2/trace/recorder`
+set -e
+assert_curl_success "Failed to obtain the flight recorder timelines"
+
+for stage in PARSE_END INPUT_SETUP_END OUTPUT_SERIALIZE_END HTTP_SEND_END; do
+    if [ `grep -c "\"$stage\"" curl.out` == "0" ]; then
+        cat curl.out
+        echo -e "\n***\n*** Test Failed: $stage missing from the timelines.\n***"
+        RET=1
+    fi
+done
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+set +e
+
+# Check the histograms of the frontend stages reported on the metrics
+# endpoint
+SERVER_ARGS="--http-stage-metrics=true --grpc-stage-metrics=true --model-repository=$MODELSDIR"
+SERVER_LOG="./inference_server_stage_metrics.log"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+INFER_REQUEST='{"inputs":[{"name":"INPUT0","datatype":"INT32","shape":[1,16],"data":[1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16]},{"name":"INPUT1","datatype":"INT32","shape":[1,16],"data":[1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1]}]}'
+rm -f ./curl.out
+set +e
+code=`curl -s -w %{http_code} -o ./curl.out -d "$INFER_REQUEST" localhost:8000/v2/models/simple/infer`
+set -e
+assert_curl_success "Failed to run inference with stage metrics"
+
+curl -s localhost:8002/metrics > ./stage_metrics.out
+for stage in parse input output reply send; do
+    if [ `grep "^nv_http_frontend_stage_duration_us_count{" stage_metrics.out | grep "model=\"simple\"" | grep -c "stage=\"$stage\""` != "1" ]; then
+        grep nv_http_frontend stage_metrics.out
+        echo -e "\n***\n*** Test Failed: $stage missing from the stage metrics.\n***"
+        RET=1
+    fi
+done
+if [ `grep "^nv_http_frontend_cpu_us_count{" stage_metrics.out | grep -c "model=\"simple\""` != "1" ]; then
+    grep nv_http_frontend stage_metrics.out
+    echo -e "\n***\n*** Test Failed: CPU time missing from the stage metrics.\n***"
+    RET=1
+fi
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+set +e
+
 # Check opentelemetry trace exporter sends proper info.
 # A helper python script starts listening on $OTLP_PORT, where
 # OTLP exporter sends traces.
@@ -747,6 +1135,59 @@ if ! [[ -s $OTEL_COLLECTOR_LOG && `grep -c 'InstrumentationScope triton-server'
 fi
 
 
+# Check that a slow collector doesn't slow down the requests, the spans
+# that don't fit in the span processor queue are dropped and counted.
+STUB_COLLECTOR=otlp_stub_collector.py
+STUB_COLLECTOR_LOG="./trace_stub_collector.log"
+STUB_OTLP_PORT=10001
+python $STUB_COLLECTOR --port $STUB_OTLP_PORT --delay 5 >> $STUB_COLLECTOR_LOG 2>&1 & STUB_COLLECTOR_PID=$!
+
+SERVER_ARGS="--trace-config=level=TIMESTAMPS --trace-config=rate=1 \
+                --trace-config=mode=opentelemetry \
+                --trace-config=opentelemetry,url=localhost:$STUB_OTLP_PORT/v1/traces \
+                --trace-config=opentelemetry,bsp-max-queue-size=4 \
+                --trace-config=opentelemetry,bsp-max-export-batch-size=2 \
+                --trace-config=opentelemetry,bsp-schedule-delay=10 \
+                --trace-config=opentelemetry,export-timeout=1000 \
+                --model-repository=$MODELSDIR"
+SERVER_LOG="./inference_server_otel_slow_collector.log"
+
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    kill $STUB_COLLECTOR_PID
+    exit 1
+fi
+
+# Exporting the 3 spans of each request synchronously would take at
+# least 30 seconds.
+SECONDS=0
+for i in {1..10}; do
+    $SIMPLE_HTTP_CLIENT >> client_slow_collector.log 2>&1
+done
+if [ $SECONDS -ge 10 ]; then
+    echo -e "\n***\n*** Test Failed: Requests waited on span export ($SECONDS seconds).\n***"
+    RET=1
+fi
+
+DROPPED_SPANS=`curl -s localhost:8002/metrics | awk '/nv_trace_otel_dropped_spans{reason="queue_full"}/ {print $2}'`
+if [ -z "$DROPPED_SPANS" ] || [ "$DROPPED_SPANS" == "0" ]; then
+    curl -s localhost:8002/metrics | grep nv_trace_otel
+    echo -e "\n***\n*** Test Failed: Expected dropped spans with a slow collector.\n***"
+    RET=1
+fi
+
+set -e
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+set +e
+
+kill $STUB_COLLECTOR_PID
+wait $STUB_COLLECTOR_PID
+
 # Unittests then check that produced spans have expected format and events
 OPENTELEMETRY_TEST=opentelemetry_unittest.py
 OPENTELEMETRY_LOG="opentelemetry_unittest.log"
@@ -0,0 +1,280 @@
+#!/usr/bin/python
+
+# Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# Converts Triton trace files, in the JSON or binary format, to the
+# Chrome trace event format that chrome://tracing and the Perfetto UI
+# load, or to the Triton JSON trace format.
+
+import argparse
+import json
+import struct
+import sys
+import zlib
+
+FLAGS = None
+
+BINARY_TRACE_MAGIC = b"TRTNTRC1"
+BLOCK_HEADER = struct.Struct("<IQQ")
+
+COMPRESSION_NONE = 0
+COMPRESSION_ZLIB = 1
+
+RECORD_STRING = 1
+RECORD_TRACE = 2
+RECORD_TIMESTAMP = 3
+RECORD_REQUEST = 4
+RECORD_TENSOR = 5
+
+# Spans whose start and end timestamps don't share a prefix.
+NAMED_SPANS = [
+    ("QUEUE", "QUEUE_START", "COMPUTE_START"),
+    ("COMPUTE_INPUT", "COMPUTE_START", "COMPUTE_INPUT_END"),
+    ("COMPUTE_INFER", "COMPUTE_INPUT_END", "COMPUTE_OUTPUT_START"),
+    ("COMPUTE_OUTPUT", "COMPUTE_OUTPUT_START", "COMPUTE_END"),
+]
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return value, pos
+        shift += 7
+
+
+def read_signed_varint(data, pos):
+    value, pos = read_varint(data, pos)
+    return (value >> 1) ^ -(value & 1), pos
+
+
+def read_string(data, pos):
+    length, pos = read_varint(data, pos)
+    return data[pos : pos + length].decode("utf-8"), pos + length
+
+
+def decode_block(content, traces):
+    """Append the trace objects of a decompressed block to 'traces', the
+    objects of a trace group are ordered as in the JSON format."""
+    strings = {}
+    last_timestamp = 0
+    group = None
+
+    def flush_group():
+        if group is None:
+            return
+        ids = []
+        by_id = {}
+        for trace in group:
+            if trace["id"] not in by_id:
+                ids.append(trace["id"])
+                by_id[trace["id"]] = []
+            by_id[trace["id"]].append(trace)
+        for trace_id in ids:
+            traces.extend(by_id[trace_id])
+
+    pos = 0
+    while pos < len(content):
+        length, pos = read_varint(content, pos)
+        end = pos + length
+        kind = content[pos]
+        rpos = pos + 1
+        if kind == RECORD_STRING:
+            string_id, rpos = read_varint(content, rpos)
+            strings[string_id], rpos = read_string(content, rpos)
+        elif kind == RECORD_TRACE:
+            flush_group()
+            group = []
+        elif kind == RECORD_TIMESTAMP:
+            trace_id, rpos = read_varint(content, rpos)
+            name_id, rpos = read_varint(content, rpos)
+            delta, rpos = read_signed_varint(content, rpos)
+            last_timestamp += delta
+            group.append(
+                {
+                    "id": trace_id,
+                    "timestamps": [{"name": strings[name_id], "ns": last_timestamp}],
+                }
+            )
+        elif kind == RECORD_REQUEST:
+            trace_id, rpos = read_varint(content, rpos)
+            model_name_id, rpos = read_varint(content, rpos)
+            model_version, rpos = read_signed_varint(content, rpos)
+            parent_id, rpos = read_varint(content, rpos)
+            request_id, rpos = read_string(content, rpos)
+            trace = {
+                "id": trace_id,
+                "model_name": strings[model_name_id],
+                "model_version": model_version,
+            }
+            if request_id:
+                trace["request_id"] = request_id
+            if parent_id != 0:
+                trace["parent_id"] = parent_id
+            group.append(trace)
+        elif kind == RECORD_TENSOR:
+            trace_id, rpos = read_varint(content, rpos)
+            tensor, rpos = read_string(content, rpos)
+            group.append(json.loads(tensor))
+        # Records of unknown kinds are skipped.
+        pos = end
+    flush_group()
+
+
+def read_binary_traces(data):
+    traces = []
+    pos = len(BINARY_TRACE_MAGIC)
+    while pos < len(data):
+        compression, raw_size, stored_size = BLOCK_HEADER.unpack_from(data, pos)
+        pos += BLOCK_HEADER.size
+        content = data[pos : pos + stored_size]
+        pos += stored_size
+        if compression == COMPRESSION_ZLIB:
+            content = zlib.decompress(content)
+        elif compression != COMPRESSION_NONE:
+            raise ValueError("unknown block compression {}".format(compression))
+        if len(content) != raw_size:
+            raise ValueError("truncated trace block")
+        decode_block(content, traces)
+    return traces
+
+
+def read_traces(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if data.startswith(BINARY_TRACE_MAGIC):
+        return read_binary_traces(data)
+    return json.loads(data)
+
+
+def to_chrome_events(traces):
+    """Return the Chrome trace events of 'traces'. Every model is shown as
+    a process and every trace as a thread of it, with a complete event
+    for every span and an instant event for the other timestamps."""
+    models = {}
+    timestamps = {}
+    for trace in traces:
+        trace_id = trace["id"]
+        if "model_name" in trace:
+            models[trace_id] = "{} ({})".format(
+                trace["model_name"], trace["model_version"]
+            )
+        for ts in trace.get("timestamps", []):
+            timestamps.setdefault(trace_id, {})[ts["name"]] = ts["ns"]
+
+    pids = {}
+    events = []
+    for trace_id in sorted(timestamps.keys()):
+        model = models.get(trace_id, "unknown")
+        if model not in pids:
+            pids[model] = len(pids) + 1
+            events.append(
+                {
+                    "name": "process_name",
+                    "ph": "M",
+                    "pid": pids[model],
+                    "args": {"name": model},
+                }
+            )
+        pid = pids[model]
+
+        names = timestamps[trace_id]
+        used = set()
+        spans = []
+        for name in names:
+            if name.endswith("_START"):
+                prefix = name[: -len("_START")]
+                if prefix + "_END" in names:
+                    spans.append((prefix, name, prefix + "_END"))
+        spans.extend(NAMED_SPANS)
+        for span_name, start, end in spans:
+            if start in names and end in names and names[end] >= names[start]:
+                events.append(
+                    {
+                        "name": span_name,
+                        "ph": "X",
+                        "pid": pid,
+                        "tid": trace_id,
+                        "ts": names[start] / 1000.0,
+                        "dur": (names[end] - names[start]) / 1000.0,
+                    }
+                )
+                used.update((start, end))
+        for name, ns in names.items():
+            if name not in used:
+                events.append(
+                    {
+                        "name": name,
+                        "ph": "i",
+                        "s": "t",
+                        "pid": pid,
+                        "tid": trace_id,
+                        "ts": ns / 1000.0,
+                    }
+                )
+    return events
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument(
+        "-f",
+        "--format",
+        choices=["chrome", "triton"],
+        default="chrome",
+        help="Output format, 'chrome' for Chrome trace events that "
+        + "chrome://tracing and the Perfetto UI load, 'triton' for the "
+        + "Triton JSON trace format.",
+    )
+    parser.add_argument(
+        "-o",
+        "--output",
+        type=str,
+        default=None,
+        help="Output file, standard output if not specified.",
+    )
+    parser.add_argument("file", type=str, nargs="+")
+    FLAGS = parser.parse_args()
+
+    traces = []
+    for path in FLAGS.file:
+        traces.extend(read_traces(path))
+
+    if FLAGS.format == "chrome":
+        result = {"traceEvents": to_chrome_events(traces), "displayTimeUnit": "ns"}
+    else:
+        result = traces
+
+    if FLAGS.output is None:
+        json.dump(result, sys.stdout)
+    else:
+        with open(FLAGS.output, "w") as f:
+            json.dump(result, f)
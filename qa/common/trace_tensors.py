@@ -0,0 +1,148 @@
+#!/usr/bin/python
+
+# Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# Reads the tensors of a Triton trace collected with
+# '--trace-config triton,tensor-format=binary'. The trace only holds the
+# dtype, the shape and the location of each tensor, the tensor data is
+# read from the tensor file written next to the trace file.
+
+import argparse
+import os
+import re
+import struct
+
+import numpy as np
+from trace_convert import read_traces
+
+FLAGS = None
+
+TRITON_TYPE_TO_NUMPY = {
+    "BOOL": np.bool_,
+    "UINT8": np.uint8,
+    "UINT16": np.uint16,
+    "UINT32": np.uint32,
+    "UINT64": np.uint64,
+    "INT8": np.int8,
+    "INT16": np.int16,
+    "INT32": np.int32,
+    "INT64": np.int64,
+    "FP16": np.float16,
+    "FP32": np.float32,
+    "FP64": np.float64,
+}
+
+
+def default_tensor_file(trace_file):
+    # Indexed trace files, 'file.N', share the tensor file of 'file'.
+    tensor_file = trace_file + ".tensors"
+    if not os.path.exists(tensor_file):
+        tensor_file = re.sub(r"\.[0-9]+$", "", trace_file) + ".tensors"
+    return tensor_file
+
+
+def to_numpy_array(tensor, data):
+    shape = [int(dim) for dim in tensor["shape"].split(",") if dim != ""]
+    dtype = tensor["dtype"]
+    if dtype == "BYTES":
+        # Each element is prefixed with its length as a 4-byte integer.
+        elements = []
+        pos = 0
+        while pos < len(data):
+            (length,) = struct.unpack_from("<I", data, pos)
+            pos += 4
+            elements.append(data[pos : pos + length])
+            pos += length
+        array = np.array(elements, dtype=np.object_)
+    elif dtype == "BF16":
+        # Numpy has no bfloat16, widen to float32.
+        array = np.frombuffer(data, dtype=np.uint16).astype(np.uint32) << 16
+        array = array.view(np.float32)
+    else:
+        array = np.frombuffer(data, dtype=TRITON_TYPE_TO_NUMPY[dtype])
+    return array.reshape(shape)
+
+
+def read_tensors(traces, tensor_file):
+    """Yield (trace, numpy array) of the tensors in 'traces', the array is
+    None if the tensor was dropped."""
+    with open(tensor_file, "rb") as f:
+        for trace in traces:
+            if "tensor" not in trace:
+                continue
+            tensor = trace["tensor"]
+            if "offset" not in tensor:
+                yield trace, None
+                continue
+            f.seek(tensor["offset"])
+            data = f.read(tensor["length"])
+            if len(data) != tensor["length"]:
+                raise Exception(
+                    "tensor file '{}' is truncated at offset {}".format(
+                        tensor_file, tensor["offset"]
+                    )
+                )
+            yield trace, to_numpy_array(tensor, data)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument(
+        "-t",
+        "--tensor-file",
+        type=str,
+        default=None,
+        help="The tensor file, 'file.tensors' of the first trace file "
+        + "if not specified.",
+    )
+    parser.add_argument(
+        "-o",
+        "--output-dir",
+        type=str,
+        default=None,
+        help="Save each tensor as '<id>_<activity>_<name>.npy' in the "
+        + "directory instead of printing the tensors.",
+    )
+    parser.add_argument("file", type=str, nargs="+")
+    FLAGS = parser.parse_args()
+
+    traces = []
+    for path in FLAGS.file:
+        traces.extend(read_traces(path))
+    tensor_file = FLAGS.tensor_file
+    if tensor_file is None:
+        tensor_file = default_tensor_file(FLAGS.file[0])
+
+    for trace, array in read_tensors(traces, tensor_file):
+        tensor = trace["tensor"]
+        label = "{}_{}_{}".format(trace["id"], trace["activity"], tensor["name"])
+        if array is None:
+            print("{}: dropped".format(label))
+        elif FLAGS.output_dir is not None:
+            np.save(os.path.join(FLAGS.output_dir, label + ".npy"), array)
+        else:
+            print("{}: {} {}\n{}".format(label, tensor["dtype"], array.shape, array))
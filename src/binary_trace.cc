@@ -0,0 +1,183 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "binary_trace.h"
+
+#include <zlib.h>
+
+#include <cstring>
+
+#include "triton/common/logging.h"
+
+namespace triton { namespace server {
+
+namespace {
+
+void
+PutVarint(std::string* buffer, uint64_t value)
+{
+  while (value >= 0x80) {
+    buffer->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  buffer->push_back(static_cast<char>(value));
+}
+
+void
+PutSignedVarint(std::string* buffer, const int64_t value)
+{
+  PutVarint(
+      buffer, (static_cast<uint64_t>(value) << 1) ^
+                  static_cast<uint64_t>(value >> 63));
+}
+
+void
+PutString(std::string* buffer, const char* str, const size_t length)
+{
+  PutVarint(buffer, length);
+  buffer->append(str, length);
+}
+
+void
+PutFixed(std::string* buffer, uint64_t value, const size_t byte_size)
+{
+  for (size_t i = 0; i < byte_size; ++i) {
+    buffer->push_back(static_cast<char>(value & 0xFF));
+    value >>= 8;
+  }
+}
+
+}  // namespace
+
+void
+BinaryTraceEncoder::AppendTrace(
+    const uint64_t group_id, const std::vector<TraceRecord>& records)
+{
+  std::string record;
+  record.push_back(TRACE);
+  PutVarint(&record, group_id);
+  AppendRecord(record);
+
+  for (const auto& trace_record : records) {
+    record.clear();
+    switch (trace_record.kind_) {
+      case TraceRecord::TIMESTAMP: {
+        const uint64_t name_id =
+            Intern(trace_record.name_, strlen(trace_record.name_));
+        record.push_back(TIMESTAMP);
+        PutVarint(&record, trace_record.trace_id_);
+        PutVarint(&record, name_id);
+        PutSignedVarint(
+            &record, static_cast<int64_t>(
+                         trace_record.value_ - last_timestamp_ns_));
+        last_timestamp_ns_ = trace_record.value_;
+        break;
+      }
+      case TraceRecord::REQUEST: {
+        const auto details =
+            reinterpret_cast<const std::string*>(trace_record.payload_);
+        const char* model_name = details->c_str();
+        const size_t model_name_length = strlen(model_name);
+        const uint64_t model_name_id = Intern(model_name, model_name_length);
+        record.push_back(REQUEST);
+        PutVarint(&record, trace_record.trace_id_);
+        PutVarint(&record, model_name_id);
+        PutSignedVarint(&record, trace_record.model_version_);
+        PutVarint(&record, trace_record.value_);
+        PutString(
+            &record, model_name + model_name_length + 1,
+            details->size() - model_name_length - 1);
+        break;
+      }
+      case TraceRecord::TENSOR: {
+        const auto tensor =
+            reinterpret_cast<const std::string*>(trace_record.payload_);
+        record.push_back(TENSOR);
+        PutVarint(&record, trace_record.trace_id_);
+        PutString(&record, tensor->data(), tensor->size());
+        break;
+      }
+      default:
+        continue;
+    }
+    AppendRecord(record);
+  }
+}
+
+std::string
+BinaryTraceEncoder::TakeBlock()
+{
+  std::string block;
+  Compression compression = NONE;
+  std::string compressed;
+  if (compress_) {
+    uLongf compressed_size = compressBound(content_.size());
+    compressed.resize(compressed_size);
+    if (compress2(
+            reinterpret_cast<Bytef*>(&compressed[0]), &compressed_size,
+            reinterpret_cast<const Bytef*>(content_.data()), content_.size(),
+            Z_DEFAULT_COMPRESSION) == Z_OK) {
+      compressed.resize(compressed_size);
+      compression = ZLIB;
+    } else {
+      LOG_ERROR << "failed to compress trace block, writing it uncompressed";
+    }
+  }
+
+  const std::string& data = (compression == ZLIB) ? compressed : content_;
+  PutFixed(&block, compression, sizeof(uint32_t));
+  PutFixed(&block, content_.size(), sizeof(uint64_t));
+  PutFixed(&block, data.size(), sizeof(uint64_t));
+  block.append(data);
+
+  content_.clear();
+  strings_.clear();
+  last_timestamp_ns_ = 0;
+  return block;
+}
+
+uint64_t
+BinaryTraceEncoder::Intern(const char* str, const size_t length)
+{
+  auto res = strings_.emplace(std::string(str, length), strings_.size());
+  if (res.second) {
+    std::string record;
+    record.push_back(STRING);
+    PutVarint(&record, res.first->second);
+    PutString(&record, str, length);
+    AppendRecord(record);
+  }
+  return res.first->second;
+}
+
+void
+BinaryTraceEncoder::AppendRecord(const std::string& record)
+{
+  PutVarint(&content_, record.size());
+  content_.append(record);
+}
+
+}}  // namespace triton::server
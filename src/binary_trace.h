@@ -0,0 +1,111 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "trace_writer.h"
+
+namespace triton { namespace server {
+
+//
+// BinaryTraceEncoder
+//
+// Encodes the traces of the Triton trace mode in the compact binary
+// format selected with '--trace-config triton,format=binary'.
+//
+// A binary trace file starts with the 8 bytes 'kBinaryTraceMagic'
+// followed by blocks. A block starts with a header of a little endian
+// uint32 compression (0 for none, 1 for zlib) and two little endian
+// uint64, the size of the block content once decompressed and the size
+// of the content that follows the header.
+//
+// The content of a block is a sequence of records, each prefixed by its
+// size. The first byte of a record is its kind. Integers are unsigned
+// LEB128 varints, signed integers are zigzag encoded first, and strings
+// are a varint size followed by the bytes.
+//
+//   STRING (1): string id, string. Interns the string for the rest of
+//     the block, the first string of a block has id 0.
+//   TRACE (2): group id. Starts the records of a trace and the traces
+//     spawned from it, which the JSON format writes next to each other.
+//   TIMESTAMP (3): trace id, name string id, signed difference in
+//     nanoseconds with the previous timestamp of the block.
+//   REQUEST (4): trace id, model name string id, signed model version,
+//     parent trace id, request id string.
+//   TENSOR (5): trace id, the tensor JSON object of the JSON format.
+//
+// Every block is self-contained, the interned strings and the timestamp
+// base are reset at the start of a block. Readers skip the records of
+// unknown kinds.
+//
+class BinaryTraceEncoder {
+ public:
+  enum RecordKind : uint8_t {
+    STRING = 1,
+    TRACE = 2,
+    TIMESTAMP = 3,
+    REQUEST = 4,
+    TENSOR = 5
+  };
+
+  enum Compression : uint32_t { NONE = 0, ZLIB = 1 };
+
+  explicit BinaryTraceEncoder(const bool compress)
+      : compress_(compress), last_timestamp_ns_(0)
+  {
+  }
+
+  // Append the records of the trace group 'group_id'. The END record of
+  // the group is not encoded.
+  void AppendTrace(
+      const uint64_t group_id, const std::vector<TraceRecord>& records);
+
+  bool Empty() const { return content_.empty(); }
+
+  // Return the block holding the traces appended since the last call,
+  // and start a new block.
+  std::string TakeBlock();
+
+ private:
+  // Return the id of 'str', interning it with a STRING record if it is
+  // not interned yet.
+  uint64_t Intern(const char* str, const size_t length);
+  void AppendRecord(const std::string& record);
+
+  const bool compress_;
+  std::string content_;
+  std::unordered_map<std::string, uint64_t> strings_;
+  uint64_t last_timestamp_ns_;
+};
+
+constexpr char kBinaryTraceMagic[] = "TRTNTRC1";
+constexpr size_t kBinaryTraceMagicSize = sizeof(kBinaryTraceMagic) - 1;
+
+}}  // namespace triton::server
@@ -290,6 +290,9 @@ enum TritonOptionId {
   OPTION_REUSE_HTTP_PORT,
   OPTION_HTTP_ADDRESS,
   OPTION_HTTP_THREAD_COUNT,
+  OPTION_HTTP_GENERATE_RESPONSE_BUFFER_BYTES,
+  OPTION_HTTP_GENERATE_RESPONSE_BUFFER_COUNT,
+  OPTION_HTTP_STAGE_METRICS,
 #endif  // TRITON_ENABLE_HTTP
 #if defined(TRITON_ENABLE_GRPC)
   OPTION_ALLOW_GRPC,
@@ -298,6 +301,13 @@ enum TritonOptionId {
   OPTION_GRPC_ADDRESS,
   OPTION_GRPC_HEADER_FORWARD_PATTERN,
   OPTION_GRPC_INFER_ALLOCATION_POOL_SIZE,
+  OPTION_GRPC_STREAM_WRITE_COALESCING,
+  OPTION_GRPC_STREAM_WRITE_COALESCING_DELAY,
+  OPTION_GRPC_STREAM_RESPONSE_BUFFER_BYTES,
+  OPTION_GRPC_STREAM_RESPONSE_BUFFER_COUNT,
+  OPTION_GRPC_INFER_CHUNKED_MAX_INPUT_BYTES,
+  OPTION_GRPC_TRANSPORT_METRICS,
+  OPTION_GRPC_STAGE_METRICS,
   OPTION_GRPC_USE_SSL,
   OPTION_GRPC_USE_SSL_MUTUAL,
   OPTION_GRPC_SERVER_CERT,
@@ -353,10 +363,19 @@ enum TritonOptionId {
   OPTION_CACHE_DIR,
   OPTION_MIN_SUPPORTED_COMPUTE_CAPABILITY,
   OPTION_EXIT_TIMEOUT_SECS,
+  OPTION_LOAD_REPORTING,
+  OPTION_LOAD_REPORT_INTERVAL_MS,
+  OPTION_INFER_REQUEST_POOL_SIZE,
+  OPTION_ALLOW_SHARED_MEMORY_RING,
+  OPTION_SHARED_MEMORY_RING_POLL_US,
+  OPTION_SHARED_MEMORY_SOCKET,
+  OPTION_SHARED_MEMORY_HUGETLBFS_DIR,
   OPTION_BACKEND_DIR,
   OPTION_REPOAGENT_DIR,
   OPTION_BUFFER_MANAGER_THREAD_COUNT,
   OPTION_MODEL_LOAD_THREAD_COUNT,
+  OPTION_CONTROL_PLANE_THREAD_COUNT,
+  OPTION_CONTROL_PLANE_QUEUE_SIZE,
   OPTION_BACKEND_CONFIG,
   OPTION_HOST_POLICY,
   OPTION_MODEL_LOAD_GPU_LIMIT,
@@ -376,6 +395,53 @@ TritonParser::SetupOptions()
        "Timeout (in seconds) when exiting to wait for in-flight inferences to "
        "finish. After the timeout expires the server exits even if inferences "
        "are still in flight."});
+  server_options_.push_back(
+      {OPTION_LOAD_REPORTING, "load-reporting", Option::ArgBool,
+       "Report the load of the server to load balancers: in the "
+       "'endpoint-load-metrics' header of HTTP inference responses and the "
+       "'/v2/load' endpoint, and in the 'endpoint-load-metrics-bin' "
+       "trailing metadata of GRPC inference responses and the ORCA "
+       "'OpenRcaService' service. Default is false."});
+  server_options_.push_back(
+      {OPTION_LOAD_REPORT_INTERVAL_MS, "load-report-interval-ms",
+       Option::ArgInt,
+       "The interval, in milliseconds, at which the load of the server is "
+       "sampled when --load-reporting is true. Default is 1000."});
+  server_options_.push_back(
+      {OPTION_INFER_REQUEST_POOL_SIZE, "infer-request-pool-size",
+       Option::ArgInt,
+       "The maximum number of idle inference request objects the HTTP and "
+       "GRPC endpoints keep for reuse for each model version. Reusing the "
+       "request objects reduces the per-request overhead of models with a "
+       "fixed signature. Default is 0 which disables the reuse."});
+  server_options_.push_back(
+      {OPTION_ALLOW_SHARED_MEMORY_RING, "allow-shared-memory-ring",
+       Option::ArgBool,
+       "Allow same-host clients to attach shared memory rings to the server "
+       "with the '/v2/sharedmemoryring' HTTP endpoint and submit inferences "
+       "through them. Default is false."});
+  server_options_.push_back(
+      {OPTION_SHARED_MEMORY_RING_POLL_US, "shared-memory-ring-poll-us",
+       Option::ArgInt,
+       "The time, in microseconds, a shared memory ring is polled after the "
+       "last submission before the server waits for the client to wake it "
+       "up. Polling lowers the latency of back to back inferences at the "
+       "cost of a busy CPU core per ring. Default is 50."});
+  server_options_.push_back(
+      {OPTION_SHARED_MEMORY_SOCKET, "shared-memory-socket", Option::ArgStr,
+       "The path of a Unix domain socket on which same-host clients can "
+       "register system shared memory by passing a file descriptor, for "
+       "example of a memfd. Regions registered through a connection are "
+       "unregistered when it closes. Access is controlled by the "
+       "permissions of the socket file. Default is empty which disables "
+       "the socket."});
+  server_options_.push_back(
+      {OPTION_SHARED_MEMORY_HUGETLBFS_DIR, "shared-memory-hugetlbfs-dir",
+       Option::ArgStr,
+       "A directory on a hugetlbfs mount whose files clients may register "
+       "as system shared memory by passing their path as the key. To allow "
+       "multiple directories, use the option multiple times. Default is "
+       "none, keys that are paths are rejected."});
 
   model_repo_options_.push_back(
       {OPTION_MODEL_REPOSITORY, "model-store", Option::ArgStr,
@@ -433,6 +499,20 @@ TritonParser::SetupOptions()
        Option::ArgInt,
        "The number of threads used to concurrently load models in "
        "model repositories. Default is 4."});
+  model_repo_options_.push_back(
+      {OPTION_CONTROL_PLANE_THREAD_COUNT, "control-plane-thread-count",
+       Option::ArgInt,
+       "The number of threads used by the HTTP and GRPC endpoints to handle "
+       "control-plane requests, such as model load / unload, model "
+       "statistics and shared memory registration, apart from the "
+       "inference threads. Default is 2."});
+  model_repo_options_.push_back(
+      {OPTION_CONTROL_PLANE_QUEUE_SIZE, "control-plane-queue-size",
+       Option::ArgInt,
+       "The maximum number of control-plane requests waiting for a thread. "
+       "Requests beyond the limit are rejected with an 'unavailable' error "
+       "so that the client can retry later. 0 means no limit. Default is "
+       "64."});
   model_repo_options_.push_back(
       {OPTION_MODEL_NAMESPACING, "model-namespacing", Option::ArgBool,
        "Whether model namespacing is enable or not. If true, models with the "
@@ -463,6 +543,25 @@ TritonParser::SetupOptions()
   http_options_.push_back(
       {OPTION_HTTP_THREAD_COUNT, "http-thread-count", Option::ArgInt,
        "Number of threads handling HTTP requests."});
+  http_options_.push_back(
+      {OPTION_HTTP_GENERATE_RESPONSE_BUFFER_BYTES,
+       "http-generate-response-buffer-bytes", Option::ArgInt,
+       "The maximum number of bytes of responses that a generate_stream "
+       "request may buffer while the client reads slower than the model "
+       "produces. Once exceeded, an error event is sent and the remaining "
+       "responses of the request are dropped. Default is 0, unlimited."});
+  http_options_.push_back(
+      {OPTION_HTTP_GENERATE_RESPONSE_BUFFER_COUNT,
+       "http-generate-response-buffer-count", Option::ArgInt,
+       "The maximum number of responses that a generate_stream request may "
+       "buffer, see --http-generate-response-buffer-bytes. Default is 0, "
+       "unlimited."});
+  http_options_.push_back(
+      {OPTION_HTTP_STAGE_METRICS, "http-stage-metrics", Option::ArgBool,
+       "Report histograms of the time spent in every frontend stage of the "
+       "HTTP inference requests, and of the CPU time spent on them by the "
+       "frontend, per model on the metrics endpoint. Requires a server "
+       "built with tracing support. Default is false."});
 #endif  // TRITON_ENABLE_HTTP
 
 #if defined(TRITON_ENABLE_GRPC)
@@ -494,6 +593,52 @@ TritonParser::SetupOptions()
        "allocated for reuse. As long as the number of in-flight requests "
        "doesn't exceed this value there will be no allocation/deallocation of "
        "request/response objects."});
+  grpc_options_.push_back(
+      {OPTION_GRPC_STREAM_WRITE_COALESCING, "grpc-stream-write-coalescing",
+       Option::ArgBool,
+       "Coalesce the responses of decoupled models that are ready at the "
+       "same time on a GRPC stream into a single transport write instead "
+       "of flushing every response separately. Default is false."});
+  grpc_options_.push_back(
+      {OPTION_GRPC_STREAM_WRITE_COALESCING_DELAY,
+       "grpc-stream-write-coalescing-delay-us", Option::ArgInt,
+       "The maximum time, in microseconds, that a single ready response is "
+       "held back waiting for more responses to coalesce with when "
+       "--grpc-stream-write-coalescing is enabled. Default is 0, responses "
+       "are only coalesced if they are already ready."});
+  grpc_options_.push_back(
+      {OPTION_GRPC_STREAM_RESPONSE_BUFFER_BYTES,
+       "grpc-stream-response-buffer-bytes", Option::ArgInt,
+       "The maximum number of bytes of decoupled model responses that a GRPC "
+       "stream may buffer while the client reads slower than the model "
+       "produces. Once exceeded, no new requests are read from the stream "
+       "until enough responses are written. Default is 0, unlimited."});
+  grpc_options_.push_back(
+      {OPTION_GRPC_STREAM_RESPONSE_BUFFER_COUNT,
+       "grpc-stream-response-buffer-count", Option::ArgInt,
+       "The maximum number of decoupled model responses that a GRPC stream "
+       "may buffer, see --grpc-stream-response-buffer-bytes. Default is 0, "
+       "unlimited."});
+  grpc_options_.push_back(
+      {OPTION_GRPC_INFER_CHUNKED_MAX_INPUT_BYTES,
+       "grpc-infer-chunked-max-input-bytes", Option::ArgInt,
+       "The maximum total byte size of the inputs of a ModelInferChunked "
+       "request. The input buffer is allocated when the request header is "
+       "read, requests whose header describes larger inputs are rejected. "
+       "Default is 8589934592 (8 GB)."});
+  grpc_options_.push_back(
+      {OPTION_GRPC_TRANSPORT_METRICS, "grpc-transport-metrics",
+       Option::ArgBool,
+       "Report transport-level metrics of the GRPC methods on the metrics "
+       "endpoint: calls, streams, messages and bytes of every method, and "
+       "the time spent queued, parsing, serializing and waiting to write "
+       "by the inference methods. Default is false."});
+  grpc_options_.push_back(
+      {OPTION_GRPC_STAGE_METRICS, "grpc-stage-metrics", Option::ArgBool,
+       "Report histograms of the time spent in every frontend stage of the "
+       "GRPC inference requests, and of the CPU time spent on them by the "
+       "frontend, per model on the metrics endpoint. Requires a server "
+       "built with tracing support. Default is false."});
   grpc_options_.push_back(
       {OPTION_GRPC_USE_SSL, "grpc-use-ssl", Option::ArgBool,
        "Use SSL authentication for GRPC requests. Default is false."});
@@ -1288,6 +1433,25 @@ TritonParser::Parse(int argc, char** argv)
         case OPTION_HTTP_THREAD_COUNT:
           lparams.http_thread_cnt_ = ParseOption<int>(optarg);
           break;
+        case OPTION_HTTP_GENERATE_RESPONSE_BUFFER_BYTES:
+          lparams.http_generate_response_buffer_bytes_ =
+              ParseOption<int64_t>(optarg);
+          if (lparams.http_generate_response_buffer_bytes_ < 0) {
+            throw ParseException(
+                "--http-generate-response-buffer-bytes must not be negative");
+          }
+          break;
+        case OPTION_HTTP_GENERATE_RESPONSE_BUFFER_COUNT:
+          lparams.http_generate_response_buffer_count_ =
+              ParseOption<int>(optarg);
+          if (lparams.http_generate_response_buffer_count_ < 0) {
+            throw ParseException(
+                "--http-generate-response-buffer-count must not be negative");
+          }
+          break;
+        case OPTION_HTTP_STAGE_METRICS:
+          lparams.http_stage_metrics_ = ParseOption<bool>(optarg);
+          break;
 #endif  // TRITON_ENABLE_HTTP
 
 #ifdef TRITON_ENABLE_SAGEMAKER
@@ -1338,6 +1502,43 @@ TritonParser::Parse(int argc, char** argv)
         case OPTION_GRPC_INFER_ALLOCATION_POOL_SIZE:
           lgrpc_options.infer_allocation_pool_size_ = ParseOption<int>(optarg);
           break;
+        case OPTION_GRPC_STREAM_WRITE_COALESCING:
+          lgrpc_options.stream_write_coalescing_ = ParseOption<bool>(optarg);
+          break;
+        case OPTION_GRPC_STREAM_WRITE_COALESCING_DELAY:
+          lgrpc_options.stream_write_coalescing_delay_us_ =
+              ParseOption<int>(optarg);
+          break;
+        case OPTION_GRPC_STREAM_RESPONSE_BUFFER_BYTES:
+          lgrpc_options.stream_response_buffer_bytes_ =
+              ParseOption<int64_t>(optarg);
+          if (lgrpc_options.stream_response_buffer_bytes_ < 0) {
+            throw ParseException(
+                "--grpc-stream-response-buffer-bytes must not be negative");
+          }
+          break;
+        case OPTION_GRPC_STREAM_RESPONSE_BUFFER_COUNT:
+          lgrpc_options.stream_response_buffer_count_ =
+              ParseOption<int>(optarg);
+          if (lgrpc_options.stream_response_buffer_count_ < 0) {
+            throw ParseException(
+                "--grpc-stream-response-buffer-count must not be negative");
+          }
+          break;
+        case OPTION_GRPC_INFER_CHUNKED_MAX_INPUT_BYTES:
+          lgrpc_options.infer_chunked_max_input_bytes_ =
+              ParseOption<int64_t>(optarg);
+          if (lgrpc_options.infer_chunked_max_input_bytes_ <= 0) {
+            throw ParseException(
+                "--grpc-infer-chunked-max-input-bytes must be positive");
+          }
+          break;
+        case OPTION_GRPC_TRANSPORT_METRICS:
+          lgrpc_options.transport_metrics_ = ParseOption<bool>(optarg);
+          break;
+        case OPTION_GRPC_STAGE_METRICS:
+          lgrpc_options.stage_metrics_ = ParseOption<bool>(optarg);
+          break;
         case OPTION_GRPC_USE_SSL:
           lgrpc_options.ssl_.use_ssl_ = ParseOption<bool>(optarg);
           break;
@@ -1590,6 +1791,45 @@ TritonParser::Parse(int argc, char** argv)
         case OPTION_EXIT_TIMEOUT_SECS:
           lparams.exit_timeout_secs_ = ParseOption<int>(optarg);
           break;
+        case OPTION_LOAD_REPORTING:
+          lparams.load_reporting_ = ParseOption<bool>(optarg);
+          break;
+        case OPTION_LOAD_REPORT_INTERVAL_MS: {
+          int interval_ms = ParseOption<int>(optarg);
+          if (interval_ms < 1) {
+            throw ParseException(
+                "--load-report-interval-ms must be at least 1");
+          }
+          lparams.load_report_interval_ms_ = interval_ms;
+          break;
+        }
+        case OPTION_INFER_REQUEST_POOL_SIZE: {
+          int pool_size = ParseOption<int>(optarg);
+          if (pool_size < 0) {
+            throw ParseException(
+                "--infer-request-pool-size must be non-negative");
+          }
+          lparams.infer_request_pool_size_ = pool_size;
+          break;
+        }
+        case OPTION_ALLOW_SHARED_MEMORY_RING:
+          lparams.allow_shared_memory_ring_ = ParseOption<bool>(optarg);
+          break;
+        case OPTION_SHARED_MEMORY_RING_POLL_US: {
+          int poll_us = ParseOption<int>(optarg);
+          if (poll_us < 0) {
+            throw ParseException(
+                "--shared-memory-ring-poll-us must be non-negative");
+          }
+          lparams.shared_memory_ring_poll_us_ = poll_us;
+          break;
+        }
+        case OPTION_SHARED_MEMORY_SOCKET:
+          lparams.shared_memory_socket_ = optarg;
+          break;
+        case OPTION_SHARED_MEMORY_HUGETLBFS_DIR:
+          lparams.shared_memory_hugetlbfs_dirs_.push_back(optarg);
+          break;
         case OPTION_BACKEND_DIR:
           lparams.backend_dir_ = optarg;
           break;
@@ -1602,6 +1842,24 @@ TritonParser::Parse(int argc, char** argv)
         case OPTION_MODEL_LOAD_THREAD_COUNT:
           lparams.model_load_thread_count_ = ParseOption<int>(optarg);
           break;
+        case OPTION_CONTROL_PLANE_THREAD_COUNT: {
+          int count = ParseOption<int>(optarg);
+          if (count < 1) {
+            throw ParseException(
+                "--control-plane-thread-count must be at least 1");
+          }
+          lparams.control_plane_thread_count_ = count;
+          break;
+        }
+        case OPTION_CONTROL_PLANE_QUEUE_SIZE: {
+          int size = ParseOption<int>(optarg);
+          if (size < 0) {
+            throw ParseException(
+                "--control-plane-queue-size must be non-negative");
+          }
+          lparams.control_plane_queue_size_ = size;
+          break;
+        }
         case OPTION_BACKEND_CONFIG:
           lparams.backend_config_settings_.push_back(
               ParseBackendConfigOption(optarg));
@@ -2059,7 +2317,7 @@ TritonParser::SetGlobalTraceArgs(
     bool trace_rate_present, bool trace_count_present,
     bool explicit_disable_trace)
 {
-  for (const auto& global_setting : lparams.trace_config_map_[""]) {
+  for (auto& global_setting : lparams.trace_config_map_[""]) {
     try {
       if (global_setting.first == "rate") {
         if (trace_rate_present) {
@@ -2092,6 +2350,37 @@ TritonParser::SetGlobalTraceArgs(
         }
         lparams.trace_count_ = ParseOption<int>(global_setting.second);
       }
+      // The tail sampling settings are only validated here, the trace
+      // manager reads the values from the trace config map.
+      if ((global_setting.first == "tail-latency-us") ||
+          (global_setting.first == "tail-queue-latency-us") ||
+          (global_setting.first == "tail-compute-latency-us")) {
+        if (ParseOption<int64_t>(global_setting.second) < 0) {
+          throw ParseException(global_setting.first + " must be non-negative");
+        }
+      }
+      if (global_setting.first == "tail-percentile") {
+        const double percentile = ParseOption<double>(global_setting.second);
+        if ((percentile <= 0) || (percentile >= 100)) {
+          throw ParseException("tail-percentile must be between 0 and 100");
+        }
+      }
+      if (global_setting.first == "tail-max-per-second") {
+        if (ParseOption<int>(global_setting.second) < 0) {
+          throw ParseException("tail-max-per-second must be non-negative");
+        }
+      }
+      if (global_setting.first == "recorder-size") {
+        if (ParseOption<int>(global_setting.second) < 0) {
+          throw ParseException("recorder-size must be non-negative");
+        }
+      }
+      // Normalized so that the trace manager only needs to compare
+      // against "true".
+      if (global_setting.first == "server-timing") {
+        global_setting.second =
+            ParseOption<bool>(global_setting.second) ? "true" : "false";
+      }
     }
     catch (const ParseException& pe) {
       std::stringstream ss;
@@ -2124,6 +2413,35 @@ TritonParser::SetTritonTraceArgs(
                     << std::endl;
         }
         lparams.trace_log_frequency_ = ParseOption<int>(mode_setting.second);
+      } else if (mode_setting.first == "queue-size") {
+        // Only validated here, the trace manager reads the value from
+        // the trace config map.
+        if (ParseOption<int>(mode_setting.second) <= 0) {
+          throw ParseException("queue-size must be positive");
+        }
+      } else if (mode_setting.first == "format") {
+        if ((mode_setting.second != "json") &&
+            (mode_setting.second != "binary")) {
+          throw ParseException("format must be 'json' or 'binary'");
+        }
+      } else if (mode_setting.first == "compression") {
+        if ((mode_setting.second != "none") &&
+            (mode_setting.second != "zlib")) {
+          throw ParseException("compression must be 'none' or 'zlib'");
+        }
+      } else if (mode_setting.first == "tensor-format") {
+        if ((mode_setting.second != "json") &&
+            (mode_setting.second != "binary")) {
+          throw ParseException("tensor-format must be 'json' or 'binary'");
+        }
+      } else if (mode_setting.first == "tensor-max-pending-bytes") {
+        if (ParseOption<int64_t>(mode_setting.second) <= 0) {
+          throw ParseException("tensor-max-pending-bytes must be positive");
+        }
+      } else if (mode_setting.first == "tensor-segment-size") {
+        if (ParseOption<int64_t>(mode_setting.second) < 0) {
+          throw ParseException("tensor-segment-size must be non-negative");
+        }
       }
     }
     catch (const ParseException& pe) {
@@ -2138,7 +2456,8 @@ TritonParser::SetTritonTraceArgs(
 
 void
 TritonParser::VerifyOpentelemetryTraceArgs(
-    bool trace_filepath_present, bool trace_log_frequency_present)
+    TritonServerParameters& lparams, bool trace_filepath_present,
+    bool trace_log_frequency_present)
 {
   if (trace_filepath_present) {
     std::cerr << "Warning: '--trace-file' is deprecated and will "
@@ -2150,6 +2469,33 @@ TritonParser::VerifyOpentelemetryTraceArgs(
                  "and will be ignored with opentelemetry tracing mode."
               << std::endl;
   }
+
+  // The span processor settings are only validated here, the trace
+  // manager reads the values from the trace config map.
+  for (const auto& mode_setting :
+       lparams.trace_config_map_[std::to_string(TRACE_MODE_OPENTELEMETRY)]) {
+    try {
+      if ((mode_setting.first == "bsp-max-queue-size") ||
+          (mode_setting.first == "bsp-max-export-batch-size")) {
+        if (ParseOption<int>(mode_setting.second) <= 0) {
+          throw ParseException(mode_setting.first + " must be positive");
+        }
+      } else if (
+          (mode_setting.first == "bsp-schedule-delay") ||
+          (mode_setting.first == "export-timeout")) {
+        if (ParseOption<int>(mode_setting.second) < 0) {
+          throw ParseException(mode_setting.first + " must be non-negative");
+        }
+      }
+    }
+    catch (const ParseException& pe) {
+      std::stringstream ss;
+      ss << "Bad option: \"--trace-config opentelemetry,"
+         << mode_setting.first << "\".\n"
+         << pe.what() << std::endl;
+      throw ParseException(ss.str());
+    }
+  }
 }
 
 void
@@ -2165,7 +2511,7 @@ TritonParser::PostProcessTraceArgs(
 
   if (lparams.trace_mode_ == TRACE_MODE_OPENTELEMETRY) {
     VerifyOpentelemetryTraceArgs(
-        trace_filepath_present, trace_log_frequency_present);
+        lparams, trace_filepath_present, trace_log_frequency_present);
   } else if (lparams.trace_mode_ == TRACE_MODE_TRITON) {
     SetTritonTraceArgs(
         lparams, trace_filepath_present, trace_log_frequency_present);
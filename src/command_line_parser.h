@@ -112,6 +112,23 @@ struct TritonServerParameters {
   bool strict_model_config_{false};
   bool strict_readiness_{true};
   int32_t exit_timeout_secs_{30};
+  // Whether the endpoints report the load of the server, and the
+  // interval at which the load is sampled.
+  bool load_reporting_{false};
+  uint32_t load_report_interval_ms_{1000};
+  // The maximum number of idle inference requests kept for reuse for
+  // each model version, 0 to disable the reuse.
+  uint32_t infer_request_pool_size_{0};
+  // Whether clients may attach shared memory rings, and for how long
+  // a ring is polled after the last submission.
+  bool allow_shared_memory_ring_{false};
+  uint32_t shared_memory_ring_poll_us_{50};
+  // The Unix socket on which clients register shared memory by
+  // descriptor, empty to disable.
+  std::string shared_memory_socket_;
+  // The directories whose hugetlbfs files clients may register as
+  // shared memory by path.
+  std::vector<std::string> shared_memory_hugetlbfs_dirs_;
 #ifdef TRITON_ENABLE_GPU
   double min_supported_compute_capability_{TRITON_MIN_COMPUTE_CAPABILITY};
 #else
@@ -131,6 +148,10 @@ struct TritonServerParameters {
   int32_t repository_poll_secs_{15};
   // Number of threads to use for concurrently loading models
   uint32_t model_load_thread_count_{4};
+  // Number of threads, and the maximum number of waiting requests, of the
+  // executor handling the control-plane requests of the endpoints.
+  uint32_t control_plane_thread_count_{2};
+  uint32_t control_plane_queue_size_{64};
   std::map<int, double> load_gpu_limit_;
 
   // Rate limiter configuration
@@ -189,6 +210,13 @@ struct TritonServerParameters {
   std::string http_forward_header_pattern_;
   // The number of threads to initialize for the HTTP front-end.
   int http_thread_cnt_{8};
+  // The maximum bytes and number of responses a generate_stream
+  // request may buffer, 0 for unlimited.
+  int64_t http_generate_response_buffer_bytes_{0};
+  int http_generate_response_buffer_count_{0};
+  // Whether the latency of the frontend stages of the inference requests
+  // is reported on the metrics endpoint.
+  bool http_stage_metrics_{false};
 #endif  // TRITON_ENABLE_HTTP
 
 #ifdef TRITON_ENABLE_GRPC
@@ -297,7 +325,8 @@ class TritonParser {
       TritonServerParameters& lparams, bool trace_filepath_present,
       bool trace_log_frequency_present);
   void VerifyOpentelemetryTraceArgs(
-      bool trace_filepath_present, bool trace_log_frequency_present);
+      TritonServerParameters& lparams, bool trace_filepath_present,
+      bool trace_log_frequency_present);
   void PostProcessTraceArgs(
       TritonServerParameters& lparams, bool trace_level_present,
       bool trace_rate_present, bool trace_count_present,
@@ -40,6 +40,8 @@ constexpr char kAcceptEncodingHTTPHeader[] = "Accept-Encoding";
 constexpr char kContentEncodingHTTPHeader[] = "Content-Encoding";
 constexpr char kContentTypeHeader[] = "Content-Type";
 constexpr char kContentLengthHeader[] = "Content-Length";
+constexpr char kEndpointLoadMetricsHeader[] = "endpoint-load-metrics";
+constexpr char kServerTimingHeader[] = "server-timing";
 
 constexpr int MAX_GRPC_MESSAGE_SIZE = INT32_MAX;
 
@@ -0,0 +1,116 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "control_plane_executor.h"
+
+#include <algorithm>
+#include <string>
+
+#include "triton/common/logging.h"
+
+namespace triton { namespace server {
+
+ControlPlaneExecutor::ControlPlaneExecutor(
+    const size_t thread_count, const size_t max_queue_size)
+    : max_queue_size_(max_queue_size), exiting_(false)
+{
+  const size_t worker_count = std::max(thread_count, (size_t)1);
+  for (size_t i = 0; i < worker_count; ++i) {
+    workers_.emplace_back(&ControlPlaneExecutor::WorkerLoop, this);
+  }
+  LOG_VERBOSE(1) << "Started control-plane executor with " << worker_count
+                 << " threads";
+}
+
+ControlPlaneExecutor::~ControlPlaneExecutor()
+{
+  Stop();
+}
+
+void
+ControlPlaneExecutor::Stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    exiting_ = true;
+  }
+  cv_.notify_all();
+
+  for (auto& worker : workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+}
+
+TRITONSERVER_Error*
+ControlPlaneExecutor::Submit(std::function<void()>&& task)
+{
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (exiting_) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_UNAVAILABLE,
+          "control-plane executor is stopped, the server is shutting down");
+    }
+    if ((max_queue_size_ != 0) && (tasks_.size() >= max_queue_size_)) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_UNAVAILABLE,
+          std::string(
+              "control-plane queue is full, " +
+              std::to_string(max_queue_size_) +
+              " operations are waiting, retry later")
+              .c_str());
+    }
+    tasks_.emplace_back(std::move(task));
+  }
+  cv_.notify_one();
+
+  return nullptr;  // success
+}
+
+void
+ControlPlaneExecutor::WorkerLoop()
+{
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      cv_.wait(lock, [this] { return exiting_ || !tasks_.empty(); });
+
+      // Queued operations are still completed on exit as each of them
+      // owes a response to a client.
+      if (tasks_.empty()) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+
+    task();
+  }
+}
+
+}}  // namespace triton::server
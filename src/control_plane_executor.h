@@ -0,0 +1,86 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "triton/core/tritonserver.h"
+
+namespace triton { namespace server {
+
+//
+// ControlPlaneExecutor
+//
+// A bounded pool of worker threads, shared by the frontends, that runs
+// control-plane operations that may take a long time, such as model
+// loading. This keeps the threads of the frontends available to serve
+// inference and health requests while those operations are in
+// progress.
+//
+class ControlPlaneExecutor {
+ public:
+  /// Create an executor.
+  /// \param thread_count The number of worker threads, at least one
+  /// worker is always created.
+  /// \param max_queue_size The maximum number of operations that can
+  /// wait for a worker, 0 for no limit.
+  ControlPlaneExecutor(const size_t thread_count, const size_t max_queue_size);
+
+  /// Waits for all queued operations to complete.
+  ~ControlPlaneExecutor();
+
+  /// Stop accepting operations and wait for the queued and running
+  /// ones to complete. The operations refer to the frontends that
+  /// submitted them, so the executor must be stopped before those are
+  /// destroyed. Can be called more than once.
+  void Stop();
+
+  /// Queue an operation to be run by a worker thread. The operation is
+  /// responsible for delivering its own result.
+  /// \param task The operation.
+  /// \return a TRITONSERVER_ERROR_UNAVAILABLE error, without running the
+  /// operation, if the queue is full or the executor is stopped.
+  TRITONSERVER_Error* Submit(std::function<void()>&& task);
+
+ private:
+  void WorkerLoop();
+
+  const size_t max_queue_size_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  bool exiting_;
+
+  std::vector<std::thread> workers_;
+};
+
+}}  // namespace triton::server
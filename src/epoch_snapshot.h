@@ -0,0 +1,139 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace triton { namespace server {
+
+//
+// An immutable snapshot of type 'T' that is read without locking and
+// without touching a reference count, as the shared memory manager
+// does for its table of blocks.
+//
+// A reader announces itself in the reader slot of its thread, for the
+// parity of the epoch it starts in. Publish() replaces the snapshot,
+// advances the epoch and waits for the readers of the previous epoch to
+// leave before deleting the previous snapshot. The slots are padded so
+// that readers on different threads don't share a cache line.
+//
+template <typename T>
+class EpochSnapshot {
+ public:
+  explicit EpochSnapshot(std::unique_ptr<T>&& snapshot)
+      : snapshot_(snapshot.release()), epoch_(0)
+  {
+    for (auto& slot : reader_slots_) {
+      slot.readers_[0] = 0;
+      slot.readers_[1] = 0;
+    }
+  }
+
+  ~EpochSnapshot() { delete snapshot_.load(); }
+
+  EpochSnapshot(const EpochSnapshot&) = delete;
+  EpochSnapshot& operator=(const EpochSnapshot&) = delete;
+
+  // Call 'fn' with the current snapshot and return its result. The
+  // snapshot must not be used once 'fn' returns.
+  template <typename Fn>
+  auto Read(Fn&& fn) const -> decltype(fn(std::declval<const T&>()))
+  {
+    Reader reader(this);
+    return fn(*snapshot_.load());
+  }
+
+  // Replace the snapshot with 'snapshot' and delete the previous one
+  // once no reader uses it. The callers must be serialized.
+  void Publish(std::unique_ptr<T>&& snapshot)
+  {
+    std::unique_ptr<T> previous(snapshot_.exchange(snapshot.release()));
+
+    // Readers that entered the previous epoch may still use the previous
+    // snapshot, the readers entering from now on see the new one.
+    const uint64_t epoch = epoch_.fetch_add(1);
+    for (auto& slot : reader_slots_) {
+      while (slot.readers_[epoch & 1].load() != 0) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+ private:
+  static constexpr size_t kReaderSlotCount = 64;
+  struct alignas(64) ReaderSlot {
+    std::atomic<uint64_t> readers_[2];
+  };
+
+  // Enter the current epoch on construction, retrying if a writer
+  // advanced it before the reader was visible, and leave it on
+  // destruction.
+  class Reader {
+   public:
+    explicit Reader(const EpochSnapshot* owner)
+        : slot_(owner->reader_slots_[SlotIndex()]),
+          epoch_(owner->epoch_.load())
+    {
+      while (true) {
+        slot_.readers_[epoch_ & 1].fetch_add(1);
+        const uint64_t current = owner->epoch_.load();
+        if (current == epoch_) {
+          break;
+        }
+        slot_.readers_[epoch_ & 1].fetch_sub(1);
+        epoch_ = current;
+      }
+    }
+
+    ~Reader() { slot_.readers_[epoch_ & 1].fetch_sub(1); }
+
+   private:
+    ReaderSlot& slot_;
+    uint64_t epoch_;
+  };
+
+  // The reader slot of the calling thread.
+  static size_t SlotIndex()
+  {
+    static std::atomic<size_t> next_slot{0};
+    thread_local const size_t slot = next_slot.fetch_add(1);
+    return slot % kReaderSlotCount;
+  }
+
+  std::atomic<T*> snapshot_;
+  std::atomic<uint64_t> epoch_;
+  mutable ReaderSlot reader_slots_[kReaderSlotCount];
+};
+
+template <typename T>
+constexpr size_t EpochSnapshot<T>::kReaderSlotCount;
+
+}}  // namespace triton::server
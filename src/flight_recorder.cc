@@ -0,0 +1,183 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "flight_recorder.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace triton { namespace server {
+
+namespace {
+
+std::atomic<uint64_t> next_recorder_id{1};
+
+void
+CopyName(char* dst, const char* src, const size_t max_length)
+{
+  const size_t length = std::min(strlen(src), max_length);
+  std::memcpy(dst, src, length);
+  dst[length] = '\0';
+}
+
+}  // namespace
+
+void
+FlightRecorder::Timeline::SetRequest(
+    const uint64_t trace_id, const char* model_name,
+    const int64_t model_version)
+{
+  trace_id_ = trace_id;
+  model_version_ = model_version;
+  CopyName(model_name_, model_name, kMaxModelNameLength);
+}
+
+FlightRecorder::FlightRecorder(const size_t size)
+    : id_(next_recorder_id.fetch_add(1)), size_(size), name_count_(0)
+{
+}
+
+uint8_t
+FlightRecorder::NameId(const char* name)
+{
+  uint32_t count = name_count_.load(std::memory_order_acquire);
+  for (uint32_t i = 0; i < count; ++i) {
+    if (strncmp(names_[i], name, kMaxNameLength) == 0) {
+      return i;
+    }
+  }
+
+  std::lock_guard<std::mutex> lk(names_mu_);
+  // The name may have been added since the names were searched.
+  count = name_count_.load(std::memory_order_relaxed);
+  for (uint32_t i = 0; i < count; ++i) {
+    if (strncmp(names_[i], name, kMaxNameLength) == 0) {
+      return i;
+    }
+  }
+  if (count == kMaxNames) {
+    return kInvalidName;
+  }
+  CopyName(names_[count], name, kMaxNameLength);
+  name_count_.store(count + 1, std::memory_order_release);
+  return count;
+}
+
+FlightRecorder::Ring*
+FlightRecorder::ThreadRing()
+{
+  thread_local uint64_t ring_owner = 0;
+  thread_local Ring* ring = nullptr;
+  if (ring_owner != id_) {
+    std::unique_ptr<Ring> new_ring(new Ring(size_));
+    ring = new_ring.get();
+    ring_owner = id_;
+    std::lock_guard<std::mutex> lk(rings_mu_);
+    rings_.emplace_back(std::move(new_ring));
+  }
+  return ring;
+}
+
+void
+FlightRecorder::Record(const Timeline& timeline)
+{
+  Ring* ring = ThreadRing();
+  std::lock_guard<std::mutex> lk(ring->mu_);
+  Entry& entry = ring->entries_[ring->next_ % size_];
+  ++ring->next_;
+  entry.trace_id_ = timeline.trace_id_;
+  entry.model_version_ = timeline.model_version_;
+  std::memcpy(
+      entry.model_name_, timeline.model_name_, sizeof(entry.model_name_));
+  entry.count_ = std::min(
+      timeline.count_.load(std::memory_order_relaxed),
+      static_cast<uint32_t>(kMaxTimestamps));
+  std::memcpy(entry.names_, timeline.names_, entry.count_);
+  std::memcpy(
+      entry.timestamps_ns_, timeline.timestamps_ns_,
+      entry.count_ * sizeof(uint64_t));
+}
+
+void
+FlightRecorder::Dump(std::ostream& out)
+{
+  std::vector<Ring*> rings;
+  {
+    std::lock_guard<std::mutex> lk(rings_mu_);
+    for (const auto& ring : rings_) {
+      rings.push_back(ring.get());
+    }
+  }
+
+  std::vector<Entry> entries;
+  for (const auto ring : rings) {
+    std::lock_guard<std::mutex> lk(ring->mu_);
+    const size_t count = std::min(ring->next_, static_cast<uint64_t>(size_));
+    entries.insert(
+        entries.end(), ring->entries_.begin(), ring->entries_.begin() + count);
+  }
+  const auto first_timestamp = [](const Entry& entry) {
+    return (entry.count_ == 0) ? 0
+                               : *std::min_element(
+                                     entry.timestamps_ns_,
+                                     entry.timestamps_ns_ + entry.count_);
+  };
+  std::sort(
+      entries.begin(), entries.end(),
+      [&first_timestamp](const Entry& lhs, const Entry& rhs) {
+        return first_timestamp(lhs) < first_timestamp(rhs);
+      });
+
+  const uint32_t name_count = name_count_.load(std::memory_order_acquire);
+  out << "[";
+  bool first = true;
+  for (const auto& entry : entries) {
+    if (!first) {
+      out << ",";
+    }
+    first = false;
+    out << "{\"id\":" << entry.trace_id_ << ",\"model_name\":\""
+        << entry.model_name_ << "\",\"model_version\":" << entry.model_version_
+        << ",\"timestamps\":[";
+    // The timestamps are added concurrently, write them in time order.
+    std::vector<uint32_t> order(entry.count_);
+    for (uint32_t i = 0; i < entry.count_; ++i) {
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&entry](uint32_t lhs, uint32_t rhs) {
+      return entry.timestamps_ns_[lhs] < entry.timestamps_ns_[rhs];
+    });
+    for (uint32_t i = 0; i < entry.count_; ++i) {
+      const uint8_t name_id = entry.names_[order[i]];
+      out << ((i == 0) ? "" : ",") << "{\"name\":\""
+          << ((name_id < name_count) ? names_[name_id] : "<unknown>")
+          << "\",\"ns\":" << entry.timestamps_ns_[order[i]] << "}";
+    }
+    out << "]}";
+  }
+  out << "]";
+}
+
+}}  // namespace triton::server
@@ -0,0 +1,147 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace triton { namespace server {
+
+//
+// FlightRecorder
+//
+// Keeps the timelines of the last requests handled by the server so
+// that recent latency detail is available even with tracing off. Each
+// request fills a Timeline while it is in flight, the completed
+// timeline is copied into a fixed size ring owned by the completing
+// thread, overwriting the oldest timeline of the ring. Recording never
+// allocates once the ring of the thread exists and only takes the
+// uncontended lock of the ring.
+//
+class FlightRecorder {
+ public:
+  static constexpr size_t kMaxTimestamps = 24;
+  static constexpr size_t kMaxModelNameLength = 47;
+
+  //
+  // The timestamps of one request. Timestamps may be added concurrently,
+  // the timestamps beyond 'kMaxTimestamps' are dropped.
+  //
+  class Timeline {
+   public:
+    Timeline() : trace_id_(0), model_version_(0), count_(0)
+    {
+      model_name_[0] = '\0';
+    }
+
+    // Set the request the timeline belongs to.
+    void SetRequest(
+        const uint64_t trace_id, const char* model_name,
+        const int64_t model_version);
+
+    // Add a timestamp of the name interned as 'name_id'.
+    void Add(const uint8_t name_id, const uint64_t timestamp_ns)
+    {
+      const uint32_t index = count_.fetch_add(1, std::memory_order_relaxed);
+      if (index < kMaxTimestamps) {
+        names_[index] = name_id;
+        timestamps_ns_[index] = timestamp_ns;
+      }
+    }
+
+   private:
+    friend class FlightRecorder;
+
+    uint64_t trace_id_;
+    int64_t model_version_;
+    char model_name_[kMaxModelNameLength + 1];
+    std::atomic<uint32_t> count_;
+    uint8_t names_[kMaxTimestamps];
+    uint64_t timestamps_ns_[kMaxTimestamps];
+  };
+
+  /// Create a recorder keeping the last 'size' timelines per thread.
+  explicit FlightRecorder(const size_t size);
+
+  /// Return the id of 'name' to be used in Timeline::Add(), interning
+  /// the name if it is seen for the first time. Return kInvalidName if
+  /// there is no room for more names.
+  uint8_t NameId(const char* name);
+  static constexpr uint8_t kInvalidName = 255;
+
+  /// Copy 'timeline' into the ring of the calling thread. 'timeline'
+  /// must no longer be modified.
+  void Record(const Timeline& timeline);
+
+  /// Write the recorded timelines as a JSON array in the format of the
+  /// Triton trace file, ordered by their first timestamp.
+  void Dump(std::ostream& out);
+
+ private:
+  static constexpr size_t kMaxNames = 64;
+  static constexpr size_t kMaxNameLength = 39;
+
+  struct Entry {
+    uint64_t trace_id_;
+    int64_t model_version_;
+    char model_name_[kMaxModelNameLength + 1];
+    uint32_t count_;
+    uint8_t names_[kMaxTimestamps];
+    uint64_t timestamps_ns_[kMaxTimestamps];
+  };
+
+  struct Ring {
+    explicit Ring(const size_t size) : entries_(size), next_(0) {}
+    std::mutex mu_;
+    std::vector<Entry> entries_;
+    // The total number of timelines recorded in the ring.
+    uint64_t next_;
+  };
+
+  // Return the ring of the calling thread, creating it if needed.
+  Ring* ThreadRing();
+
+  // Unique across recorders so that a thread never uses the ring of a
+  // destroyed recorder.
+  const uint64_t id_;
+  const size_t size_;
+
+  std::mutex names_mu_;
+  char names_[kMaxNames][kMaxNameLength + 1];
+  std::atomic<uint32_t> name_count_;
+
+  // The rings of all the threads that recorded a timeline, the ring of
+  // a thread outlives the thread so that its timelines can be dumped.
+  std::mutex rings_mu_;
+  std::vector<std::unique_ptr<Ring>> rings_;
+};
+
+}}  // namespace triton::server
@@ -0,0 +1,177 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "frontend_metrics.h"
+
+namespace triton { namespace server {
+
+//
+// A histogram reported next to the metrics of the core, exported as the
+// '_bucket', '_sum' and '_count' counters of the Prometheus histogram
+// convention so that quantiles can be computed from the buckets.
+//
+// Observing a value only increments an atomic bucket and sum local to
+// the histogram. The values observed since the last publication are
+// added to the reported counters by Publish(), so the cost of an
+// observation doesn't depend on the number of buckets.
+//
+class FrontendHistogram {
+ public:
+  // 'bounds' are the increasing upper bounds of the buckets, a last
+  // '+Inf' bucket is added.
+  FrontendHistogram(
+      const FrontendMetricFamily& bucket_family,
+      const FrontendMetricFamily& sum_family,
+      const FrontendMetricFamily& count_family,
+      const std::vector<std::pair<std::string, std::string>>& labels,
+      const std::vector<uint64_t>& bounds)
+      : bounds_(bounds),
+        buckets_(new std::atomic<uint64_t>[bounds.size() + 1]), sum_(0),
+        sum_metric_(sum_family, labels), count_metric_(count_family, labels)
+  {
+    for (size_t idx = 0; idx <= bounds_.size(); ++idx) {
+      buckets_[idx].store(0, std::memory_order_relaxed);
+      auto bucket_labels = labels;
+      bucket_labels.emplace_back(
+          "le",
+          (idx < bounds_.size()) ? std::to_string(bounds_[idx]) : "+Inf");
+      bucket_metrics_.emplace_back(
+          new FrontendMetric(bucket_family, bucket_labels));
+    }
+  }
+
+  void Observe(const uint64_t value)
+  {
+    // The value is counted in the first bucket whose bound is at least
+    // 'value'.
+    const size_t idx =
+        std::lower_bound(bounds_.begin(), bounds_.end(), value) -
+        bounds_.begin();
+    buckets_[idx].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  // Adds the values observed since the last publication to the
+  // reported counters, the reported buckets are cumulative.
+  void Publish()
+  {
+    uint64_t count = 0;
+    for (size_t idx = 0; idx <= bounds_.size(); ++idx) {
+      count += buckets_[idx].exchange(0, std::memory_order_relaxed);
+      if (count != 0) {
+        bucket_metrics_[idx]->Increment(count);
+      }
+    }
+    const uint64_t sum = sum_.exchange(0, std::memory_order_relaxed);
+    if (count != 0) {
+      sum_metric_.Increment(sum);
+      count_metric_.Increment(count);
+    }
+  }
+
+ private:
+  const std::vector<uint64_t> bounds_;
+
+  // The counts of the values observed in each bucket since the last
+  // publication, not cumulative.
+  std::unique_ptr<std::atomic<uint64_t>[]> buckets_;
+  std::atomic<uint64_t> sum_;
+
+  std::vector<std::unique_ptr<FrontendMetric>> bucket_metrics_;
+  FrontendMetric sum_metric_;
+  FrontendMetric count_metric_;
+};
+
+//
+// Publishes a set of histograms every 'interval' from a thread of its
+// own, and a last time when destroyed, so that every observed value is
+// reported within an interval whether or not more values are observed.
+//
+class FrontendHistogramPublisher {
+ public:
+  explicit FrontendHistogramPublisher(
+      const std::chrono::milliseconds interval = std::chrono::seconds(1))
+      : interval_(interval), exit_(false)
+  {
+    thread_ = std::thread([this]() { Run(); });
+  }
+
+  ~FrontendHistogramPublisher()
+  {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      exit_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+
+    std::lock_guard<std::mutex> lk(mu_);
+    for (auto& histogram : histograms_) {
+      histogram->Publish();
+    }
+  }
+
+  // Adds 'histogram' to the published histograms.
+  void Add(const std::shared_ptr<FrontendHistogram>& histogram)
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    histograms_.emplace_back(histogram);
+  }
+
+ private:
+  void Run()
+  {
+    std::unique_lock<std::mutex> lk(mu_);
+    while (!cv_.wait_for(lk, interval_, [this]() { return exit_; })) {
+      for (auto& histogram : histograms_) {
+        histogram->Publish();
+      }
+    }
+  }
+
+  const std::chrono::milliseconds interval_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool exit_;
+  std::vector<std::shared_ptr<FrontendHistogram>> histograms_;
+  std::thread thread_;
+};
+
+}}  // namespace triton::server
@@ -0,0 +1,154 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "triton/common/logging.h"
+#include "triton/core/tritonserver.h"
+
+namespace triton { namespace server {
+
+//
+// Wrappers over the TRITONSERVER custom metric API that the endpoints
+// use to report their own metrics next to the metrics of the core.
+// Failing to create a metric is logged and leaves the metric as a
+// no-op, reporting a metric never fails the caller. Without
+// TRITON_ENABLE_METRICS all the wrappers are no-ops.
+//
+class FrontendMetricFamily {
+ public:
+  FrontendMetricFamily(
+      const TRITONSERVER_MetricKind kind, const std::string& name,
+      const std::string& description)
+      : family_(nullptr)
+  {
+#ifdef TRITON_ENABLE_METRICS
+    TRITONSERVER_Error* err = TRITONSERVER_MetricFamilyNew(
+        &family_, kind, name.c_str(), description.c_str());
+    if (err != nullptr) {
+      LOG_ERROR << "failed to create metric family '" << name
+                << "': " << TRITONSERVER_ErrorMessage(err);
+      TRITONSERVER_ErrorDelete(err);
+      family_ = nullptr;
+    }
+#endif  // TRITON_ENABLE_METRICS
+  }
+
+  ~FrontendMetricFamily()
+  {
+#ifdef TRITON_ENABLE_METRICS
+    if (family_ != nullptr) {
+      LOG_TRITONSERVER_ERROR(
+          TRITONSERVER_MetricFamilyDelete(family_),
+          "deleting metric family");
+    }
+#endif  // TRITON_ENABLE_METRICS
+  }
+
+  TRITONSERVER_MetricFamily* Family() const { return family_; }
+
+ private:
+  TRITONSERVER_MetricFamily* family_;
+};
+
+// A metric of a family. Must be destroyed before its family.
+class FrontendMetric {
+ public:
+  explicit FrontendMetric(
+      const FrontendMetricFamily& family,
+      const std::vector<std::pair<std::string, std::string>>& labels = {})
+      : metric_(nullptr)
+  {
+#ifdef TRITON_ENABLE_METRICS
+    if (family.Family() == nullptr) {
+      return;
+    }
+
+    std::vector<const TRITONSERVER_Parameter*> params;
+    for (const auto& label : labels) {
+      params.emplace_back(TRITONSERVER_ParameterNew(
+          label.first.c_str(), TRITONSERVER_PARAMETER_STRING,
+          label.second.c_str()));
+    }
+    TRITONSERVER_Error* err = TRITONSERVER_MetricNew(
+        &metric_, family.Family(), params.data(), params.size());
+    for (const auto param : params) {
+      TRITONSERVER_ParameterDelete(const_cast<TRITONSERVER_Parameter*>(param));
+    }
+    if (err != nullptr) {
+      LOG_ERROR << "failed to create metric: "
+                << TRITONSERVER_ErrorMessage(err);
+      TRITONSERVER_ErrorDelete(err);
+      metric_ = nullptr;
+    }
+#endif  // TRITON_ENABLE_METRICS
+  }
+
+  ~FrontendMetric()
+  {
+#ifdef TRITON_ENABLE_METRICS
+    if (metric_ != nullptr) {
+      LOG_TRITONSERVER_ERROR(
+          TRITONSERVER_MetricDelete(metric_), "deleting metric");
+    }
+#endif  // TRITON_ENABLE_METRICS
+  }
+
+  // Adds 'value' to the metric. Negative values are only valid for
+  // gauges.
+  void Increment(const double value)
+  {
+#ifdef TRITON_ENABLE_METRICS
+    if (metric_ != nullptr) {
+      TRITONSERVER_Error* err = TRITONSERVER_MetricIncrement(metric_, value);
+      if (err != nullptr) {
+        TRITONSERVER_ErrorDelete(err);
+      }
+    }
+#endif  // TRITON_ENABLE_METRICS
+  }
+
+  // Sets the value of a gauge.
+  void Set(const double value)
+  {
+#ifdef TRITON_ENABLE_METRICS
+    if (metric_ != nullptr) {
+      TRITONSERVER_Error* err = TRITONSERVER_MetricSet(metric_, value);
+      if (err != nullptr) {
+        TRITONSERVER_ErrorDelete(err);
+      }
+    }
+#endif  // TRITON_ENABLE_METRICS
+  }
+
+ private:
+  TRITONSERVER_Metric* metric_;
+};
+
+}}  // namespace triton::server
@@ -0,0 +1,200 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace triton { namespace server {
+
+// The stages of the handling of an inference request by the HTTP and
+// GRPC frontends. The timestamp of each stage is recorded to the trace
+// of the request under the name returned by FrontendStageName(), the
+// names are interned so that capturing a timestamp doesn't allocate.
+enum class FrontendStage : uint8_t {
+  HTTP_RECV_START,
+  HTTP_RECV_END,
+  GRPC_WAITREAD_START,
+  GRPC_WAITREAD_END,
+  DECOMPRESS_START,
+  DECOMPRESS_END,
+  PARSE_START,
+  PARSE_END,
+  INPUT_SETUP_START,
+  INPUT_SETUP_END,
+  INFER_RESPONSE_COMPLETE,
+  OUTPUT_SERIALIZE_START,
+  OUTPUT_SERIALIZE_END,
+  COMPRESS_START,
+  COMPRESS_END,
+  HTTP_SEND_START,
+  HTTP_SEND_END,
+  GRPC_SEND_START,
+  GRPC_SEND_END,
+  COUNT
+};
+
+inline const char*
+FrontendStageName(const FrontendStage stage)
+{
+  static const char* kNames[] = {
+      "HTTP_RECV_START",
+      "HTTP_RECV_END",
+      "GRPC_WAITREAD_START",
+      "GRPC_WAITREAD_END",
+      "DECOMPRESS_START",
+      "DECOMPRESS_END",
+      "PARSE_START",
+      "PARSE_END",
+      "INPUT_SETUP_START",
+      "INPUT_SETUP_END",
+      "INFER_RESPONSE_COMPLETE",
+      "OUTPUT_SERIALIZE_START",
+      "OUTPUT_SERIALIZE_END",
+      "COMPRESS_START",
+      "COMPRESS_END",
+      "HTTP_SEND_START",
+      "HTTP_SEND_END",
+      "GRPC_SEND_START",
+      "GRPC_SEND_END"};
+  static_assert(
+      sizeof(kNames) / sizeof(kNames[0]) ==
+          static_cast<size_t>(FrontendStage::COUNT),
+      "a name is required for every frontend stage");
+  return kNames[static_cast<size_t>(stage)];
+}
+
+//
+// The frontend stage timestamps of a request, in the order they are
+// captured. The timestamps are held until the trace of the request is
+// available and are used to report the per-stage breakdown of the
+// request to the client.
+//
+class FrontendTimestamps {
+ public:
+  using Timestamp = std::pair<FrontendStage, uint64_t>;
+
+  void Capture(const FrontendStage stage, const uint64_t timestamp_ns)
+  {
+    if (timestamps_.capacity() == 0) {
+      timestamps_.reserve(kReservedCount);
+    }
+    timestamps_.emplace_back(stage, timestamp_ns);
+  }
+
+  // Keeps the capacity so that a reused state doesn't reallocate.
+  void Clear() { timestamps_.clear(); }
+  bool Empty() const { return timestamps_.empty(); }
+
+  std::vector<Timestamp>::const_iterator begin() const
+  {
+    return timestamps_.begin();
+  }
+  std::vector<Timestamp>::const_iterator end() const
+  {
+    return timestamps_.end();
+  }
+
+  // Return the per-stage breakdown of the request in the format of a
+  // 'Server-Timing' header, for example "parse;dur=0.012, infer;dur=1.2".
+  // The durations are in milliseconds, a stage is only reported if both
+  // of its timestamps are captured. Return an empty string if no stage
+  // is complete.
+  std::string ServerTiming() const
+  {
+    static const struct {
+      const char* name_;
+      FrontendStage start_;
+      FrontendStage end_;
+    } kMetrics[] = {
+        {"decompress", FrontendStage::DECOMPRESS_START,
+         FrontendStage::DECOMPRESS_END},
+        {"parse", FrontendStage::PARSE_START, FrontendStage::PARSE_END},
+        {"input", FrontendStage::INPUT_SETUP_START,
+         FrontendStage::INPUT_SETUP_END},
+        {"infer", FrontendStage::INPUT_SETUP_END,
+         FrontendStage::INFER_RESPONSE_COMPLETE},
+        {"output", FrontendStage::OUTPUT_SERIALIZE_START,
+         FrontendStage::OUTPUT_SERIALIZE_END},
+        {"compress", FrontendStage::COMPRESS_START,
+         FrontendStage::COMPRESS_END}};
+
+    std::string timing;
+    for (const auto& metric : kMetrics) {
+      uint64_t duration_ns;
+      if (!Duration(metric.start_, metric.end_, &duration_ns)) {
+        continue;
+      }
+      char entry[64];
+      snprintf(
+          entry, sizeof(entry), "%s%s;dur=%.3f", timing.empty() ? "" : ", ",
+          metric.name_, duration_ns / 1000000.0);
+      timing += entry;
+    }
+    return timing;
+  }
+
+  // Return in 'duration_ns' the time from the first timestamp of 'start'
+  // to the first timestamp of 'end'. Return false if either timestamp is
+  // not captured or 'end' precedes 'start'.
+  bool Duration(
+      const FrontendStage start, const FrontendStage end,
+      uint64_t* duration_ns) const
+  {
+    uint64_t start_ns, end_ns;
+    if (!Find(start, &start_ns) || !Find(end, &end_ns) || (end_ns < start_ns)) {
+      return false;
+    }
+    *duration_ns = end_ns - start_ns;
+    return true;
+  }
+
+ private:
+  // Enough for the stages of a request without a reallocation.
+  static constexpr size_t kReservedCount =
+      static_cast<size_t>(FrontendStage::COUNT);
+
+  // Find the first timestamp of 'stage', a stage can be captured more
+  // than once if the request has more than one response.
+  bool Find(const FrontendStage stage, uint64_t* timestamp_ns) const
+  {
+    for (const auto& timestamp : timestamps_) {
+      if (timestamp.first == stage) {
+        *timestamp_ns = timestamp.second;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::vector<Timestamp> timestamps_;
+};
+
+}}  // namespace triton::server
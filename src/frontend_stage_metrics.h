@@ -0,0 +1,285 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <time.h>
+#endif  // !_WIN32
+
+#include "epoch_snapshot.h"
+#include "frontend_histogram.h"
+#include "frontend_metrics.h"
+#include "frontend_stage.h"
+
+namespace triton { namespace server {
+
+//
+// Histograms of the durations of the frontend stages of the inference
+// requests of each model, and of the CPU time the frontend threads spend
+// on a request, reported next to the metrics of the core. The histograms
+// are exported as the '_bucket', '_sum' and '_count' counters of the
+// Prometheus histogram convention.
+//
+// Observing a request only increments the atomic log-scale buckets of
+// a FrontendHistogram local to the endpoint, the observations are added
+// to the reported counters every second by a publisher thread, and a
+// last time when the metrics are destroyed.
+// The stages are taken from the frontend stage timestamps of the
+// request, which are only captured in builds with tracing enabled.
+//
+class FrontendStageMetrics {
+ public:
+  // 'endpoint' names the metric families, "nv_<endpoint>_frontend_...".
+  explicit FrontendStageMetrics(const std::string& endpoint)
+      : stage_bucket_family_(
+            TRITONSERVER_METRIC_KIND_COUNTER,
+            "nv_" + endpoint + "_frontend_stage_duration_us_bucket",
+            "Cumulative count of " + endpoint +
+                " inference request stages that took at most 'le' "
+                "microseconds"),
+        stage_sum_family_(
+            TRITONSERVER_METRIC_KIND_COUNTER,
+            "nv_" + endpoint + "_frontend_stage_duration_us_sum",
+            "Cumulative duration in microseconds of " + endpoint +
+                " inference request stages"),
+        stage_count_family_(
+            TRITONSERVER_METRIC_KIND_COUNTER,
+            "nv_" + endpoint + "_frontend_stage_duration_us_count",
+            "Number of " + endpoint + " inference request stages observed"),
+        cpu_bucket_family_(
+            TRITONSERVER_METRIC_KIND_COUNTER,
+            "nv_" + endpoint + "_frontend_cpu_us_bucket",
+            "Cumulative count of " + endpoint +
+                " inference requests that took at most 'le' microseconds "
+                "of frontend thread CPU time"),
+        cpu_sum_family_(
+            TRITONSERVER_METRIC_KIND_COUNTER,
+            "nv_" + endpoint + "_frontend_cpu_us_sum",
+            "Cumulative frontend thread CPU time in microseconds of " +
+                endpoint + " inference requests"),
+        cpu_count_family_(
+            TRITONSERVER_METRIC_KIND_COUNTER,
+            "nv_" + endpoint + "_frontend_cpu_us_count",
+            "Number of " + endpoint +
+                " inference requests whose frontend thread CPU time is "
+                "observed"),
+        models_(std::unique_ptr<ModelMap>(new ModelMap()))
+  {
+  }
+
+  // Returns the CPU time in nanoseconds consumed by the calling thread,
+  // 0 if not available on the platform.
+  static uint64_t ThreadCpuNs()
+  {
+#ifdef _WIN32
+    return 0;
+#else
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+      return 0;
+    }
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif  // _WIN32
+  }
+
+  // Observes the stages captured in 'timestamps' and the frontend
+  // thread CPU time 'cpu_ns' of a request of 'model_name'. The CPU
+  // time is not observed if 0.
+  void Observe(
+      const std::string& model_name, const FrontendTimestamps& timestamps,
+      const uint64_t cpu_ns)
+  {
+    Model(model_name)->Observe(timestamps, cpu_ns);
+  }
+
+ private:
+  // The bucket upper bounds are the powers of 2 from 4 microseconds to
+  // about a second, a last '+Inf' bucket is added.
+  static std::vector<uint64_t> BucketBounds()
+  {
+    std::vector<uint64_t> bounds;
+    for (uint64_t bound = 4; bound <= (uint64_t(1) << 20); bound <<= 1) {
+      bounds.push_back(bound);
+    }
+    return bounds;
+  }
+
+  // The observed stages and the frontend stage timestamps they span.
+  // The reply is the time from the response being received from the
+  // core to it being handed to the transport.
+  enum class Stage {
+    DECOMPRESS,
+    PARSE,
+    INPUT,
+    OUTPUT,
+    COMPRESS,
+    REPLY,
+    SEND,
+    COUNT
+  };
+
+  struct StageSpan {
+    Stage stage_;
+    FrontendStage start_;
+    FrontendStage end_;
+  };
+
+  static const char* StageName(const Stage stage)
+  {
+    static const char* kNames[] = {"decompress", "parse", "input", "output",
+                                   "compress",   "reply", "send"};
+    static_assert(
+        sizeof(kNames) / sizeof(kNames[0]) == static_cast<size_t>(Stage::COUNT),
+        "a name is required for every observed stage");
+    return kNames[static_cast<size_t>(stage)];
+  }
+
+  //
+  // The histograms of a model.
+  //
+  class ModelMetrics {
+   public:
+    // The histograms of the model are published by the publisher of
+    // 'metrics'.
+    ModelMetrics(FrontendStageMetrics& metrics, const std::string& model_name)
+    {
+      const std::vector<uint64_t> bounds = BucketBounds();
+      for (size_t idx = 0; idx < static_cast<size_t>(Stage::COUNT); ++idx) {
+        stages_.emplace_back(std::make_shared<FrontendHistogram>(
+            metrics.stage_bucket_family_, metrics.stage_sum_family_,
+            metrics.stage_count_family_,
+            std::vector<std::pair<std::string, std::string>>{
+                {"model", model_name},
+                {"stage", StageName(static_cast<Stage>(idx))}},
+            bounds));
+        metrics.publisher_.Add(stages_.back());
+      }
+      cpu_ = std::make_shared<FrontendHistogram>(
+          metrics.cpu_bucket_family_, metrics.cpu_sum_family_,
+          metrics.cpu_count_family_,
+          std::vector<std::pair<std::string, std::string>>{
+              {"model", model_name}},
+          bounds);
+      metrics.publisher_.Add(cpu_);
+    }
+
+    void Observe(const FrontendTimestamps& timestamps, const uint64_t cpu_ns)
+    {
+      static const StageSpan kSpans[] = {
+          {Stage::DECOMPRESS, FrontendStage::DECOMPRESS_START,
+           FrontendStage::DECOMPRESS_END},
+          {Stage::PARSE, FrontendStage::PARSE_START, FrontendStage::PARSE_END},
+          {Stage::INPUT, FrontendStage::INPUT_SETUP_START,
+           FrontendStage::INPUT_SETUP_END},
+          {Stage::OUTPUT, FrontendStage::OUTPUT_SERIALIZE_START,
+           FrontendStage::OUTPUT_SERIALIZE_END},
+          {Stage::COMPRESS, FrontendStage::COMPRESS_START,
+           FrontendStage::COMPRESS_END},
+          {Stage::REPLY, FrontendStage::INFER_RESPONSE_COMPLETE,
+           FrontendStage::HTTP_SEND_START},
+          {Stage::REPLY, FrontendStage::INFER_RESPONSE_COMPLETE,
+           FrontendStage::GRPC_SEND_START},
+          {Stage::SEND, FrontendStage::HTTP_SEND_START,
+           FrontendStage::HTTP_SEND_END},
+          {Stage::SEND, FrontendStage::GRPC_SEND_START,
+           FrontendStage::GRPC_SEND_END}};
+
+      for (const auto& span : kSpans) {
+        uint64_t duration_ns;
+        if (timestamps.Duration(span.start_, span.end_, &duration_ns)) {
+          stages_[static_cast<size_t>(span.stage_)]->Observe(
+              duration_ns / 1000);
+        }
+      }
+      if (cpu_ns != 0) {
+        cpu_->Observe(cpu_ns / 1000);
+      }
+    }
+
+   private:
+    std::vector<std::shared_ptr<FrontendHistogram>> stages_;
+    std::shared_ptr<FrontendHistogram> cpu_;
+  };
+
+  using ModelMap =
+      std::unordered_map<std::string, std::shared_ptr<ModelMetrics>>;
+
+  // Returns the histograms of 'model_name', creating them on the first
+  // request of the model. The map is replaced as a whole when a model is
+  // added so that looking up a known model neither locks nor touches a
+  // reference count. The histograms of a model are kept once created,
+  // so they outlive the map they are found in.
+  ModelMetrics* Model(const std::string& model_name)
+  {
+    ModelMetrics* model =
+        models_.Read([&model_name](const ModelMap& models) -> ModelMetrics* {
+          const auto it = models.find(model_name);
+          return (it != models.end()) ? it->second.get() : nullptr;
+        });
+    if (model != nullptr) {
+      return model;
+    }
+
+    std::lock_guard<std::mutex> lk(mu_);
+    std::unique_ptr<ModelMap> updated(models_.Read(
+        [](const ModelMap& models) { return new ModelMap(models); }));
+    const auto it = updated->find(model_name);
+    if (it != updated->end()) {
+      return it->second.get();
+    }
+    std::shared_ptr<ModelMetrics> metrics(new ModelMetrics(*this, model_name));
+    updated->emplace(model_name, metrics);
+    models_.Publish(std::move(updated));
+    return metrics.get();
+  }
+
+  FrontendMetricFamily stage_bucket_family_;
+  FrontendMetricFamily stage_sum_family_;
+  FrontendMetricFamily stage_count_family_;
+  FrontendMetricFamily cpu_bucket_family_;
+  FrontendMetricFamily cpu_sum_family_;
+  FrontendMetricFamily cpu_count_family_;
+
+  // Declared after the families so that the last publication happens
+  // before they are destroyed.
+  FrontendHistogramPublisher publisher_;
+
+  // Serializes the addition of models, which are published to the
+  // readers of 'models_'.
+  std::mutex mu_;
+  EpochSnapshot<ModelMap> models_;
+};
+
+}}  // namespace triton::server
@@ -27,9 +27,11 @@
 #include "grpc_server.h"
 
 #include <google/protobuf/arena.h>
+#include <google/protobuf/unknown_field_set.h>
 #include <grpc++/alarm.h>
 
 #include <chrono>
+#include <climits>
 #include <condition_variable>
 #include <cstdint>
 #include <fstream>
@@ -68,6 +70,68 @@ namespace triton { namespace server { namespace grpc {
 
 namespace {
 
+// The shared memory register responses defined by the KServe protocol
+// are empty, so the handle assigned to a newly registered region is
+// returned as field 1 ('uint64 handle = 1'). Clients built against the
+// unextended protocol simply ignore it.
+template <typename ResponseType>
+void
+SetSharedMemoryHandle(ResponseType* response, const uint64_t handle)
+{
+  response->GetReflection()->MutableUnknownFields(response)->AddVarint(
+      1 /* number */, handle);
+}
+
+// Likewise the system shared memory register request has no mapping
+// options, they are read from fields 5 to 11 ('bool prefault = 5',
+// 'bool huge_pages = 6', 'bool lock = 7', 'optional int64 numa_node =
+// 8', 'bool pool = 9', 'optional uint64 pool_block_size = 10' and
+// 'uint64 pool_lease_ms = 11').
+TRITONSERVER_Error*
+GetSharedMemoryMappingOptions(
+    const inference::SystemSharedMemoryRegisterRequest& request,
+    SharedMemoryManager::MappingOptions* options)
+{
+  const google::protobuf::UnknownFieldSet& fields =
+      request.GetReflection()->GetUnknownFields(request);
+  for (int idx = 0; idx < fields.field_count(); ++idx) {
+    const google::protobuf::UnknownField& field = fields.field(idx);
+    if (field.type() != google::protobuf::UnknownField::TYPE_VARINT) {
+      continue;
+    }
+    switch (field.number()) {
+      case 5:
+        options->prefault_ = (field.varint() != 0);
+        break;
+      case 6:
+        options->huge_pages_ = (field.varint() != 0);
+        break;
+      case 7:
+        options->lock_ = (field.varint() != 0);
+        break;
+      case 8: {
+        const int64_t numa_node = static_cast<int64_t>(field.varint());
+        RETURN_IF_ERR(SharedMemoryManager::CheckNumaNode(numa_node));
+        options->numa_node_ = numa_node;
+        break;
+      }
+      case 9:
+        options->pool_ = (field.varint() != 0);
+        break;
+      case 10:
+        options->pool_block_size_ = field.varint();
+        break;
+      case 11:
+        options->pool_lease_ms_ = field.varint();
+        break;
+      default:
+        break;
+    }
+  }
+
+  return nullptr;  // success
+}
+
 //
 // The server has separate handling mechanisms for inference RPCs
 // and non-inference RPCs.
@@ -92,22 +156,16 @@ class CommonCallData : public ICallData {
       const StandardRegisterFunc OnRegister,
       const StandardCallbackFunc OnExecute, const bool async,
       ::grpc::ServerCompletionQueue* cq,
-      const std::pair<std::string, std::string>& restricted_kv)
+      const std::pair<std::string, std::string>& restricted_kv,
+      ControlPlaneExecutor* executor = nullptr)
       : name_(name), id_(id), OnRegister_(OnRegister), OnExecute_(OnExecute),
-        async_(async), cq_(cq), responder_(&ctx_), step_(Steps::START),
-        restricted_kv_(restricted_kv)
+        async_(async && (executor != nullptr)), cq_(cq), executor_(executor),
+        responder_(&ctx_), step_(Steps::START), restricted_kv_(restricted_kv)
   {
     OnRegister_(&ctx_, &request_, &responder_, this);
     LOG_VERBOSE(1) << "Ready for RPC '" << name_ << "', " << id_;
   }
 
-  ~CommonCallData()
-  {
-    if (async_thread_.joinable()) {
-      async_thread_.join();
-    }
-  }
-
   bool Process(bool ok) override;
 
   std::string Name() override { return name_; }
@@ -126,6 +184,7 @@ class CommonCallData : public ICallData {
   const StandardCallbackFunc OnExecute_;
   const bool async_;
   ::grpc::ServerCompletionQueue* cq_;
+  ControlPlaneExecutor* executor_;
 
   ::grpc::ServerContext ctx_;
   ::grpc::Alarm alarm_;
@@ -135,8 +194,6 @@ class CommonCallData : public ICallData {
   ResponseType response_;
   ::grpc::Status status_;
 
-  std::thread async_thread_;
-
   Steps step_;
 
   std::pair<std::string, std::string> restricted_kv_{"", ""};
@@ -155,9 +212,6 @@ CommonCallData<ResponderType, RequestType, ResponseType>::Process(bool rpc_ok)
   // we can do since we one execute one step.
   const bool shutdown = (!rpc_ok && (step_ == Steps::START));
   if (shutdown) {
-    if (async_thread_.joinable()) {
-      async_thread_.join();
-    }
     step_ = Steps::FINISH;
   }
 
@@ -165,7 +219,8 @@ CommonCallData<ResponderType, RequestType, ResponseType>::Process(bool rpc_ok)
     // Start a new request to replace this one...
     if (!shutdown) {
       new CommonCallData<ResponderType, RequestType, ResponseType>(
-          name_, id_ + 1, OnRegister_, OnExecute_, async_, cq_, restricted_kv_);
+          name_, id_ + 1, OnRegister_, OnExecute_, async_, cq_, restricted_kv_,
+          executor_);
     }
 
     if (!async_) {
@@ -174,10 +229,16 @@ CommonCallData<ResponderType, RequestType, ResponseType>::Process(bool rpc_ok)
       Execute();
       WriteResponse();
     } else {
-      // For asynchronous calls, delegate the execution to another
-      // thread.
+      // For asynchronous calls, delegate the execution to the
+      // control-plane executor so that the handler thread is not
+      // blocked.
       step_ = Steps::ISSUED;
-      async_thread_ = std::thread(&CommonCallData::Execute, this);
+      TRITONSERVER_Error* err = executor_->Submit([this] { Execute(); });
+      if (err != nullptr) {
+        GrpcStatusUtil::Create(&status_, err);
+        TRITONSERVER_ErrorDelete(err);
+        WriteResponse();
+      }
     }
   } else if (step_ == Steps::WRITEREADY) {
     // Will only come here for asynchronous mode.
@@ -254,7 +315,8 @@ class CommonHandler : public HandlerBase {
       ::grpc::health::v1::Health::AsyncService* health_service,
       ::grpc::ServerCompletionQueue* cq,
       std::map<std::string, std::pair<std::string, std::string>>
-          restricted_keys);
+          restricted_keys,
+      const std::shared_ptr<ControlPlaneExecutor>& control_plane_executor);
 
   // Descriptive name of of the handler.
   const std::string& Name() const { return name_; }
@@ -301,6 +363,9 @@ class CommonHandler : public HandlerBase {
   std::unique_ptr<std::thread> thread_;
   std::map<std::string, std::pair<std::string, std::string>> restricted_keys_;
   static std::pair<std::string, std::string> empty_restricted_key_;
+
+  // Runs the RPCs that may take a long time.
+  std::shared_ptr<ControlPlaneExecutor> control_plane_executor_;
 };
 
 std::pair<std::string, std::string> CommonHandler::empty_restricted_key_{
@@ -314,11 +379,13 @@ CommonHandler::CommonHandler(
     inference::GRPCInferenceService::AsyncService* service,
     ::grpc::health::v1::Health::AsyncService* health_service,
     ::grpc::ServerCompletionQueue* cq,
-    std::map<std::string, std::pair<std::string, std::string>> restricted_keys)
+    std::map<std::string, std::pair<std::string, std::string>> restricted_keys,
+    const std::shared_ptr<ControlPlaneExecutor>& control_plane_executor)
     : name_(name), tritonserver_(tritonserver), shm_manager_(shm_manager),
       trace_manager_(trace_manager), service_(service),
       health_service_(health_service), cq_(cq),
-      restricted_keys_(restricted_keys)
+      restricted_keys_(restricted_keys),
+      control_plane_executor_(control_plane_executor)
 {
 }
 
@@ -1209,7 +1276,7 @@ CommonHandler::RegisterModelStatistics()
       ::grpc::ServerAsyncResponseWriter<inference::ModelStatisticsResponse>,
       inference::ModelStatisticsRequest, inference::ModelStatisticsResponse>(
       "ModelStatistics", 0, OnRegisterModelStatistics, OnExecuteModelStatistics,
-      false /* async */, cq_, restricted_kv);
+      true /* async */, cq_, restricted_kv, control_plane_executor_.get());
 }
 
 void
@@ -1792,9 +1859,18 @@ CommonHandler::RegisterSystemSharedMemoryRegister()
           inference::SystemSharedMemoryRegisterRequest& request,
           inference::SystemSharedMemoryRegisterResponse* response,
           ::grpc::Status* status) {
-        TRITONSERVER_Error* err = shm_manager_->RegisterSystemSharedMemory(
-            request.name(), request.key(), request.offset(),
-            request.byte_size());
+        SharedMemoryManager::MappingOptions options;
+        uint64_t handle = 0;
+        TRITONSERVER_Error* err =
+            GetSharedMemoryMappingOptions(request, &options);
+        if (err == nullptr) {
+          err = shm_manager_->RegisterSystemSharedMemory(
+              request.name(), request.key(), request.offset(),
+              request.byte_size(), options, &handle);
+        }
+        if (err == nullptr) {
+          SetSharedMemoryHandle(response, handle);
+        }
 
         GrpcStatusUtil::Create(status, err);
         TRITONSERVER_ErrorDelete(err);
@@ -1809,8 +1885,8 @@ CommonHandler::RegisterSystemSharedMemoryRegister()
       inference::SystemSharedMemoryRegisterRequest,
       inference::SystemSharedMemoryRegisterResponse>(
       "SystemSharedMemoryRegister", 0, OnRegisterSystemSharedMemoryRegister,
-      OnExecuteSystemSharedMemoryRegister, false /* async */, cq_,
-      restricted_kv);
+      OnExecuteSystemSharedMemoryRegister, true /* async */, cq_,
+      restricted_kv, control_plane_executor_.get());
 }
 
 void
@@ -1853,8 +1929,8 @@ CommonHandler::RegisterSystemSharedMemoryUnregister()
       inference::SystemSharedMemoryUnregisterRequest,
       inference::SystemSharedMemoryUnregisterResponse>(
       "SystemSharedMemoryUnregister", 0, OnRegisterSystemSharedMemoryUnregister,
-      OnExecuteSystemSharedMemoryUnregister, false /* async */, cq_,
-      restricted_kv);
+      OnExecuteSystemSharedMemoryUnregister, true /* async */, cq_,
+      restricted_kv, control_plane_executor_.get());
 }
 
 void
@@ -1945,11 +2021,15 @@ CommonHandler::RegisterCudaSharedMemoryRegister()
           ::grpc::Status* status) {
         TRITONSERVER_Error* err = nullptr;
 #ifdef TRITON_ENABLE_GPU
+        uint64_t handle = 0;
         err = shm_manager_->RegisterCUDASharedMemory(
             request.name(),
             reinterpret_cast<const cudaIpcMemHandle_t*>(
                 request.raw_handle().c_str()),
-            request.byte_size(), request.device_id());
+            request.byte_size(), request.device_id(), &handle);
+        if (err == nullptr) {
+          SetSharedMemoryHandle(response, handle);
+        }
 #else
         err = TRITONSERVER_ErrorNew(
             TRITONSERVER_ERROR_INVALID_ARG,
@@ -1972,7 +2052,8 @@ CommonHandler::RegisterCudaSharedMemoryRegister()
       inference::CudaSharedMemoryRegisterRequest,
       inference::CudaSharedMemoryRegisterResponse>(
       "CudaSharedMemoryRegister", 0, OnRegisterCudaSharedMemoryRegister,
-      OnExecuteCudaSharedMemoryRegister, false /* async */, cq_, restricted_kv);
+      OnExecuteCudaSharedMemoryRegister, true /* async */, cq_, restricted_kv,
+      control_plane_executor_.get());
 }
 
 void
@@ -2015,8 +2096,8 @@ CommonHandler::RegisterCudaSharedMemoryUnregister()
       inference::CudaSharedMemoryUnregisterRequest,
       inference::CudaSharedMemoryUnregisterResponse>(
       "CudaSharedMemoryUnregister", 0, OnRegisterCudaSharedMemoryUnregister,
-      OnExecuteCudaSharedMemoryUnregister, false /* async */, cq_,
-      restricted_kv);
+      OnExecuteCudaSharedMemoryUnregister, true /* async */, cq_,
+      restricted_kv, control_plane_executor_.get());
 }
 
 void
@@ -2232,7 +2313,8 @@ CommonHandler::RegisterRepositoryModelLoad()
       inference::RepositoryModelLoadRequest,
       inference::RepositoryModelLoadResponse>(
       "RepositoryModelLoad", 0, OnRegisterRepositoryModelLoad,
-      OnExecuteRepositoryModelLoad, true /* async */, cq_, restricted_kv);
+      OnExecuteRepositoryModelLoad, true /* async */, cq_, restricted_kv,
+      control_plane_executor_.get());
 }
 
 void
@@ -2302,7 +2384,8 @@ CommonHandler::RegisterRepositoryModelUnload()
       inference::RepositoryModelUnloadRequest,
       inference::RepositoryModelUnloadResponse>(
       "RepositoryModelUnload", 0, OnRegisterRepositoryModelUnload,
-      OnExecuteRepositoryModelUnload, true /* async */, cq_, restricted_kv);
+      OnExecuteRepositoryModelUnload, true /* async */, cq_, restricted_kv,
+      control_plane_executor_.get());
 }
 
 }  // namespace
@@ -2314,11 +2397,15 @@ Server::Server(
     const std::shared_ptr<TRITONSERVER_Server>& tritonserver,
     triton::server::TraceManager* trace_manager,
     const std::shared_ptr<SharedMemoryManager>& shm_manager,
+    const std::shared_ptr<ControlPlaneExecutor>& control_plane_executor,
+    const std::shared_ptr<LoadReporter>& load_reporter,
+    const std::shared_ptr<InferRequestPool>& request_pool,
     const Options& options)
     : tritonserver_(tritonserver), trace_manager_(trace_manager),
       shm_manager_(shm_manager), server_addr_(
                                      options.socket_.address_ + ":" +
-                                     std::to_string(options.socket_.port_))
+                                     std::to_string(options.socket_.port_)),
+      request_pool_(request_pool)
 {
   std::shared_ptr<::grpc::ServerCredentials> credentials;
   const auto& ssl_options = options.ssl_;
@@ -2346,9 +2433,51 @@ Server::Server(
   builder_.SetMaxMessageSize(MAX_GRPC_MESSAGE_SIZE);
   builder_.RegisterService(&service_);
   builder_.RegisterService(&health_service_);
+  builder_.RegisterService(&batch_service_);
+  builder_.RegisterService(&chunked_service_);
+  if (load_reporter != nullptr) {
+    builder_.RegisterService(&orca_service_);
+  }
   builder_.AddChannelArgument(
       GRPC_ARG_ALLOW_REUSEPORT, options.socket_.reuse_port_);
 
+  std::vector<
+      std::unique_ptr<::grpc::experimental::ServerInterceptorFactoryInterface>>
+      interceptor_creators;
+  if (options.transport_metrics_) {
+    // The RPCs, messages and bytes of every method are counted by an
+    // interceptor, the stages of the inference RPCs are timed by their
+    // handlers.
+    transport_metrics_ = std::make_shared<TransportMetrics>(
+        std::vector<std::string>{
+            "inference.GRPCInferenceService",
+            "inference.GRPCInferenceBatchService",
+            "inference.GRPCInferenceChunkedService"},
+        std::vector<std::string>{
+            "/inference.GRPCInferenceService/ModelInfer",
+            "/inference.GRPCInferenceService/ModelStreamInfer"});
+    interceptor_creators.emplace_back(
+        new TransportMetricsInterceptorFactory(transport_metrics_));
+  }
+  if (options.stage_metrics_) {
+    stage_metrics_ = std::make_shared<FrontendStageMetrics>("grpc");
+  }
+  if (load_reporter != nullptr) {
+    // The load report is attached to the responses of the inference
+    // RPCs, and streamed by the out-of-band ORCA service.
+    interceptor_creators.emplace_back(new LoadReportInterceptorFactory(
+        load_reporter, std::make_shared<OrcaReportEncoder>(load_reporter),
+        std::set<std::string>{
+            "/inference.GRPCInferenceService/ModelInfer",
+            "/inference.GRPCInferenceService/ModelStreamInfer",
+            "/inference.GRPCInferenceBatchService/ModelInferBatch",
+            "/inference.GRPCInferenceChunkedService/ModelInferChunked"}));
+  }
+  if (!interceptor_creators.empty()) {
+    builder_.experimental().SetInterceptorCreators(
+        std::move(interceptor_creators));
+  }
+
   {
     // GRPC KeepAlive Docs:
     // https://grpc.github.io/grpc/cpp/md_doc_keepalive.html NOTE: In order to
@@ -2410,6 +2539,11 @@ Server::Server(
   common_cq_ = builder_.AddCompletionQueue();
   model_infer_cq_ = builder_.AddCompletionQueue();
   model_stream_infer_cq_ = builder_.AddCompletionQueue();
+  model_infer_batch_cq_ = builder_.AddCompletionQueue();
+  model_infer_chunked_cq_ = builder_.AddCompletionQueue();
+  if (load_reporter != nullptr) {
+    orca_cq_ = builder_.AddCompletionQueue();
+  }
 
   // Read and set restriction for each protocol specified
   // map from protocol name to a pair of header to look for and the key
@@ -2431,7 +2565,8 @@ Server::Server(
   // A common Handler for other non-inference requests
   common_handler_.reset(new CommonHandler(
       "CommonHandler", tritonserver_, shm_manager_, trace_manager_, &service_,
-      &health_service_, common_cq_.get(), restricted_keys));
+      &health_service_, common_cq_.get(), restricted_keys,
+      control_plane_executor));
 
   // [FIXME] "register" logic is different for infer
   // Handler for model inference requests.
@@ -2441,22 +2576,62 @@ Server::Server(
           ? std::pair<std::string, std::string>{"", ""}
           : it->second;
   for (int i = 0; i < REGISTER_GRPC_INFER_THREAD_COUNT; ++i) {
-    model_infer_handlers_.emplace_back(new ModelInferHandler(
+    ModelInferHandler* handler = new ModelInferHandler(
         "ModelInferHandler", tritonserver_, trace_manager_, shm_manager_,
         &service_, model_infer_cq_.get(),
         options.infer_allocation_pool_size_ /* max_state_bucket_count */,
         options.infer_compression_level_, restricted_kv,
-        options.forward_header_pattern_));
+        options.forward_header_pattern_);
+    if (transport_metrics_ != nullptr) {
+      handler->SetTransportMetrics(transport_metrics_->Method(
+          "/inference.GRPCInferenceService/ModelInfer"));
+    }
+    handler->SetStageMetrics(stage_metrics_.get());
+    handler->SetRequestPool(request_pool_.get());
+    model_infer_handlers_.emplace_back(handler);
   }
 
   // Handler for streaming inference requests. Keeps one handler for streaming
   // to avoid possible concurrent writes which is not allowed
-  model_stream_infer_handlers_.emplace_back(new ModelStreamInferHandler(
+  ModelStreamInferHandler* stream_handler = new ModelStreamInferHandler(
       "ModelStreamInferHandler", tritonserver_, trace_manager_, shm_manager_,
       &service_, model_stream_infer_cq_.get(),
       options.infer_allocation_pool_size_ /* max_state_bucket_count */,
       options.infer_compression_level_, restricted_kv,
+      options.forward_header_pattern_, options.stream_write_coalescing_,
+      options.stream_write_coalescing_delay_us_,
+      options.stream_response_buffer_bytes_,
+      options.stream_response_buffer_count_);
+  if (transport_metrics_ != nullptr) {
+    stream_handler->SetTransportMetrics(transport_metrics_->Method(
+        "/inference.GRPCInferenceService/ModelStreamInfer"));
+  }
+  stream_handler->SetStageMetrics(stage_metrics_.get());
+  model_stream_infer_handlers_.emplace_back(stream_handler);
+
+  // Handler for batched inference requests. Uses its own completion
+  // queue as the handler threads only recognize their own state type.
+  model_infer_batch_handler_.reset(new ModelInferBatchHandler(
+      "ModelInferBatchHandler", tritonserver_, trace_manager_, shm_manager_,
+      &batch_service_, model_infer_batch_cq_.get(),
+      options.infer_allocation_pool_size_ /* max_state_bucket_count */,
+      options.infer_compression_level_, restricted_kv,
       options.forward_header_pattern_));
+
+  // Handler for inference requests with tensors sent in chunks.
+  model_infer_chunked_handler_.reset(new ModelInferChunkedHandler(
+      "ModelInferChunkedHandler", tritonserver_, trace_manager_,
+      &chunked_service_, model_infer_chunked_cq_.get(),
+      options.infer_allocation_pool_size_ /* max_state_bucket_count */,
+      options.infer_compression_level_, restricted_kv,
+      options.forward_header_pattern_,
+      options.infer_chunked_max_input_bytes_));
+
+  // Handler for the out-of-band load reports.
+  if (load_reporter != nullptr) {
+    orca_handler_.reset(new OrcaHandler(
+        "OrcaHandler", load_reporter, &orca_service_, orca_cq_.get()));
+  }
 }
 
 Server::~Server()
@@ -2469,13 +2644,18 @@ Server::Create(
     const std::shared_ptr<TRITONSERVER_Server>& tritonserver,
     triton::server::TraceManager* trace_manager,
     const std::shared_ptr<SharedMemoryManager>& shm_manager,
+    const std::shared_ptr<ControlPlaneExecutor>& control_plane_executor,
+    const std::shared_ptr<LoadReporter>& load_reporter,
+    const std::shared_ptr<InferRequestPool>& request_pool,
     const Options& server_options, std::unique_ptr<Server>* server)
 {
   const std::string addr = server_options.socket_.address_ + ":" +
                            std::to_string(server_options.socket_.port_);
   try {
     server->reset(
-        new Server(tritonserver, trace_manager, shm_manager, server_options));
+        new Server(
+            tritonserver, trace_manager, shm_manager, control_plane_executor,
+            load_reporter, request_pool, server_options));
   }
   catch (const std::invalid_argument& pe) {
     return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, pe.what());
@@ -2508,6 +2688,11 @@ Server::Start()
   for (auto& model_stream_infer_handler : model_stream_infer_handlers_) {
     model_stream_infer_handler->Start();
   }
+  model_infer_batch_handler_->Start();
+  model_infer_chunked_handler_->Start();
+  if (orca_handler_ != nullptr) {
+    orca_handler_->Start();
+  }
 
   running_ = true;
   LOG_INFO << "Started GRPCInferenceService at " << server_addr_;
@@ -2522,12 +2707,23 @@ Server::Stop()
         TRITONSERVER_ERROR_UNAVAILABLE, "GRPC server is not running.");
   }
 
+  // The load report streams only end when the clients cancel them,
+  // complete them so that they don't hold up the shutdown.
+  if (orca_handler_ != nullptr) {
+    orca_handler_->Drain();
+  }
+
   // Always shutdown the completion queue after the server.
   server_->Shutdown();
 
   common_cq_->Shutdown();
   model_infer_cq_->Shutdown();
   model_stream_infer_cq_->Shutdown();
+  model_infer_batch_cq_->Shutdown();
+  model_infer_chunked_cq_->Shutdown();
+  if (orca_cq_ != nullptr) {
+    orca_cq_->Shutdown();
+  }
 
   // Must stop all handlers explicitly to wait for all the handler
   // threads to join since they are referencing completion queue, etc.
@@ -2538,6 +2734,11 @@ Server::Stop()
   for (auto& model_stream_infer_handler : model_stream_infer_handlers_) {
     model_stream_infer_handler->Stop();
   }
+  model_infer_batch_handler_->Stop();
+  model_infer_chunked_handler_->Stop();
+  if (orca_handler_ != nullptr) {
+    orca_handler_->Stop();
+  }
 
   running_ = false;
   return nullptr;  // success
@@ -29,14 +29,19 @@
 
 #include <vector>
 
+#include "../control_plane_executor.h"
 #include "../shared_memory_manager.h"
 #include "../tracer.h"
 #include "grpc_handler.h"
 #include "grpc_service.grpc.pb.h"
 #include "grpc_utils.h"
 #include "health.grpc.pb.h"
+#include "infer_batch_handler.h"
+#include "infer_chunked_handler.h"
 #include "infer_handler.h"
+#include "orca_service.h"
 #include "stream_infer_handler.h"
+#include "transport_metrics.h"
 #include "triton/core/tritonserver.h"
 
 namespace triton { namespace server { namespace grpc {
@@ -92,6 +97,25 @@ struct Options {
   int infer_allocation_pool_size_{8};
   std::vector<ProtocolGroup> protocol_groups_{};
   std::string forward_header_pattern_;
+  // Whether decoupled responses that are ready at the same time on a
+  // stream are coalesced into a single transport write, and the
+  // maximum time in microseconds a lone response may be held back
+  // waiting for more responses to coalesce with.
+  bool stream_write_coalescing_{false};
+  int stream_write_coalescing_delay_us_{0};
+  // The maximum bytes and number of decoupled responses a stream may
+  // buffer before it stops reading new requests, 0 for unlimited.
+  int64_t stream_response_buffer_bytes_{0};
+  int stream_response_buffer_count_{0};
+  // The maximum total byte size of the inputs of a ModelInferChunked
+  // request, checked before the input buffer is allocated.
+  int64_t infer_chunked_max_input_bytes_{int64_t(8) << 30};
+  // Whether transport-level metrics of the GRPC methods are reported
+  // on the metrics endpoint.
+  bool transport_metrics_{false};
+  // Whether the latency of the frontend stages of the inference RPCs is
+  // reported on the metrics endpoint.
+  bool stage_metrics_{false};
 };
 
 class Server {
@@ -100,6 +124,9 @@ class Server {
       const std::shared_ptr<TRITONSERVER_Server>& tritonserver,
       triton::server::TraceManager* trace_manager,
       const std::shared_ptr<SharedMemoryManager>& shm_manager,
+      const std::shared_ptr<ControlPlaneExecutor>& control_plane_executor,
+      const std::shared_ptr<LoadReporter>& load_reporter,
+      const std::shared_ptr<InferRequestPool>& request_pool,
       const Options& server_options, std::unique_ptr<Server>* server);
 
   ~Server();
@@ -112,6 +139,9 @@ class Server {
       const std::shared_ptr<TRITONSERVER_Server>& tritonserver,
       triton::server::TraceManager* trace_manager,
       const std::shared_ptr<SharedMemoryManager>& shm_manager,
+      const std::shared_ptr<ControlPlaneExecutor>& control_plane_executor,
+      const std::shared_ptr<LoadReporter>& load_reporter,
+      const std::shared_ptr<InferRequestPool>& request_pool,
       const Options& server_options);
 
   std::shared_ptr<TRITONSERVER_Server> tritonserver_;
@@ -119,20 +149,40 @@ class Server {
   std::shared_ptr<SharedMemoryManager> shm_manager_;
   const std::string server_addr_;
 
+  // nullptr if transport metrics are not reported.
+  std::shared_ptr<TransportMetrics> transport_metrics_;
+
+  // nullptr if frontend stage metrics are not reported.
+  std::shared_ptr<FrontendStageMetrics> stage_metrics_;
+
+  // nullptr if inference requests are not reused.
+  std::shared_ptr<InferRequestPool> request_pool_;
+
   ::grpc::ServerBuilder builder_;
 
   inference::GRPCInferenceService::AsyncService service_;
   ::grpc::health::v1::Health::AsyncService health_service_;
+  inference::GRPCInferenceBatchService::AsyncService batch_service_;
+  inference::GRPCInferenceChunkedService::AsyncService chunked_service_;
+  // Only registered if load reporting is enabled.
+  xds::service::orca::v3::OpenRcaService::AsyncService orca_service_;
 
   std::unique_ptr<::grpc::Server> server_;
 
   std::unique_ptr<::grpc::ServerCompletionQueue> common_cq_;
   std::unique_ptr<::grpc::ServerCompletionQueue> model_infer_cq_;
   std::unique_ptr<::grpc::ServerCompletionQueue> model_stream_infer_cq_;
+  std::unique_ptr<::grpc::ServerCompletionQueue> model_infer_batch_cq_;
+  std::unique_ptr<::grpc::ServerCompletionQueue> model_infer_chunked_cq_;
+  std::unique_ptr<::grpc::ServerCompletionQueue> orca_cq_;
 
   std::unique_ptr<HandlerBase> common_handler_;
   std::vector<std::unique_ptr<HandlerBase>> model_infer_handlers_;
   std::vector<std::unique_ptr<HandlerBase>> model_stream_infer_handlers_;
+  std::unique_ptr<HandlerBase> model_infer_batch_handler_;
+  std::unique_ptr<HandlerBase> model_infer_chunked_handler_;
+  // nullptr if load reporting is not enabled.
+  std::unique_ptr<OrcaHandler> orca_handler_;
 
   int bound_port_{0};
   bool running_{false};
@@ -92,25 +92,35 @@ template <typename TensorType>
 TRITONSERVER_Error*
 ParseSharedMemoryParams(
     const TensorType& tensor, bool* has_shared_memory, std::string* region_name,
-    int64_t* offset, size_t* byte_size)
+    uint64_t* region_handle, int64_t* offset, size_t* byte_size)
 {
   *has_shared_memory = false;
+  *region_handle = 0 /* lookup by name */;
   *offset = 0 /* default value */;
   const auto& region_it = tensor.parameters().find("shared_memory_region");
   if (region_it != tensor.parameters().end()) {
     *has_shared_memory = true;
     const auto& infer_param = region_it->second;
-    if (infer_param.parameter_choice_case() !=
+    // The region can be named either by the name it was registered with
+    // or by the handle returned from registration.
+    if (infer_param.parameter_choice_case() ==
         inference::InferParameter::ParameterChoiceCase::kStringParam) {
+      *region_name = infer_param.string_param();
+    } else if (
+        (infer_param.parameter_choice_case() ==
+         inference::InferParameter::ParameterChoiceCase::kInt64Param) &&
+        (infer_param.int64_param() > 0)) {
+      *region_handle = infer_param.int64_param();
+    } else {
       return TRITONSERVER_ErrorNew(
           TRITONSERVER_ERROR_INVALID_ARG,
           std::string(
               "invalid value type for 'shared_memory_region' parameter for "
               "tensor '" +
-              tensor.name() + "', expected string_param.")
+              tensor.name() +
+              "', expected string_param or positive int64_param.")
               .c_str());
     }
-    *region_name = infer_param.string_param();
   }
 
   const auto& offset_it = tensor.parameters().find("shared_memory_offset");
@@ -0,0 +1,466 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "infer_batch_handler.h"
+
+namespace triton { namespace server { namespace grpc {
+
+//===========================================================================
+//  The following section contains the handling mechanism for
+//  ModelInferBatch RPC. The requests of the batch share the RPC overhead
+//  but are otherwise processed the same as ModelInfer requests.
+//===========================================================================
+
+ModelInferBatchHandler::ModelInferBatchHandler(
+    const std::string& name,
+    const std::shared_ptr<TRITONSERVER_Server>& tritonserver,
+    TraceManager* trace_manager,
+    const std::shared_ptr<SharedMemoryManager>& shm_manager,
+    inference::GRPCInferenceBatchService::AsyncService* service,
+    ::grpc::ServerCompletionQueue* cq, size_t max_state_bucket_count,
+    grpc_compression_level compression_level,
+    std::pair<std::string, std::string> restricted_kv,
+    const std::string& forward_header_pattern)
+    : InferHandler(
+          name, tritonserver, service, cq, max_state_bucket_count,
+          restricted_kv, forward_header_pattern),
+      trace_manager_(trace_manager), shm_manager_(shm_manager),
+      compression_level_(compression_level)
+{
+  // Create the allocator that will be used to allocate buffers for
+  // the result tensors. The buffers are created directly in the
+  // response of each item so there is no start function.
+  FAIL_IF_ERR(
+      TRITONSERVER_ResponseAllocatorNew(
+          &allocator_, BatchInferResponseAlloc, InferResponseFree,
+          nullptr /* start_fn */),
+      "creating inference response allocator");
+  FAIL_IF_ERR(
+      TRITONSERVER_ResponseAllocatorSetQueryFunction(
+          allocator_, BatchOutputBufferQuery),
+      "setting allocator's query function");
+  FAIL_IF_ERR(
+      TRITONSERVER_ResponseAllocatorSetBufferAttributesFunction(
+          allocator_, BatchOutputBufferAttributes),
+      "setting allocator's output buffer attributes function");
+}
+
+ModelInferBatchHandler::~ModelInferBatchHandler()
+{
+  LOG_TRITONSERVER_ERROR(
+      TRITONSERVER_ResponseAllocatorDelete(allocator_),
+      "deleting response allocator");
+}
+
+// Make sure to keep BatchInferResponseAlloc and BatchOutputBufferQuery
+// logic in sync with InferResponseAlloc and OutputBufferQuery
+TRITONSERVER_Error*
+ModelInferBatchHandler::BatchInferResponseAlloc(
+    TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
+    size_t byte_size, TRITONSERVER_MemoryType preferred_memory_type,
+    int64_t preferred_memory_type_id, void* userp, void** buffer,
+    void** buffer_userp, TRITONSERVER_MemoryType* actual_memory_type,
+    int64_t* actual_memory_type_id)
+{
+  BatchItem* item = reinterpret_cast<BatchItem*>(userp);
+  // The allocations of the items are kept with the state which outlives
+  // the batch until the batch response is sent, each item is a response.
+  State* state = item->batch_->state_;
+  return ResponseAllocatorHelper(
+      allocator, tensor_name, byte_size, preferred_memory_type,
+      preferred_memory_type_id, item->response_item_->mutable_response(),
+      item->alloc_payload_.shm_map_, &state->alloc_payload_.pool_allocations_,
+      item - item->batch_->items_.data(), buffer, buffer_userp,
+      actual_memory_type, actual_memory_type_id);
+}
+
+TRITONSERVER_Error*
+ModelInferBatchHandler::BatchOutputBufferQuery(
+    TRITONSERVER_ResponseAllocator* allocator, void* userp,
+    const char* tensor_name, size_t* byte_size,
+    TRITONSERVER_MemoryType* memory_type, int64_t* memory_type_id)
+{
+  BatchItem* item = reinterpret_cast<BatchItem*>(userp);
+  return OutputBufferQueryHelper(
+      allocator, tensor_name, byte_size, item->alloc_payload_.shm_map_,
+      memory_type, memory_type_id);
+}
+
+TRITONSERVER_Error*
+ModelInferBatchHandler::BatchOutputBufferAttributes(
+    TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
+    TRITONSERVER_BufferAttributes* buffer_attributes, void* userp,
+    void* buffer_userp)
+{
+  BatchItem* item = reinterpret_cast<BatchItem*>(userp);
+  return OutputBufferAttributesHelper(
+      allocator, tensor_name, item->alloc_payload_.shm_map_,
+      buffer_attributes);
+}
+
+void
+ModelInferBatchHandler::StartNewRequest()
+{
+  auto context = std::make_shared<State::Context>(cq_);
+  context->SetCompressionLevel(compression_level_);
+  State* state = StateNew(tritonserver_.get(), context);
+
+#ifdef TRITON_ENABLE_TRACING
+  // Can't create trace as we don't know the model to be requested,
+  // track timestamps in 'state'
+  state->trace_timestamps_.Capture(
+      FrontendStage::GRPC_WAITREAD_START, TraceManager::CaptureTimestamp());
+#endif  // TRITON_ENABLE_TRACING
+
+  service_->RequestModelInferBatch(
+      state->context_->ctx_.get(), state->request_,
+      state->context_->responder_.get(), cq_, cq_, state);
+
+  LOG_VERBOSE(1) << "New request handler for " << Name() << ", "
+                 << state->unique_id_;
+}
+
+bool
+ModelInferBatchHandler::Process(InferHandler::State* state, bool rpc_ok)
+{
+  std::lock_guard<std::recursive_mutex> lock(state->step_mtx_);
+
+  // Handle notification for cancellation which can be raised
+  // asynchronously if detected on the network. The requests of the
+  // batch are not tracked as inflight so the state is released once
+  // the batch completes.
+  if (state->IsGrpcContextCancelled()) {
+    bool resume = state->context_->HandleCancellation(state, rpc_ok, Name());
+    return resume;
+  }
+
+  LOG_VERBOSE(1) << "Process for " << Name() << ", rpc_ok=" << rpc_ok << ", "
+                 << state->unique_id_ << " step " << state->step_;
+
+  bool finished = false;
+
+  // If RPC failed on a new request then the server is shutting down
+  // and so we should do nothing (including not registering for a new
+  // request).
+  const bool shutdown = (!rpc_ok && (state->step_ == Steps::START));
+  if (shutdown) {
+    state->step_ = Steps::FINISH;
+    finished = true;
+  }
+
+  if (state->step_ == Steps::START) {
+#ifdef TRITON_ENABLE_TRACING
+    state->trace_timestamps_.Capture(
+        FrontendStage::GRPC_WAITREAD_END, TraceManager::CaptureTimestamp());
+#endif  // TRITON_ENABLE_TRACING
+
+    // Start a new request to replace this one...
+    if (!shutdown) {
+      StartNewRequest();
+    }
+
+    if (ExecutePrecondition(state)) {
+      Execute(state);
+    } else {
+      ::grpc::Status status = ::grpc::Status(
+          ::grpc::StatusCode::UNAVAILABLE,
+          std::string("This protocol is restricted, expecting header '") +
+              restricted_kv_.first + "'");
+
+#ifdef TRITON_ENABLE_TRACING
+      state->trace_timestamps_.Capture(
+          FrontendStage::GRPC_SEND_START, TraceManager::CaptureTimestamp());
+#endif  // TRITON_ENABLE_TRACING
+
+      state->step_ = COMPLETE;
+      state->context_->responder_->Finish(
+          inference::ModelInferBatchResponse(), status, state);
+    }
+  } else if (state->step_ == Steps::COMPLETE) {
+#ifdef TRITON_ENABLE_TRACING
+    state->trace_timestamps_.Capture(
+        FrontendStage::GRPC_SEND_END, TraceManager::CaptureTimestamp());
+#endif  // TRITON_ENABLE_TRACING
+
+    // The outputs allocated in pools belong to the client once the
+    // response is sent, they are released otherwise.
+    if (rpc_ok) {
+      state->alloc_payload_.pool_allocations_.Deliver();
+    } else {
+      state->alloc_payload_.pool_allocations_.Release();
+    }
+
+    state->step_ = Steps::FINISH;
+  } else if (state->step_ == Steps::FINISH) {
+    finished = true;
+  }
+
+  return !finished;
+}
+
+void
+ModelInferBatchHandler::Execute(InferHandler::State* state)
+{
+  const inference::ModelInferBatchRequest& batch_request = *state->request_;
+  inference::ModelInferBatchResponse* batch_response =
+      state->response_queue_->GetNonDecoupledResponse();
+
+  // Create all the response items before issuing any request so that
+  // the items are not moved while the responses are being filled
+  // concurrently.
+  BatchPayload* batch = new BatchPayload(state, batch_request.requests_size());
+  for (auto& item : batch->items_) {
+    item.batch_ = batch;
+    item.response_item_ = batch_response->add_responses();
+    item.response_item_->mutable_response();
+  }
+
+  state->step_ = ISSUED;
+  for (int i = 0; i < batch_request.requests_size(); ++i) {
+    BatchItem* item = &batch->items_[i];
+    TRITONSERVER_Error* err =
+        ExecuteItem(state, batch_request.requests(i), item);
+    if (err != nullptr) {
+      // The request was not issued so no callback will be invoked for
+      // the item.
+      SetItemError(item, err);
+      TRITONSERVER_ErrorDelete(err);
+      BatchEventComplete(batch, 2);
+    }
+  }
+
+  // All items are issued, release the count held by Execute().
+  BatchEventComplete(batch, 1);
+}
+
+TRITONSERVER_Error*
+ModelInferBatchHandler::ExecuteItem(
+    InferHandler::State* state, const inference::ModelInferRequest& request,
+    BatchItem* item)
+{
+  TRITONSERVER_Error* err = nullptr;
+  int64_t requested_model_version;
+  if (err == nullptr) {
+    err = GetModelVersionFromString(
+        request.model_version(), &requested_model_version);
+  }
+
+  if (err == nullptr) {
+    uint32_t txn_flags;
+    err = TRITONSERVER_ServerModelTransactionProperties(
+        tritonserver_.get(), request.model_name().c_str(),
+        requested_model_version, &txn_flags, nullptr /* voidp */);
+    if ((err == nullptr) && (txn_flags & TRITONSERVER_TXN_DECOUPLED) != 0) {
+      err = TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_UNSUPPORTED,
+          "ModelInferBatch RPC doesn't support models with decoupled "
+          "transaction policy");
+    }
+  }
+
+  TRITONSERVER_InferenceRequest* irequest = nullptr;
+  if (err == nullptr) {
+    err = TRITONSERVER_InferenceRequestNew(
+        &irequest, tritonserver_.get(), request.model_name().c_str(),
+        requested_model_version);
+  }
+
+  // The state parameters only apply to stream requests.
+  StateParameters parameters;
+  if (err == nullptr) {
+    err = SetInferenceRequestMetadata(irequest, request, parameters);
+  }
+
+  if (err == nullptr) {
+    err = ForwardHeadersAsParameters(irequest, state);
+  }
+
+  // Will be used to hold the serialized data in case explicit string
+  // tensors are present in the request.
+  std::list<std::string> serialized_data;
+  // Keeps the shared memory regions used by the inputs mapped until
+  // the request is released.
+  std::vector<SharedMemoryManager::Reference> shm_references;
+
+  if (err == nullptr) {
+    err = InferGRPCToInput(
+        tritonserver_, shm_manager_, request, &serialized_data,
+        &shm_references, irequest);
+  }
+  if (err == nullptr) {
+    err = InferAllocatorPayload<inference::ModelInferResponse>(
+        tritonserver_, shm_manager_, request, std::move(serialized_data),
+        std::move(shm_references), nullptr /* response_queue */,
+        &item->alloc_payload_);
+  }
+  if (err == nullptr) {
+    err = TRITONSERVER_InferenceRequestSetReleaseCallback(
+        irequest, BatchInferRequestComplete,
+        item /* request_release_userp */);
+  }
+  if (err == nullptr) {
+    err = TRITONSERVER_InferenceRequestSetResponseCallback(
+        irequest, allocator_, item /* response_allocator_userp */,
+        BatchInferResponseComplete, item);
+  }
+  if (err == nullptr) {
+    TRITONSERVER_InferenceTrace* triton_trace = nullptr;
+#ifdef TRITON_ENABLE_TRACING
+    item->trace_ = std::move(trace_manager_->SampleTrace(request.model_name()));
+    if (item->trace_ != nullptr) {
+      triton_trace = item->trace_->trace_;
+    }
+#endif  // TRITON_ENABLE_TRACING
+
+    err = TRITONSERVER_ServerInferAsync(
+        tritonserver_.get(), irequest, triton_trace);
+  }
+
+  if (err != nullptr) {
+    LOG_VERBOSE(1) << "[request id: " << request.id() << "] "
+                   << "Infer failed: " << TRITONSERVER_ErrorMessage(err);
+    LOG_TRITONSERVER_ERROR(
+        TRITONSERVER_InferenceRequestDelete(irequest),
+        "deleting GRPC inference request");
+  }
+
+  return err;
+}
+
+void
+ModelInferBatchHandler::SetItemError(BatchItem* item, TRITONSERVER_Error* err)
+{
+  ::grpc::Status status;
+  GrpcStatusUtil::Create(&status, err);
+  item->response_item_->mutable_response()->Clear();
+  item->response_item_->set_code(status.error_code());
+  item->response_item_->set_message(status.error_message());
+
+  // The client doesn't learn where the outputs of the item were
+  // allocated.
+  item->batch_->state_->alloc_payload_.pool_allocations_.ReleaseResponse(
+      item - item->batch_->items_.data());
+}
+
+void
+ModelInferBatchHandler::BatchInferRequestComplete(
+    TRITONSERVER_InferenceRequest* request, const uint32_t flags, void* userp)
+{
+  LOG_VERBOSE(1) << "ModelInferBatchHandler::BatchInferRequestComplete";
+
+  if ((flags & TRITONSERVER_REQUEST_RELEASE_ALL) != 0) {
+    LOG_TRITONSERVER_ERROR(
+        TRITONSERVER_InferenceRequestDelete(request),
+        "deleting GRPC inference request");
+
+    // The input data referenced by the request is owned by the batch
+    // so the batch must not complete before the request is released.
+    BatchItem* item = reinterpret_cast<BatchItem*>(userp);
+    BatchEventComplete(item->batch_, 1);
+  }
+}
+
+void
+ModelInferBatchHandler::BatchInferResponseComplete(
+    TRITONSERVER_InferenceResponse* iresponse, const uint32_t flags,
+    void* userp)
+{
+  BatchItem* item = reinterpret_cast<BatchItem*>(userp);
+
+  // Defer to the callback with the final response
+  if ((flags & TRITONSERVER_RESPONSE_COMPLETE_FINAL) == 0) {
+    LOG_ERROR << "[INTERNAL] ModelInferBatch received a response without "
+                 "FINAL flag";
+    if (iresponse != nullptr) {
+      LOG_TRITONSERVER_ERROR(
+          TRITONSERVER_InferenceResponseDelete(iresponse),
+          "deleting GRPC inference response");
+    }
+    return;
+  }
+
+  TRITONSERVER_Error* err = nullptr;
+  if (iresponse == nullptr) {
+    err = TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL, "received an unexpected null response");
+  } else {
+    // Each item is only accessed by its own callbacks so the items of
+    // the batch can be completed concurrently.
+    err = InferResponseCompleteCommon<inference::ModelInferResponse>(
+        item->batch_->state_->tritonserver_, iresponse,
+        *item->response_item_->mutable_response(), item->alloc_payload_);
+    LOG_TRITONSERVER_ERROR(
+        TRITONSERVER_InferenceResponseDelete(iresponse),
+        "deleting GRPC inference response");
+  }
+
+  if (err != nullptr) {
+    SetItemError(item, err);
+    TRITONSERVER_ErrorDelete(err);
+  }
+
+  BatchEventComplete(item->batch_, 1);
+}
+
+void
+ModelInferBatchHandler::BatchEventComplete(BatchPayload* batch, size_t count)
+{
+  if (batch->pending_.fetch_sub(count) != count) {
+    return;
+  }
+
+  State* state = batch->state_;
+  delete batch;
+
+  std::lock_guard<std::recursive_mutex> lock(state->step_mtx_);
+
+  LOG_VERBOSE(1) << "ModelInferBatchHandler::BatchEventComplete, "
+                 << state->unique_id_ << " step " << state->step_;
+
+#ifdef TRITON_ENABLE_TRACING
+  state->trace_timestamps_.Capture(
+      FrontendStage::INFER_RESPONSE_COMPLETE, TraceManager::CaptureTimestamp());
+#endif  // TRITON_ENABLE_TRACING
+
+  // If gRPC Stream is cancelled then no need of returning a response.
+  if (state->IsGrpcContextCancelled()) {
+    state->step_ = Steps::CANCELLED;
+    // Send state back to the queue so that state can be released
+    // in the next cycle.
+    state->context_->PutTaskBackToQueue(state);
+    return;
+  }
+
+#ifdef TRITON_ENABLE_TRACING
+  state->trace_timestamps_.Capture(
+      FrontendStage::GRPC_SEND_START, TraceManager::CaptureTimestamp());
+#endif  // TRITON_ENABLE_TRACING
+
+  state->step_ = COMPLETE;
+  state->context_->responder_->Finish(
+      *state->response_queue_->GetResponseAt(0), ::grpc::Status::OK, state);
+}
+
+}}}  // namespace triton::server::grpc
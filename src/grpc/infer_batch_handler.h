@@ -0,0 +1,140 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "grpc_batch_service.grpc.pb.h"
+#include "infer_handler.h"
+
+namespace triton { namespace server { namespace grpc {
+
+//
+// ModelInferBatchHandler
+//
+// Handles the ModelInferBatch RPC. Every request of the batch is
+// submitted to Triton as an independent inference request so that the
+// scheduler of the model (e.g. the dynamic batcher) can combine them,
+// and the responses are returned in a single RPC, in request order,
+// once all of them are complete.
+//
+class ModelInferBatchHandler
+    : public InferHandler<
+          inference::GRPCInferenceBatchService::AsyncService,
+          ::grpc::ServerAsyncResponseWriter<
+              inference::ModelInferBatchResponse>,
+          inference::ModelInferBatchRequest,
+          inference::ModelInferBatchResponse> {
+ public:
+  ModelInferBatchHandler(
+      const std::string& name,
+      const std::shared_ptr<TRITONSERVER_Server>& tritonserver,
+      TraceManager* trace_manager,
+      const std::shared_ptr<SharedMemoryManager>& shm_manager,
+      inference::GRPCInferenceBatchService::AsyncService* service,
+      ::grpc::ServerCompletionQueue* cq, size_t max_state_bucket_count,
+      grpc_compression_level compression_level,
+      std::pair<std::string, std::string> restricted_kv,
+      const std::string& forward_header_pattern);
+
+  ~ModelInferBatchHandler();
+
+ protected:
+  void StartNewRequest() override;
+  bool Process(State* state, bool rpc_ok) override;
+
+ private:
+  struct BatchPayload;
+
+  // The per-request state of a batch. Used as the userp of the
+  // allocator, the request release callback and the response callback
+  // of the corresponding inference request.
+  struct BatchItem {
+    BatchPayload* batch_;
+    // The item of the batch response, owned by the batch response.
+    inference::ModelInferBatchResponse::Item* response_item_;
+    AllocPayload<inference::ModelInferResponse> alloc_payload_;
+#ifdef TRITON_ENABLE_TRACING
+    std::shared_ptr<TraceManager::Trace> trace_;
+#endif  // TRITON_ENABLE_TRACING
+  };
+
+  struct BatchPayload {
+    BatchPayload(State* state, size_t item_count)
+        : state_(state), items_(item_count),
+          // Each item completes after both its final response and its
+          // request release are received, the extra count is held by
+          // Execute() until all items are issued.
+          pending_(2 * item_count + 1)
+    {
+    }
+
+    State* state_;
+    std::vector<BatchItem> items_;
+    std::atomic<size_t> pending_;
+  };
+
+  void Execute(State* state);
+  TRITONSERVER_Error* ExecuteItem(
+      State* state, const inference::ModelInferRequest& request,
+      BatchItem* item);
+
+  // Records that 'count' of the pending events of 'batch' completed and
+  // sends the batch response once there is none left.
+  static void BatchEventComplete(BatchPayload* batch, size_t count);
+  static void SetItemError(BatchItem* item, TRITONSERVER_Error* err);
+
+  static TRITONSERVER_Error* BatchInferResponseAlloc(
+      TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
+      size_t byte_size, TRITONSERVER_MemoryType preferred_memory_type,
+      int64_t preferred_memory_type_id, void* userp, void** buffer,
+      void** buffer_userp, TRITONSERVER_MemoryType* actual_memory_type,
+      int64_t* actual_memory_type_id);
+  static TRITONSERVER_Error* BatchOutputBufferQuery(
+      TRITONSERVER_ResponseAllocator* allocator, void* userp,
+      const char* tensor_name, size_t* byte_size,
+      TRITONSERVER_MemoryType* memory_type, int64_t* memory_type_id);
+  static TRITONSERVER_Error* BatchOutputBufferAttributes(
+      TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
+      TRITONSERVER_BufferAttributes* buffer_attributes, void* userp,
+      void* buffer_userp);
+  static void BatchInferRequestComplete(
+      TRITONSERVER_InferenceRequest* request, const uint32_t flags,
+      void* userp);
+  static void BatchInferResponseComplete(
+      TRITONSERVER_InferenceResponse* response, const uint32_t flags,
+      void* userp);
+
+  TraceManager* trace_manager_;
+  std::shared_ptr<SharedMemoryManager> shm_manager_;
+  TRITONSERVER_ResponseAllocator* allocator_;
+
+  grpc_compression_level compression_level_;
+};
+
+}}}  // namespace triton::server::grpc
@@ -0,0 +1,744 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "infer_chunked_handler.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace triton { namespace server { namespace grpc {
+
+namespace {
+
+// The output chunk byte size used when the request doesn't specify
+// one, and the largest allowed to bound the memory used by a write.
+constexpr size_t kDefaultOutputChunkByteSize = 1 << 20;
+constexpr size_t kMaxOutputChunkByteSize = 64 << 20;
+
+}  // namespace
+
+//===========================================================================
+//  The following section contains the handling mechanism for
+//  ModelInferChunked RPC. The RPC goes through the following steps:
+//
+//    READ: the request header and then the input chunks are read, until
+//          all input contents are received.
+//    ISSUED: the request is executed by Triton.
+//    WRITEREADY: the response is ready, or the request failed.
+//    WRITTEN: the response header and then the output chunks are
+//             written, one per write, until all output contents are
+//             written.
+//    COMPLETE: the RPC is finished.
+//===========================================================================
+
+ModelInferChunkedHandler::Transfer::~Transfer()
+{
+  // The request is only owned by the transfer if it was never issued.
+  if (irequest_ != nullptr) {
+    LOG_TRITONSERVER_ERROR(
+        TRITONSERVER_InferenceRequestDelete(irequest_),
+        "deleting GRPC inference request");
+  }
+  // Deleting the response frees the output buffers.
+  if (iresponse_ != nullptr) {
+    LOG_TRITONSERVER_ERROR(
+        TRITONSERVER_InferenceResponseDelete(iresponse_),
+        "deleting GRPC inference response");
+  }
+}
+
+bool
+ModelInferChunkedHandler::Transfer::InputComplete()
+{
+  while ((input_idx_ < inputs_.size()) &&
+         (input_offset_ == inputs_[input_idx_].byte_size_)) {
+    ++input_idx_;
+    input_offset_ = 0;
+  }
+  return (input_idx_ == inputs_.size());
+}
+
+bool
+ModelInferChunkedHandler::Transfer::OutputComplete()
+{
+  while ((output_idx_ < outputs_.size()) &&
+         (output_offset_ == outputs_[output_idx_].byte_size_)) {
+    ++output_idx_;
+    output_offset_ = 0;
+  }
+  return (output_idx_ == outputs_.size());
+}
+
+ModelInferChunkedHandler::ModelInferChunkedHandler(
+    const std::string& name,
+    const std::shared_ptr<TRITONSERVER_Server>& tritonserver,
+    TraceManager* trace_manager,
+    inference::GRPCInferenceChunkedService::AsyncService* service,
+    ::grpc::ServerCompletionQueue* cq, size_t max_state_bucket_count,
+    grpc_compression_level compression_level,
+    std::pair<std::string, std::string> restricted_kv,
+    const std::string& forward_header_pattern,
+    const size_t max_input_byte_size)
+    : InferHandler(
+          name, tritonserver, service, cq, max_state_bucket_count,
+          restricted_kv, forward_header_pattern),
+      trace_manager_(trace_manager), compression_level_(compression_level),
+      max_input_byte_size_(max_input_byte_size)
+{
+  // The output buffers are allocated separately from the response
+  // messages so that they can be streamed in chunks.
+  FAIL_IF_ERR(
+      TRITONSERVER_ResponseAllocatorNew(
+          &allocator_, ChunkedInferResponseAlloc, ChunkedInferResponseFree,
+          nullptr /* start_fn */),
+      "creating inference response allocator");
+}
+
+ModelInferChunkedHandler::~ModelInferChunkedHandler()
+{
+  LOG_TRITONSERVER_ERROR(
+      TRITONSERVER_ResponseAllocatorDelete(allocator_),
+      "deleting response allocator");
+}
+
+TRITONSERVER_Error*
+ModelInferChunkedHandler::ChunkedInferResponseAlloc(
+    TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
+    size_t byte_size, TRITONSERVER_MemoryType preferred_memory_type,
+    int64_t preferred_memory_type_id, void* userp, void** buffer,
+    void** buffer_userp, TRITONSERVER_MemoryType* actual_memory_type,
+    int64_t* actual_memory_type_id)
+{
+  Transfer* transfer = reinterpret_cast<Transfer*>(userp);
+
+  *buffer = nullptr;
+  *buffer_userp = nullptr;
+  *actual_memory_type = TRITONSERVER_MEMORY_CPU;
+  *actual_memory_type_id = 0;
+
+  // We add an output even if the 'byte_size' == 0 because we expect
+  // to have an output in the response header for every output.
+  inference::ModelInferResponse::InferOutputTensor* output_tensor =
+      transfer->header_->add_outputs();
+  output_tensor->set_name(tensor_name);
+
+  if (byte_size > 0) {
+    *buffer = malloc(byte_size);
+    if (*buffer == nullptr) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INTERNAL,
+          std::string(
+              "unable to allocate " + std::to_string(byte_size) +
+              " bytes for output '" + tensor_name + "'")
+              .c_str());
+    }
+  }
+
+  LOG_VERBOSE(1) << "GRPC: using chunked buffer for '" << tensor_name
+                 << "', size: " << byte_size << ", addr: " << *buffer;
+
+  return nullptr;  // Success
+}
+
+TRITONSERVER_Error*
+ModelInferChunkedHandler::ChunkedInferResponseFree(
+    TRITONSERVER_ResponseAllocator* allocator, void* buffer,
+    void* buffer_userp, size_t byte_size, TRITONSERVER_MemoryType memory_type,
+    int64_t memory_type_id)
+{
+  LOG_VERBOSE(1) << "GRPC free: "
+                 << "size " << byte_size << ", addr " << buffer;
+
+  free(buffer);
+  return nullptr;  // Success
+}
+
+void
+ModelInferChunkedHandler::StartNewRequest()
+{
+  auto context = std::make_shared<State::Context>(cq_);
+  context->SetCompressionLevel(compression_level_);
+  State* state = StateNew(tritonserver_.get(), context);
+
+#ifdef TRITON_ENABLE_TRACING
+  // Can't create trace as we don't know the model to be requested,
+  // track timestamps in 'state'
+  state->trace_timestamps_.Capture(
+      FrontendStage::GRPC_WAITREAD_START, TraceManager::CaptureTimestamp());
+#endif  // TRITON_ENABLE_TRACING
+
+  service_->RequestModelInferChunked(
+      state->context_->ctx_.get(), state->context_->responder_.get(), cq_,
+      cq_, state);
+
+  LOG_VERBOSE(1) << "New request handler for " << Name() << ", "
+                 << state->unique_id_;
+}
+
+bool
+ModelInferChunkedHandler::Process(InferHandler::State* state, bool rpc_ok)
+{
+  std::lock_guard<std::recursive_mutex> lock(state->step_mtx_);
+
+  // Handle notification for cancellation which can be raised
+  // asynchronously if detected on the network.
+  if (state->IsGrpcContextCancelled()) {
+    bool resume = state->context_->HandleCancellation(state, rpc_ok, Name());
+    if (!resume) {
+      transfers_.erase(state);
+    }
+    return resume;
+  }
+
+  LOG_VERBOSE(1) << "Process for " << Name() << ", rpc_ok=" << rpc_ok << ", "
+                 << state->unique_id_ << " step " << state->step_;
+
+  bool finished = false;
+
+  // If RPC failed on a new request then the server is shutting down
+  // and so we should do nothing (including not registering for a new
+  // request).
+  const bool shutdown = (!rpc_ok && (state->step_ == Steps::START));
+  if (shutdown) {
+    state->step_ = Steps::FINISH;
+    finished = true;
+  }
+
+  if (state->step_ == Steps::START) {
+    // Start a new request to replace this one...
+    if (!shutdown) {
+      StartNewRequest();
+    }
+
+    if (ExecutePrecondition(state)) {
+      transfers_[state].reset(new Transfer(state));
+      state->step_ = Steps::READ;
+      state->context_->responder_->Read(state->request_, state);
+    } else {
+      Finish(
+          state, ::grpc::Status(
+                     ::grpc::StatusCode::UNAVAILABLE,
+                     std::string(
+                         "This protocol is restricted, expecting header '") +
+                         restricted_kv_.first + "'"));
+    }
+  } else if (state->step_ == Steps::READ) {
+    Transfer* transfer = transfers_[state].get();
+    TRITONSERVER_Error* err = nullptr;
+    if (!rpc_ok) {
+      err = TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          "ModelInferChunked stream closed before all input contents were "
+          "received");
+    } else if (transfer->irequest_ == nullptr) {
+#ifdef TRITON_ENABLE_TRACING
+      state->trace_timestamps_.Capture(
+          FrontendStage::GRPC_WAITREAD_END, TraceManager::CaptureTimestamp());
+#endif  // TRITON_ENABLE_TRACING
+      err = ReadHeader(state, transfer);
+    } else {
+      err = ReadChunk(state, transfer);
+    }
+
+    if (err == nullptr) {
+      err = ContinueRequest(state, transfer);
+    }
+    if (err != nullptr) {
+      FinishWithError(state, err);
+    }
+  } else if (state->step_ == Steps::WRITEREADY) {
+    ContinueResponse(state, transfers_[state].get());
+  } else if (state->step_ == Steps::WRITTEN) {
+    if (rpc_ok) {
+      ContinueResponse(state, transfers_[state].get());
+    } else {
+      Finish(
+          state, ::grpc::Status(
+                     ::grpc::StatusCode::UNAVAILABLE,
+                     "failed to write ModelInferChunked response"));
+    }
+  } else if (state->step_ == Steps::COMPLETE) {
+#ifdef TRITON_ENABLE_TRACING
+    state->trace_timestamps_.Capture(
+        FrontendStage::GRPC_SEND_END, TraceManager::CaptureTimestamp());
+#endif  // TRITON_ENABLE_TRACING
+
+    state->step_ = Steps::FINISH;
+  } else if (state->step_ == Steps::FINISH) {
+    finished = true;
+  }
+
+  if (finished) {
+    transfers_.erase(state);
+  }
+
+  return !finished;
+}
+
+TRITONSERVER_Error*
+ModelInferChunkedHandler::ReadHeader(
+    InferHandler::State* state, Transfer* transfer)
+{
+  const inference::ModelInferChunkedRequest& chunked_request =
+      *state->request_;
+  if (!chunked_request.has_request()) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        "expected the request header as the first message of the "
+        "ModelInferChunked stream");
+  }
+  const inference::ModelInferRequest& request = chunked_request.request();
+  if (request.raw_input_contents_size() != 0) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        "ModelInferChunked request header must not specify "
+        "'raw_input_contents', the input contents are sent as chunks");
+  }
+
+  int64_t requested_model_version;
+  RETURN_IF_ERR(GetModelVersionFromString(
+      request.model_version(), &requested_model_version));
+
+  uint32_t txn_flags;
+  RETURN_IF_ERR(TRITONSERVER_ServerModelTransactionProperties(
+      tritonserver_.get(), request.model_name().c_str(),
+      requested_model_version, &txn_flags, nullptr /* voidp */));
+  if ((txn_flags & TRITONSERVER_TXN_DECOUPLED) != 0) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_UNSUPPORTED,
+        "ModelInferChunked RPC doesn't support models with decoupled "
+        "transaction policy");
+  }
+
+  for (const auto& output : request.outputs()) {
+    const auto& params = output.parameters();
+    if ((params.find("shared_memory_region") != params.end()) ||
+        (params.find("classification") != params.end())) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_UNSUPPORTED,
+          std::string(
+              "ModelInferChunked RPC doesn't support shared memory or "
+              "classification for output '" +
+              output.name() + "'")
+              .c_str());
+    }
+  }
+
+  // Compute the byte size of each input so that all input contents
+  // can be received into a single buffer. The sizes come from the
+  // client, so they are bounded before anything is allocated.
+  std::vector<size_t> byte_sizes;
+  size_t total_byte_size = 0;
+  for (const auto& input : request.inputs()) {
+    const auto& params = input.parameters();
+    if (input.has_contents() ||
+        (params.find("shared_memory_region") != params.end())) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          std::string(
+              "ModelInferChunked request header must not specify the "
+              "contents of input '" +
+              input.name() + "'")
+              .c_str());
+    }
+
+    const TRITONSERVER_DataType dtype =
+        TRITONSERVER_StringToDataType(input.datatype().c_str());
+    size_t byte_size = 0;
+    if (dtype == TRITONSERVER_TYPE_BYTES) {
+      const auto itr = params.find("byte_size");
+      if ((itr == params.end()) ||
+          (itr->second.parameter_choice_case() !=
+           inference::InferParameter::ParameterChoiceCase::kInt64Param) ||
+          (itr->second.int64_param() < 0)) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_INVALID_ARG,
+            std::string(
+                "input '" + input.name() +
+                "' with BYTES datatype must specify its byte size with the "
+                "'byte_size' int64 parameter")
+                .c_str());
+      }
+      byte_size = itr->second.int64_param();
+    } else {
+      byte_size = TRITONSERVER_DataTypeByteSize(dtype);
+      for (const auto dim : input.shape()) {
+        if ((dim < 0) ||
+            ((dim != 0) && (byte_size > (max_input_byte_size_ / dim)))) {
+          return TRITONSERVER_ErrorNew(
+              TRITONSERVER_ERROR_INVALID_ARG,
+              std::string(
+                  "input '" + input.name() +
+                  "' has an invalid shape or exceeds the maximum input "
+                  "size of " +
+                  std::to_string(max_input_byte_size_) + " bytes")
+                  .c_str());
+        }
+        byte_size *= dim;
+      }
+    }
+    if (byte_size > (max_input_byte_size_ - total_byte_size)) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          std::string(
+              "the inputs of the ModelInferChunked request exceed the "
+              "maximum input size of " +
+              std::to_string(max_input_byte_size_) + " bytes")
+              .c_str());
+    }
+    byte_sizes.push_back(byte_size);
+    total_byte_size += byte_size;
+  }
+
+  RETURN_IF_ERR(TRITONSERVER_InferenceRequestNew(
+      &transfer->irequest_, tritonserver_.get(), request.model_name().c_str(),
+      requested_model_version));
+  RETURN_IF_ERR(SetInferenceRequestMetadata(
+      transfer->irequest_, request, state->parameters_));
+  RETURN_IF_ERR(ForwardHeadersAsParameters(transfer->irequest_, state));
+
+  // The inputs are given their region of the buffer before any
+  // contents are received, the buffer is not used by Triton until the
+  // request is issued.
+  transfer->input_buffer_.reset(new InputBuffer(total_byte_size));
+  if (transfer->input_buffer_->data_ == nullptr) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_UNAVAILABLE,
+        std::string(
+            "unable to allocate " + std::to_string(total_byte_size) +
+            " bytes for the inputs of the ModelInferChunked request")
+            .c_str());
+  }
+  char* base = transfer->input_buffer_->data_.get();
+  for (int i = 0; i < request.inputs_size(); ++i) {
+    transfer->inputs_.push_back({base, byte_sizes[i]});
+    RETURN_IF_ERR(TRITONSERVER_InferenceRequestAppendInputData(
+        transfer->irequest_, request.inputs(i).name().c_str(), base,
+        byte_sizes[i], TRITONSERVER_MEMORY_CPU, 0 /* memory_type_id */));
+    base += byte_sizes[i];
+  }
+
+  transfer->output_chunk_byte_size_ =
+      (chunked_request.output_chunk_byte_size() == 0)
+          ? kDefaultOutputChunkByteSize
+          : std::min(
+                static_cast<size_t>(chunked_request.output_chunk_byte_size()),
+                kMaxOutputChunkByteSize);
+
+#ifdef TRITON_ENABLE_TRACING
+  state->trace_ = std::move(trace_manager_->SampleTrace(request.model_name()));
+#endif  // TRITON_ENABLE_TRACING
+
+  return nullptr;  // Success
+}
+
+TRITONSERVER_Error*
+ModelInferChunkedHandler::ReadChunk(
+    InferHandler::State* state, Transfer* transfer)
+{
+  const inference::ModelInferChunkedRequest& chunked_request =
+      *state->request_;
+  if (!chunked_request.has_chunk()) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        "expected an input chunk after the request header of the "
+        "ModelInferChunked stream");
+  }
+
+  // Chunks must arrive in order so that each is copied to its final
+  // location without tracking which ranges of an input are received.
+  const inference::InferTensorChunk& chunk = chunked_request.chunk();
+  if ((chunk.index() != transfer->input_idx_) ||
+      (chunk.offset() != transfer->input_offset_)) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "expected chunk of input " + std::to_string(transfer->input_idx_) +
+            " at offset " + std::to_string(transfer->input_offset_) +
+            ", got input " + std::to_string(chunk.index()) + " at offset " +
+            std::to_string(chunk.offset()))
+            .c_str());
+  }
+
+  const TensorRegion& region = transfer->inputs_[transfer->input_idx_];
+  if (chunk.data().size() > (region.byte_size_ - transfer->input_offset_)) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "chunk of input " + std::to_string(chunk.index()) +
+            " exceeds the byte size of the input, " +
+            std::to_string(region.byte_size_))
+            .c_str());
+  }
+
+  memcpy(
+      region.base_ + transfer->input_offset_, chunk.data().data(),
+      chunk.data().size());
+  transfer->input_offset_ += chunk.data().size();
+
+  return nullptr;  // Success
+}
+
+TRITONSERVER_Error*
+ModelInferChunkedHandler::ContinueRequest(
+    InferHandler::State* state, Transfer* transfer)
+{
+  if (!transfer->InputComplete()) {
+    state->step_ = Steps::READ;
+    state->context_->responder_->Read(state->request_, state);
+    return nullptr;  // Success
+  }
+
+  return Execute(state, transfer);
+}
+
+TRITONSERVER_Error*
+ModelInferChunkedHandler::Execute(
+    InferHandler::State* state, Transfer* transfer)
+{
+  transfer->message_ = state->response_queue_->GetNonDecoupledResponse();
+  transfer->header_ = transfer->message_->mutable_response();
+
+  RETURN_IF_ERR(TRITONSERVER_InferenceRequestSetReleaseCallback(
+      transfer->irequest_, ChunkedInferRequestComplete,
+      transfer->input_buffer_.get() /* request_release_userp */));
+  RETURN_IF_ERR(TRITONSERVER_InferenceRequestSetResponseCallback(
+      transfer->irequest_, allocator_,
+      transfer /* response_allocator_userp */, ChunkedInferResponseComplete,
+      transfer));
+
+  TRITONSERVER_InferenceTrace* triton_trace = nullptr;
+#ifdef TRITON_ENABLE_TRACING
+  if (state->trace_ != nullptr) {
+    triton_trace = state->trace_->trace_;
+  }
+#endif  // TRITON_ENABLE_TRACING
+
+  state->step_ = Steps::ISSUED;
+  RETURN_IF_ERR(TRITONSERVER_ServerInferAsync(
+      tritonserver_.get(), transfer->irequest_, triton_trace));
+
+  // The request and the input buffer are now released by
+  // ChunkedInferRequestComplete. Recording the state and the irequest
+  // to handle gRPC stream cancellation.
+  state->context_->InsertInflightState(state, transfer->irequest_);
+  transfer->input_buffer_.release();
+  transfer->irequest_ = nullptr;
+
+  return nullptr;  // Success
+}
+
+void
+ModelInferChunkedHandler::ContinueResponse(
+    InferHandler::State* state, Transfer* transfer)
+{
+  if (!transfer->status_.ok()) {
+    Finish(state, transfer->status_);
+    return;
+  }
+
+  if (!transfer->header_written_) {
+#ifdef TRITON_ENABLE_TRACING
+    state->trace_timestamps_.Capture(
+        FrontendStage::GRPC_SEND_START, TraceManager::CaptureTimestamp());
+#endif  // TRITON_ENABLE_TRACING
+
+    transfer->header_written_ = true;
+    state->step_ = Steps::WRITTEN;
+    state->context_->responder_->Write(*transfer->message_, state);
+    return;
+  }
+
+  if (transfer->OutputComplete()) {
+    Finish(state, ::grpc::Status::OK);
+    return;
+  }
+
+  // The message is serialized by Write() so it can be re-used for
+  // every chunk.
+  if (transfer->header_ != nullptr) {
+    transfer->message_->clear_response();
+    transfer->header_ = nullptr;
+  }
+
+  const TensorRegion& region = transfer->outputs_[transfer->output_idx_];
+  const size_t byte_size = std::min(
+      transfer->output_chunk_byte_size_,
+      region.byte_size_ - transfer->output_offset_);
+  inference::InferTensorChunk* chunk = transfer->message_->mutable_chunk();
+  chunk->set_index(transfer->output_idx_);
+  chunk->set_offset(transfer->output_offset_);
+  chunk->set_data(region.base_ + transfer->output_offset_, byte_size);
+  transfer->output_offset_ += byte_size;
+
+  state->step_ = Steps::WRITTEN;
+  state->context_->responder_->Write(*transfer->message_, state);
+}
+
+void
+ModelInferChunkedHandler::Finish(
+    InferHandler::State* state, const ::grpc::Status& status)
+{
+  state->step_ = Steps::COMPLETE;
+  state->context_->responder_->Finish(status, state);
+}
+
+void
+ModelInferChunkedHandler::FinishWithError(
+    InferHandler::State* state, TRITONSERVER_Error* err)
+{
+  LOG_VERBOSE(1) << "ModelInferChunked failed: "
+                 << TRITONSERVER_ErrorMessage(err);
+
+  ::grpc::Status status;
+  GrpcStatusUtil::Create(&status, err);
+  TRITONSERVER_ErrorDelete(err);
+  Finish(state, status);
+}
+
+void
+ModelInferChunkedHandler::ChunkedInferRequestComplete(
+    TRITONSERVER_InferenceRequest* request, const uint32_t flags, void* userp)
+{
+  LOG_VERBOSE(1) << "ModelInferChunkedHandler::ChunkedInferRequestComplete";
+
+  if ((flags & TRITONSERVER_REQUEST_RELEASE_ALL) != 0) {
+    LOG_TRITONSERVER_ERROR(
+        TRITONSERVER_InferenceRequestDelete(request),
+        "deleting GRPC inference request");
+    delete reinterpret_cast<InputBuffer*>(userp);
+  }
+}
+
+void
+ModelInferChunkedHandler::ChunkedInferResponseComplete(
+    TRITONSERVER_InferenceResponse* iresponse, const uint32_t flags,
+    void* userp)
+{
+  Transfer* transfer = reinterpret_cast<Transfer*>(userp);
+  State* state = transfer->state_;
+
+  std::lock_guard<std::recursive_mutex> lock(state->step_mtx_);
+
+  LOG_VERBOSE(1) << "ModelInferChunkedHandler::ChunkedInferResponseComplete, "
+                 << state->unique_id_ << " step " << state->step_;
+
+  // Defer to the callback with the final response
+  if ((flags & TRITONSERVER_RESPONSE_COMPLETE_FINAL) == 0) {
+    LOG_ERROR << "[INTERNAL] ModelInferChunked received a response without "
+                 "FINAL flag";
+    if (iresponse != nullptr) {
+      LOG_TRITONSERVER_ERROR(
+          TRITONSERVER_InferenceResponseDelete(iresponse),
+          "deleting GRPC inference response");
+    }
+    return;
+  }
+
+  state->context_->EraseInflightState(state);
+
+#ifdef TRITON_ENABLE_TRACING
+  state->trace_timestamps_.Capture(
+      FrontendStage::INFER_RESPONSE_COMPLETE, TraceManager::CaptureTimestamp());
+#endif  // TRITON_ENABLE_TRACING
+
+  // If gRPC Stream is cancelled then no need of returning a response.
+  if (state->IsGrpcContextCancelled()) {
+    if (iresponse != nullptr) {
+      LOG_TRITONSERVER_ERROR(
+          TRITONSERVER_InferenceResponseDelete(iresponse),
+          "deleting GRPC inference response");
+    }
+    state->step_ = Steps::CANCELLED;
+    // Send state back to the queue so that state can be released
+    // in the next cycle.
+    state->context_->PutTaskBackToQueue(state);
+    return;
+  }
+
+  TRITONSERVER_Error* err = nullptr;
+  if (iresponse == nullptr) {
+    err = TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL, "received an unexpected null response");
+  } else {
+    // The response holds the output buffers so it is kept until all
+    // output chunks are written.
+    transfer->iresponse_ = iresponse;
+
+    // Classification is not supported so the allocator payload is
+    // only needed to complete the response header.
+    AllocPayload<inference::ModelInferResponse> alloc_payload;
+    err = InferResponseCompleteCommon<inference::ModelInferResponse>(
+        state->tritonserver_, iresponse, *transfer->header_, alloc_payload);
+  }
+
+  // Record the contents of each output in the order of the response
+  // header.
+  uint32_t output_count = 0;
+  if (err == nullptr) {
+    err = TRITONSERVER_InferenceResponseOutputCount(iresponse, &output_count);
+  }
+  transfer->outputs_.assign(output_count, TensorRegion{nullptr, 0});
+  for (uint32_t idx = 0; (err == nullptr) && (idx < output_count); ++idx) {
+    const char* cname;
+    TRITONSERVER_DataType datatype;
+    const int64_t* shape;
+    uint64_t dim_count;
+    const void* base;
+    size_t byte_size;
+    TRITONSERVER_MemoryType memory_type;
+    int64_t memory_type_id;
+    void* buffer_userp;
+    err = TRITONSERVER_InferenceResponseOutput(
+        iresponse, idx, &cname, &datatype, &shape, &dim_count, &base,
+        &byte_size, &memory_type, &memory_type_id, &buffer_userp);
+    if (err != nullptr) {
+      break;
+    }
+
+    for (int i = 0; i < transfer->header_->outputs_size(); ++i) {
+      auto* output = transfer->header_->mutable_outputs(i);
+      if (output->name() == cname) {
+        (*output->mutable_parameters())["byte_size"].set_int64_param(
+            byte_size);
+        transfer->outputs_[i] = TensorRegion{
+            const_cast<char*>(static_cast<const char*>(base)), byte_size};
+        break;
+      }
+    }
+  }
+
+  if (err != nullptr) {
+    GrpcStatusUtil::Create(&transfer->status_, err);
+    TRITONSERVER_ErrorDelete(err);
+  }
+
+  // The response is written by the handler thread.
+  state->step_ = Steps::WRITEREADY;
+  state->context_->PutTaskBackToQueue(state);
+}
+
+}}}  // namespace triton::server::grpc
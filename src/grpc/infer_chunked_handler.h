@@ -0,0 +1,187 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <memory>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "grpc_chunked_service.grpc.pb.h"
+#include "infer_handler.h"
+
+namespace triton { namespace server { namespace grpc {
+
+//
+// ModelInferChunkedHandler
+//
+// Handles the ModelInferChunked RPC. The input chunks are copied into a
+// single buffer, allocated once the request header is read, that is
+// used directly as the input data of the inference request. The output
+// buffers are written by the model and are streamed to the client one
+// chunk per write, the next chunk is only written once the previous
+// one completes. So the server holds about one copy of the tensors of
+// a request at any point.
+//
+class ModelInferChunkedHandler
+    : public InferHandler<
+          inference::GRPCInferenceChunkedService::AsyncService,
+          ::grpc::ServerAsyncReaderWriter<
+              inference::ModelInferChunkedResponse,
+              inference::ModelInferChunkedRequest>,
+          inference::ModelInferChunkedRequest,
+          inference::ModelInferChunkedResponse> {
+ public:
+  ModelInferChunkedHandler(
+      const std::string& name,
+      const std::shared_ptr<TRITONSERVER_Server>& tritonserver,
+      TraceManager* trace_manager,
+      inference::GRPCInferenceChunkedService::AsyncService* service,
+      ::grpc::ServerCompletionQueue* cq, size_t max_state_bucket_count,
+      grpc_compression_level compression_level,
+      std::pair<std::string, std::string> restricted_kv,
+      const std::string& forward_header_pattern,
+      const size_t max_input_byte_size);
+
+  ~ModelInferChunkedHandler();
+
+ protected:
+  void StartNewRequest() override;
+  bool Process(State* state, bool rpc_ok) override;
+
+ private:
+  // The contents of an input or output tensor.
+  struct TensorRegion {
+    char* base_;
+    size_t byte_size_;
+  };
+
+  // The input buffer of a request. Owned by the transfer until the
+  // request is issued and then released by the request release
+  // callback, as the request may outlive the RPC. 'data_' is nullptr if
+  // the buffer can't be allocated.
+  struct InputBuffer {
+    explicit InputBuffer(size_t byte_size)
+        : data_(new (std::nothrow) char[byte_size])
+    {
+    }
+    std::unique_ptr<char[]> data_;
+  };
+
+  // The progress of a single ModelInferChunked RPC. Used as the userp
+  // of the allocator and the response callback of the inference
+  // request.
+  struct Transfer {
+    explicit Transfer(State* state)
+        : state_(state), irequest_(nullptr), input_idx_(0),
+          input_offset_(0), output_chunk_byte_size_(0), message_(nullptr),
+          header_(nullptr), iresponse_(nullptr), header_written_(false),
+          output_idx_(0), output_offset_(0)
+    {
+    }
+    ~Transfer();
+
+    // Returns true if the contents of all inputs are received. Skips
+    // the inputs whose contents are complete.
+    bool InputComplete();
+
+    // Returns true if the contents of all outputs are written. Skips
+    // the outputs whose contents are complete.
+    bool OutputComplete();
+
+    State* state_;
+
+    TRITONSERVER_InferenceRequest* irequest_;
+    std::unique_ptr<InputBuffer> input_buffer_;
+    std::vector<TensorRegion> inputs_;
+    size_t input_idx_;
+    size_t input_offset_;
+
+    size_t output_chunk_byte_size_;
+    // The message used for every write of the response and the
+    // response header within it, owned by the response queue of the
+    // state.
+    inference::ModelInferChunkedResponse* message_;
+    inference::ModelInferResponse* header_;
+    // Holds the output buffers until all chunks are written.
+    TRITONSERVER_InferenceResponse* iresponse_;
+    std::vector<TensorRegion> outputs_;
+    bool header_written_;
+    size_t output_idx_;
+    size_t output_offset_;
+
+    // The status to complete the RPC with once the response is ready.
+    ::grpc::Status status_;
+  };
+
+  TRITONSERVER_Error* ReadHeader(State* state, Transfer* transfer);
+  TRITONSERVER_Error* ReadChunk(State* state, Transfer* transfer);
+  TRITONSERVER_Error* Execute(State* state, Transfer* transfer);
+
+  // Issues the next read, or the inference once all input contents
+  // are received.
+  TRITONSERVER_Error* ContinueRequest(State* state, Transfer* transfer);
+
+  // Writes the next message of the response, or completes the RPC once
+  // all output contents are written.
+  void ContinueResponse(State* state, Transfer* transfer);
+
+  void Finish(State* state, const ::grpc::Status& status);
+  void FinishWithError(State* state, TRITONSERVER_Error* err);
+
+  static TRITONSERVER_Error* ChunkedInferResponseAlloc(
+      TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
+      size_t byte_size, TRITONSERVER_MemoryType preferred_memory_type,
+      int64_t preferred_memory_type_id, void* userp, void** buffer,
+      void** buffer_userp, TRITONSERVER_MemoryType* actual_memory_type,
+      int64_t* actual_memory_type_id);
+  static TRITONSERVER_Error* ChunkedInferResponseFree(
+      TRITONSERVER_ResponseAllocator* allocator, void* buffer,
+      void* buffer_userp, size_t byte_size, TRITONSERVER_MemoryType memory_type,
+      int64_t memory_type_id);
+  static void ChunkedInferRequestComplete(
+      TRITONSERVER_InferenceRequest* request, const uint32_t flags,
+      void* userp);
+  static void ChunkedInferResponseComplete(
+      TRITONSERVER_InferenceResponse* response, const uint32_t flags,
+      void* userp);
+
+  TraceManager* trace_manager_;
+  TRITONSERVER_ResponseAllocator* allocator_;
+
+  grpc_compression_level compression_level_;
+
+  // The maximum total byte size of the inputs of a request.
+  const size_t max_input_byte_size_;
+
+  // The transfer of each RPC in progress, only accessed by the handler
+  // thread.
+  std::unordered_map<State*, std::unique_ptr<Transfer>> transfers_;
+};
+
+}}}  // namespace triton::server::grpc
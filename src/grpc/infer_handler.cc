@@ -26,6 +26,8 @@
 
 #include "infer_handler.h"
 
+#include "tensor_contents.h"
+
 #ifndef NDEBUG
 uint64_t
 NextUniqueId()
@@ -71,7 +73,10 @@ OutputBufferQueryHelper(
     if (pr != shm_map.end()) {
       // The output is in shared memory so check that shared memory
       // size is at least large enough for the output, if byte size is provided
-      if ((byte_size != nullptr) && (*byte_size > pr->second.byte_size_)) {
+      const bool unbounded_pool =
+          (pr->second.pool_ != nullptr) && (pr->second.byte_size_ == 0);
+      if ((byte_size != nullptr) && !unbounded_pool &&
+          (*byte_size > pr->second.byte_size_)) {
         // Don't return error yet and just set to the default properties for
         // GRPC buffer, error will be raised when allocation happens
         *memory_type = TRITONSERVER_MEMORY_CPU;
@@ -109,7 +114,8 @@ InferResponseAlloc(
       payload->response_queue_->GetNonDecoupledResponse();
   return ResponseAllocatorHelper(
       allocator, tensor_name, byte_size, preferred_memory_type,
-      preferred_memory_type_id, response, payload->shm_map_, buffer,
+      preferred_memory_type_id, response, payload->shm_map_,
+      &payload->pool_allocations_, 0 /* response_index */, buffer,
       buffer_userp, actual_memory_type, actual_memory_type_id);
 }
 
@@ -168,6 +174,7 @@ TRITONSERVER_Error* InferGRPCToInput(
     const std::shared_ptr<SharedMemoryManager>& shm_manager,
     const inference::ModelInferRequest& request,
     std::list<std::string>* serialized_data,
+    std::vector<SharedMemoryManager::Reference>* shm_references,
     TRITONSERVER_InferenceRequest* inference_request);
 
 TRITONSERVER_Error*
@@ -379,12 +386,44 @@ SetStateParameterFromTritonParameter(
   return nullptr;  // success
 }
 
+// Narrows the 32-bit typed 'contents' of an input into a new buffer
+// owned by 'serialized_data' and sets 'base' and 'byte_size' to it.
+template <typename SrcType, typename DstType>
+TRITONSERVER_Error*
+NarrowContents(
+    const google::protobuf::RepeatedField<SrcType>& contents,
+    bool (*narrow)(const SrcType*, size_t, DstType*),
+    const std::string& contents_name, const std::string& input_name,
+    const std::string& model_name, TRITONSERVER_DataType dtype,
+    std::list<std::string>* serialized_data, const void** base,
+    size_t* byte_size)
+{
+  serialized_data->emplace_back();
+  auto& serialized = serialized_data->back();
+  serialized.resize(contents.size() * sizeof(DstType));
+  if (!narrow(
+          contents.data(), contents.size(),
+          reinterpret_cast<DstType*>(&serialized[0]))) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "'" + contents_name + "' of input '" + input_name +
+            "' for model '" + model_name + "' contains value out of range " +
+            "for datatype " + TRITONSERVER_DataTypeString(dtype))
+            .c_str());
+  }
+  *base = serialized.c_str();
+  *byte_size = serialized.size();
+  return nullptr;  // success
+}
+
 TRITONSERVER_Error*
 InferGRPCToInput(
     const std::shared_ptr<TRITONSERVER_Server>& tritonserver,
     const std::shared_ptr<SharedMemoryManager>& shm_manager,
     const inference::ModelInferRequest& request,
     std::list<std::string>* serialized_data,
+    std::vector<SharedMemoryManager::Reference>* shm_references,
     TRITONSERVER_InferenceRequest* inference_request)
 {
   // Verify that the batch-byte-size of each input matches the size of
@@ -397,21 +436,16 @@ InferGRPCToInput(
     int64_t memory_type_id = 0;
 
     std::string region_name;
+    uint64_t region_handle;
     int64_t offset;
     bool has_shared_memory;
     RETURN_IF_ERR(
         ParseSharedMemoryParams<inference::ModelInferRequest::InferInputTensor>(
-            io, &has_shared_memory, &region_name, &offset, &byte_size));
+            io, &has_shared_memory, &region_name, &region_handle, &offset,
+            &byte_size));
 
     TRITONSERVER_BufferAttributes* buffer_attributes;
-    RETURN_IF_ERR(TRITONSERVER_BufferAttributesNew(&buffer_attributes));
-    auto buffer_attributes_del =
-        [](TRITONSERVER_BufferAttributes* buffer_attributes) {
-          TRITONSERVER_BufferAttributesDelete(buffer_attributes);
-        };
-    std::unique_ptr<
-        TRITONSERVER_BufferAttributes, decltype(buffer_attributes_del)>
-        buffer_attrsl(buffer_attributes, buffer_attributes_del);
+    RETURN_IF_ERR(ThreadLocalBufferAttributes(&buffer_attributes));
     char* cuda_ipc_handle = nullptr;
 
     if (has_shared_memory) {
@@ -426,13 +460,16 @@ InferGRPCToInput(
                 .c_str());
       }
       void* tmp;
+      SharedMemoryManager::Reference reference;
       RETURN_IF_ERR(shm_manager->GetMemoryInfo(
-          region_name, offset, &tmp, &memory_type, &memory_type_id));
+          region_name, region_handle, offset, &tmp, &memory_type,
+          &memory_type_id, &reference));
+      shm_references->emplace_back(std::move(reference));
       base = tmp;
       if (memory_type == TRITONSERVER_MEMORY_GPU) {
 #ifdef TRITON_ENABLE_GPU
         RETURN_IF_ERR(shm_manager->GetCUDAHandle(
-            region_name,
+            region_name, region_handle,
             reinterpret_cast<cudaIpcMemHandle_t**>(&cuda_ipc_handle)));
 #endif
       }
@@ -463,36 +500,18 @@ InferGRPCToInput(
             RETURN_IF_ERR(InferGRPCToInputHelper(
                 io.name(), request.model_name(), TRITONSERVER_TYPE_INT8, dtype,
                 byte_size));
-            serialized_data->emplace_back();
-            auto& serialized = serialized_data->back();
-            serialized.reserve(
-                io.contents().int_contents_size() * elem_byte_size);
-            for (const auto& element : io.contents().int_contents()) {
-              // Assuming the system is little-endian, picking the
-              // least significant byte of 32-bit integer as a
-              // int8 element
-              serialized.append(
-                  reinterpret_cast<const char*>(&element), elem_byte_size);
-            }
-            base = serialized.c_str();
-            byte_size = serialized.size();
+            RETURN_IF_ERR(NarrowContents(
+                io.contents().int_contents(), NarrowInt32ToInt8,
+                "int_contents", io.name(), request.model_name(), dtype,
+                serialized_data, &base, &byte_size));
           } else if (dtype == TRITONSERVER_TYPE_INT16) {
             RETURN_IF_ERR(InferGRPCToInputHelper(
                 io.name(), request.model_name(), TRITONSERVER_TYPE_INT16, dtype,
                 byte_size));
-            serialized_data->emplace_back();
-            auto& serialized = serialized_data->back();
-            serialized.reserve(
-                io.contents().int_contents_size() * elem_byte_size);
-            for (const auto& element : io.contents().int_contents()) {
-              // Assuming the system is little-endian, picking the
-              // least 2 significant bytes of 32-bit integer as a
-              // int16 element
-              serialized.append(
-                  reinterpret_cast<const char*>(&element), elem_byte_size);
-            }
-            base = serialized.c_str();
-            byte_size = serialized.size();
+            RETURN_IF_ERR(NarrowContents(
+                io.contents().int_contents(), NarrowInt32ToInt16,
+                "int_contents", io.name(), request.model_name(), dtype,
+                serialized_data, &base, &byte_size));
           } else {
             RETURN_IF_ERR(InferGRPCToInputHelper(
                 io.name(), request.model_name(), TRITONSERVER_TYPE_INT32, dtype,
@@ -515,36 +534,18 @@ InferGRPCToInput(
             RETURN_IF_ERR(InferGRPCToInputHelper(
                 io.name(), request.model_name(), TRITONSERVER_TYPE_UINT8, dtype,
                 byte_size));
-            serialized_data->emplace_back();
-            auto& serialized = serialized_data->back();
-            serialized.reserve(
-                io.contents().uint_contents_size() * elem_byte_size);
-            for (const auto& element : io.contents().uint_contents()) {
-              // Assuming the system is little-endian, picking the
-              // least significant byte of 32-bit unsigned integer as a
-              // uint8 element
-              serialized.append(
-                  reinterpret_cast<const char*>(&element), elem_byte_size);
-            }
-            base = serialized.c_str();
-            byte_size = serialized.size();
+            RETURN_IF_ERR(NarrowContents(
+                io.contents().uint_contents(), NarrowUint32ToUint8,
+                "uint_contents", io.name(), request.model_name(), dtype,
+                serialized_data, &base, &byte_size));
           } else if (dtype == TRITONSERVER_TYPE_UINT16) {
             RETURN_IF_ERR(InferGRPCToInputHelper(
                 io.name(), request.model_name(), TRITONSERVER_TYPE_UINT16,
                 dtype, byte_size));
-            serialized_data->emplace_back();
-            auto& serialized = serialized_data->back();
-            serialized.reserve(
-                io.contents().uint_contents_size() * elem_byte_size);
-            for (const auto& element : io.contents().uint_contents()) {
-              // Assuming the system is little-endian, picking the
-              // least 2 significant bytes of 32-bit integer as a
-              // uint16 element
-              serialized.append(
-                  reinterpret_cast<const char*>(&element), elem_byte_size);
-            }
-            base = serialized.c_str();
-            byte_size = serialized.size();
+            RETURN_IF_ERR(NarrowContents(
+                io.contents().uint_contents(), NarrowUint32ToUint16,
+                "uint_contents", io.name(), request.model_name(), dtype,
+                serialized_data, &base, &byte_size));
           } else {
             RETURN_IF_ERR(InferGRPCToInputHelper(
                 io.name(), request.model_name(), TRITONSERVER_TYPE_UINT32,
@@ -589,13 +590,11 @@ InferGRPCToInput(
           // Serialize the output tensor strings. Each string is
           // serialized as a 4-byte length followed by the string itself
           // with no null-terminator.
-          for (const auto& element : io.contents().bytes_contents()) {
-            uint32_t len{(uint32_t)element.size()};
-            serialized.append(
-                reinterpret_cast<const char*>(&len), sizeof(uint32_t));
-            if (element.size() > 0) {
-              serialized.append(element.c_str(), len);
-            }
+          serialized.resize(
+              SerializedBytesContentsByteSize(io.contents().bytes_contents()));
+          if (!serialized.empty()) {
+            SerializeBytesContents(
+                io.contents().bytes_contents(), &serialized[0]);
           }
           base = serialized.c_str();
           byte_size = serialized.size();
@@ -615,11 +614,9 @@ InferGRPCToInput(
       }
     }
 
-    if (cuda_ipc_handle != nullptr) {
-      RETURN_IF_ERR(TRITONSERVER_BufferAttributesSetCudaIpcHandle(
-          buffer_attributes, reinterpret_cast<void*>(cuda_ipc_handle)));
-    }
-
+    // Set every attribute as the attributes are reused across inputs.
+    RETURN_IF_ERR(TRITONSERVER_BufferAttributesSetCudaIpcHandle(
+        buffer_attributes, reinterpret_cast<void*>(cuda_ipc_handle)));
     RETURN_IF_ERR(TRITONSERVER_BufferAttributesSetMemoryType(
         buffer_attributes, memory_type));
     RETURN_IF_ERR(TRITONSERVER_BufferAttributesSetMemoryTypeId(
@@ -641,12 +638,37 @@ InferRequestComplete(
   LOG_VERBOSE(1) << "ModelInferHandler::InferRequestComplete";
 
   if ((flags & TRITONSERVER_REQUEST_RELEASE_ALL) != 0) {
-    LOG_TRITONSERVER_ERROR(
-        TRITONSERVER_InferenceRequestDelete(request),
-        "deleting GRPC inference request");
+    if (userp != nullptr) {
+      InferRequestPool::Release(
+          reinterpret_cast<InferRequestPool::Entry*>(userp));
+    } else {
+      LOG_TRITONSERVER_ERROR(
+          TRITONSERVER_InferenceRequestDelete(request),
+          "deleting GRPC inference request");
+    }
+  }
+}
+
+namespace {
+
+// Returns true if 'request' has parameters that are set as parameters
+// of the inference request, which can't be removed from a request to
+// reuse it.
+bool
+HasCustomParameters(const inference::ModelInferRequest& request)
+{
+  for (const auto& param : request.parameters()) {
+    if ((param.first != "sequence_id") && (param.first != "sequence_start") &&
+        (param.first != "sequence_end") && (param.first != "priority") &&
+        (param.first != "timeout") && (param.first.rfind("triton_", 0) != 0)) {
+      return true;
+    }
   }
+  return false;
 }
 
+}  // namespace
+
 //===========================================================================
 //  The following section contains the handling mechanism for ModelInfer RPC.
 //  This implementation is tuned towards performance and reducing latency.
@@ -662,12 +684,12 @@ ModelInferHandler::StartNewRequest()
 #ifdef TRITON_ENABLE_TRACING
   // Can't create trace as we don't know the model to be requested,
   // track timestamps in 'state'
-  state->trace_timestamps_.emplace_back(
-      std::make_pair("GRPC_WAITREAD_START", TraceManager::CaptureTimestamp()));
+  state->trace_timestamps_.Capture(
+      FrontendStage::GRPC_WAITREAD_START, TraceManager::CaptureTimestamp());
 #endif  // TRITON_ENABLE_TRACING
 
   service_->RequestModelInfer(
-      state->context_->ctx_.get(), &state->request_,
+      state->context_->ctx_.get(), state->request_,
       state->context_->responder_.get(), cq_, cq_, state);
 
   LOG_VERBOSE(1) << "New request handler for " << Name() << ", "
@@ -714,8 +736,8 @@ ModelInferHandler::Process(InferHandler::State* state, bool rpc_ok)
 #ifdef TRITON_ENABLE_TRACING
     // Can't create trace as we don't know the model to be requested,
     // track timestamps in 'state'
-    state->trace_timestamps_.emplace_back(
-        std::make_pair("GRPC_WAITREAD_END", TraceManager::CaptureTimestamp()));
+    state->trace_timestamps_.Capture(
+        FrontendStage::GRPC_WAITREAD_END, TraceManager::CaptureTimestamp());
 #endif  // TRITON_ENABLE_TRACING
 
     // Start a new request to replace this one...
@@ -733,8 +755,8 @@ ModelInferHandler::Process(InferHandler::State* state, bool rpc_ok)
 
 
 #ifdef TRITON_ENABLE_TRACING
-      state->trace_timestamps_.emplace_back(
-          std::make_pair("GRPC_SEND_START", TraceManager::CaptureTimestamp()));
+      state->trace_timestamps_.Capture(
+          FrontendStage::GRPC_SEND_START, TraceManager::CaptureTimestamp());
 #endif  // TRITON_ENABLE_TRACING
 
       state->step_ = COMPLETE;
@@ -744,9 +766,18 @@ ModelInferHandler::Process(InferHandler::State* state, bool rpc_ok)
 
   } else if (state->step_ == Steps::COMPLETE) {
 #ifdef TRITON_ENABLE_TRACING
-    state->trace_timestamps_.emplace_back(
-        std::make_pair("GRPC_SEND_END", TraceManager::CaptureTimestamp()));
+    state->trace_timestamps_.Capture(
+        FrontendStage::GRPC_SEND_END, TraceManager::CaptureTimestamp());
 #endif  // TRITON_ENABLE_TRACING
+    state->ObserveStages();
+
+    // The outputs allocated in pools belong to the client once the
+    // response is sent, they are released otherwise.
+    if (rpc_ok) {
+      state->alloc_payload_.pool_allocations_.Deliver();
+    } else {
+      state->alloc_payload_.pool_allocations_.Release();
+    }
 
     state->step_ = Steps::FINISH;
   } else if (state->step_ == Steps::FINISH) {
@@ -761,7 +792,8 @@ ResponseAllocatorHelper(
     TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
     size_t byte_size, TRITONSERVER_MemoryType preferred_memory_type,
     int64_t preferred_memory_type_id, inference::ModelInferResponse* response,
-    const TensorShmMap& shm_map, void** buffer, void** buffer_userp,
+    const TensorShmMap& shm_map, SharedMemoryPoolAllocations* pool_allocations,
+    const uint32_t response_index, void** buffer, void** buffer_userp,
     TRITONSERVER_MemoryType* actual_memory_type, int64_t* actual_memory_type_id)
 {
   *buffer = nullptr;
@@ -780,8 +812,11 @@ ResponseAllocatorHelper(
     const auto& pr = shm_map.find(tensor_name);
     if (pr != shm_map.end()) {
       // The output is in shared memory so check that shared memory
-      // size is at least large enough for the output.
-      if (byte_size > pr->second.byte_size_) {
+      // size is at least large enough for the output. An output in a
+      // pool is allocated here with its actual size.
+      const bool unbounded_pool =
+          (pr->second.pool_ != nullptr) && (pr->second.byte_size_ == 0);
+      if (!unbounded_pool && (byte_size > pr->second.byte_size_)) {
         return TRITONSERVER_ErrorNew(
             TRITONSERVER_ERROR_INTERNAL,
             std::string(
@@ -794,6 +829,21 @@ ResponseAllocatorHelper(
       }
 
       *buffer = const_cast<void*>(pr->second.base_);
+      if (pr->second.pool_ != nullptr) {
+        // Tell the client where the server put the output in the pool
+        // and the lease to release it with.
+        size_t offset;
+        uint64_t lease;
+        RETURN_IF_ERR(pr->second.pool_->Allocate(byte_size, &offset, &lease));
+        pool_allocations->Add(
+            pr->second.pool_, pr->second.pool_reference_, offset, lease,
+            response_index);
+        *buffer = reinterpret_cast<uint8_t*>(pr->second.pool_->Base()) + offset;
+        auto& params = *output_tensor->mutable_parameters();
+        params["shared_memory_offset"].set_int64_param(offset);
+        params["shared_memory_byte_size"].set_int64_param(byte_size);
+        params["shared_memory_pool_lease"].set_int64_param(lease);
+      }
       *actual_memory_type = pr->second.memory_type_;
       *actual_memory_type_id = pr->second.memory_type_id_;
 
@@ -830,8 +880,12 @@ void
 ModelInferHandler::Execute(InferHandler::State* state)
 {
   TRITONSERVER_Error* err = nullptr;
-  const inference::ModelInferRequest& request = state->request_;
+  const inference::ModelInferRequest& request = *state->request_;
   auto response_queue = state->response_queue_;
+  const uint64_t parse_start_ns = (state->transport_metrics_ != nullptr)
+                                      ? TransportMethodMetrics::Now()
+                                      : 0;
+  const uint64_t cpu_start_ns = state->CpuStart();
   int64_t requested_model_version;
   if (err == nullptr) {
     err = GetModelVersionFromString(
@@ -852,14 +906,29 @@ ModelInferHandler::Execute(InferHandler::State* state)
   }
 
   // Create the inference request which contains all the
-  // input information needed for an inference.
+  // input information needed for an inference, or reuse one of the
+  // pool.
   TRITONSERVER_InferenceRequest* irequest = nullptr;
-  if (err == nullptr) {
+  InferRequestPool::Entry* pooled_request = nullptr;
+  if ((err == nullptr) && (request_pool_ != nullptr)) {
+    err = request_pool_->Acquire(
+        request.model_name(), requested_model_version, &pooled_request);
+    if (err == nullptr) {
+      irequest = pooled_request->irequest_;
+      pooled_request->reusable_ =
+          header_forward_pattern_.empty() && !HasCustomParameters(request);
+    }
+  } else if (err == nullptr) {
     err = TRITONSERVER_InferenceRequestNew(
         &irequest, tritonserver_.get(), request.model_name().c_str(),
         requested_model_version);
   }
 
+#ifdef TRITON_ENABLE_TRACING
+  state->trace_timestamps_.Capture(
+      FrontendStage::INPUT_SETUP_START, TraceManager::CaptureTimestamp());
+#endif  // TRITON_ENABLE_TRACING
+
   if (err == nullptr) {
     err = SetInferenceRequestMetadata(irequest, request, state->parameters_);
   }
@@ -871,19 +940,31 @@ ModelInferHandler::Execute(InferHandler::State* state)
   // Will be used to hold the serialized data in case explicit string
   // tensors are present in the request.
   std::list<std::string> serialized_data;
+  // Keeps the shared memory regions used by the inputs mapped until
+  // the request is released.
+  std::vector<SharedMemoryManager::Reference> shm_references;
 
   if (err == nullptr) {
     err = InferGRPCToInput(
-        tritonserver_, shm_manager_, request, &serialized_data, irequest);
+        tritonserver_, shm_manager_, request, &serialized_data,
+        &shm_references, irequest);
   }
   if (err == nullptr) {
     err = InferAllocatorPayload<inference::ModelInferResponse>(
         tritonserver_, shm_manager_, request, std::move(serialized_data),
-        response_queue, &state->alloc_payload_);
+        std::move(shm_references), response_queue, &state->alloc_payload_);
   }
+
+#ifdef TRITON_ENABLE_TRACING
+  state->trace_timestamps_.Capture(
+      FrontendStage::INPUT_SETUP_END, TraceManager::CaptureTimestamp());
+  state->server_timing_ = trace_manager_->ServerTiming();
+#endif  // TRITON_ENABLE_TRACING
+
   if (err == nullptr) {
     err = TRITONSERVER_InferenceRequestSetReleaseCallback(
-        irequest, InferRequestComplete, nullptr /* request_release_userp */);
+        irequest, InferRequestComplete,
+        pooled_request /* request_release_userp */);
   }
   if (err == nullptr) {
     err = TRITONSERVER_InferenceRequestSetResponseCallback(
@@ -912,6 +993,12 @@ ModelInferHandler::Execute(InferHandler::State* state)
     }
 #endif  // TRITON_ENABLE_TRACING
 
+    if (parse_start_ns != 0) {
+      state->transport_metrics_->ObserveStage(
+          TransportStage::PARSE, parse_start_ns);
+    }
+
+    state->AddCpu(cpu_start_ns);
     state->step_ = ISSUED;
     err = TRITONSERVER_ServerInferAsync(
         tritonserver_.get(), irequest, triton_trace);
@@ -928,9 +1015,13 @@ ModelInferHandler::Execute(InferHandler::State* state)
     LOG_VERBOSE(1) << "[request id: " << request_id << "] "
                    << "Infer failed: " << TRITONSERVER_ErrorMessage(err);
 
-    LOG_TRITONSERVER_ERROR(
-        TRITONSERVER_InferenceRequestDelete(irequest),
-        "deleting GRPC inference request");
+    if (pooled_request != nullptr) {
+      InferRequestPool::Release(pooled_request);
+    } else {
+      LOG_TRITONSERVER_ERROR(
+          TRITONSERVER_InferenceRequestDelete(irequest),
+          "deleting GRPC inference request");
+    }
 
     ::grpc::Status status;
     GrpcStatusUtil::Create(&status, err);
@@ -939,8 +1030,11 @@ ModelInferHandler::Execute(InferHandler::State* state)
     inference::ModelInferResponse error_response;
 
 #ifdef TRITON_ENABLE_TRACING
-    state->trace_timestamps_.emplace_back(
-        std::make_pair("GRPC_SEND_START", TraceManager::CaptureTimestamp()));
+    if (state->trace_ != nullptr) {
+      state->trace_->MarkFailed();
+    }
+    state->trace_timestamps_.Capture(
+        FrontendStage::GRPC_SEND_START, TraceManager::CaptureTimestamp());
 #endif  // TRITON_ENABLE_TRACING
 
     state->step_ = COMPLETE;
@@ -976,9 +1070,10 @@ ModelInferHandler::InferResponseComplete(
   state->context_->EraseInflightState(state);
 
 #ifdef TRITON_ENABLE_TRACING
-  state->trace_timestamps_.emplace_back(std::make_pair(
-      "INFER_RESPONSE_COMPLETE", TraceManager::CaptureTimestamp()));
+  state->trace_timestamps_.Capture(
+      FrontendStage::INFER_RESPONSE_COMPLETE, TraceManager::CaptureTimestamp());
 #endif  // TRITON_ENABLE_TRACING
+  const uint64_t cpu_start_ns = state->CpuStart();
 
   // If gRPC Stream is cancelled then no need of forming and returning
   // a response.
@@ -1002,6 +1097,12 @@ ModelInferHandler::InferResponseComplete(
     return;
   }
 
+  // The state may be released as soon as the response is handed to the
+  // transport, hold onto the metrics.
+  TransportMethodMetrics* transport_metrics = state->transport_metrics_;
+  const uint64_t serialize_start_ns =
+      (transport_metrics != nullptr) ? TransportMethodMetrics::Now() : 0;
+
   TRITONSERVER_Error* err = nullptr;
   // This callback is expected to be called exactly once for each request.
   // Will use the single response object in the response list to hold the
@@ -1028,12 +1129,27 @@ ModelInferHandler::InferResponseComplete(
     err = TRITONSERVER_ErrorNew(
         TRITONSERVER_ERROR_INTERNAL, "received an unexpected null response");
   } else {
+#ifdef TRITON_ENABLE_TRACING
+    state->trace_timestamps_.Capture(
+        FrontendStage::OUTPUT_SERIALIZE_START,
+        TraceManager::CaptureTimestamp());
+#endif  // TRITON_ENABLE_TRACING
     err = InferResponseCompleteCommon<inference::ModelInferResponse>(
         state->tritonserver_, iresponse, *response, state->alloc_payload_);
+#ifdef TRITON_ENABLE_TRACING
+    state->trace_timestamps_.Capture(
+        FrontendStage::OUTPUT_SERIALIZE_END, TraceManager::CaptureTimestamp());
+#endif  // TRITON_ENABLE_TRACING
   }
 
   if (err != nullptr) {
     response->Clear();
+    state->alloc_payload_.pool_allocations_.Release();
+#ifdef TRITON_ENABLE_TRACING
+    if (state->trace_ != nullptr) {
+      state->trace_->MarkFailed();
+    }
+#endif  // TRITON_ENABLE_TRACING
   }
 
   ::grpc::Status status;
@@ -1045,15 +1161,27 @@ ModelInferHandler::InferResponseComplete(
       "deleting GRPC inference response");
 
 #ifdef TRITON_ENABLE_TRACING
-  state->trace_timestamps_.emplace_back(
-      std::make_pair("GRPC_SEND_START", TraceManager::CaptureTimestamp()));
+  // The breakdown is sent in the trailing metadata so that it can cover
+  // the serialization of the response.
+  if (state->server_timing_) {
+    state->context_->ctx_->AddTrailingMetadata(
+        kServerTimingHeader, state->trace_timestamps_.ServerTiming());
+  }
+  state->trace_timestamps_.Capture(
+      FrontendStage::GRPC_SEND_START, TraceManager::CaptureTimestamp());
 #endif  // TRITON_ENABLE_TRACING
 
+  state->AddCpu(cpu_start_ns);
   state->step_ = COMPLETE;
   state->context_->responder_->Finish(*response, status, state);
   if (response_created) {
     delete response;
   }
+
+  if (serialize_start_ns != 0) {
+    transport_metrics->ObserveStage(
+        TransportStage::SERIALIZE, serialize_start_ns);
+  }
 }
 
 }}}  // namespace triton::server::grpc
@@ -25,6 +25,8 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <google/protobuf/arena.h>
+#include <google/protobuf/message_lite.h>
 #include <grpc++/alarm.h>
 #include <grpc++/grpc++.h>
 #include <re2/re2.h>
@@ -33,11 +35,16 @@
 #include <queue>
 #include <regex>
 #include <thread>
+#include <vector>
 
+#include "../frontend_stage_metrics.h"
+#include "../infer_request_pool.h"
+#include "../response_buffer_budget.h"
 #include "../tracer.h"
 #include "grpc_handler.h"
 #include "grpc_service.grpc.pb.h"
 #include "grpc_utils.h"
+#include "transport_metrics.h"
 #include "triton/common/logging.h"
 #include "triton/core/tritonserver.h"
 
@@ -88,33 +95,97 @@ class Barrier {
   size_t generation_;
 };
 
+// Size of the initial block owned by each per-state protobuf arena. The
+// initial block is retained across Arena::Reset() so a state that is
+// re-used for a typical request does not return to the heap for its
+// messages.
+#define GRPC_STATE_ARENA_INITIAL_BLOCK_SIZE (8 * 1024)
+
 //
-// ResponseQueue
+// MessageArena
 //
-// A simple queue holding the responses to be written. Uses a
-// vector of persistent message objects to prevent allocating
-// memory for each response to be written.
+// Owns a protobuf arena backed by a persistent initial block. The
+// messages created on the arena are kept across Reset() and cleared
+// instead, so that the strings of their repeated fields, e.g. the raw
+// tensor contents, keep their capacity for the next request. The arena
+// only releases the messages when it grew beyond its initial block.
 //
-template <typename ResponseType>
-class ResponseQueue {
+class MessageArena {
  public:
-  explicit ResponseQueue() { Reset(); }
+  MessageArena()
+      : initial_block_(new char[GRPC_STATE_ARENA_INITIAL_BLOCK_SIZE]),
+        arena_(MakeOptions(initial_block_.get()))
+  {
+  }
+
+  template <typename MessageType>
+  MessageType* Create()
+  {
+    static_assert(
+        google::protobuf::Arena::is_arena_constructable<MessageType>::value,
+        "gRPC messages must be generated with arena support enabled");
+    MessageType* message =
+        google::protobuf::Arena::CreateMessage<MessageType>(&arena_);
+    messages_.push_back(message);
+    return message;
+  }
 
-  ~ResponseQueue()
+  // Clears all messages created on the arena and returns true. If the
+  // arena grew beyond its initial block, destroys the messages instead,
+  // returning any block allocated beyond the initial block to the heap,
+  // and returns false.
+  bool Reset()
   {
-    for (auto response : responses_) {
-      delete response;
+    if (arena_.SpaceAllocated() > GRPC_STATE_ARENA_INITIAL_BLOCK_SIZE) {
+      messages_.clear();
+      arena_.Reset();
+      return false;
+    }
+    for (auto message : messages_) {
+      message->Clear();
     }
+    return true;
+  }
+
+  uint64_t SpaceAllocated() const { return arena_.SpaceAllocated(); }
+
+ private:
+  static google::protobuf::ArenaOptions MakeOptions(char* initial_block)
+  {
+    google::protobuf::ArenaOptions options;
+    options.initial_block = initial_block;
+    options.initial_block_size = GRPC_STATE_ARENA_INITIAL_BLOCK_SIZE;
+    return options;
   }
 
-  // Resets the queue
+  // Declared before 'arena_' so that it outlives the arena.
+  std::unique_ptr<char[]> initial_block_;
+  google::protobuf::Arena arena_;
+  // The messages created on 'arena_'.
+  std::vector<google::protobuf::MessageLite*> messages_;
+};
+
+//
+// ResponseQueue
+//
+// A simple queue holding the responses to be written. The response
+// messages are allocated on an arena owned by the queue and are cleared,
+// rather than freed, when the queue is re-used.
+//
+template <typename ResponseType>
+class ResponseQueue {
+ public:
+  explicit ResponseQueue() { Reset(); }
+
+  // Resets the queue. All responses previously returned by the queue
+  // are cleared, or invalidated if the arena had to release them.
   void Reset()
   {
     alloc_count_ = 0;
     ready_count_ = 0;
     current_index_ = 0;
-    for (auto response : responses_) {
-      response->Clear();
+    if (!arena_.Reset()) {
+      responses_.clear();
     }
   }
 
@@ -126,7 +197,7 @@ class ResponseQueue {
     std::lock_guard<std::mutex> lock(mtx_);
     alloc_count_ = 1;
     if (responses_.size() < 1) {
-      responses_.push_back(new ResponseType());
+      responses_.push_back(arena_.Create<ResponseType>());
     }
     return responses_[0];
   }
@@ -137,7 +208,7 @@ class ResponseQueue {
     std::lock_guard<std::mutex> lock(mtx_);
     alloc_count_++;
     if (responses_.size() < alloc_count_) {
-      responses_.push_back(new ResponseType());
+      responses_.push_back(arena_.Create<ResponseType>());
     }
   }
 
@@ -214,8 +285,34 @@ class ResponseQueue {
     return (ready_count_ > current_index_);
   }
 
+  // Returns the number of responses that are ready
+  // to be written but not yet popped.
+  uint32_t ReadyResponseCount()
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return (ready_count_ - current_index_);
+  }
+
+  // Returns the number of responses allocated, the index
+  // of the next response to be allocated.
+  uint32_t AllocatedResponseCount()
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return alloc_count_;
+  }
+
+  // Returns the number of responses popped, the index
+  // of the next response to be written.
+  uint32_t PoppedResponseCount()
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return current_index_;
+  }
+
  private:
+  // The responses are owned by 'arena_'.
   std::vector<ResponseType*> responses_;
+  MessageArena arena_;
   std::mutex mtx_;
 
   // There are three indices to track the responses in the queue
@@ -246,6 +343,12 @@ struct ShmInfo {
   TRITONSERVER_MemoryType memory_type_;
   int64_t memory_type_id_;
   char* cuda_ipc_handle_;
+
+  // For outputs in a shared memory pool, the pool that the output is
+  // allocated in and the reference to its region. 'byte_size_' is then
+  // the maximum size of the output, or 0 if there is none.
+  SharedMemoryPool* pool_ = nullptr;
+  SharedMemoryManager::Reference pool_reference_;
 };
 
 
@@ -278,6 +381,15 @@ struct AllocPayload {
   // lifetime is that of a response... but it is convenient to keep it
   // here.
   std::list<std::string> serialized_data_;
+
+  // References to the shared memory regions used by the request's inputs
+  // and outputs, so that a region unregistered while the request is in
+  // flight stays mapped until the request is done with it.
+  std::vector<SharedMemoryManager::Reference> shm_references_;
+
+  // The allocations of the outputs in shared memory pools, released if
+  // the responses aren't written to the client.
+  SharedMemoryPoolAllocations pool_allocations_;
 };
 
 template <typename ResponseType>
@@ -287,6 +399,7 @@ InferAllocatorPayload(
     const std::shared_ptr<SharedMemoryManager>& shm_manager,
     const inference::ModelInferRequest& request,
     std::list<std::string>&& serialized_data,
+    std::vector<SharedMemoryManager::Reference>&& shm_references,
     std::shared_ptr<ResponseQueue<ResponseType>> response_queue,
     AllocPayload<ResponseType>* alloc_payload)
 {
@@ -294,6 +407,7 @@ InferAllocatorPayload(
   alloc_payload->shm_map_.clear();
   alloc_payload->classification_map_.clear();
   alloc_payload->serialized_data_ = std::move(serialized_data);
+  alloc_payload->shm_references_ = std::move(shm_references);
 
   // If any of the outputs use shared memory, then we must calculate
   // the memory address for that output and store it in the allocator
@@ -301,12 +415,14 @@ InferAllocatorPayload(
   // invoked.
   for (const auto& io : request.outputs()) {
     std::string region_name;
+    uint64_t region_handle;
     int64_t offset;
     size_t byte_size;
     bool has_shared_memory;
     RETURN_IF_ERR(ParseSharedMemoryParams<
                   inference::ModelInferRequest::InferRequestedOutputTensor>(
-        io, &has_shared_memory, &region_name, &offset, &byte_size));
+        io, &has_shared_memory, &region_name, &region_handle, &offset,
+        &byte_size));
 
     bool has_classification;
     uint32_t classification_count;
@@ -324,14 +440,35 @@ InferAllocatorPayload(
       void* base;
       TRITONSERVER_MemoryType memory_type;
       int64_t memory_type_id;
+      SharedMemoryManager::Reference reference;
+      SharedMemoryPool* pool;
       RETURN_IF_ERR(shm_manager->GetMemoryInfo(
-          region_name, offset, &base, &memory_type, &memory_type_id));
-
-      if (memory_type == TRITONSERVER_MEMORY_GPU) {
+          region_name, region_handle, offset, &base, &memory_type,
+          &memory_type_id, &reference, nullptr /* byte_size */, &pool));
+      alloc_payload->shm_references_.emplace_back(std::move(reference));
+
+      if (pool != nullptr) {
+        // The output is allocated in the pool once its size is known.
+        if (offset != 0) {
+          return TRITONSERVER_ErrorNew(
+              TRITONSERVER_ERROR_INVALID_ARG,
+              std::string(
+                  "'shared_memory_offset' can't be set for output '" +
+                  io.name() + "', it is allocated by the server in the pool")
+                  .c_str());
+        }
+        ShmInfo info(
+            nullptr /* base */, byte_size, memory_type, memory_type_id,
+            nullptr /* cuda_ipc_handle */);
+        info.pool_ = pool;
+        info.pool_reference_ = alloc_payload->shm_references_.back();
+        alloc_payload->shm_map_.emplace(io.name(), info);
+      } else if (memory_type == TRITONSERVER_MEMORY_GPU) {
 #ifdef TRITON_ENABLE_GPU
         char* cuda_handle;
         RETURN_IF_ERR(shm_manager->GetCUDAHandle(
-            region_name, reinterpret_cast<cudaIpcMemHandle_t**>(&cuda_handle)));
+            region_name, region_handle,
+            reinterpret_cast<cudaIpcMemHandle_t**>(&cuda_handle)));
         alloc_payload->shm_map_.emplace(
             io.name(),
             ShmInfo(base, byte_size, memory_type, memory_type_id, cuda_handle));
@@ -361,13 +498,15 @@ TRITONSERVER_Error* InferGRPCToInput(
     const std::shared_ptr<SharedMemoryManager>& shm_manager,
     const inference::ModelInferRequest& request,
     std::list<std::string>* serialized_data,
+    std::vector<SharedMemoryManager::Reference>* shm_references,
     TRITONSERVER_InferenceRequest* inference_request);
 
 TRITONSERVER_Error* ResponseAllocatorHelper(
     TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
     size_t byte_size, TRITONSERVER_MemoryType preferred_memory_type,
     int64_t preferred_memory_type_id, inference::ModelInferResponse* response,
-    const TensorShmMap& shm_map, void** buffer, void** buffer_userp,
+    const TensorShmMap& shm_map, SharedMemoryPoolAllocations* pool_allocations,
+    const uint32_t response_index, void** buffer, void** buffer_userp,
     TRITONSERVER_MemoryType* actual_memory_type,
     int64_t* actual_memory_type_id);
 
@@ -399,6 +538,8 @@ TRITONSERVER_Error* SetStateParameterFromTritonParameter(
     StateParameters& state_params,
     const std::pair<std::string, inference::InferParameter>& param);
 
+// Release callback of the inference requests. 'userp' is the
+// InferRequestPool::Entry of a pooled request, or nullptr.
 void InferRequestComplete(
     TRITONSERVER_InferenceRequest* request, const uint32_t flags, void* userp);
 
@@ -627,17 +768,96 @@ class InferHandlerState {
         ::grpc::ServerCompletionQueue* cq, const uint64_t unique_id = 0)
         : cq_(cq), unique_id_(unique_id), ongoing_requests_(0),
           step_(Steps::START), finish_ok_(true), ongoing_write_(false),
-          received_notification_(false)
+          received_notification_(false), buffered_bytes_(0),
+          buffered_count_(0), paused_read_state_(nullptr)
     {
       ctx_.reset(new ::grpc::ServerContext());
       responder_.reset(new ServerResponderType(ctx_.get()));
     }
 
+    ~Context()
+    {
+      // Responses that were never written, for example because the
+      // stream was cancelled, are no longer buffered.
+      if (buffer_budget_ != nullptr) {
+        buffer_budget_->ReportBuffered(
+            -static_cast<double>(buffered_bytes_),
+            -static_cast<double>(buffered_count_));
+      }
+    }
+
     void SetCompressionLevel(grpc_compression_level compression_level)
     {
       ctx_->set_compression_level(compression_level);
     }
 
+    void SetBufferBudget(const std::shared_ptr<ResponseBufferBudget>& budget)
+    {
+      buffer_budget_ = budget;
+    }
+
+    bool HasBufferBudget() { return (buffer_budget_ != nullptr); }
+
+    // Accounts a response of 'byte_size' bytes that is ready to be
+    // written to the stream.
+    void BufferResponse(const size_t byte_size)
+    {
+      if (buffer_budget_ == nullptr) {
+        return;
+      }
+      std::lock_guard<std::recursive_mutex> lock(mu_);
+      buffered_bytes_ += byte_size;
+      buffered_count_++;
+      buffer_budget_->ReportBuffered(byte_size, 1);
+    }
+
+    // Accounts a response of 'byte_size' bytes that has been handed
+    // to the stream.
+    void UnbufferResponse(const size_t byte_size)
+    {
+      if (buffer_budget_ == nullptr) {
+        return;
+      }
+      std::lock_guard<std::recursive_mutex> lock(mu_);
+      buffered_bytes_ -= std::min(buffered_bytes_, byte_size);
+      if (buffered_count_ > 0) {
+        buffered_count_--;
+      }
+      buffer_budget_->ReportBuffered(-static_cast<double>(byte_size), -1);
+    }
+
+    // Holds 'state' back from reading the next request of the stream
+    // if the buffered responses exceed the budget. Returns true if the
+    // read is paused, in which case the state is handed back by
+    // ResumeRead() once enough responses are written.
+    bool PauseReadIfOverBudget(InferHandlerStateType* state)
+    {
+      if (buffer_budget_ == nullptr) {
+        return false;
+      }
+      std::lock_guard<std::recursive_mutex> lock(mu_);
+      if (!buffer_budget_->Exceeded(buffered_bytes_, buffered_count_)) {
+        return false;
+      }
+      buffer_budget_->ReportExceeded();
+      paused_read_state_ = state;
+      return true;
+    }
+
+    // Returns the state whose read was paused if the buffered
+    // responses are back within the budget, nullptr otherwise.
+    InferHandlerStateType* ResumeRead()
+    {
+      std::lock_guard<std::recursive_mutex> lock(mu_);
+      if ((paused_read_state_ == nullptr) ||
+          buffer_budget_->Exceeded(buffered_bytes_, buffered_count_)) {
+        return nullptr;
+      }
+      InferHandlerStateType* state = paused_read_state_;
+      paused_read_state_ = nullptr;
+      return state;
+    }
+
     void GrpcContextAsyncNotifyWhenDone(InferHandlerStateType* state)
     {
       notify_state_ = std::unique_ptr<InferHandlerStateType>(
@@ -689,6 +909,9 @@ class InferHandlerState {
           }
           PutTaskBackToQueue(state);
         }
+        // The paused state, if any, is among 'all_states_' and so has
+        // been finished above.
+        paused_read_state_ = nullptr;
         step_ = Steps::FINISH;
         return true;
       }
@@ -772,6 +995,14 @@ class InferHandlerState {
             PutTaskBackToQueue(state);
           }
         }
+
+        // A state paused on the response buffer budget has no pending
+        // operation, place it on the completion queue so that it can
+        // be released.
+        if (paused_read_state_ != nullptr) {
+          PutTaskBackToQueue(paused_read_state_);
+          paused_read_state_ = nullptr;
+        }
       }
     }
 
@@ -846,16 +1077,20 @@ class InferHandlerState {
       states_.push(state);
     }
 
-    // Write the response to the stream directly.
-    void DecoupledWriteResponse(InferHandlerStateType* state)
+    // Write the response to the stream directly. 'options' can carry
+    // a buffer hint to let the transport hold the message back and
+    // coalesce it with the next write on the stream.
+    void DecoupledWriteResponse(
+        InferHandlerStateType* state,
+        const ::grpc::WriteOptions& options = ::grpc::WriteOptions())
     {
 #ifdef TRITON_ENABLE_TRACING
-      state->trace_timestamps_.emplace_back(
-          std::make_pair("GRPC_SEND_START", TraceManager::CaptureTimestamp()));
+      state->trace_timestamps_.Capture(
+          FrontendStage::GRPC_SEND_START, TraceManager::CaptureTimestamp());
 #endif  // TRITON_ENABLE_TRACING
       state->step_ = Steps::WRITTEN;
       ResponseType* response = state->response_queue_->GetCurrentResponse();
-      responder_->Write(*response, state);
+      responder_->Write(*response, options, state);
 
       // Clear the response after writing
       response->mutable_infer_response()->Clear();
@@ -869,14 +1104,52 @@ class InferHandlerState {
     void PutTaskBackToQueue(InferHandlerStateType* state)
     {
       std::lock_guard<std::recursive_mutex> lock(mu_);
+      if (state->transport_metrics_ != nullptr) {
+        state->enqueue_ns_ = TransportMethodMetrics::Now();
+      }
       // FIXME: Is there a better way to put task on the
       // completion queue rather than using alarm object?
       // The alarm object will add a new task to the back of the
       // completion queue when it expires or when it’s cancelled.
+      if (state->alarm_delayed_) {
+        // The alarm is still pending, it can't be set again. Cancelling
+        // it puts the state on the queue right away instead.
+        state->alarm_.Cancel();
+        return;
+      }
       state->alarm_.Set(
           cq_, gpr_now(gpr_clock_type::GPR_CLOCK_REALTIME), state);
     }
 
+    // Adds the state object to the completion queue once 'delay_us'
+    // microseconds have passed. Putting the state back on the queue
+    // in the meantime does it right away instead. Must be followed by
+    // TaskTakenFromQueue() when the state is taken from the queue.
+    void PutTaskBackToQueueAfter(InferHandlerStateType* state, int delay_us)
+    {
+      std::lock_guard<std::recursive_mutex> lock(mu_);
+      state->alarm_delayed_ = true;
+      state->alarm_.Set(
+          cq_,
+          gpr_time_add(
+              gpr_now(gpr_clock_type::GPR_CLOCK_REALTIME),
+              gpr_time_from_micros(delay_us, GPR_TIMESPAN)),
+          state);
+    }
+
+    // Records that 'state' was taken from the completion queue, so that
+    // a delayed alarm of the state is no longer pending. Must be called
+    // by the thread that handles the completion queue.
+    void TaskTakenFromQueue(InferHandlerStateType* state)
+    {
+      // Only this thread sets the flag so it can be read without the
+      // lock.
+      if (state->alarm_delayed_) {
+        std::lock_guard<std::recursive_mutex> lock(mu_);
+        state->alarm_delayed_ = false;
+      }
+    }
+
     // Check the state at the front of the queue and write it if
     // ready. The state at the front of the queue is ready if it is in
     // the WRITEREADY state and it equals 'required_state' (or
@@ -900,9 +1173,15 @@ class InferHandlerState {
         return nullptr;
       }
 
+      if (state->write_ready_ns_ != 0) {
+        state->transport_metrics_->ObserveStage(
+            TransportStage::WRITE_WAIT, state->write_ready_ns_);
+        state->write_ready_ns_ = 0;
+      }
+
 #ifdef TRITON_ENABLE_TRACING
-      state->trace_timestamps_.emplace_back(
-          std::make_pair("GRPC_SEND_START", TraceManager::CaptureTimestamp()));
+      state->trace_timestamps_.Capture(
+          FrontendStage::GRPC_SEND_START, TraceManager::CaptureTimestamp());
 #endif  // TRITON_ENABLE_TRACING
 
       state->step_ = Steps::WRITTEN;
@@ -986,6 +1265,17 @@ class InferHandlerState {
     // Tracks whether the async notification has been delivered by
     // completion queue.
     bool received_notification_;
+
+    // The responses of the stream that are ready to be written but
+    // not yet written, and the budget they are accounted against.
+    // Guarded by 'mu_'.
+    std::shared_ptr<ResponseBufferBudget> buffer_budget_;
+    size_t buffered_bytes_;
+    uint32_t buffered_count_;
+
+    // The state that reads the next request of the stream once the
+    // buffered responses are back within the budget.
+    InferHandlerStateType* paused_read_state_;
   };
 
   // This constructor is used to build a wrapper state object
@@ -993,7 +1283,8 @@ class InferHandlerState {
   // object is used to distinguish a tag from AsyncNotifyWhenDone()
   // signal.
   explicit InferHandlerState(Steps start_step, InferHandlerState* state)
-      : step_(start_step), state_ptr_(state), async_notify_state_(false)
+      : step_(start_step), request_(nullptr), state_ptr_(state),
+        async_notify_state_(false)
   {
     state->MarkAsAsyncNotifyState();
   }
@@ -1001,7 +1292,8 @@ class InferHandlerState {
   explicit InferHandlerState(
       TRITONSERVER_Server* tritonserver,
       const std::shared_ptr<Context>& context, Steps start_step = Steps::START)
-      : tritonserver_(tritonserver), async_notify_state_(false)
+      : tritonserver_(tritonserver), request_(nullptr),
+        async_notify_state_(false)
   {
     // For debugging and testing,
     const char* dstr = getenv("TRITONSERVER_DELAY_GRPC_RESPONSE");
@@ -1027,8 +1319,15 @@ class InferHandlerState {
     cb_count_ = 0;
     is_decoupled_ = false;
     complete_ = false;
+    write_deferred_ = false;
+    alarm_delayed_ = false;
+    enqueue_ns_ = 0;
+    write_ready_ns_ = 0;
+    cpu_ns_ = 0;
     parameters_ = {};
-    request_.Clear();
+    if (!arena_.Reset() || (request_ == nullptr)) {
+      request_ = arena_.Create<RequestType>();
+    }
     response_queue_->Reset();
     // Clear trace_timestamps_ here so they do not grow indefinitely since
     // states are re-used for performance.
@@ -1043,6 +1342,8 @@ class InferHandlerState {
   {
     context_ = nullptr;
     ClearTraceTimestamps();
+    // The outputs allocated in pools of responses that weren't sent.
+    alloc_payload_.pool_allocations_.Release();
   }
 
   void ClearTraceTimestamps()
@@ -1054,7 +1355,41 @@ class InferHandlerState {
       }
       trace_.reset();
     }
-    trace_timestamps_.clear();
+    trace_timestamps_.Clear();
+#endif  // TRITON_ENABLE_TRACING
+  }
+
+  // Return the CPU time of the calling thread to pass to AddCpu() if
+  // the stage metrics are reported, 0 otherwise.
+  uint64_t CpuStart() const
+  {
+    return (stage_metrics_ != nullptr) ? FrontendStageMetrics::ThreadCpuNs()
+                                       : 0;
+  }
+
+  // Add the CPU time of the calling thread since 'start_ns' to the
+  // frontend CPU time of the request.
+  void AddCpu(const uint64_t start_ns)
+  {
+    if (stage_metrics_ != nullptr) {
+      cpu_ns_.fetch_add(
+          FrontendStageMetrics::ThreadCpuNs() - start_ns,
+          std::memory_order_relaxed);
+    }
+  }
+
+  // Observe the stages of the request if the stage metrics are
+  // reported. Must be called once the responses of the request are
+  // written. Only the requests that reached the model are observed so
+  // that the metrics are not labeled with arbitrary model names.
+  void ObserveStages()
+  {
+#ifdef TRITON_ENABLE_TRACING
+    if ((stage_metrics_ != nullptr) && (cb_count_ != 0)) {
+      stage_metrics_->Observe(
+          request_->model_name(), trace_timestamps_,
+          cpu_ns_.load(std::memory_order_relaxed));
+    }
 #endif  // TRITON_ENABLE_TRACING
   }
 
@@ -1082,7 +1417,9 @@ class InferHandlerState {
 #ifdef TRITON_ENABLE_TRACING
   std::shared_ptr<TraceManager::Trace> trace_;
   // Additional timestamps that are captured before a trace stream is acquired
-  std::deque<std::pair<std::string, uint64_t>> trace_timestamps_;
+  FrontendTimestamps trace_timestamps_;
+  // Whether the per-stage breakdown of the request is sent to the client.
+  bool server_timing_ = false;
 #endif  // TRITON_ENABLE_TRACING
 
   bool is_decoupled_ = false;
@@ -1091,7 +1428,33 @@ class InferHandlerState {
   std::atomic<uint32_t> cb_count_;
   bool complete_;
 
-  RequestType request_;
+  // Whether the write of the current ready response has already
+  // been held back once to coalesce it with later responses.
+  bool write_deferred_;
+
+  // Whether 'alarm_' is set to put the state back on the completion
+  // queue after a delay and the state wasn't taken from the queue
+  // since. Protected by the mutex of the context.
+  bool alarm_delayed_ = false;
+
+  // The transport metrics of the RPC, nullptr if not reported. When
+  // reported, the times in nanoseconds the state was last put back on
+  // the completion queue and its response became ready to be written,
+  // 0 if not pending.
+  TransportMethodMetrics* transport_metrics_ = nullptr;
+  uint64_t enqueue_ns_ = 0;
+  uint64_t write_ready_ns_ = 0;
+
+  // The frontend stage metrics of the request, nullptr if not reported.
+  // When reported, the CPU time in nanoseconds spent on the request by
+  // the handler thread and the threads delivering its responses.
+  FrontendStageMetrics* stage_metrics_ = nullptr;
+  std::atomic<uint64_t> cpu_ns_{0};
+
+  // The request is owned by 'arena_', it is cleared by Reset() or
+  // re-created if the arena released it.
+  MessageArena arena_;
+  RequestType* request_;
   std::shared_ptr<ResponseQueue<ResponseType>> response_queue_;
 
   ::grpc::Alarm alarm_;
@@ -1140,6 +1503,20 @@ class InferHandler : public HandlerBase {
   // Stop handling requests.
   void Stop() override;
 
+  // Report the transport metrics of the requests to 'metrics'. Must be
+  // called before Start().
+  void SetTransportMetrics(TransportMethodMetrics* metrics)
+  {
+    transport_metrics_ = metrics;
+  }
+
+  // Report the frontend stages of the requests to 'metrics'. Must be
+  // called before Start().
+  void SetStageMetrics(FrontendStageMetrics* metrics)
+  {
+    stage_metrics_ = metrics;
+  }
+
  protected:
   using State =
       InferHandlerState<ServerResponderType, RequestType, ResponseType>;
@@ -1165,6 +1542,8 @@ class InferHandler : public HandlerBase {
     if (state == nullptr) {
       state = new State(tritonserver, context, start_step);
     }
+    state->transport_metrics_ = transport_metrics_;
+    state->stage_metrics_ = stage_metrics_;
 
     if (start_step == Steps::START) {
       // Need to be called to receive an asynchronous notification
@@ -1221,6 +1600,9 @@ class InferHandler : public HandlerBase {
   std::pair<std::string, std::string> restricted_kv_;
   std::string header_forward_pattern_;
   re2::RE2 header_forward_regex_;
+
+  TransportMethodMetrics* transport_metrics_ = nullptr;
+  FrontendStageMetrics* stage_metrics_ = nullptr;
 };
 
 template <
@@ -1282,6 +1664,13 @@ InferHandler<
         state->context_->SetReceivedNotification(true);
         LOG_VERBOSE(1) << "Received notification for " << Name() << ", "
                        << state->unique_id_;
+      } else {
+        state->context_->TaskTakenFromQueue(state);
+        if (state->enqueue_ns_ != 0) {
+          state->transport_metrics_->ObserveStage(
+              TransportStage::QUEUE, state->enqueue_ns_);
+          state->enqueue_ns_ = 0;
+        }
       }
       LOG_VERBOSE(2) << "Grpc::CQ::Next() "
                      << state->context_->DebugString(state);
@@ -1407,6 +1796,10 @@ class ModelInferHandler
         "deleting response allocator");
   }
 
+  // Reuse the inference requests of 'pool', which must outlive the
+  // requests. Must be called before Start().
+  void SetRequestPool(InferRequestPool* pool) { request_pool_ = pool; }
+
  protected:
   void StartNewRequest() override;
   bool Process(State* state, bool rpc_ok) override;
@@ -1422,6 +1815,9 @@ class ModelInferHandler
   TRITONSERVER_ResponseAllocator* allocator_;
 
   grpc_compression_level compression_level_;
+
+  // nullptr if inference requests are not reused.
+  InferRequestPool* request_pool_ = nullptr;
 };
 
 }}}  // namespace triton::server::grpc
@@ -0,0 +1,265 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "orca_service.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "triton/common/logging.h"
+
+namespace triton { namespace server { namespace grpc {
+
+//
+// OrcaReportEncoder
+//
+void
+OrcaReportEncoder::Fill(
+    const LoadReport& report, xds::data::orca::v3::OrcaLoadReport* orca)
+{
+  orca->set_cpu_utilization(report.cpu_utilization_);
+  orca->set_rps_fractional(report.requests_per_second_);
+  auto& named_metrics = *orca->mutable_named_metrics();
+  named_metrics["inflight_requests"] = report.inflight_requests_;
+  named_metrics["shed_rate"] = report.shed_per_second_;
+  for (const auto& depth : report.queue_depth_) {
+    named_metrics["queue_depth." + depth.first] = depth.second;
+  }
+}
+
+std::shared_ptr<const std::string>
+OrcaReportEncoder::Encoded()
+{
+  std::shared_ptr<const LoadReport> report = reporter_->Report();
+  std::shared_ptr<const Encoding> encoding = std::atomic_load(&encoding_);
+  if ((encoding == nullptr) || (encoding->report_ != report)) {
+    // Concurrent callers may encode the same snapshot, which is
+    // harmless and cheaper than serializing them.
+    xds::data::orca::v3::OrcaLoadReport orca;
+    Fill(*report, &orca);
+    std::shared_ptr<Encoding> fresh = std::make_shared<Encoding>();
+    fresh->report_ = report;
+    fresh->encoded_ = std::make_shared<const std::string>(
+        orca.SerializeAsString());
+    encoding = fresh;
+    std::atomic_store(&encoding_, encoding);
+  }
+  return encoding->encoded_;
+}
+
+//
+// LoadReportInterceptor
+//
+LoadReportInterceptor::LoadReportInterceptor(
+    LoadReporter* reporter, OrcaReportEncoder* encoder)
+    : reporter_(reporter), encoder_(encoder)
+{
+  reporter_->RequestStarted();
+}
+
+LoadReportInterceptor::~LoadReportInterceptor()
+{
+  reporter_->RequestDone();
+}
+
+void
+LoadReportInterceptor::Intercept(
+    ::grpc::experimental::InterceptorBatchMethods* methods)
+{
+  if (methods->QueryInterceptionHookPoint(
+          ::grpc::experimental::InterceptionHookPoints::PRE_SEND_STATUS)) {
+    if (methods->GetSendStatus().error_code() ==
+        ::grpc::StatusCode::UNAVAILABLE) {
+      reporter_->RequestShed();
+    }
+    methods->GetSendTrailingMetadata()->emplace(
+        "endpoint-load-metrics-bin", *encoder_->Encoded());
+  }
+  methods->Proceed();
+}
+
+::grpc::experimental::Interceptor*
+LoadReportInterceptorFactory::CreateServerInterceptor(
+    ::grpc::experimental::ServerRpcInfo* info)
+{
+  if (methods_.find(info->method()) == methods_.end()) {
+    return nullptr;
+  }
+  return new LoadReportInterceptor(reporter_.get(), encoder_.get());
+}
+
+//
+// OrcaHandler
+//
+struct OrcaHandler::Stream {
+  enum class Step { START, WRITTEN, WAITING, FINISH };
+
+  Stream() : responder_(&ctx_), step_(Step::START) {}
+
+  ::grpc::ServerContext ctx_;
+  ::grpc::ServerAsyncWriter<xds::data::orca::v3::OrcaLoadReport> responder_;
+  xds::service::orca::v3::OrcaLoadReportRequest request_;
+  xds::data::orca::v3::OrcaLoadReport report_;
+  ::grpc::Alarm alarm_;
+  Step step_;
+  std::chrono::milliseconds interval_;
+};
+
+OrcaHandler::OrcaHandler(
+    const std::string& name, const std::shared_ptr<LoadReporter>& reporter,
+    xds::service::orca::v3::OpenRcaService::AsyncService* service,
+    ::grpc::ServerCompletionQueue* cq)
+    : name_(name), reporter_(reporter), service_(service), cq_(cq),
+      draining_(false)
+{
+}
+
+OrcaHandler::~OrcaHandler()
+{
+  for (Stream* stream : streams_) {
+    delete stream;
+  }
+  LOG_VERBOSE(1) << "Destructed " << name_;
+}
+
+void
+OrcaHandler::Start()
+{
+  StartNewStream();
+  thread_.reset(new std::thread([this] {
+    void* tag;
+    bool ok;
+    while (cq_->Next(&tag, &ok)) {
+      Stream* stream = static_cast<Stream*>(tag);
+      if (!Process(stream, ok)) {
+        {
+          std::lock_guard<std::mutex> lock(mu_);
+          streams_.erase(stream);
+        }
+        delete stream;
+      }
+    }
+  }));
+  LOG_VERBOSE(1) << "Thread started for " << name_;
+}
+
+void
+OrcaHandler::Stop()
+{
+  if ((thread_ != nullptr) && thread_->joinable()) {
+    thread_->join();
+  }
+  LOG_VERBOSE(1) << "Thread exited for " << name_;
+}
+
+void
+OrcaHandler::Drain()
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  draining_ = true;
+  for (Stream* stream : streams_) {
+    stream->alarm_.Cancel();
+  }
+}
+
+void
+OrcaHandler::StartNewStream()
+{
+  Stream* stream = new Stream();
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    streams_.insert(stream);
+  }
+  service_->RequestStreamCoreMetrics(
+      &stream->ctx_, &stream->request_, &stream->responder_, cq_, cq_,
+      stream);
+}
+
+void
+OrcaHandler::WriteReport(Stream* stream)
+{
+  stream->report_.Clear();
+  OrcaReportEncoder::Fill(*reporter_->Report(), &stream->report_);
+  stream->step_ = Stream::Step::WRITTEN;
+  stream->responder_.Write(stream->report_, stream);
+}
+
+bool
+OrcaHandler::Process(Stream* stream, bool ok)
+{
+  switch (stream->step_) {
+    case Stream::Step::START: {
+      // If the stream failed to start the server is shutting down.
+      if (!ok) {
+        return false;
+      }
+      StartNewStream();
+
+      // Never report more often than the reporter takes snapshots.
+      const auto& requested = stream->request_.report_interval();
+      stream->interval_ = std::max(
+          std::chrono::milliseconds(
+              requested.seconds() * 1000 + requested.nanos() / 1000000),
+          std::chrono::milliseconds(reporter_->IntervalMs()));
+      WriteReport(stream);
+      return true;
+    }
+    case Stream::Step::WRITTEN: {
+      std::lock_guard<std::mutex> lock(mu_);
+      // Failing to write means that the client is gone.
+      if (!ok || draining_) {
+        stream->step_ = Stream::Step::FINISH;
+        stream->responder_.Finish(
+            ok ? ::grpc::Status::OK : ::grpc::Status::CANCELLED, stream);
+      } else {
+        stream->step_ = Stream::Step::WAITING;
+        stream->alarm_.Set(
+            cq_, std::chrono::system_clock::now() + stream->interval_,
+            stream);
+      }
+      return true;
+    }
+    case Stream::Step::WAITING: {
+      bool draining;
+      {
+        std::lock_guard<std::mutex> lock(mu_);
+        draining = draining_;
+      }
+      if (draining) {
+        stream->step_ = Stream::Step::FINISH;
+        stream->responder_.Finish(::grpc::Status::OK, stream);
+      } else {
+        WriteReport(stream);
+      }
+      return true;
+    }
+    case Stream::Step::FINISH:
+    default:
+      return false;
+  }
+}
+
+}}}  // namespace triton::server::grpc
@@ -0,0 +1,155 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <grpc++/alarm.h>
+#include <grpc++/grpc++.h>
+#include <grpcpp/support/server_interceptor.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../load_reporter.h"
+#include "grpc_handler.h"
+#include "orca_load_report.pb.h"
+#include "orca_service.grpc.pb.h"
+
+namespace triton { namespace server { namespace grpc {
+
+//
+// Caches the latest load report of a LoadReporter serialized as an
+// ORCA load report, so that it is serialized once per snapshot instead
+// of once per response.
+//
+class OrcaReportEncoder {
+ public:
+  explicit OrcaReportEncoder(const std::shared_ptr<LoadReporter>& reporter)
+      : reporter_(reporter)
+  {
+  }
+
+  static void Fill(
+      const LoadReport& report, xds::data::orca::v3::OrcaLoadReport* orca);
+
+  // Returns the serialized ORCA load report of the latest snapshot.
+  std::shared_ptr<const std::string> Encoded();
+
+ private:
+  struct Encoding {
+    std::shared_ptr<const LoadReport> report_;
+    std::shared_ptr<const std::string> encoded_;
+  };
+
+  std::shared_ptr<LoadReporter> reporter_;
+  // Accessed with the atomic operations of std::shared_ptr.
+  std::shared_ptr<const Encoding> encoding_;
+};
+
+//
+// Server interceptor that tracks the inference RPCs in the load
+// reporter and attaches the latest load report to their trailing
+// metadata, as 'endpoint-load-metrics-bin' per the ORCA protocol.
+//
+class LoadReportInterceptor : public ::grpc::experimental::Interceptor {
+ public:
+  LoadReportInterceptor(
+      LoadReporter* reporter, OrcaReportEncoder* encoder);
+  ~LoadReportInterceptor();
+
+  void Intercept(::grpc::experimental::InterceptorBatchMethods* methods)
+      override;
+
+ private:
+  LoadReporter* reporter_;
+  OrcaReportEncoder* encoder_;
+};
+
+class LoadReportInterceptorFactory
+    : public ::grpc::experimental::ServerInterceptorFactoryInterface {
+ public:
+  // 'methods' are the full gRPC names of the inference methods.
+  LoadReportInterceptorFactory(
+      const std::shared_ptr<LoadReporter>& reporter,
+      const std::shared_ptr<OrcaReportEncoder>& encoder,
+      const std::set<std::string>& methods)
+      : reporter_(reporter), encoder_(encoder), methods_(methods)
+  {
+  }
+
+  ::grpc::experimental::Interceptor* CreateServerInterceptor(
+      ::grpc::experimental::ServerRpcInfo* info) override;
+
+ private:
+  std::shared_ptr<LoadReporter> reporter_;
+  std::shared_ptr<OrcaReportEncoder> encoder_;
+  const std::set<std::string> methods_;
+};
+
+//
+// Handler for the StreamCoreMetrics RPC of the ORCA out-of-band load
+// reporting service, on a completion queue of its own.
+//
+class OrcaHandler : public HandlerBase {
+ public:
+  OrcaHandler(
+      const std::string& name, const std::shared_ptr<LoadReporter>& reporter,
+      xds::service::orca::v3::OpenRcaService::AsyncService* service,
+      ::grpc::ServerCompletionQueue* cq);
+  ~OrcaHandler();
+
+  void Start() override;
+  void Stop() override;
+
+  // Completes the streams at their next report instead of waiting for
+  // the clients to cancel them, must be called before shutting down
+  // the server.
+  void Drain();
+
+ private:
+  struct Stream;
+
+  void StartNewStream();
+  bool Process(Stream* stream, bool ok);
+  void WriteReport(Stream* stream);
+
+  const std::string name_;
+  std::shared_ptr<LoadReporter> reporter_;
+  xds::service::orca::v3::OpenRcaService::AsyncService* service_;
+  ::grpc::ServerCompletionQueue* cq_;
+  std::unique_ptr<std::thread> thread_;
+
+  // Protects 'draining_' and the alarms of 'streams_'.
+  std::mutex mu_;
+  bool draining_;
+  std::set<Stream*> streams_;
+};
+
+}}}  // namespace triton::server::grpc
@@ -54,8 +54,9 @@ StreamInferResponseAlloc(
   return ResponseAllocatorHelper(
       allocator, tensor_name, byte_size, preferred_memory_type,
       preferred_memory_type_id, response->mutable_infer_response(),
-      payload->shm_map_, buffer, buffer_userp, actual_memory_type,
-      actual_memory_type_id);
+      payload->shm_map_, &payload->pool_allocations_,
+      payload->response_queue_->AllocatedResponseCount() - 1, buffer,
+      buffer_userp, actual_memory_type, actual_memory_type_id);
 }
 
 TRITONSERVER_Error*
@@ -112,13 +113,14 @@ ModelStreamInferHandler::StartNewRequest()
 {
   auto context = std::make_shared<State::Context>(cq_, NEXT_UNIQUE_ID);
   context->SetCompressionLevel(compression_level_);
+  context->SetBufferBudget(buffer_budget_);
   State* state = StateNew(tritonserver_.get(), context);
 
 #ifdef TRITON_ENABLE_TRACING
   // Can't create trace as we don't know the model to be requested,
   // track timestamps in 'state'
-  state->trace_timestamps_.emplace_back(
-      std::make_pair("GRPC_WAITREAD_START", TraceManager::CaptureTimestamp()));
+  state->trace_timestamps_.Capture(
+      FrontendStage::GRPC_WAITREAD_START, TraceManager::CaptureTimestamp());
 #endif  // TRITON_ENABLE_TRACING
 
   service_->RequestModelStreamInfer(
@@ -177,7 +179,7 @@ ModelStreamInferHandler::Process(InferHandler::State* state, bool rpc_ok)
       // used yet so use it to read a request off the connection.
       state->context_->step_ = Steps::READ;
       state->step_ = Steps::READ;
-      state->context_->responder_->Read(&state->request_, state);
+      state->context_->responder_->Read(state->request_, state);
     } else {
       // Precondition is not satisfied, cancel the stream
       state->context_->step_ = Steps::COMPLETE;
@@ -192,10 +194,10 @@ ModelStreamInferHandler::Process(InferHandler::State* state, bool rpc_ok)
 
   } else if (state->step_ == Steps::READ) {
     TRITONSERVER_Error* err = nullptr;
-    const inference::ModelInferRequest& request = state->request_;
+    const inference::ModelInferRequest& request = *state->request_;
 #ifdef TRITON_ENABLE_TRACING
-    state->trace_timestamps_.emplace_back(
-        std::make_pair("GRPC_WAITREAD_END", TraceManager::CaptureTimestamp()));
+    state->trace_timestamps_.Capture(
+        FrontendStage::GRPC_WAITREAD_END, TraceManager::CaptureTimestamp());
 #endif  // TRITON_ENABLE_TRACING
 
     // If done reading and no in-flight requests then can finish the
@@ -219,6 +221,11 @@ ModelStreamInferHandler::Process(InferHandler::State* state, bool rpc_ok)
       return !finished;
     }
 
+    const uint64_t parse_start_ns = (state->transport_metrics_ != nullptr)
+                                        ? TransportMethodMetrics::Now()
+                                        : 0;
+    const uint64_t cpu_start_ns = state->CpuStart();
+
     int64_t requested_model_version;
     err = GetModelVersionFromString(
         request.model_version(), &requested_model_version);
@@ -264,6 +271,11 @@ ModelStreamInferHandler::Process(InferHandler::State* state, bool rpc_ok)
           requested_model_version);
     }
 
+#ifdef TRITON_ENABLE_TRACING
+    state->trace_timestamps_.Capture(
+        FrontendStage::INPUT_SETUP_START, TraceManager::CaptureTimestamp());
+#endif  // TRITON_ENABLE_TRACING
+
     if (err == nullptr) {
       err = SetInferenceRequestMetadata(irequest, request, state->parameters_);
     }
@@ -275,16 +287,26 @@ ModelStreamInferHandler::Process(InferHandler::State* state, bool rpc_ok)
     // Will be used to hold the serialized data in case explicit string
     // tensors are present in the request.
     std::list<std::string> serialized_data;
+    // Keeps the shared memory regions used by the inputs mapped until
+    // the request is released.
+    std::vector<SharedMemoryManager::Reference> shm_references;
 
     if (err == nullptr) {
       err = InferGRPCToInput(
-          tritonserver_, shm_manager_, request, &serialized_data, irequest);
+          tritonserver_, shm_manager_, request, &serialized_data,
+          &shm_references, irequest);
     }
     if (err == nullptr) {
       err = InferAllocatorPayload<inference::ModelStreamInferResponse>(
           tritonserver_, shm_manager_, request, std::move(serialized_data),
-          response_queue_, &state->alloc_payload_);
+          std::move(shm_references), response_queue_,
+          &state->alloc_payload_);
     }
+
+#ifdef TRITON_ENABLE_TRACING
+    state->trace_timestamps_.Capture(
+        FrontendStage::INPUT_SETUP_END, TraceManager::CaptureTimestamp());
+#endif  // TRITON_ENABLE_TRACING
     if (err == nullptr) {
       err = TRITONSERVER_InferenceRequestSetReleaseCallback(
           irequest, InferRequestComplete, nullptr /* request_release_userp */);
@@ -306,6 +328,12 @@ ModelStreamInferHandler::Process(InferHandler::State* state, bool rpc_ok)
       }
 #endif  // TRITON_ENABLE_TRACING
 
+      if (parse_start_ns != 0) {
+        state->transport_metrics_->ObserveStage(
+            TransportStage::PARSE, parse_start_ns);
+      }
+
+      state->AddCpu(cpu_start_ns);
       state->step_ = ISSUED;
       err = TRITONSERVER_ServerInferAsync(
           tritonserver_.get(), irequest, triton_trace);
@@ -345,14 +373,25 @@ ModelStreamInferHandler::Process(InferHandler::State* state, bool rpc_ok)
       GrpcStatusUtil::Create(&status, err);
       TRITONSERVER_ErrorDelete(err);
       response->set_error_message(status.error_message());
+#ifdef TRITON_ENABLE_TRACING
+      if (state->trace_ != nullptr) {
+        state->trace_->MarkFailed();
+      }
+#endif  // TRITON_ENABLE_TRACING
 
       response->mutable_infer_response()->Clear();
       // repopulate the id so that client knows which request failed.
       response->mutable_infer_response()->set_id(request.id());
       state->step_ = Steps::WRITEREADY;
       if (!state->is_decoupled_) {
+        if (state->transport_metrics_ != nullptr) {
+          state->write_ready_ns_ = TransportMethodMetrics::Now();
+        }
         state->context_->WriteResponseIfReady(state);
       } else {
+        if (state->context_->HasBufferBudget()) {
+          state->context_->BufferResponse(response->ByteSizeLong());
+        }
         state->response_queue_->MarkNextResponseComplete();
         state->complete_ = true;
         state->context_->PutTaskBackToQueue(state);
@@ -370,12 +409,21 @@ ModelStreamInferHandler::Process(InferHandler::State* state, bool rpc_ok)
     // next request to read.
     // Can't create trace as we don't know the model to be requested,
     // track timestamps in 'state'
-    next_read_state->trace_timestamps_.emplace_back(std::make_pair(
-        "GRPC_WAITREAD_START", TraceManager::CaptureTimestamp()));
+    next_read_state->trace_timestamps_.Capture(
+        FrontendStage::GRPC_WAITREAD_START, TraceManager::CaptureTimestamp());
 #endif  // TRITON_ENABLE_TRACING
 
-    next_read_state->context_->responder_->Read(
-        &next_read_state->request_, next_read_state);
+    // Stop reading requests from the stream while it buffers more
+    // responses than its budget allows, the read is issued once
+    // enough responses are written.
+    if (next_read_state->context_->PauseReadIfOverBudget(next_read_state)) {
+      LOG_VERBOSE(1) << "Pausing reads for " << Name() << ", context "
+                     << next_read_state->context_->unique_id_
+                     << ", response buffer budget exceeded";
+    } else {
+      next_read_state->context_->responder_->Read(
+          next_read_state->request_, next_read_state);
+    }
   } else if (state->step_ == Steps::PARTIAL_COMPLETION) {
     state->step_ = Steps::COMPLETE;
   } else if (state->step_ == Steps::COMPLETE) {
@@ -400,8 +448,8 @@ ModelStreamInferHandler::Process(InferHandler::State* state, bool rpc_ok)
     if (state->step_ == Steps::WRITTEN) {
       state->context_->ongoing_write_ = false;
 #ifdef TRITON_ENABLE_TRACING
-      state->trace_timestamps_.emplace_back(
-          std::make_pair("GRPC_SEND_END", TraceManager::CaptureTimestamp()));
+      state->trace_timestamps_.Capture(
+          FrontendStage::GRPC_SEND_END, TraceManager::CaptureTimestamp());
 #endif  // TRITON_ENABLE_TRACING
 
       // If the write failed (for example, client closed the stream)
@@ -414,6 +462,9 @@ ModelStreamInferHandler::Process(InferHandler::State* state, bool rpc_ok)
                        << state->unique_id_ << " step " << state->step_
                        << ", failed";
         state->context_->finish_ok_ = false;
+        state->alloc_payload_.pool_allocations_.Release();
+      } else {
+        state->alloc_payload_.pool_allocations_.Deliver();
       }
 
       // Log an error if 'state' is not the expected next response. Mark
@@ -433,6 +484,7 @@ ModelStreamInferHandler::Process(InferHandler::State* state, bool rpc_ok)
 
       // The response for the request has been written completely.
       // The counter can be safely decremented.
+      state->ObserveStages();
       state->context_->DecrementRequestCounter();
       finished = Finish(state);
     }
@@ -443,8 +495,8 @@ ModelStreamInferHandler::Process(InferHandler::State* state, bool rpc_ok)
     if (state->step_ == Steps::WRITTEN) {
       state->context_->ongoing_write_ = false;
 #ifdef TRITON_ENABLE_TRACING
-      state->trace_timestamps_.emplace_back(
-          std::make_pair("GRPC_SEND_END", TraceManager::CaptureTimestamp()));
+      state->trace_timestamps_.Capture(
+          FrontendStage::GRPC_SEND_END, TraceManager::CaptureTimestamp());
 #endif  // TRITON_ENABLE_TRACING
 
       // If the write failed (for example, client closed the stream)
@@ -457,11 +509,28 @@ ModelStreamInferHandler::Process(InferHandler::State* state, bool rpc_ok)
                        << state->unique_id_ << " step " << state->step_
                        << ", failed";
         state->context_->finish_ok_ = false;
+        state->alloc_payload_.pool_allocations_.Release();
+      } else {
+        // The responses are written in order, all the popped ones are
+        // delivered.
+        state->alloc_payload_.pool_allocations_.Deliver(
+            state->response_queue_->PoppedResponseCount());
+      }
+
+      // Resume reading requests from the stream if the reads were
+      // paused and the buffered responses are back within the budget.
+      State* read_state = state->context_->ResumeRead();
+      if (read_state != nullptr) {
+        LOG_VERBOSE(1) << "Resuming reads for " << Name() << ", context "
+                       << read_state->context_->unique_id_;
+        read_state->context_->responder_->Read(
+            read_state->request_, read_state);
       }
 
       // Finish the state if all the transactions associated with
       // the state have completed.
       if (state->IsComplete()) {
+        state->ObserveStages();
         state->context_->DecrementRequestCounter();
         finished = Finish(state);
       } else {
@@ -493,6 +562,7 @@ ModelStreamInferHandler::Process(InferHandler::State* state, bool rpc_ok)
       // Finish the state if all the transactions associated with
       // the state have completed.
       if (state->IsComplete()) {
+        state->ObserveStages();
         state->context_->DecrementRequestCounter();
         finished = Finish(state);
       } else {
@@ -502,8 +572,7 @@ ModelStreamInferHandler::Process(InferHandler::State* state, bool rpc_ok)
         // defer writing and place the task at the back
         // of the completion queue to be taken up later.
         if (!state->context_->ongoing_write_) {
-          state->context_->ongoing_write_ = true;
-          state->context_->DecoupledWriteResponse(state);
+          WriteDecoupledResponse(state);
         } else {
           state->context_->PutTaskBackToQueue(state);
         }
@@ -514,6 +583,50 @@ ModelStreamInferHandler::Process(InferHandler::State* state, bool rpc_ok)
   return !finished;
 }
 
+void
+ModelStreamInferHandler::WriteDecoupledResponse(InferHandler::State* state)
+{
+  ::grpc::WriteOptions options;
+  if (write_coalescing_) {
+    // A lone response of an incomplete request is held back once, for
+    // at most 'write_coalescing_delay_us_', so that responses produced
+    // in the meantime can share the same transport write. The state
+    // stays in WRITEREADY so that response callbacks don't requeue it.
+    const uint32_t ready_count =
+        state->response_queue_->ReadyResponseCount();
+    if ((ready_count == 1) && (write_coalescing_delay_us_ > 0) &&
+        !state->write_deferred_) {
+      std::lock_guard<std::recursive_mutex> lock(state->step_mtx_);
+      if (!state->complete_) {
+        state->write_deferred_ = true;
+        state->context_->PutTaskBackToQueueAfter(
+            state, write_coalescing_delay_us_);
+        return;
+      }
+    }
+
+    // Hint the transport to buffer the write while more responses are
+    // queued behind it. The last ready response is written without
+    // the hint which flushes everything buffered so far. The state
+    // always returns to WRITEREADY after a hinted write because the
+    // queue is not empty, so a buffered response is never left
+    // unflushed.
+    if (ready_count > 1) {
+      options.set_buffer_hint();
+    }
+    state->write_deferred_ = false;
+  }
+
+  // The response leaves the stream's buffer once handed to gRPC.
+  if (state->context_->HasBufferBudget()) {
+    state->context_->UnbufferResponse(
+        state->response_queue_->GetCurrentResponse()->ByteSizeLong());
+  }
+
+  state->context_->ongoing_write_ = true;
+  state->context_->DecoupledWriteResponse(state, options);
+}
+
 bool
 ModelStreamInferHandler::Finish(InferHandler::State* state)
 {
@@ -547,6 +660,7 @@ ModelStreamInferHandler::StreamInferResponseComplete(
     void* userp)
 {
   State* state = reinterpret_cast<State*>(userp);
+  const uint64_t cpu_start_ns = state->CpuStart();
 
   // Increment the callback index
   uint32_t response_index = state->cb_count_++;
@@ -558,8 +672,9 @@ ModelStreamInferHandler::StreamInferResponseComplete(
 
 #ifdef TRITON_ENABLE_TRACING
   if (state->cb_count_ == 1) {
-    state->trace_timestamps_.emplace_back(std::make_pair(
-        "INFER_RESPONSE_COMPLETE", TraceManager::CaptureTimestamp()));
+    state->trace_timestamps_.Capture(
+        FrontendStage::INFER_RESPONSE_COMPLETE,
+        TraceManager::CaptureTimestamp());
   }
 #endif  // TRITON_ENABLE_TRACING
 
@@ -609,7 +724,7 @@ ModelStreamInferHandler::StreamInferResponseComplete(
   }
 
   auto& response_queue = state->response_queue_;
-  std::string log_request_id = state->request_.id();
+  std::string log_request_id = state->request_->id();
   if (log_request_id.empty()) {
     log_request_id = "<id_unknown>";
   }
@@ -623,10 +738,34 @@ ModelStreamInferHandler::StreamInferResponseComplete(
     if (response) {
       inference::ModelInferResponse& infer_response =
           *(response->mutable_infer_response());
+      const uint64_t serialize_start_ns =
+          (state->transport_metrics_ != nullptr)
+              ? TransportMethodMetrics::Now()
+              : 0;
+#ifdef TRITON_ENABLE_TRACING
+      // Only the serialization of the first response is traced, the same
+      // as its completion.
+      if (state->cb_count_ == 1) {
+        state->trace_timestamps_.Capture(
+            FrontendStage::OUTPUT_SERIALIZE_START,
+            TraceManager::CaptureTimestamp());
+      }
+#endif  // TRITON_ENABLE_TRACING
       // Validate Triton iresponse and set grpc/protobuf response fields from it
       err = InferResponseCompleteCommon<inference::ModelStreamInferResponse>(
           state->tritonserver_, iresponse, infer_response,
           state->alloc_payload_);
+#ifdef TRITON_ENABLE_TRACING
+      if (state->cb_count_ == 1) {
+        state->trace_timestamps_.Capture(
+            FrontendStage::OUTPUT_SERIALIZE_END,
+            TraceManager::CaptureTimestamp());
+      }
+#endif  // TRITON_ENABLE_TRACING
+      if (serialize_start_ns != 0) {
+        state->transport_metrics_->ObserveStage(
+            TransportStage::SERIALIZE, serialize_start_ns);
+      }
     } else {
       LOG_ERROR << "expected the response allocator to have added the response";
     }
@@ -636,8 +775,14 @@ ModelStreamInferHandler::StreamInferResponseComplete(
       ::grpc::Status status;
       GrpcStatusUtil::Create(&status, err);
       response->mutable_infer_response()->Clear();
+      state->alloc_payload_.pool_allocations_.ReleaseResponse(response_index);
       response->set_error_message(status.error_message());
       LOG_VERBOSE(1) << "Failed for ID: " << log_request_id << std::endl;
+#ifdef TRITON_ENABLE_TRACING
+      if (state->trace_ != nullptr) {
+        state->trace_->MarkFailed();
+      }
+#endif  // TRITON_ENABLE_TRACING
     }
 
     TRITONSERVER_ErrorDelete(err);
@@ -675,9 +820,9 @@ ModelStreamInferHandler::StreamInferResponseComplete(
     // Set response metadata to associate it with request. These will be set
     // by InferResponseCompleteCommon for successful inference.
     if (create_empty_response || failed) {
-      infer_response.set_id(state->request_.id());
-      infer_response.set_model_name(state->request_.model_name());
-      infer_response.set_model_version(state->request_.model_version());
+      infer_response.set_id(state->request_->id());
+      infer_response.set_model_name(state->request_->model_name());
+      infer_response.set_model_version(state->request_->model_version());
     }
     auto& params = *(infer_response.mutable_parameters());
     params["triton_final_response"].set_bool_param(state->complete_);
@@ -706,8 +851,12 @@ ModelStreamInferHandler::StreamInferResponseComplete(
       return;
     }
 
+    state->AddCpu(cpu_start_ns);
     if (state->is_decoupled_) {
       if (response) {
+        if (state->context_->HasBufferBudget()) {
+          state->context_->BufferResponse(response->ByteSizeLong());
+        }
         state->response_queue_->MarkNextResponseComplete();
       }
       if (state->step_ == Steps::ISSUED) {
@@ -715,6 +864,9 @@ ModelStreamInferHandler::StreamInferResponseComplete(
         state->context_->PutTaskBackToQueue(state);
       }
     } else {
+      if (state->transport_metrics_ != nullptr) {
+        state->write_ready_ns_ = TransportMethodMetrics::Now();
+      }
       state->step_ = Steps::WRITEREADY;
       state->context_->WriteResponseIfReady(state);
     }
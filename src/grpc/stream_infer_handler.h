@@ -73,13 +73,23 @@ class ModelStreamInferHandler
       ::grpc::ServerCompletionQueue* cq, size_t max_state_bucket_count,
       grpc_compression_level compression_level,
       std::pair<std::string, std::string> restricted_kv,
-      const std::string& header_forward_pattern)
+      const std::string& header_forward_pattern,
+      bool write_coalescing = false, int write_coalescing_delay_us = 0,
+      size_t response_buffer_bytes = 0, uint32_t response_buffer_count = 0)
       : InferHandler(
             name, tritonserver, service, cq, max_state_bucket_count,
             restricted_kv, header_forward_pattern),
         trace_manager_(trace_manager), shm_manager_(shm_manager),
-        compression_level_(compression_level)
+        compression_level_(compression_level),
+        write_coalescing_(write_coalescing),
+        write_coalescing_delay_us_(write_coalescing_delay_us)
   {
+    // The buffered responses are only accounted when they are limited.
+    if ((response_buffer_bytes != 0) || (response_buffer_count != 0)) {
+      buffer_budget_.reset(new ResponseBufferBudget(
+          "grpc", response_buffer_bytes, response_buffer_count));
+    }
+
     // Create the allocator that will be used to allocate buffers for
     // the result tensors.
     FAIL_IF_ERR(
@@ -113,12 +123,24 @@ class ModelStreamInferHandler
       TRITONSERVER_InferenceResponse* response, const uint32_t flags,
       void* userp);
   bool Finish(State* state);
+  void WriteDecoupledResponse(State* state);
 
   TraceManager* trace_manager_;
   std::shared_ptr<SharedMemoryManager> shm_manager_;
   TRITONSERVER_ResponseAllocator* allocator_;
 
   grpc_compression_level compression_level_;
+
+  // Whether decoupled responses that are ready together are
+  // coalesced into a single transport write, and how long a lone
+  // response may be held back waiting for more responses.
+  const bool write_coalescing_;
+  const int write_coalescing_delay_us_;
+
+  // Bounds the decoupled responses each stream buffers while the
+  // client is reading slower than the model produces. Shared with
+  // the stream contexts which may outlive the handler.
+  std::shared_ptr<ResponseBufferBudget> buffer_budget_;
 };
 
 }}}  // namespace triton::server::grpc
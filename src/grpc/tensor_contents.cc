@@ -0,0 +1,298 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "tensor_contents.h"
+
+#include <cstring>
+#include <type_traits>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define TRITON_CONTENTS_AVX2 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define TRITON_CONTENTS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace triton { namespace server { namespace grpc {
+
+namespace {
+
+// The kernels below operate on the bit pattern of the elements so that
+// the same code serves signed and unsigned types. An element 'v' is
+// representable in the destination type iff '(v + bias) & mask' is zero
+// in 32-bit unsigned arithmetic, where 'bias' moves the smallest
+// representable value of a signed destination type to zero. The check
+// is accumulated with a bitwise OR and only inspected once per call so
+// it stays off the critical path of the conversion.
+template <typename DstType>
+struct NarrowRange {
+  static constexpr uint32_t kBias =
+      std::is_signed<DstType>::value ? (1u << (sizeof(DstType) * 8 - 1)) : 0;
+  static constexpr uint32_t kMask = ~((1u << (sizeof(DstType) * 8)) - 1);
+};
+
+template <typename DstType>
+uint32_t
+NarrowScalar(const uint32_t* src, size_t count, DstType* dst)
+{
+  uint32_t out_of_range = 0;
+  for (size_t i = 0; i < count; ++i) {
+    out_of_range |= (src[i] + NarrowRange<DstType>::kBias) &
+                    NarrowRange<DstType>::kMask;
+    dst[i] = static_cast<DstType>(src[i]);
+  }
+  return out_of_range;
+}
+
+#ifdef TRITON_CONTENTS_AVX2
+bool
+HasAvx2()
+{
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  return has_avx2;
+}
+
+// AVX2 packs saturate, which is exact for the in-range elements, so the
+// signedness of the destination selects the pack instruction. The packs
+// operate within 128-bit lanes and a final permute restores the element
+// order. Returns the number of elements converted, the remainder is left
+// to the scalar loop.
+template <bool kSigned>
+__attribute__((target("avx2"))) size_t
+Narrow32To16Avx2(
+    const uint32_t* src, size_t count, uint16_t* dst, uint32_t* out_of_range)
+{
+  const __m256i bias = _mm256_set1_epi32(kSigned ? 0x8000 : 0);
+  const __m256i mask = _mm256_set1_epi32(0xFFFF0000);
+  __m256i acc = _mm256_setzero_si256();
+  const __m256i* in = reinterpret_cast<const __m256i*>(src);
+  __m256i* out = reinterpret_cast<__m256i*>(dst);
+  const size_t blocks = count / 16;
+  for (size_t i = 0; i < blocks; ++i) {
+    const __m256i a = _mm256_loadu_si256(in + 2 * i);
+    const __m256i b = _mm256_loadu_si256(in + 2 * i + 1);
+    acc = _mm256_or_si256(
+        acc, _mm256_and_si256(_mm256_add_epi32(a, bias), mask));
+    acc = _mm256_or_si256(
+        acc, _mm256_and_si256(_mm256_add_epi32(b, bias), mask));
+    const __m256i packed =
+        kSigned ? _mm256_packs_epi32(a, b) : _mm256_packus_epi32(a, b);
+    _mm256_storeu_si256(out + i, _mm256_permute4x64_epi64(packed, 0xD8));
+  }
+  *out_of_range |= !_mm256_testz_si256(acc, acc);
+  return blocks * 16;
+}
+
+template <bool kSigned>
+__attribute__((target("avx2"))) size_t
+Narrow32To8Avx2(
+    const uint32_t* src, size_t count, uint8_t* dst, uint32_t* out_of_range)
+{
+  const __m256i bias = _mm256_set1_epi32(kSigned ? 0x80 : 0);
+  const __m256i mask = _mm256_set1_epi32(0xFFFFFF00);
+  const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  __m256i acc = _mm256_setzero_si256();
+  const __m256i* in = reinterpret_cast<const __m256i*>(src);
+  __m256i* out = reinterpret_cast<__m256i*>(dst);
+  const size_t blocks = count / 32;
+  for (size_t i = 0; i < blocks; ++i) {
+    const __m256i a = _mm256_loadu_si256(in + 4 * i);
+    const __m256i b = _mm256_loadu_si256(in + 4 * i + 1);
+    const __m256i c = _mm256_loadu_si256(in + 4 * i + 2);
+    const __m256i d = _mm256_loadu_si256(in + 4 * i + 3);
+    acc = _mm256_or_si256(
+        acc, _mm256_and_si256(_mm256_add_epi32(a, bias), mask));
+    acc = _mm256_or_si256(
+        acc, _mm256_and_si256(_mm256_add_epi32(b, bias), mask));
+    acc = _mm256_or_si256(
+        acc, _mm256_and_si256(_mm256_add_epi32(c, bias), mask));
+    acc = _mm256_or_si256(
+        acc, _mm256_and_si256(_mm256_add_epi32(d, bias), mask));
+    __m256i packed;
+    if (kSigned) {
+      packed = _mm256_packs_epi16(
+          _mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+    } else {
+      packed = _mm256_packus_epi16(
+          _mm256_packus_epi32(a, b), _mm256_packus_epi32(c, d));
+    }
+    _mm256_storeu_si256(out + i, _mm256_permutevar8x32_epi32(packed, order));
+  }
+  *out_of_range |= !_mm256_testz_si256(acc, acc);
+  return blocks * 32;
+}
+#endif  // TRITON_CONTENTS_AVX2
+
+#ifdef TRITON_CONTENTS_NEON
+// NEON narrowing moves truncate, so the same kernel serves signed and
+// unsigned destinations. Returns the number of elements converted, the
+// remainder is left to the scalar loop.
+size_t
+Narrow32To16Neon(
+    const uint32_t* src, size_t count, uint16_t* dst, uint32_t bias,
+    uint32_t* out_of_range)
+{
+  const uint32x4_t vbias = vdupq_n_u32(bias);
+  const uint32x4_t mask = vdupq_n_u32(0xFFFF0000);
+  uint32x4_t acc = vdupq_n_u32(0);
+  const size_t blocks = count / 8;
+  for (size_t i = 0; i < blocks; ++i) {
+    const uint32x4_t a = vld1q_u32(src + 8 * i);
+    const uint32x4_t b = vld1q_u32(src + 8 * i + 4);
+    acc = vorrq_u32(acc, vandq_u32(vaddq_u32(a, vbias), mask));
+    acc = vorrq_u32(acc, vandq_u32(vaddq_u32(b, vbias), mask));
+    vst1q_u16(dst + 8 * i, vcombine_u16(vmovn_u32(a), vmovn_u32(b)));
+  }
+  *out_of_range |= vmaxvq_u32(acc);
+  return blocks * 8;
+}
+
+size_t
+Narrow32To8Neon(
+    const uint32_t* src, size_t count, uint8_t* dst, uint32_t bias,
+    uint32_t* out_of_range)
+{
+  const uint32x4_t vbias = vdupq_n_u32(bias);
+  const uint32x4_t mask = vdupq_n_u32(0xFFFFFF00);
+  uint32x4_t acc = vdupq_n_u32(0);
+  const size_t blocks = count / 16;
+  for (size_t i = 0; i < blocks; ++i) {
+    const uint32x4_t a = vld1q_u32(src + 16 * i);
+    const uint32x4_t b = vld1q_u32(src + 16 * i + 4);
+    const uint32x4_t c = vld1q_u32(src + 16 * i + 8);
+    const uint32x4_t d = vld1q_u32(src + 16 * i + 12);
+    acc = vorrq_u32(acc, vandq_u32(vaddq_u32(a, vbias), mask));
+    acc = vorrq_u32(acc, vandq_u32(vaddq_u32(b, vbias), mask));
+    acc = vorrq_u32(acc, vandq_u32(vaddq_u32(c, vbias), mask));
+    acc = vorrq_u32(acc, vandq_u32(vaddq_u32(d, vbias), mask));
+    const uint16x8_t ab = vcombine_u16(vmovn_u32(a), vmovn_u32(b));
+    const uint16x8_t cd = vcombine_u16(vmovn_u32(c), vmovn_u32(d));
+    vst1q_u8(dst + 16 * i, vcombine_u8(vmovn_u16(ab), vmovn_u16(cd)));
+  }
+  *out_of_range |= vmaxvq_u32(acc);
+  return blocks * 16;
+}
+#endif  // TRITON_CONTENTS_NEON
+
+// Converts as many elements as possible with the vector kernel
+// available on this platform and returns the number converted.
+template <typename DstType>
+size_t
+NarrowVector(
+    const uint32_t* src, size_t count, DstType* dst, uint32_t* out_of_range)
+{
+  constexpr bool kSigned = std::is_signed<DstType>::value;
+#if defined(TRITON_CONTENTS_AVX2)
+  if (HasAvx2()) {
+    if (sizeof(DstType) == 1) {
+      return Narrow32To8Avx2<kSigned>(
+          src, count, reinterpret_cast<uint8_t*>(dst), out_of_range);
+    } else {
+      return Narrow32To16Avx2<kSigned>(
+          src, count, reinterpret_cast<uint16_t*>(dst), out_of_range);
+    }
+  }
+#elif defined(TRITON_CONTENTS_NEON)
+  if (sizeof(DstType) == 1) {
+    return Narrow32To8Neon(
+        src, count, reinterpret_cast<uint8_t*>(dst),
+        NarrowRange<DstType>::kBias, out_of_range);
+  } else {
+    return Narrow32To16Neon(
+        src, count, reinterpret_cast<uint16_t*>(dst),
+        NarrowRange<DstType>::kBias, out_of_range);
+  }
+#endif
+  return 0;
+}
+
+template <typename SrcType, typename DstType>
+bool
+Narrow(const SrcType* src, size_t count, DstType* dst)
+{
+  static_assert(sizeof(SrcType) == sizeof(uint32_t), "expect 32-bit source");
+  const uint32_t* usrc = reinterpret_cast<const uint32_t*>(src);
+  uint32_t out_of_range = 0;
+  const size_t converted = NarrowVector(usrc, count, dst, &out_of_range);
+  out_of_range |=
+      NarrowScalar(usrc + converted, count - converted, dst + converted);
+  return (out_of_range == 0);
+}
+
+}  // namespace
+
+bool
+NarrowInt32ToInt8(const int32_t* src, size_t count, int8_t* dst)
+{
+  return Narrow(src, count, dst);
+}
+
+bool
+NarrowInt32ToInt16(const int32_t* src, size_t count, int16_t* dst)
+{
+  return Narrow(src, count, dst);
+}
+
+bool
+NarrowUint32ToUint8(const uint32_t* src, size_t count, uint8_t* dst)
+{
+  return Narrow(src, count, dst);
+}
+
+bool
+NarrowUint32ToUint16(const uint32_t* src, size_t count, uint16_t* dst)
+{
+  return Narrow(src, count, dst);
+}
+
+size_t
+SerializedBytesContentsByteSize(
+    const google::protobuf::RepeatedPtrField<std::string>& contents)
+{
+  size_t byte_size = contents.size() * sizeof(uint32_t);
+  for (const auto& element : contents) {
+    byte_size += element.size();
+  }
+  return byte_size;
+}
+
+void
+SerializeBytesContents(
+    const google::protobuf::RepeatedPtrField<std::string>& contents,
+    char* dst)
+{
+  for (const auto& element : contents) {
+    const uint32_t len = element.size();
+    std::memcpy(dst, &len, sizeof(uint32_t));
+    dst += sizeof(uint32_t);
+    if (len > 0) {
+      std::memcpy(dst, element.data(), len);
+      dst += len;
+    }
+  }
+}
+
+}}}  // namespace triton::server::grpc
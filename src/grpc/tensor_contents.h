@@ -0,0 +1,64 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <google/protobuf/repeated_field.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace triton { namespace server { namespace grpc {
+
+//
+// Conversion of the typed 'contents' of an inference input into the
+// tensor layout expected by Triton.
+//
+// The narrowing functions convert 'count' 32-bit elements in 'src' into
+// 'dst', which must hold at least 'count' destination elements. The
+// conversion uses AVX2 or NEON when available and falls back to scalar
+// code otherwise. The functions return false if any element is not
+// representable in the destination type, in which case the content of
+// 'dst' is unspecified.
+//
+bool NarrowInt32ToInt8(const int32_t* src, size_t count, int8_t* dst);
+bool NarrowInt32ToInt16(const int32_t* src, size_t count, int16_t* dst);
+bool NarrowUint32ToUint8(const uint32_t* src, size_t count, uint8_t* dst);
+bool NarrowUint32ToUint16(const uint32_t* src, size_t count, uint16_t* dst);
+
+// Returns the byte size of 'contents' when serialized as a Triton BYTES
+// tensor, that is each element as a 4-byte length followed by the
+// element itself with no null-terminator.
+size_t SerializedBytesContentsByteSize(
+    const google::protobuf::RepeatedPtrField<std::string>& contents);
+
+// Serializes 'contents' as a Triton BYTES tensor into 'dst', which must
+// hold at least SerializedBytesContentsByteSize(contents) bytes.
+void SerializeBytesContents(
+    const google::protobuf::RepeatedPtrField<std::string>& contents,
+    char* dst);
+
+}}}  // namespace triton::server::grpc
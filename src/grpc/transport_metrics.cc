@@ -0,0 +1,275 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "transport_metrics.h"
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message_lite.h>
+
+#include <algorithm>
+
+namespace triton { namespace server { namespace grpc {
+
+namespace {
+
+// Upper bounds, in microseconds, of the buckets of the stage durations.
+const std::vector<uint64_t> kStageBucketBoundsUs{
+    50, 100, 250, 500, 1000, 5000, 10000, 100000};
+
+const char*
+StageName(const TransportStage stage)
+{
+  switch (stage) {
+    case TransportStage::QUEUE:
+      return "queue";
+    case TransportStage::PARSE:
+      return "parse";
+    case TransportStage::SERIALIZE:
+      return "serialize";
+    case TransportStage::WRITE_WAIT:
+      return "write_wait";
+    default:
+      return "<invalid>";
+  }
+}
+
+}  // namespace
+
+//
+// TransportMethodMetrics
+//
+void
+TransportMethodMetrics::RpcStarted(const bool streaming)
+{
+  started_rpcs_->Increment(1);
+  inflight_rpcs_->Increment(1);
+  if (streaming) {
+    started_streams_->Increment(1);
+    active_streams_->Increment(1);
+  }
+}
+
+void
+TransportMethodMetrics::RpcDone(const bool streaming)
+{
+  inflight_rpcs_->Increment(-1);
+  if (streaming) {
+    active_streams_->Increment(-1);
+  }
+}
+
+void
+TransportMethodMetrics::MessageReceived(const size_t byte_size)
+{
+  received_messages_->Increment(1);
+  received_bytes_->Increment(byte_size);
+}
+
+void
+TransportMethodMetrics::MessageSent(const size_t byte_size)
+{
+  sent_messages_->Increment(1);
+  sent_bytes_->Increment(byte_size);
+}
+
+void
+TransportMethodMetrics::ObserveStage(
+    const TransportStage stage, const uint64_t start_ns)
+{
+  if (stages_.empty()) {
+    return;
+  }
+  const uint64_t now_ns = Now();
+  const uint64_t duration_ns = (now_ns > start_ns) ? (now_ns - start_ns) : 0;
+  stages_[static_cast<size_t>(stage)]->Observe(duration_ns / 1000);
+}
+
+//
+// TransportMetrics
+//
+TransportMetrics::TransportMetrics(
+    const std::vector<std::string>& services,
+    const std::vector<std::string>& staged_methods)
+    : started_rpcs_family_(
+          TRITONSERVER_METRIC_KIND_COUNTER, "nv_grpc_server_started_rpcs",
+          "Number of GRPC calls started"),
+      inflight_rpcs_family_(
+          TRITONSERVER_METRIC_KIND_GAUGE, "nv_grpc_server_inflight_rpcs",
+          "Number of GRPC calls in progress"),
+      started_streams_family_(
+          TRITONSERVER_METRIC_KIND_COUNTER, "nv_grpc_server_started_streams",
+          "Number of streaming GRPC calls started"),
+      active_streams_family_(
+          TRITONSERVER_METRIC_KIND_GAUGE, "nv_grpc_server_active_streams",
+          "Number of streaming GRPC calls in progress"),
+      received_messages_family_(
+          TRITONSERVER_METRIC_KIND_COUNTER,
+          "nv_grpc_server_received_messages",
+          "Number of GRPC messages received"),
+      received_bytes_family_(
+          TRITONSERVER_METRIC_KIND_COUNTER, "nv_grpc_server_received_bytes",
+          "Serialized size in bytes of the GRPC messages received"),
+      sent_messages_family_(
+          TRITONSERVER_METRIC_KIND_COUNTER, "nv_grpc_server_sent_messages",
+          "Number of GRPC messages sent"),
+      sent_bytes_family_(
+          TRITONSERVER_METRIC_KIND_COUNTER, "nv_grpc_server_sent_bytes",
+          "Serialized size in bytes of the GRPC messages sent"),
+      stage_bucket_family_(
+          TRITONSERVER_METRIC_KIND_COUNTER,
+          "nv_grpc_server_stage_duration_us_bucket",
+          "Cumulative count of GRPC inference stages that took at most "
+          "'le' microseconds"),
+      stage_sum_family_(
+          TRITONSERVER_METRIC_KIND_COUNTER,
+          "nv_grpc_server_stage_duration_us_sum",
+          "Cumulative duration in microseconds of GRPC inference stages"),
+      stage_count_family_(
+          TRITONSERVER_METRIC_KIND_COUNTER,
+          "nv_grpc_server_stage_duration_us_count",
+          "Number of GRPC inference stages observed")
+{
+  const google::protobuf::DescriptorPool* pool =
+      google::protobuf::DescriptorPool::generated_pool();
+  for (const auto& service_name : services) {
+    const google::protobuf::ServiceDescriptor* service =
+        pool->FindServiceByName(service_name);
+    if (service == nullptr) {
+      LOG_ERROR << "unable to find GRPC service '" << service_name
+                << "', its transport metrics are not reported";
+      continue;
+    }
+    for (int i = 0; i < service->method_count(); ++i) {
+      const std::string method =
+          "/" + service_name + "/" + service->method(i)->name();
+      const std::vector<std::pair<std::string, std::string>> labels{
+          {"method", method}};
+
+      std::unique_ptr<TransportMethodMetrics> metrics(
+          new TransportMethodMetrics());
+      metrics->started_rpcs_.reset(
+          new FrontendMetric(started_rpcs_family_, labels));
+      metrics->inflight_rpcs_.reset(
+          new FrontendMetric(inflight_rpcs_family_, labels));
+      metrics->started_streams_.reset(
+          new FrontendMetric(started_streams_family_, labels));
+      metrics->active_streams_.reset(
+          new FrontendMetric(active_streams_family_, labels));
+      metrics->received_messages_.reset(
+          new FrontendMetric(received_messages_family_, labels));
+      metrics->received_bytes_.reset(
+          new FrontendMetric(received_bytes_family_, labels));
+      metrics->sent_messages_.reset(
+          new FrontendMetric(sent_messages_family_, labels));
+      metrics->sent_bytes_.reset(
+          new FrontendMetric(sent_bytes_family_, labels));
+
+      if (std::find(staged_methods.begin(), staged_methods.end(), method) !=
+          staged_methods.end()) {
+        if (publisher_ == nullptr) {
+          publisher_.reset(new FrontendHistogramPublisher());
+        }
+        for (size_t s = 0; s < static_cast<size_t>(TransportStage::COUNT);
+             ++s) {
+          auto stage_labels = labels;
+          stage_labels.emplace_back(
+              "stage", StageName(static_cast<TransportStage>(s)));
+          metrics->stages_.emplace_back(std::make_shared<FrontendHistogram>(
+              stage_bucket_family_, stage_sum_family_, stage_count_family_,
+              stage_labels, kStageBucketBoundsUs));
+          publisher_->Add(metrics->stages_.back());
+        }
+      }
+
+      methods_.emplace(method, std::move(metrics));
+    }
+  }
+}
+
+TransportMethodMetrics*
+TransportMetrics::Method(const std::string& method) const
+{
+  const auto it = methods_.find(method);
+  return (it == methods_.end()) ? nullptr : it->second.get();
+}
+
+//
+// TransportMetricsInterceptor
+//
+TransportMetricsInterceptor::TransportMetricsInterceptor(
+    TransportMethodMetrics* metrics, const bool streaming)
+    : metrics_(metrics), streaming_(streaming)
+{
+  metrics_->RpcStarted(streaming_);
+}
+
+TransportMetricsInterceptor::~TransportMetricsInterceptor()
+{
+  metrics_->RpcDone(streaming_);
+}
+
+void
+TransportMetricsInterceptor::Intercept(
+    ::grpc::experimental::InterceptorBatchMethods* methods)
+{
+  if (methods->QueryInterceptionHookPoint(
+          ::grpc::experimental::InterceptionHookPoints::POST_RECV_MESSAGE)) {
+    // The received message is already parsed, all the messages of the
+    // services are protobuf messages so its size is the size it had on
+    // the wire, before any compression.
+    const auto message = static_cast<const google::protobuf::MessageLite*>(
+        methods->GetRecvMessage());
+    if (message != nullptr) {
+      metrics_->MessageReceived(message->ByteSizeLong());
+    }
+  }
+  if (methods->QueryInterceptionHookPoint(
+          ::grpc::experimental::InterceptionHookPoints::PRE_SEND_MESSAGE)) {
+    const ::grpc::ByteBuffer* buffer = methods->GetSerializedSendMessage();
+    if (buffer != nullptr) {
+      metrics_->MessageSent(buffer->Length());
+    }
+  }
+  methods->Proceed();
+}
+
+//
+// TransportMetricsInterceptorFactory
+//
+::grpc::experimental::Interceptor*
+TransportMetricsInterceptorFactory::CreateServerInterceptor(
+    ::grpc::experimental::ServerRpcInfo* info)
+{
+  TransportMethodMetrics* metrics = metrics_->Method(info->method());
+  if (metrics == nullptr) {
+    return nullptr;
+  }
+  return new TransportMetricsInterceptor(
+      metrics,
+      info->type() != ::grpc::experimental::ServerRpcInfo::Type::UNARY);
+}
+
+}}}  // namespace triton::server::grpc
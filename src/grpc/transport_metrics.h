@@ -0,0 +1,169 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <grpcpp/support/server_interceptor.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../frontend_histogram.h"
+#include "../frontend_metrics.h"
+
+namespace triton { namespace server { namespace grpc {
+
+// The stages of an inference RPC whose duration is observed.
+enum class TransportStage {
+  // From a state being put back on the completion queue by a core
+  // thread to the handler thread processing it.
+  QUEUE,
+  // From the request being read to it being issued to the core.
+  PARSE,
+  // From the response being received from the core to it being handed
+  // to the transport.
+  SERIALIZE,
+  // From the response being ready to it being written, waiting behind
+  // the responses of earlier requests of the stream.
+  WRITE_WAIT,
+  COUNT
+};
+
+//
+// The transport metrics of a single gRPC method.
+//
+class TransportMethodMetrics {
+ public:
+  // Returns a timestamp in nanoseconds to pass to ObserveStage().
+  static uint64_t Now()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  void RpcStarted(const bool streaming);
+  void RpcDone(const bool streaming);
+  void MessageReceived(const size_t byte_size);
+  void MessageSent(const size_t byte_size);
+
+  // Observes the duration of 'stage' from 'start_ns' to now. No-op if
+  // the stages of the method are not observed.
+  void ObserveStage(const TransportStage stage, const uint64_t start_ns);
+
+ private:
+  friend class TransportMetrics;
+
+  std::unique_ptr<FrontendMetric> started_rpcs_;
+  std::unique_ptr<FrontendMetric> inflight_rpcs_;
+  std::unique_ptr<FrontendMetric> started_streams_;
+  std::unique_ptr<FrontendMetric> active_streams_;
+  std::unique_ptr<FrontendMetric> received_messages_;
+  std::unique_ptr<FrontendMetric> received_bytes_;
+  std::unique_ptr<FrontendMetric> sent_messages_;
+  std::unique_ptr<FrontendMetric> sent_bytes_;
+  // The histograms of the durations of the stages in microseconds.
+  // Empty if the stages of the method are not observed.
+  std::vector<std::shared_ptr<FrontendHistogram>> stages_;
+};
+
+//
+// The transport metrics of the methods of the GRPC endpoint, reported
+// next to the metrics of the core on the metrics endpoint. The set of
+// methods is fixed on construction so looking up a method is lock-free.
+//
+class TransportMetrics {
+ public:
+  // Creates the metrics of every method of 'services', given by their
+  // full protobuf names. The stages are only observed for the methods
+  // in 'staged_methods', given by their full gRPC names
+  // ("/<service>/<method>").
+  TransportMetrics(
+      const std::vector<std::string>& services,
+      const std::vector<std::string>& staged_methods);
+
+  // Returns the metrics of 'method', given by its full gRPC name, or
+  // nullptr if the method is unknown.
+  TransportMethodMetrics* Method(const std::string& method) const;
+
+ private:
+  FrontendMetricFamily started_rpcs_family_;
+  FrontendMetricFamily inflight_rpcs_family_;
+  FrontendMetricFamily started_streams_family_;
+  FrontendMetricFamily active_streams_family_;
+  FrontendMetricFamily received_messages_family_;
+  FrontendMetricFamily received_bytes_family_;
+  FrontendMetricFamily sent_messages_family_;
+  FrontendMetricFamily sent_bytes_family_;
+  FrontendMetricFamily stage_bucket_family_;
+  FrontendMetricFamily stage_sum_family_;
+  FrontendMetricFamily stage_count_family_;
+
+  std::unordered_map<std::string, std::unique_ptr<TransportMethodMetrics>>
+      methods_;
+
+  // Publishes the stage histograms, nullptr if no stage is observed.
+  std::unique_ptr<FrontendHistogramPublisher> publisher_;
+};
+
+//
+// Server interceptor counting the RPCs, messages and bytes of the
+// methods known to a TransportMetrics.
+//
+class TransportMetricsInterceptor : public ::grpc::experimental::Interceptor {
+ public:
+  TransportMetricsInterceptor(
+      TransportMethodMetrics* metrics, const bool streaming);
+  ~TransportMetricsInterceptor();
+
+  void Intercept(::grpc::experimental::InterceptorBatchMethods* methods)
+      override;
+
+ private:
+  TransportMethodMetrics* metrics_;
+  const bool streaming_;
+};
+
+class TransportMetricsInterceptorFactory
+    : public ::grpc::experimental::ServerInterceptorFactoryInterface {
+ public:
+  explicit TransportMetricsInterceptorFactory(
+      const std::shared_ptr<TransportMetrics>& metrics)
+      : metrics_(metrics)
+  {
+  }
+
+  ::grpc::experimental::Interceptor* CreateServerInterceptor(
+      ::grpc::experimental::ServerRpcInfo* info) override;
+
+ private:
+  std::shared_ptr<TransportMetrics> metrics_;
+};
+
+}}}  // namespace triton::server::grpc
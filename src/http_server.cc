@@ -31,11 +31,13 @@
 #include "http_server.h"
 
 #include <event2/buffer.h>
+#include <event2/bufferevent.h>
 #include <re2/re2.h>
 
 #include <algorithm>
 #include <list>
 #include <regex>
+#include <sstream>
 #include <thread>
 
 #include "classification.h"
@@ -67,7 +69,7 @@ namespace triton { namespace server {
     TRITONSERVER_Error* err__ = (X);                  \
     if (err__ != nullptr) {                           \
       EVBufferAddErrorJson((REQ)->buffer_out, err__); \
-      evhtp_send_reply((REQ), EVHTP_RES_BADREQ);      \
+      SendReply((REQ), EVHTP_RES_BADREQ);             \
       TRITONSERVER_ErrorDelete(err__);                \
       return;                                         \
     }                                                 \
@@ -76,11 +78,29 @@ namespace triton { namespace server {
 #define RETURN_AND_RESPOND_WITH_ERR(REQ, CODE, MSG) \
   do {                                              \
     EVBufferAddErrorJson((REQ)->buffer_out, MSG);   \
-    evhtp_send_reply((REQ), CODE);                  \
+    SendReply((REQ), CODE);                         \
     return;                                         \
   } while (false)
 
 namespace {
+
+// The reply code of the control-plane request being handled by the
+// current thread, see HTTPAPIServer::HandleControlPlane().
+thread_local evhtp_res* deferred_reply_code = nullptr;
+
+// Sends the reply of 'req', unless 'req' is handled by a control-plane
+// worker in which case the reply is sent later from the thread of the
+// connection.
+void
+SendReply(evhtp_request_t* req, evhtp_res code)
+{
+  if (deferred_reply_code != nullptr) {
+    *deferred_reply_code = code;
+    return;
+  }
+  evhtp_send_reply(req, code);
+}
+
 void
 EVBufferAddErrorJson(evbuffer* buffer, const char* message)
 {
@@ -94,6 +114,21 @@ EVBufferAddErrorJson(evbuffer* buffer, const char* message)
   evbuffer_add(buffer, buffer_json.Base(), buffer_json.Size());
 }
 
+// Adds the body of a successful shared memory register response, which
+// carries the handle that can be used in place of the region name.
+void
+EVBufferAddSharedMemoryHandleJson(evbuffer* buffer, const uint64_t handle)
+{
+  triton::common::TritonJson::Value response(
+      triton::common::TritonJson::ValueType::OBJECT);
+  response.AddUInt("handle", handle);
+
+  triton::common::TritonJson::WriteBuffer buffer_json;
+  response.Write(&buffer_json);
+
+  evbuffer_add(buffer, buffer_json.Base(), buffer_json.Size());
+}
+
 void
 EVBufferAddErrorJson(evbuffer* buffer, TRITONSERVER_Error* err)
 {
@@ -795,22 +830,37 @@ CheckBinaryOutputData(
 TRITONSERVER_Error*
 CheckSharedMemoryData(
     triton::common::TritonJson::Value& request_input, bool* use_shm,
-    const char** shm_region, uint64_t* offset, uint64_t* byte_size)
+    const char** shm_region, uint64_t* shm_handle, uint64_t* offset,
+    uint64_t* byte_size)
 {
   *use_shm = false;
+  *shm_region = "";
+  *shm_handle = 0;
   *offset = 0;
   *byte_size = 0;
 
   triton::common::TritonJson::Value params_json;
   if (request_input.Find("parameters", &params_json)) {
     {
+      // The region is given either by name or by the handle returned
+      // when it was registered.
       triton::common::TritonJson::Value region_json;
       if (params_json.Find("shared_memory_region", &region_json)) {
         *use_shm = true;
         size_t len;
-        RETURN_MSG_IF_ERR(
-            region_json.AsString(shm_region, &len),
-            "Unable to parse 'shared_memory_region'");
+        TRITONSERVER_Error* err = region_json.AsString(shm_region, &len);
+        if (err != nullptr) {
+          TRITONSERVER_ErrorDelete(err);
+          *shm_region = "";
+          RETURN_MSG_IF_ERR(
+              region_json.AsUInt(shm_handle),
+              "Unable to parse 'shared_memory_region'");
+          if (*shm_handle == 0) {
+            return TRITONSERVER_ErrorNew(
+                TRITONSERVER_ERROR_INVALID_ARG,
+                "'shared_memory_region' handle must be non-zero");
+          }
+        }
       }
     }
 
@@ -1038,7 +1088,13 @@ HTTPAPIServer::HTTPAPIServer(
     triton::server::TraceManager* trace_manager,
     const std::shared_ptr<SharedMemoryManager>& shm_manager, const int32_t port,
     const bool reuse_port, const std::string& address,
-    const std::string& header_forward_pattern, const int thread_cnt)
+    const std::string& header_forward_pattern, const int thread_cnt,
+    const std::shared_ptr<ResponseBufferBudget>& generate_buffer_budget,
+    const std::shared_ptr<ControlPlaneExecutor>& control_plane_executor,
+    const std::shared_ptr<LoadReporter>& load_reporter,
+    const std::shared_ptr<InferRequestPool>& request_pool,
+    const std::shared_ptr<SharedMemoryRingServer>& shm_ring_server,
+    const std::shared_ptr<FrontendStageMetrics>& stage_metrics)
     : HTTPServer(port, reuse_port, address, header_forward_pattern, thread_cnt),
       server_(server), trace_manager_(trace_manager), shm_manager_(shm_manager),
       allocator_(nullptr), server_regex_(R"(/v2(?:/health/(live|ready))?)"),
@@ -1047,10 +1103,16 @@ HTTPAPIServer::HTTPAPIServer(
       modelcontrol_regex_(
           R"(/v2/repository(?:/([^/]+))?/(index|models/([^/]+)/(load|unload)))"),
       systemsharedmemory_regex_(
-          R"(/v2/systemsharedmemory(?:/region/([^/]+))?/(status|register|unregister))"),
+          R"(/v2/systemsharedmemory(?:/region/([^/]+))?/(status|register|unregister|release))"),
       cudasharedmemory_regex_(
           R"(/v2/cudasharedmemory(?:/region/([^/]+))?/(status|register|unregister))"),
-      trace_regex_(R"(/v2/trace/setting)")
+      sharedmemoryring_regex_(
+          R"(/v2/sharedmemoryring(?:/region/([^/]+))?/(status|attach|detach))"),
+      trace_regex_(R"(/v2/trace/(setting|recorder))"),
+      generate_buffer_budget_(generate_buffer_budget),
+      control_plane_executor_(control_plane_executor),
+      load_reporter_(load_reporter), request_pool_(request_pool),
+      shm_ring_server_(shm_ring_server), stage_metrics_(stage_metrics)
 {
   // FIXME, don't cache server metadata. The http endpoint should
   // not be deciding that server metadata will not change during
@@ -1134,8 +1196,11 @@ HTTPAPIServer::InferResponseAlloc(
   // If the output is in shared memory...
   if (info->kind_ == AllocPayload::OutputInfo::SHM) {
     // ...then make sure shared memory size is at least as big as
-    // the size of the output.
-    if (byte_size > info->byte_size_) {
+    // the size of the output. An output in a pool is allocated here
+    // with its actual size.
+    const bool unbounded_pool =
+        (info->pool_ != nullptr) && (info->byte_size_ == 0);
+    if (!unbounded_pool && (byte_size > info->byte_size_)) {
       const auto info_byte_size = info->byte_size_;
       delete info;
       return TRITONSERVER_ErrorNew(
@@ -1148,6 +1213,22 @@ HTTPAPIServer::InferResponseAlloc(
               .c_str());
     }
 
+    if (info->pool_ != nullptr) {
+      TRITONSERVER_Error* err = info->pool_->Allocate(
+          byte_size, &info->pool_offset_, &info->pool_lease_);
+      if (err != nullptr) {
+        delete info;
+        return err;
+      }
+      if (info->pool_lease_ != 0) {
+        payload->pool_allocations_.Add(
+            info->pool_, info->pool_reference_, info->pool_offset_,
+            info->pool_lease_);
+      }
+      info->base_ =
+          reinterpret_cast<uint8_t*>(info->pool_->Base()) + info->pool_offset_;
+    }
+
     *buffer = const_cast<void*>(info->base_);
     *actual_memory_type = info->memory_type_;
     *actual_memory_type_id = info->device_id_;
@@ -1231,7 +1312,10 @@ HTTPAPIServer::OutputBufferQuery(
         (pr->second->kind_ == AllocPayload::OutputInfo::SHM)) {
       // The output is in shared memory so check that shared memory
       // size is at least large enough for the output, if byte size is provided
-      if ((byte_size != nullptr) && (*byte_size > pr->second->byte_size_)) {
+      const bool unbounded_pool =
+          (pr->second->pool_ != nullptr) && (pr->second->byte_size_ == 0);
+      if ((byte_size != nullptr) && !unbounded_pool &&
+          (*byte_size > pr->second->byte_size_)) {
         // Don't return error yet and just set to the default properties for
         // GRPC buffer, error will be raised when allocation happens
         *memory_type = TRITONSERVER_MEMORY_CPU;
@@ -1507,7 +1591,7 @@ HTTPAPIServer::HandleRepositoryControl(
   }
 
   RETURN_AND_RESPOND_IF_ERR(req, err);
-  evhtp_send_reply(req, EVHTP_RES_OK);
+  SendReply(req, EVHTP_RES_OK);
 }
 
 void
@@ -1667,7 +1751,7 @@ HTTPAPIServer::HandleModelStats(
       if (err == nullptr) {
         // Add the statistics to the response
         evbuffer_add(req->buffer_out, buffer, byte_size);
-        evhtp_send_reply(req, EVHTP_RES_OK);
+        SendReply(req, EVHTP_RES_OK);
       }
       TRITONSERVER_MessageDelete(model_stats_message);
     }
@@ -1935,6 +2019,35 @@ HTTPAPIServer::HandleTrace(evhtp_request_t* req, const std::string& model_name)
 #endif
 }
 
+void
+HTTPAPIServer::HandleTraceRecorder(evhtp_request_t* req)
+{
+  AddContentTypeHeader(req, "application/json");
+  if (req->method != htp_method_GET) {
+    RETURN_AND_RESPOND_WITH_ERR(
+        req, EVHTP_RES_METHNALLOWED, "Method Not Allowed");
+    return;
+  }
+
+#ifdef TRITON_ENABLE_TRACING
+  if (trace_manager_ == nullptr) {
+    RETURN_AND_RESPOND_IF_ERR(
+        req, TRITONSERVER_ErrorNew(
+                 TRITONSERVER_ERROR_UNAVAILABLE, "tracing is not enabled"));
+  }
+  std::stringstream timelines;
+  RETURN_AND_RESPOND_IF_ERR(req, trace_manager_->DumpRecorder(timelines));
+  const std::string buffer = timelines.str();
+  evbuffer_add(req->buffer_out, buffer.data(), buffer.size());
+  evhtp_send_reply(req, EVHTP_RES_OK);
+#else
+  RETURN_AND_RESPOND_IF_ERR(
+      req, TRITONSERVER_ErrorNew(
+               TRITONSERVER_ERROR_UNAVAILABLE,
+               "the server does not support tracing"));
+#endif
+}
+
 void
 HTTPAPIServer::HandleLogging(evhtp_request_t* req)
 {
@@ -2187,9 +2300,19 @@ HTTPAPIServer::HandleSystemSharedMemory(
             }
           }
 
+          SharedMemoryManager::MappingOptions options;
+          if (err == nullptr) {
+            err = SharedMemoryManager::ParseMappingOptions(
+                register_request, &options);
+          }
+
           if (err == nullptr) {
+            uint64_t handle = 0;
             err = shm_manager_->RegisterSystemSharedMemory(
-                region_name, shm_key, offset, byte_size);
+                region_name, shm_key, offset, byte_size, options, &handle);
+            if (err == nullptr) {
+              EVBufferAddSharedMemoryHandleJson(req->buffer_out, handle);
+            }
           }
         }
       }
@@ -2200,10 +2323,94 @@ HTTPAPIServer::HandleSystemSharedMemory(
     } else {
       err = shm_manager_->Unregister(region_name, TRITONSERVER_MEMORY_CPU);
     }
+  } else if (action == "release") {
+    if (region_name.empty()) {
+      err = TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          "'region name' is necessary to release an output in a shared "
+          "memory pool");
+    } else {
+      struct evbuffer_iovec* v = nullptr;
+      int v_idx = 0;
+      int n = evbuffer_peek(req->buffer_in, -1, NULL, NULL, 0);
+      if (n > 0) {
+        v = static_cast<struct evbuffer_iovec*>(
+            alloca(sizeof(struct evbuffer_iovec) * n));
+        if (evbuffer_peek(req->buffer_in, -1, NULL, v, n) != n) {
+          err = TRITONSERVER_ErrorNew(
+              TRITONSERVER_ERROR_INTERNAL,
+              "unexpected error getting release request buffers");
+        }
+      }
+
+      triton::common::TritonJson::Value release_request;
+      if (err == nullptr) {
+        size_t buffer_len = evbuffer_get_length(req->buffer_in);
+        err = EVBufferToJson(&release_request, v, &v_idx, buffer_len, n);
+      }
+      uint64_t offset = 0;
+      uint64_t lease = 0;
+      if (err == nullptr) {
+        err = release_request.MemberAsUInt("offset", &offset);
+      }
+      if (err == nullptr) {
+        err = release_request.MemberAsUInt("lease", &lease);
+      }
+      if (err == nullptr) {
+        err = shm_manager_->ReleasePoolAllocation(
+            region_name, 0 /* handle */, offset, lease);
+      }
+    }
   }
 
   RETURN_AND_RESPOND_IF_ERR(req, err);
-  evhtp_send_reply(req, EVHTP_RES_OK);
+  SendReply(req, EVHTP_RES_OK);
+}
+
+void
+HTTPAPIServer::HandleSharedMemoryRing(
+    evhtp_request_t* req, const std::string& region_name,
+    const std::string& action)
+{
+  AddContentTypeHeader(req, "application/json");
+  if ((action == "status") && (req->method != htp_method_GET)) {
+    RETURN_AND_RESPOND_WITH_ERR(
+        req, EVHTP_RES_METHNALLOWED, "Method Not Allowed");
+  } else if ((action != "status") && (req->method != htp_method_POST)) {
+    RETURN_AND_RESPOND_WITH_ERR(
+        req, EVHTP_RES_METHNALLOWED, "Method Not Allowed");
+  }
+  if (shm_ring_server_ == nullptr) {
+    RETURN_AND_RESPOND_WITH_ERR(
+        req, EVHTP_RES_BADREQ, "shared memory rings are not enabled");
+  }
+
+  TRITONSERVER_Error* err = nullptr;
+  if (action == "status") {
+    triton::common::TritonJson::Value ring_status(
+        triton::common::TritonJson::ValueType::ARRAY);
+    err = shm_ring_server_->GetStatus(region_name, &ring_status);
+    if (err == nullptr) {
+      triton::common::TritonJson::WriteBuffer buffer;
+      err = ring_status.Write(&buffer);
+      if (err == nullptr) {
+        evbuffer_add(req->buffer_out, buffer.Base(), buffer.Size());
+      }
+    }
+  } else if (action == "attach") {
+    if (region_name.empty()) {
+      err = TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          "'region name' is necessary to attach a shared memory ring");
+    } else {
+      err = shm_ring_server_->Attach(region_name);
+    }
+  } else if (action == "detach") {
+    err = shm_ring_server_->Detach(region_name);
+  }
+
+  RETURN_AND_RESPOND_IF_ERR(req, err);
+  SendReply(req, EVHTP_RES_OK);
 }
 
 void
@@ -2294,11 +2501,15 @@ HTTPAPIServer::HandleCudaSharedMemory(
                   "cudaIpcMemHandle_t");
             } else {
               raw_handle.resize(sizeof(cudaIpcMemHandle_t));
+              uint64_t handle = 0;
               err = shm_manager_->RegisterCUDASharedMemory(
                   region_name.c_str(),
                   reinterpret_cast<const cudaIpcMemHandle_t*>(
                       raw_handle.data()),
-                  byte_size, device_id);
+                  byte_size, device_id, &handle);
+              if (err == nullptr) {
+                EVBufferAddSharedMemoryHandleJson(req->buffer_out, handle);
+              }
             }
           }
         }
@@ -2321,7 +2532,7 @@ HTTPAPIServer::HandleCudaSharedMemory(
   }
 
   RETURN_AND_RESPOND_IF_ERR(req, err);
-  evhtp_send_reply(req, EVHTP_RES_OK);
+  SendReply(req, EVHTP_RES_OK);
 }
 
 TRITONSERVER_Error*
@@ -2531,29 +2742,26 @@ HTTPAPIServer::ParseJsonTritonIO(
       bool use_shm;
       uint64_t shm_offset;
       const char* shm_region;
+      uint64_t shm_handle;
       RETURN_IF_ERR(CheckSharedMemoryData(
-          request_input, &use_shm, &shm_region, &shm_offset,
+          request_input, &use_shm, &shm_region, &shm_handle, &shm_offset,
           reinterpret_cast<uint64_t*>(&byte_size)));
       if (use_shm) {
         void* base;
         TRITONSERVER_MemoryType memory_type;
         int64_t memory_type_id;
+        SharedMemoryManager::Reference reference;
         RETURN_IF_ERR(shm_manager_->GetMemoryInfo(
-            shm_region, shm_offset, &base, &memory_type, &memory_type_id));
+            shm_region, shm_handle, shm_offset, &base, &memory_type,
+            &memory_type_id, &reference));
+        infer_req->shm_references_.emplace_back(std::move(reference));
         if (memory_type == TRITONSERVER_MEMORY_GPU) {
 #ifdef TRITON_ENABLE_GPU
           cudaIpcMemHandle_t* cuda_handle;
-          RETURN_IF_ERR(shm_manager_->GetCUDAHandle(shm_region, &cuda_handle));
+          RETURN_IF_ERR(shm_manager_->GetCUDAHandle(
+              shm_region, shm_handle, &cuda_handle));
           TRITONSERVER_BufferAttributes* buffer_attributes;
-          RETURN_IF_ERR(TRITONSERVER_BufferAttributesNew(&buffer_attributes));
-          auto buffer_attributes_del =
-              [](TRITONSERVER_BufferAttributes* buffer_attributes) {
-                TRITONSERVER_BufferAttributesDelete(buffer_attributes);
-              };
-
-          std::unique_ptr<
-              TRITONSERVER_BufferAttributes, decltype(buffer_attributes_del)>
-              buffer_attrsl(buffer_attributes, buffer_attributes_del);
+          RETURN_IF_ERR(ThreadLocalBufferAttributes(&buffer_attributes));
           RETURN_IF_ERR(TRITONSERVER_BufferAttributesSetMemoryType(
               buffer_attributes, memory_type));
           RETURN_IF_ERR(TRITONSERVER_BufferAttributesSetMemoryTypeId(
@@ -2643,8 +2851,10 @@ HTTPAPIServer::ParseJsonTritonIO(
       bool use_shm;
       uint64_t offset, byte_size;
       const char* shm_region;
+      uint64_t shm_handle;
       RETURN_IF_ERR(CheckSharedMemoryData(
-          request_output, &use_shm, &shm_region, &offset, &byte_size));
+          request_output, &use_shm, &shm_region, &shm_handle, &offset,
+          &byte_size));
 
       // ValidateOutputParameter ensures that both shm and
       // classification cannot be true.
@@ -2652,13 +2862,34 @@ HTTPAPIServer::ParseJsonTritonIO(
         void* base;
         TRITONSERVER_MemoryType memory_type;
         int64_t memory_type_id;
+        SharedMemoryManager::Reference reference;
+        SharedMemoryPool* pool;
         RETURN_IF_ERR(shm_manager_->GetMemoryInfo(
-            shm_region, offset, &base, &memory_type, &memory_type_id));
-
-        if (memory_type == TRITONSERVER_MEMORY_GPU) {
+            shm_region, shm_handle, offset, &base, &memory_type,
+            &memory_type_id, &reference, nullptr /* byte_size */, &pool));
+        if ((pool != nullptr) && (offset != 0)) {
+          return TRITONSERVER_ErrorNew(
+              TRITONSERVER_ERROR_INVALID_ARG,
+              std::string(
+                  "'shared_memory_offset' can't be set for output '" +
+                  std::string(output_name) +
+                  "', it is allocated by the server in the pool")
+                  .c_str());
+        }
+        if (pool != nullptr) {
+          // The output is allocated in the pool once its size is known,
+          // the allocation may outlive the request.
+          AllocPayload::OutputInfo* info = new AllocPayload::OutputInfo(
+              nullptr /* base */, byte_size, memory_type, memory_type_id,
+              nullptr /* cuda ipc handle */);
+          info->pool_ = pool;
+          info->pool_reference_ = reference;
+          infer_req->alloc_payload_.output_map_.emplace(output_name, info);
+        } else if (memory_type == TRITONSERVER_MEMORY_GPU) {
 #ifdef TRITON_ENABLE_GPU
           cudaIpcMemHandle_t* cuda_handle;
-          RETURN_IF_ERR(shm_manager_->GetCUDAHandle(shm_region, &cuda_handle));
+          RETURN_IF_ERR(shm_manager_->GetCUDAHandle(
+              shm_region, shm_handle, &cuda_handle));
           infer_req->alloc_payload_.output_map_.emplace(
               std::piecewise_construct, std::forward_as_tuple(output_name),
               std::forward_as_tuple(new AllocPayload::OutputInfo(
@@ -2672,6 +2903,7 @@ HTTPAPIServer::ParseJsonTritonIO(
                   base, byte_size, memory_type, memory_type_id,
                   nullptr /* cuda ipc handle */)));
         }
+        infer_req->shm_references_.emplace_back(std::move(reference));
       } else {
         bool use_binary;
         RETURN_IF_ERR(CheckBinaryOutputData(request_output, &use_binary));
@@ -2769,6 +3001,7 @@ HTTPAPIServer::ParseJsonTritonParams(
       } else {
         RETURN_IF_ERR(SetTritonParameterFromJsonParameter(
             parameter, params_json, irequest));
+        infer_req->custom_parameters_ = true;
       }
     }
 
@@ -2847,14 +3080,18 @@ HTTPAPIServer::EVBufferToInput(
   // Extract just the json header from the HTTP body. 'header_length == 0' means
   // that the entire HTTP body should be input data for a raw binary request.
   triton::common::TritonJson::Value request_json;
+  infer_req->CaptureStage(FrontendStage::PARSE_START);
   RETURN_IF_ERR(EVBufferToJson(&request_json, v, &v_idx, header_length, n));
+  infer_req->CaptureStage(FrontendStage::PARSE_END);
 
   // Parse request JSON and fill related Triton fields
+  infer_req->CaptureStage(FrontendStage::INPUT_SETUP_START);
   RETURN_IF_ERR(ParseJsonTritonRequestID(request_json, irequest));
   RETURN_IF_ERR(ParseJsonTritonParams(request_json, irequest, infer_req));
   RETURN_IF_ERR(ParseJsonTritonIO(
       request_json, irequest, infer_req, model_name, v, &v_idx, header_length,
       n));
+  infer_req->CaptureStage(FrontendStage::INPUT_SETUP_END);
 
   return nullptr;  // success
 }
@@ -2865,6 +3102,7 @@ HTTPAPIServer::EVBufferToRawInput(
     evbuffer* input_buffer, InferRequestClass* infer_req)
 {
   static const char* raw_input_name = "raw_input";
+  infer_req->CaptureStage(FrontendStage::INPUT_SETUP_START);
   RETURN_IF_ERR(
       TRITONSERVER_InferenceRequestAddRawInput(irequest, raw_input_name));
 
@@ -2909,6 +3147,7 @@ HTTPAPIServer::EVBufferToRawInput(
   }
   infer_req->alloc_payload_.default_output_kind_ =
       AllocPayload::OutputInfo::BINARY;
+  infer_req->CaptureStage(FrontendStage::INPUT_SETUP_END);
   return nullptr;  // success
 }
 
@@ -2980,8 +3219,8 @@ HTTPAPIServer::StartTrace(
     // Timestamps from evhtp are capture in 'req'. We record here
     // since this is the first place where we have access to trace
     // manager.
-    trace->CaptureTimestamp("HTTP_RECV_START", req->recv_start_ns);
-    trace->CaptureTimestamp("HTTP_RECV_END", req->recv_end_ns);
+    trace->CaptureTimestamp(FrontendStage::HTTP_RECV_START, req->recv_start_ns);
+    trace->CaptureTimestamp(FrontendStage::HTTP_RECV_END, req->recv_end_ns);
   }
   return trace;
 #else
@@ -3112,7 +3351,8 @@ HTTPAPIServer::HandleGenerate(
     generate_request.reset(new GenerateRequestClass(
         server_.get(), req, GetResponseCompressionType(req),
         generate_stream_request_schema_.get(),
-        generate_stream_response_schema_.get(), streaming, irequest));
+        generate_stream_response_schema_.get(), streaming, irequest,
+        generate_buffer_budget_));
   } else {
     generate_request.reset(new GenerateRequestClass(
         server_.get(), req, GetResponseCompressionType(req),
@@ -3120,6 +3360,7 @@ HTTPAPIServer::HandleGenerate(
         streaming, irequest));
   }
   generate_request->trace_ = trace;
+  TrackLoad(req, generate_request.get());
 
   const char* request_id = "<id_unknown>";
   // Callback to cleanup on any errors encountered below. Capture everything
@@ -3149,6 +3390,9 @@ HTTPAPIServer::HandleGenerate(
       evhtp_request_resume(req);
 
 #ifdef TRITON_ENABLE_TRACING
+      if (trace != nullptr) {
+        trace->MarkFailed();
+      }
       // If HTTP server still owns Triton trace
       if ((trace != nullptr) && (trace->trace_ != nullptr)) {
         TraceManager::TraceRelease(trace->trace_, trace->trace_userp_);
@@ -3427,10 +3671,27 @@ HTTPAPIServer::HandleInfer(
   TRITONSERVER_InferenceTrace* triton_trace = nullptr;
   std::shared_ptr<TraceManager::Trace> trace =
       StartTrace(req, model_name, &triton_trace);
-
-  // Decompress request body if it is compressed in supported type
+  bool server_timing = false;
+  FrontendStageMetrics* stage_metrics = nullptr;
+#ifdef TRITON_ENABLE_TRACING
+  server_timing =
+      (trace_manager_ != nullptr) && trace_manager_->ServerTiming();
+  stage_metrics = stage_metrics_.get();
+#endif  // TRITON_ENABLE_TRACING
+  const uint64_t cpu_start_ns =
+      (stage_metrics != nullptr) ? FrontendStageMetrics::ThreadCpuNs() : 0;
+
+  // Decompress request body if it is compressed in supported type. The
+  // request object holding the stage timestamps doesn't exist yet, the
+  // timestamps are captured into it once it is created.
+  const bool capture_stages =
+      (trace != nullptr) || server_timing || (stage_metrics != nullptr);
+  const uint64_t decompress_start_ns =
+      capture_stages ? TraceManager::CaptureTimestamp() : 0;
   evbuffer* decompressed_buffer = nullptr;
   RETURN_AND_RESPOND_IF_ERR(req, DecompressBuffer(req, &decompressed_buffer));
+  const uint64_t decompress_end_ns =
+      capture_stages ? TraceManager::CaptureTimestamp() : 0;
 
   // Get content length as a default header_length if no header specified
   int32_t content_length = 0;
@@ -3443,18 +3704,42 @@ HTTPAPIServer::HandleInfer(
       req, GetInferenceHeaderLength(req, content_length, &header_length));
 
   // Create the inference request object which provides all information needed
-  // for an inference. Make sure it is cleaned up on early error.
+  // for an inference, or reuse one of the pool. Make sure it is cleaned up on
+  // early error.
   TRITONSERVER_InferenceRequest* irequest = nullptr;
-  RETURN_AND_RESPOND_IF_ERR(
-      req, TRITONSERVER_InferenceRequestNew(
-               &irequest, server_.get(), model_name.c_str(),
-               requested_model_version));
+  InferRequestPool::Entry* pooled_request = nullptr;
+  if (request_pool_ != nullptr) {
+    RETURN_AND_RESPOND_IF_ERR(
+        req, request_pool_->Acquire(
+                 model_name, requested_model_version, &pooled_request));
+    irequest = pooled_request->irequest_;
+    // Only reusable once it is known not to set state that can't be
+    // reset.
+    pooled_request->reusable_ = false;
+  } else {
+    RETURN_AND_RESPOND_IF_ERR(
+        req, TRITONSERVER_InferenceRequestNew(
+                 &irequest, server_.get(), model_name.c_str(),
+                 requested_model_version));
+  }
 
   // HTTP request paused when creating inference request. Resume it on exit if
   // this function returns early due to error. Otherwise resumed in callback.
   bool connection_paused = true;
   auto infer_request = CreateInferRequest(req);
   infer_request->trace_ = trace;
+  infer_request->server_timing_ = server_timing;
+  if (stage_metrics != nullptr) {
+    infer_request->stage_metrics_ = stage_metrics;
+    infer_request->model_name_ = model_name;
+  }
+  if (capture_stages && (decompressed_buffer != nullptr)) {
+    infer_request->CaptureStage(
+        FrontendStage::DECOMPRESS_START, decompress_start_ns);
+    infer_request->CaptureStage(
+        FrontendStage::DECOMPRESS_END, decompress_end_ns);
+  }
+  TrackLoad(req, infer_request.get());
 
   const char* request_id = "<id_unknown>";
   // Callback to cleanup on any errors encountered below. Capture everything
@@ -3471,15 +3756,22 @@ HTTPAPIServer::HandleInfer(
         evhtp_request_resume(req);
       }
 #ifdef TRITON_ENABLE_TRACING
+      if (trace != nullptr) {
+        trace->MarkFailed();
+      }
       // If HTTP server still owns Triton trace
       if ((trace != nullptr) && (trace->trace_ != nullptr)) {
         TraceManager::TraceRelease(trace->trace_, trace->trace_userp_);
       }
 #endif  // TRITON_ENABLE_TRACING
 
-      LOG_TRITONSERVER_ERROR(
-          TRITONSERVER_InferenceRequestDelete(irequest),
-          "deleting HTTP/REST inference request");
+      if (pooled_request != nullptr) {
+        InferRequestPool::Release(pooled_request);
+      } else {
+        LOG_TRITONSERVER_ERROR(
+            TRITONSERVER_InferenceRequestDelete(irequest),
+            "deleting HTTP/REST inference request");
+      }
     }
   };
 
@@ -3501,11 +3793,24 @@ HTTPAPIServer::HandleInfer(
 
   RETURN_AND_CALLBACK_IF_ERR(ForwardHeaders(req, irequest), error_callback);
 
-  RETURN_AND_CALLBACK_IF_ERR(
-      TRITONSERVER_InferenceRequestSetReleaseCallback(
-          irequest, InferRequestClass::InferRequestComplete,
-          decompressed_buffer),
-      error_callback);
+  if (pooled_request != nullptr) {
+    // Forwarded headers and custom parameters can't be removed from the
+    // request.
+    pooled_request->reusable_ =
+        header_forward_pattern_.empty() && !infer_request->custom_parameters_;
+    pooled_request->userp_ = decompressed_buffer;
+    RETURN_AND_CALLBACK_IF_ERR(
+        TRITONSERVER_InferenceRequestSetReleaseCallback(
+            irequest, InferRequestClass::PooledInferRequestComplete,
+            pooled_request),
+        error_callback);
+  } else {
+    RETURN_AND_CALLBACK_IF_ERR(
+        TRITONSERVER_InferenceRequestSetReleaseCallback(
+            irequest, InferRequestClass::InferRequestComplete,
+            decompressed_buffer),
+        error_callback);
+  }
   RETURN_AND_CALLBACK_IF_ERR(
       TRITONSERVER_InferenceRequestSetResponseCallback(
           irequest, allocator_,
@@ -3514,6 +3819,8 @@ HTTPAPIServer::HandleInfer(
           reinterpret_cast<void*>(infer_request.get())),
       error_callback);
 
+  // The request may complete before the call returns.
+  infer_request->AddCpu(cpu_start_ns);
   auto err =
       TRITONSERVER_ServerInferAsync(server_.get(), irequest, triton_trace);
 #ifdef TRITON_ENABLE_TRACING
@@ -3535,17 +3842,12 @@ HTTPAPIServer::OKReplyCallback(evthr_t* thr, void* arg, void* shared)
       reinterpret_cast<HTTPAPIServer::InferRequestClass*>(arg);
 
   evhtp_request_t* request = infer_request->EvHtpRequest();
+  const uint64_t cpu_start_ns = infer_request->CpuStart();
   evhtp_send_reply(request, EVHTP_RES_OK);
   evhtp_request_resume(request);
-
-#ifdef TRITON_ENABLE_TRACING
-  if (infer_request->trace_ != nullptr) {
-    infer_request->trace_->CaptureTimestamp(
-        "HTTP_SEND_START", request->send_start_ns);
-    infer_request->trace_->CaptureTimestamp(
-        "HTTP_SEND_END", request->send_end_ns);
-  }
-#endif  // TRITON_ENABLE_TRACING
+  infer_request->alloc_payload_.pool_allocations_.Deliver();
+  infer_request->AddCpu(cpu_start_ns);
+  infer_request->ReplySent();
 
   delete infer_request;
 }
@@ -3557,17 +3859,11 @@ HTTPAPIServer::BADReplyCallback(evthr_t* thr, void* arg, void* shared)
       reinterpret_cast<HTTPAPIServer::InferRequestClass*>(arg);
 
   evhtp_request_t* request = infer_request->EvHtpRequest();
+  const uint64_t cpu_start_ns = infer_request->CpuStart();
   evhtp_send_reply(request, EVHTP_RES_BADREQ);
   evhtp_request_resume(request);
-
-#ifdef TRITON_ENABLE_TRACING
-  if (infer_request->trace_ != nullptr) {
-    infer_request->trace_->CaptureTimestamp(
-        "HTTP_SEND_START", request->send_start_ns);
-    infer_request->trace_->CaptureTimestamp(
-        "HTTP_SEND_END", request->send_end_ns);
-  }
-#endif  // TRITON_ENABLE_TRACING
+  infer_request->AddCpu(cpu_start_ns);
+  infer_request->ReplySent();
 
   delete infer_request;
 }
@@ -3583,6 +3879,79 @@ HTTPAPIServer::InferRequestClass::InferRequestClass(
   evhtp_request_pause(req);
 }
 
+HTTPAPIServer::InferRequestClass::~InferRequestClass()
+{
+  if (load_reporter_ != nullptr) {
+    load_reporter_->RequestDone();
+  }
+}
+
+void
+HTTPAPIServer::InferRequestClass::RecordResponseError(TRITONSERVER_Error* err)
+{
+  if ((load_reporter_ != nullptr) &&
+      (TRITONSERVER_ErrorCode(err) == TRITONSERVER_ERROR_UNAVAILABLE)) {
+    load_reporter_->RequestShed();
+  }
+#ifdef TRITON_ENABLE_TRACING
+  if (trace_ != nullptr) {
+    trace_->MarkFailed();
+  }
+#endif  // TRITON_ENABLE_TRACING
+}
+
+void
+HTTPAPIServer::InferRequestClass::CaptureStage(const FrontendStage stage)
+{
+#ifdef TRITON_ENABLE_TRACING
+  // Avoid reading the clock if the timestamp is not used.
+  if ((trace_ != nullptr) || server_timing_ || (stage_metrics_ != nullptr)) {
+    CaptureStage(stage, TraceManager::CaptureTimestamp());
+  }
+#endif  // TRITON_ENABLE_TRACING
+}
+
+void
+HTTPAPIServer::InferRequestClass::CaptureStage(
+    const FrontendStage stage, const uint64_t timestamp_ns)
+{
+#ifdef TRITON_ENABLE_TRACING
+  if (trace_ != nullptr) {
+    trace_->CaptureTimestamp(stage, timestamp_ns);
+  }
+  if (server_timing_ || (stage_metrics_ != nullptr)) {
+    stage_timestamps_.Capture(stage, timestamp_ns);
+  }
+#endif  // TRITON_ENABLE_TRACING
+}
+
+uint64_t
+HTTPAPIServer::InferRequestClass::CpuStart() const
+{
+  return (stage_metrics_ != nullptr) ? FrontendStageMetrics::ThreadCpuNs()
+                                     : 0;
+}
+
+void
+HTTPAPIServer::InferRequestClass::AddCpu(const uint64_t start_ns)
+{
+  if (stage_metrics_ != nullptr) {
+    cpu_ns_ += FrontendStageMetrics::ThreadCpuNs() - start_ns;
+  }
+}
+
+void
+HTTPAPIServer::InferRequestClass::ReplySent()
+{
+#ifdef TRITON_ENABLE_TRACING
+  CaptureStage(FrontendStage::HTTP_SEND_START, req_->send_start_ns);
+  CaptureStage(FrontendStage::HTTP_SEND_END, req_->send_end_ns);
+  if (stage_metrics_ != nullptr) {
+    stage_metrics_->Observe(model_name_, stage_timestamps_, cpu_ns_);
+  }
+#endif  // TRITON_ENABLE_TRACING
+}
+
 void
 HTTPAPIServer::InferRequestClass::InferRequestComplete(
     TRITONSERVER_InferenceRequest* request, const uint32_t flags, void* userp)
@@ -3600,6 +3969,20 @@ HTTPAPIServer::InferRequestClass::InferRequestComplete(
   }
 }
 
+void
+HTTPAPIServer::InferRequestClass::PooledInferRequestComplete(
+    TRITONSERVER_InferenceRequest* request, const uint32_t flags, void* userp)
+{
+  if ((flags & TRITONSERVER_REQUEST_RELEASE_ALL) != 0) {
+    auto entry = reinterpret_cast<InferRequestPool::Entry*>(userp);
+    if (entry->userp_ != nullptr) {
+      evbuffer_free(reinterpret_cast<evbuffer*>(entry->userp_));
+      entry->userp_ = nullptr;
+    }
+    InferRequestPool::Release(entry);
+  }
+}
+
 void
 HTTPAPIServer::InferRequestClass::InferResponseComplete(
     TRITONSERVER_InferenceResponse* response, const uint32_t flags, void* userp)
@@ -3624,6 +4007,11 @@ HTTPAPIServer::InferRequestClass::InferResponseComplete(
     return;
   }
 
+  // Captured before the response is finalized so that the serialization
+  // of the response is traced as its own stage.
+  infer_request->CaptureStage(FrontendStage::INFER_RESPONSE_COMPLETE);
+  const uint64_t cpu_start_ns = infer_request->CpuStart();
+
   TRITONSERVER_Error* err = nullptr;
   if (response_count != 0) {
     err = TRITONSERVER_ErrorNew(
@@ -3639,15 +4027,22 @@ HTTPAPIServer::InferRequestClass::InferResponseComplete(
   }
 
 #ifdef TRITON_ENABLE_TRACING
-  if (infer_request->trace_ != nullptr) {
-    infer_request->trace_->CaptureTimestamp(
-        "INFER_RESPONSE_COMPLETE", TraceManager::CaptureTimestamp());
+  if (infer_request->server_timing_) {
+    const std::string timing = infer_request->stage_timestamps_.ServerTiming();
+    if (!timing.empty()) {
+      evhtp_headers_add_header(
+          infer_request->req_->headers_out,
+          evhtp_header_new(kServerTimingHeader, timing.c_str(), 1, 1));
+    }
   }
 #endif  // TRITON_ENABLE_TRACING
 
+  // The request is released by the reply callback.
+  infer_request->AddCpu(cpu_start_ns);
   if (err == nullptr) {
     evthr_defer(infer_request->thread_, OKReplyCallback, infer_request);
   } else {
+    infer_request->RecordResponseError(err);
     EVBufferAddErrorJson(infer_request->req_->buffer_out, err);
     TRITONSERVER_ErrorDelete(err);
     evthr_defer(infer_request->thread_, BADReplyCallback, infer_request);
@@ -3664,6 +4059,8 @@ HTTPAPIServer::InferRequestClass::FinalizeResponse(
 {
   RETURN_IF_ERR(TRITONSERVER_InferenceResponseError(response));
 
+  CaptureStage(FrontendStage::OUTPUT_SERIALIZE_START);
+
   triton::common::TritonJson::Value response_json(
       triton::common::TritonJson::ValueType::OBJECT);
 
@@ -3868,6 +4265,18 @@ HTTPAPIServer::InferRequestClass::FinalizeResponse(
       RETURN_IF_ERR(WriteDataToJson(
           &data_json, cname, datatype, base, byte_size, element_count));
       RETURN_IF_ERR(output_json.Add("data", std::move(data_json)));
+    } else if (info->pool_ != nullptr) {
+      // Tell the client where the server put the output in the pool and
+      // the lease to release it with.
+      triton::common::TritonJson::Value parameters_json(
+          response_json, triton::common::TritonJson::ValueType::OBJECT);
+      RETURN_IF_ERR(
+          parameters_json.AddUInt("shared_memory_offset", info->pool_offset_));
+      RETURN_IF_ERR(
+          parameters_json.AddUInt("shared_memory_byte_size", byte_size));
+      RETURN_IF_ERR(parameters_json.AddUInt(
+          "shared_memory_pool_lease", info->pool_lease_));
+      RETURN_IF_ERR(output_json.Add("parameters", std::move(parameters_json)));
     }
 
     RETURN_IF_ERR(response_outputs.Append(std::move(output_json)));
@@ -3889,13 +4298,17 @@ HTTPAPIServer::InferRequestClass::FinalizeResponse(
     }
   }
 
+  CaptureStage(FrontendStage::OUTPUT_SERIALIZE_END);
+
   evbuffer* response_body = response_placeholder;
   switch (response_compression_type_) {
     case DataCompressor::Type::DEFLATE:
     case DataCompressor::Type::GZIP: {
       auto compressed_buffer = evbuffer_new();
+      CaptureStage(FrontendStage::COMPRESS_START);
       auto err = DataCompressor::CompressData(
           response_compression_type_, response_placeholder, compressed_buffer);
+      CaptureStage(FrontendStage::COMPRESS_END);
       if (err == nullptr) {
         response_body = compressed_buffer;
         evbuffer_free(response_placeholder);
@@ -3966,6 +4379,11 @@ HTTPAPIServer::GenerateRequestClass::~GenerateRequestClass()
     evbuffer_free(pending_http_responses_.front());
     pending_http_responses_.pop();
   }
+  if (buffer_budget_ != nullptr) {
+    buffer_budget_->ReportBuffered(
+        -static_cast<double>(reported_bytes_),
+        -static_cast<double>(reported_count_));
+  }
 }
 
 void
@@ -3991,6 +4409,7 @@ HTTPAPIServer::GenerateRequestClass::InferResponseComplete(
     err = infer_request->FinalizeResponse(response);
   }
   if (err != nullptr) {
+    infer_request->RecordResponseError(err);
     infer_request->AddErrorJson(err);
   }
 
@@ -4005,7 +4424,8 @@ HTTPAPIServer::GenerateRequestClass::InferResponseComplete(
 #ifdef TRITON_ENABLE_TRACING
   if (infer_request->trace_ != nullptr) {
     infer_request->trace_->CaptureTimestamp(
-        "INFER_RESPONSE_COMPLETE", TraceManager::CaptureTimestamp());
+        FrontendStage::INFER_RESPONSE_COMPLETE,
+        TraceManager::CaptureTimestamp());
   }
 #endif  // TRITON_ENABLE_TRACING
 
@@ -4079,23 +4499,49 @@ HTTPAPIServer::GenerateRequestClass::SendChunkResponse(bool end)
   evbuffer* buffer = nullptr;
   {
     std::lock_guard<std::mutex> lk(res_mtx_);
-    // This function may be called with no pending responses when
-    // response complete callback is invoked with flag-only
-    if (pending_http_responses_.empty()) {
-      return;
+    if (budget_exceeded_) {
+      // Drop whatever is pending and send the error in its place, once.
+      while (!pending_http_responses_.empty()) {
+        evbuffer_free(pending_http_responses_.front());
+        pending_http_responses_.pop();
+      }
+      pending_bytes_ = 0;
+      if (budget_error_sent_) {
+        return;
+      }
+      budget_error_sent_ = true;
+      buffer = ErrorJsonBuffer(TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_UNAVAILABLE,
+          "response buffer budget exceeded, client is not reading responses "
+          "fast enough, remaining responses are dropped"));
+    } else {
+      // This function may be called with no pending responses when
+      // response complete callback is invoked with flag-only
+      if (pending_http_responses_.empty()) {
+        return;
+      }
+      buffer = pending_http_responses_.front();
+      pending_http_responses_.pop();
+      pending_bytes_ -= std::min(pending_bytes_, evbuffer_get_length(buffer));
     }
-    buffer = pending_http_responses_.front();
-    pending_http_responses_.pop();
   }
   evhtp_send_reply_chunk(req_, buffer);
   evbuffer_free(buffer);
 
+  // Sending the error above reports the budget as exceeded only once so
+  // this recurses at most once.
+  if (UpdateBufferedResponses()) {
+    SendChunkResponse(end);
+    return;
+  }
+
 #ifdef TRITON_ENABLE_TRACING
   if (trace_ != nullptr) {
     // [FIXME] currently send_start_ns / send_end_ns is
     // not captured in evhtp when response is sent in chunks
-    trace_->CaptureTimestamp("HTTP_SEND_START", req_->send_start_ns);
-    trace_->CaptureTimestamp("HTTP_SEND_END", req_->send_end_ns);
+    trace_->CaptureTimestamp(
+        FrontendStage::HTTP_SEND_START, req_->send_start_ns);
+    trace_->CaptureTimestamp(FrontendStage::HTTP_SEND_END, req_->send_end_ns);
   }
 #endif  // TRITON_ENABLE_TRACING
 }
@@ -4211,16 +4657,19 @@ HTTPAPIServer::GenerateRequestClass::FinalizeResponse(
     evbuffer_add(response_body, sse_suffix.c_str(), sse_suffix.length());
   }
 
-  {
-    std::lock_guard<std::mutex> lk(res_mtx_);
-    pending_http_responses_.emplace(response_body);
-  }
+  EnqueueResponse(response_body);
 
   return nullptr;  // success
 }
 
 void
 HTTPAPIServer::GenerateRequestClass::AddErrorJson(TRITONSERVER_Error* error)
+{
+  EnqueueResponse(ErrorJsonBuffer(error));
+}
+
+evbuffer*
+HTTPAPIServer::GenerateRequestClass::ErrorJsonBuffer(TRITONSERVER_Error* error)
 {
   evbuffer* buffer = evbuffer_new();
   if (streaming_) {
@@ -4233,12 +4682,56 @@ HTTPAPIServer::GenerateRequestClass::AddErrorJson(TRITONSERVER_Error* error)
     evbuffer_add(buffer, sse_suffix.c_str(), sse_suffix.length());
   }
   TRITONSERVER_ErrorDelete(error);
-  {
-    std::lock_guard<std::mutex> lk(res_mtx_);
-    pending_http_responses_.emplace(buffer);
+  return buffer;
+}
+
+void
+HTTPAPIServer::GenerateRequestClass::EnqueueResponse(evbuffer* buffer)
+{
+  std::lock_guard<std::mutex> lk(res_mtx_);
+  if (budget_exceeded_) {
+    evbuffer_free(buffer);
+    return;
+  }
+  pending_bytes_ += evbuffer_get_length(buffer);
+  pending_http_responses_.emplace(buffer);
+  if ((buffer_budget_ != nullptr) &&
+      buffer_budget_->Exceeded(
+          pending_bytes_, pending_http_responses_.size())) {
+    budget_exceeded_ = true;
+    buffer_budget_->ReportExceeded();
   }
 }
 
+bool
+HTTPAPIServer::GenerateRequestClass::UpdateBufferedResponses()
+{
+  if (buffer_budget_ == nullptr) {
+    return false;
+  }
+
+  // The responses already handed to evhtp remain buffered in the
+  // connection until the client reads them.
+  evhtp_connection_t* htpconn = evhtp_request_get_connection(req_);
+  size_t bytes = evbuffer_get_length(bufferevent_get_output(htpconn->bev));
+
+  std::lock_guard<std::mutex> lk(res_mtx_);
+  bytes += pending_bytes_;
+  const uint32_t count = pending_http_responses_.size();
+  buffer_budget_->ReportBuffered(
+      static_cast<double>(bytes) - reported_bytes_,
+      static_cast<double>(count) - reported_count_);
+  reported_bytes_ = bytes;
+  reported_count_ = count;
+
+  if (!budget_exceeded_ && buffer_budget_->Exceeded(bytes, count)) {
+    budget_exceeded_ = true;
+    buffer_budget_->ReportExceeded();
+    return true;
+  }
+  return false;
+}
+
 TRITONSERVER_Error*
 HTTPAPIServer::GenerateRequestClass::ConvertGenerateResponse(
     const std::map<
@@ -4378,15 +4871,123 @@ HTTPAPIServer::GenerateRequestClass::ExactMappingOutput(
   return nullptr;  // success
 }
 
+void
+HTTPAPIServer::HandleControlPlane(
+    evhtp_request_t* req, std::function<void()>&& handler)
+{
+  if (control_plane_executor_ == nullptr) {
+    handler();
+    return;
+  }
+
+  // The request is paused until the reply is sent from the thread of
+  // the connection, as the connection must not be accessed by any
+  // other thread.
+  evhtp_connection_t* htpconn = evhtp_request_get_connection(req);
+  ControlPlaneRequest* control_request =
+      new ControlPlaneRequest{req, htpconn->thread, EVHTP_RES_OK};
+  evhtp_request_pause(req);
+
+  TRITONSERVER_Error* err = control_plane_executor_->Submit(
+      [control_request, handler]() {
+        deferred_reply_code = &control_request->code_;
+        handler();
+        deferred_reply_code = nullptr;
+        evthr_defer(
+            control_request->thread_, ControlPlaneReplyCallback,
+            control_request);
+      });
+  if (err != nullptr) {
+    delete control_request;
+    evhtp_request_resume(req);
+    EVBufferAddErrorJson(req->buffer_out, err);
+    evhtp_send_reply(req, EVHTP_RES_SERVUNAVAIL);
+    TRITONSERVER_ErrorDelete(err);
+  }
+}
+
+void
+HTTPAPIServer::ControlPlaneReplyCallback(evthr_t* thr, void* arg, void* shared)
+{
+  ControlPlaneRequest* control_request =
+      reinterpret_cast<ControlPlaneRequest*>(arg);
+
+  evhtp_send_reply(control_request->req_, control_request->code_);
+  evhtp_request_resume(control_request->req_);
+
+  delete control_request;
+}
+
+void
+HTTPAPIServer::TrackLoad(
+    evhtp_request_t* req, InferRequestClass* infer_request)
+{
+  if (load_reporter_ == nullptr) {
+    return;
+  }
+
+  load_reporter_->RequestStarted();
+  infer_request->load_reporter_ = load_reporter_.get();
+  evhtp_headers_add_header(
+      req->headers_out,
+      evhtp_header_new(
+          kEndpointLoadMetricsHeader,
+          load_reporter_->Report()->ToText().c_str(), 1, 1));
+}
+
+void
+HTTPAPIServer::HandleLoad(evhtp_request_t* req)
+{
+  AddContentTypeHeader(req, "application/json");
+  if (req->method != htp_method_GET) {
+    RETURN_AND_RESPOND_WITH_ERR(
+        req, EVHTP_RES_METHNALLOWED, "Method Not Allowed");
+  }
+  if (load_reporter_ == nullptr) {
+    RETURN_AND_RESPOND_WITH_ERR(
+        req, EVHTP_RES_BADREQ, "load reporting is not enabled");
+  }
+
+  std::shared_ptr<const LoadReport> report = load_reporter_->Report();
+  triton::common::TritonJson::Value load_json(
+      triton::common::TritonJson::ValueType::OBJECT);
+  RETURN_AND_RESPOND_IF_ERR(
+      req, load_json.AddDouble("cpu_utilization", report->cpu_utilization_));
+  RETURN_AND_RESPOND_IF_ERR(
+      req,
+      load_json.AddDouble("requests_per_second", report->requests_per_second_));
+  RETURN_AND_RESPOND_IF_ERR(
+      req, load_json.AddDouble("shed_rate", report->shed_per_second_));
+  RETURN_AND_RESPOND_IF_ERR(
+      req, load_json.AddUInt("inflight_requests", report->inflight_requests_));
+  triton::common::TritonJson::Value queue_depth_json(
+      load_json, triton::common::TritonJson::ValueType::OBJECT);
+  for (const auto& depth : report->queue_depth_) {
+    RETURN_AND_RESPOND_IF_ERR(
+        req, queue_depth_json.AddUInt(depth.first.c_str(), depth.second));
+  }
+  RETURN_AND_RESPOND_IF_ERR(
+      req, load_json.Add("queue_depth", std::move(queue_depth_json)));
+
+  triton::common::TritonJson::WriteBuffer buffer;
+  RETURN_AND_RESPOND_IF_ERR(req, load_json.Write(&buffer));
+  evbuffer_add(req->buffer_out, buffer.Base(), buffer.Size());
+  evhtp_send_reply(req, EVHTP_RES_OK);
+}
+
 void
 HTTPAPIServer::Handle(evhtp_request_t* req)
 {
   LOG_VERBOSE(1) << "HTTP request: " << req->method << " "
                  << req->uri->path->full;
 
+  if (std::string(req->uri->path->full) == "/v2/load") {
+    HandleLoad(req);
+    return;
+  }
   if (std::string(req->uri->path->full) == "/v2/models/stats") {
     // model statistics
-    HandleModelStats(req);
+    HandleControlPlane(req, [this, req] { HandleModelStats(req); });
     return;
   }
   if (std::string(req->uri->path->full) == "/v2/logging") {
@@ -4420,7 +5021,9 @@ HTTPAPIServer::Handle(evhtp_request_t* req)
       return;
     } else if (kind == "stats") {
       // model statistics
-      HandleModelStats(req, model_name, version);
+      HandleControlPlane(req, [this, req, model_name, version] {
+        HandleModelStats(req, model_name, version);
+      });
       return;
     } else if (kind == "trace/setting") {
       // Trace with specific model, there is no specification on versioning
@@ -4449,14 +5052,38 @@ HTTPAPIServer::Handle(evhtp_request_t* req)
   } else if (RE2::FullMatch(
                  std::string(req->uri->path->full), systemsharedmemory_regex_,
                  &region, &action)) {
-    // system shared memory
-    HandleSystemSharedMemory(req, region, action);
+    // system shared memory, only the status is handled inline
+    if (action == "status") {
+      HandleSystemSharedMemory(req, region, action);
+    } else {
+      HandleControlPlane(req, [this, req, region, action] {
+        HandleSystemSharedMemory(req, region, action);
+      });
+    }
     return;
   } else if (RE2::FullMatch(
                  std::string(req->uri->path->full), cudasharedmemory_regex_,
                  &region, &action)) {
-    // cuda shared memory
-    HandleCudaSharedMemory(req, region, action);
+    // cuda shared memory, only the status is handled inline
+    if (action == "status") {
+      HandleCudaSharedMemory(req, region, action);
+    } else {
+      HandleControlPlane(req, [this, req, region, action] {
+        HandleCudaSharedMemory(req, region, action);
+      });
+    }
+    return;
+  } else if (RE2::FullMatch(
+                 std::string(req->uri->path->full), sharedmemoryring_regex_,
+                 &region, &action)) {
+    // shared memory ring, only the status is handled inline
+    if (action == "status") {
+      HandleSharedMemoryRing(req, region, action);
+    } else {
+      HandleControlPlane(req, [this, req, region, action] {
+        HandleSharedMemoryRing(req, region, action);
+      });
+    }
     return;
   } else if (RE2::FullMatch(
                  std::string(req->uri->path->full), modelcontrol_regex_,
@@ -4466,12 +5093,19 @@ HTTPAPIServer::Handle(evhtp_request_t* req)
       HandleRepositoryIndex(req, repo_name);
       return;
     } else if (kind.find("models", 0) == 0) {
-      HandleRepositoryControl(req, repo_name, model_name, action);
+      HandleControlPlane(req, [this, req, repo_name, model_name, action] {
+        HandleRepositoryControl(req, repo_name, model_name, action);
+      });
       return;
     }
-  } else if (RE2::FullMatch(std::string(req->uri->path->full), trace_regex_)) {
-    // trace request on global settings
-    HandleTrace(req);
+  } else if (RE2::FullMatch(
+                 std::string(req->uri->path->full), trace_regex_, &kind)) {
+    if (kind == "recorder") {
+      HandleTraceRecorder(req);
+    } else {
+      // trace request on global settings
+      HandleTrace(req);
+    }
     return;
   }
 
@@ -4484,14 +5118,34 @@ TRITONSERVER_Error*
 HTTPAPIServer::Create(
     const std::shared_ptr<TRITONSERVER_Server>& server,
     triton::server::TraceManager* trace_manager,
-    const std::shared_ptr<SharedMemoryManager>& shm_manager, const int32_t port,
-    const bool reuse_port, const std::string& address,
+    const std::shared_ptr<SharedMemoryManager>& shm_manager,
+    const std::shared_ptr<ControlPlaneExecutor>& control_plane_executor,
+    const std::shared_ptr<LoadReporter>& load_reporter,
+    const std::shared_ptr<InferRequestPool>& request_pool,
+    const std::shared_ptr<SharedMemoryRingServer>& shm_ring_server,
+    const int32_t port, const bool reuse_port, const std::string& address,
     const std::string& header_forward_pattern, const int thread_cnt,
+    const size_t generate_response_buffer_bytes,
+    const uint32_t generate_response_buffer_count, const bool stage_metrics,
     std::unique_ptr<HTTPServer>* http_server)
 {
+  // The buffered responses are only accounted when they are limited.
+  std::shared_ptr<ResponseBufferBudget> generate_buffer_budget;
+  if ((generate_response_buffer_bytes != 0) ||
+      (generate_response_buffer_count != 0)) {
+    generate_buffer_budget.reset(new ResponseBufferBudget(
+        "http", generate_response_buffer_bytes,
+        generate_response_buffer_count));
+  }
+  std::shared_ptr<FrontendStageMetrics> frontend_stage_metrics;
+  if (stage_metrics) {
+    frontend_stage_metrics = std::make_shared<FrontendStageMetrics>("http");
+  }
   http_server->reset(new HTTPAPIServer(
       server, trace_manager, shm_manager, port, reuse_port, address,
-      header_forward_pattern, thread_cnt));
+      header_forward_pattern, thread_cnt, generate_buffer_budget,
+      control_plane_executor, load_reporter, request_pool, shm_ring_server,
+      frontend_stage_metrics));
 
   const std::string addr = address + ":" + std::to_string(port);
   LOG_INFO << "Started HTTPService at " << addr;
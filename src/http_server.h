@@ -28,6 +28,7 @@
 #include <evhtp/evhtp.h>
 #include <re2/re2.h>
 
+#include <functional>
 #include <list>
 #include <map>
 #include <memory>
@@ -35,10 +36,17 @@
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "common.h"
+#include "control_plane_executor.h"
 #include "data_compressor.h"
+#include "frontend_stage_metrics.h"
+#include "infer_request_pool.h"
+#include "load_reporter.h"
+#include "response_buffer_budget.h"
 #include "shared_memory_manager.h"
+#include "shared_memory_ring_server.h"
 #include "tracer.h"
 #include "triton/common/logging.h"
 #include "triton/core/tritonserver.h"
@@ -149,8 +157,14 @@ class HTTPAPIServer : public HTTPServer {
       const std::shared_ptr<TRITONSERVER_Server>& server,
       triton::server::TraceManager* trace_manager,
       const std::shared_ptr<SharedMemoryManager>& smb_manager,
+      const std::shared_ptr<ControlPlaneExecutor>& control_plane_executor,
+      const std::shared_ptr<LoadReporter>& load_reporter,
+      const std::shared_ptr<InferRequestPool>& request_pool,
+      const std::shared_ptr<SharedMemoryRingServer>& shm_ring_server,
       const int32_t port, const bool reuse_port, const std::string& address,
       const std::string& header_forward_pattern, const int thread_cnt,
+      const size_t generate_response_buffer_bytes,
+      const uint32_t generate_response_buffer_count, const bool stage_metrics,
       std::unique_ptr<HTTPServer>* http_server);
 
   virtual ~HTTPAPIServer();
@@ -173,6 +187,14 @@ class HTTPAPIServer : public HTTPServer {
       evbuffer* evbuffer_;
       char* cuda_ipc_handle_;
 
+      // For outputs in a shared memory pool, the pool that the output is
+      // allocated in, and the allocation. 'byte_size_' is then the
+      // maximum size of the output, or 0 if there is none.
+      SharedMemoryPool* pool_ = nullptr;
+      SharedMemoryManager::Reference pool_reference_;
+      size_t pool_offset_ = 0;
+      uint64_t pool_lease_ = 0;
+
       // For non-shared memory
       OutputInfo(Kind k, uint32_t class_cnt)
           : kind_(k), class_cnt_(class_cnt), evbuffer_(nullptr)
@@ -207,6 +229,10 @@ class HTTPAPIServer : public HTTPServer {
     AllocPayload() : default_output_kind_(OutputInfo::Kind::JSON){};
     std::unordered_map<std::string, OutputInfo*> output_map_;
     AllocPayload::OutputInfo::Kind default_output_kind_;
+
+    // The allocations of the outputs in shared memory pools, released
+    // if the response isn't sent to the client.
+    SharedMemoryPoolAllocations pool_allocations_;
   };
 
   // Object associated with an inference request. This persists
@@ -221,13 +247,18 @@ class HTTPAPIServer : public HTTPServer {
     explicit InferRequestClass(
         TRITONSERVER_Server* server, evhtp_request_t* req,
         DataCompressor::Type response_compression_type);
-    virtual ~InferRequestClass() = default;
+    virtual ~InferRequestClass();
 
     evhtp_request_t* EvHtpRequest() const { return req_; }
 
     static void InferRequestComplete(
         TRITONSERVER_InferenceRequest* request, const uint32_t flags,
         void* userp);
+    // Release callback of the requests of an InferRequestPool, 'userp'
+    // is the InferRequestPool::Entry of the request.
+    static void PooledInferRequestComplete(
+        TRITONSERVER_InferenceRequest* request, const uint32_t flags,
+        void* userp);
     static void InferResponseComplete(
         TRITONSERVER_InferenceResponse* response, const uint32_t flags,
         void* userp);
@@ -241,8 +272,47 @@ class HTTPAPIServer : public HTTPServer {
 
     uint32_t IncrementResponseCount();
 
+    // Records a response that failed with 'err' in the load reporter and
+    // the trace of the request.
+    void RecordResponseError(TRITONSERVER_Error* err);
+
+    // Capture the timestamp of the frontend 'stage' of the request. The
+    // timestamp is recorded to the trace of the request and kept for the
+    // 'Server-Timing' header and the stage metrics if they are reported.
+    void CaptureStage(const FrontendStage stage);
+    void CaptureStage(const FrontendStage stage, const uint64_t timestamp_ns);
+
+    // Return the CPU time of the calling thread to pass to AddCpu() if
+    // the stage metrics are reported, 0 otherwise.
+    uint64_t CpuStart() const;
+    // Add the CPU time of the calling thread since 'start_ns' to the
+    // frontend CPU time of the request.
+    void AddCpu(const uint64_t start_ns);
+    // Capture the send of the reply to the request and observe the
+    // stages of the request. Must be called after the reply is sent.
+    void ReplySent();
+
     // Only used if tracing enabled
     std::shared_ptr<TraceManager::Trace> trace_;
+    // Whether the 'Server-Timing' header is added to the response and
+    // the timestamps it and the stage metrics are formed from, only used
+    // if tracing enabled.
+    bool server_timing_ = false;
+    FrontendTimestamps stage_timestamps_;
+    // The metrics the stages of the request are observed by, the model
+    // of the request and the CPU time in nanoseconds the frontend threads
+    // spent on the request. nullptr if not reported.
+    FrontendStageMetrics* stage_metrics_ = nullptr;
+    std::string model_name_;
+    uint64_t cpu_ns_ = 0;
+
+    // Tracks the request until its destruction if load reporting is
+    // enabled, nullptr otherwise.
+    LoadReporter* load_reporter_ = nullptr;
+
+    // Whether the request sets parameters that are passed to the model
+    // as parameters of the inference request.
+    bool custom_parameters_ = false;
 
     AllocPayload alloc_payload_;
 
@@ -251,6 +321,11 @@ class HTTPAPIServer : public HTTPServer {
     // lifetime of the request.
     std::list<std::vector<char>> serialized_data_;
 
+    // The shared memory regions used by the request's inputs and outputs.
+    // Holding them keeps a region that is unregistered while the request
+    // is in flight mapped until the request is destroyed.
+    std::vector<SharedMemoryManager::Reference> shm_references_;
+
    protected:
     TRITONSERVER_Server* server_;
     evhtp_request_t* req_;
@@ -269,10 +344,12 @@ class HTTPAPIServer : public HTTPServer {
         DataCompressor::Type response_compression_type,
         const MappingSchema* request_schema,
         const MappingSchema* response_schema, bool streaming,
-        TRITONSERVER_InferenceRequest* triton_request)
+        TRITONSERVER_InferenceRequest* triton_request,
+        const std::shared_ptr<ResponseBufferBudget>& buffer_budget = nullptr)
         : InferRequestClass(server, req, response_compression_type),
           request_schema_(request_schema), response_schema_(response_schema),
-          streaming_(streaming), triton_request_(triton_request)
+          streaming_(streaming), triton_request_(triton_request),
+          buffer_budget_(buffer_budget)
     {
     }
     virtual ~GenerateRequestClass();
@@ -291,7 +368,17 @@ class HTTPAPIServer : public HTTPServer {
     TRITONSERVER_Error* FinalizeResponse(
         TRITONSERVER_InferenceResponse* response) override;
     void AddErrorJson(TRITONSERVER_Error* error);
+    // Returns a new buffer holding 'error' as an event, takes ownership
+    // of 'error'.
+    evbuffer* ErrorJsonBuffer(TRITONSERVER_Error* error);
     void StartResponse(evhtp_res code);
+    // Queues 'buffer' to be sent, or drops it if the response buffer
+    // budget has been exceeded.
+    void EnqueueResponse(evbuffer* buffer);
+    // Reports the bytes buffered for the request, both queued and in
+    // the connection output buffer. Returns true if the response
+    // buffer budget has just been exceeded.
+    bool UpdateBufferedResponses();
 
     // [DLIS-5551] currently always performs basic conversion, only maps schema
     // of EXACT_MAPPING kind. MAPPING_SCHEMA and upcoming kinds are for
@@ -350,6 +437,17 @@ class HTTPAPIServer : public HTTPServer {
     std::mutex res_mtx_;
     std::queue<evbuffer*> pending_http_responses_;
     bool end_{false};
+
+    // Bounds the responses that the request buffers while the client
+    // reads slower than the model produces, nullptr if unbounded. Once
+    // exceeded, the pending and all later responses are dropped and
+    // an error is sent in their place. Guarded by 'res_mtx_'.
+    std::shared_ptr<ResponseBufferBudget> buffer_budget_;
+    size_t pending_bytes_{0};
+    size_t reported_bytes_{0};
+    uint32_t reported_count_{0};
+    bool budget_exceeded_{false};
+    bool budget_error_sent_{false};
   };
 
  protected:
@@ -358,7 +456,16 @@ class HTTPAPIServer : public HTTPServer {
       triton::server::TraceManager* trace_manager,
       const std::shared_ptr<SharedMemoryManager>& shm_manager,
       const int32_t port, const bool reuse_port, const std::string& address,
-      const std::string& header_forward_pattern, const int thread_cnt);
+      const std::string& header_forward_pattern, const int thread_cnt,
+      const std::shared_ptr<ResponseBufferBudget>& generate_buffer_budget =
+          nullptr,
+      const std::shared_ptr<ControlPlaneExecutor>& control_plane_executor =
+          nullptr,
+      const std::shared_ptr<LoadReporter>& load_reporter = nullptr,
+      const std::shared_ptr<InferRequestPool>& request_pool = nullptr,
+      const std::shared_ptr<SharedMemoryRingServer>& shm_ring_server =
+          nullptr,
+      const std::shared_ptr<FrontendStageMetrics>& stage_metrics = nullptr);
   virtual void Handle(evhtp_request_t* req) override;
   // [FIXME] extract to "infer" class
   virtual std::unique_ptr<InferRequestClass> CreateInferRequest(
@@ -442,8 +549,22 @@ class HTTPAPIServer : public HTTPServer {
   void HandleCudaSharedMemory(
       evhtp_request_t* req, const std::string& region_name,
       const std::string& action);
+  void HandleSharedMemoryRing(
+      evhtp_request_t* req, const std::string& region_name,
+      const std::string& action);
   void HandleTrace(evhtp_request_t* req, const std::string& model_name = "");
+  void HandleTraceRecorder(evhtp_request_t* req);
   void HandleLogging(evhtp_request_t* req);
+  void HandleLoad(evhtp_request_t* req);
+
+  // Tracks 'infer_request' in the load reporter, if any, and attaches
+  // the latest load report to the response of 'req'.
+  void TrackLoad(evhtp_request_t* req, InferRequestClass* infer_request);
+
+  // Runs 'handler' for 'req' on the control-plane executor, or inline
+  // if there is no executor.
+  void HandleControlPlane(
+      evhtp_request_t* req, std::function<void()>&& handler);
 
   // Text Generation / LLM format
   //'streaming' selects the schema pair to convert request / response.
@@ -495,6 +616,15 @@ class HTTPAPIServer : public HTTPServer {
   static void OKReplyCallback(evthr_t* thr, void* arg, void* shared);
   static void BADReplyCallback(evthr_t* thr, void* arg, void* shared);
 
+  // A request handled by the control-plane executor.
+  struct ControlPlaneRequest {
+    evhtp_request_t* req_;
+    evthr_t* thread_;
+    evhtp_res code_;
+  };
+  static void ControlPlaneReplyCallback(
+      evthr_t* thr, void* arg, void* shared);
+
   std::shared_ptr<TRITONSERVER_Server> server_;
 
   // Storing server metadata as it is consistent during server running
@@ -513,6 +643,7 @@ class HTTPAPIServer : public HTTPServer {
   re2::RE2 modelcontrol_regex_;
   re2::RE2 systemsharedmemory_regex_;
   re2::RE2 cudasharedmemory_regex_;
+  re2::RE2 sharedmemoryring_regex_;
   re2::RE2 trace_regex_;
 
   // [DLIS-5551] currently always performs basic conversion, only maps schema
@@ -524,6 +655,16 @@ class HTTPAPIServer : public HTTPServer {
       new MappingSchema()};
   std::unique_ptr<MappingSchema> generate_stream_request_schema_{
       new MappingSchema()};
+  // Response buffer budget of each generate_stream request.
+  std::shared_ptr<ResponseBufferBudget> generate_buffer_budget_;
+  std::shared_ptr<ControlPlaneExecutor> control_plane_executor_;
+  std::shared_ptr<LoadReporter> load_reporter_;
+  // nullptr if inference requests are not reused.
+  std::shared_ptr<InferRequestPool> request_pool_;
+  // nullptr if shared memory rings are not allowed.
+  std::shared_ptr<SharedMemoryRingServer> shm_ring_server_;
+  // nullptr if the frontend stage metrics are not reported.
+  std::shared_ptr<FrontendStageMetrics> stage_metrics_;
 
   // Provisional definition of generate mapping schema
   // to allow for parameters passing
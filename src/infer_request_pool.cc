@@ -0,0 +1,367 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "infer_request_pool.h"
+
+#include "common.h"
+#include "triton/common/logging.h"
+
+namespace triton { namespace server {
+
+namespace {
+
+// Resets 'irequest' to the state of a new request, except for the
+// parameters that can't be removed. Returns false if the request can't
+// be reused.
+bool
+ResetRequest(TRITONSERVER_InferenceRequest* irequest)
+{
+  bool cancelled = true;
+  TRITONSERVER_Error* err =
+      TRITONSERVER_InferenceRequestIsCancelled(irequest, &cancelled);
+  if ((err == nullptr) && !cancelled) {
+    err = TRITONSERVER_InferenceRequestRemoveAllInputs(irequest);
+  }
+  if ((err == nullptr) && !cancelled) {
+    err = TRITONSERVER_InferenceRequestRemoveAllRequestedOutputs(irequest);
+  }
+  if ((err == nullptr) && !cancelled) {
+    err = TRITONSERVER_InferenceRequestSetId(irequest, "");
+  }
+  if ((err == nullptr) && !cancelled) {
+    err = TRITONSERVER_InferenceRequestSetFlags(irequest, 0);
+  }
+  if ((err == nullptr) && !cancelled) {
+    err = TRITONSERVER_InferenceRequestSetCorrelationId(irequest, 0);
+  }
+  if ((err == nullptr) && !cancelled) {
+    err = TRITONSERVER_InferenceRequestSetPriorityUInt64(irequest, 0);
+  }
+  if ((err == nullptr) && !cancelled) {
+    err = TRITONSERVER_InferenceRequestSetTimeoutMicroseconds(irequest, 0);
+  }
+  if (err != nullptr) {
+    LOG_VERBOSE(1) << "unable to reset pooled inference request: "
+                   << TRITONSERVER_ErrorMessage(err);
+    TRITONSERVER_ErrorDelete(err);
+    return false;
+  }
+
+  return !cancelled;
+}
+
+// Clears the callbacks that the previous user of 'irequest' set, so
+// that they can't be invoked for the next request. Can't be part of
+// ResetRequest() which runs in the release callback itself. Returns
+// false if the request can't be reused.
+bool
+ClearCallbacks(TRITONSERVER_InferenceRequest* irequest)
+{
+  TRITONSERVER_Error* err = TRITONSERVER_InferenceRequestSetReleaseCallback(
+      irequest, nullptr /* request_release_fn */,
+      nullptr /* request_release_userp */);
+  if (err == nullptr) {
+    err = TRITONSERVER_InferenceRequestSetResponseCallback(
+        irequest, nullptr /* response_allocator */,
+        nullptr /* response_allocator_userp */, nullptr /* response_fn */,
+        nullptr /* response_userp */);
+  }
+  if (err != nullptr) {
+    LOG_VERBOSE(1) << "unable to clear pooled inference request callbacks: "
+                   << TRITONSERVER_ErrorMessage(err);
+    TRITONSERVER_ErrorDelete(err);
+    return false;
+  }
+
+  return true;
+}
+
+// Owns the buffer attributes object of a thread.
+struct ThreadBufferAttributes {
+  ~ThreadBufferAttributes()
+  {
+    if (buffer_attributes_ != nullptr) {
+      LOG_TRITONSERVER_ERROR(
+          TRITONSERVER_BufferAttributesDelete(buffer_attributes_),
+          "deleting buffer attributes");
+    }
+  }
+
+  TRITONSERVER_BufferAttributes* buffer_attributes_{nullptr};
+};
+
+void
+DeleteEntry(InferRequestPool::Entry* entry)
+{
+  if (entry->irequest_ != nullptr) {
+    LOG_TRITONSERVER_ERROR(
+        TRITONSERVER_InferenceRequestDelete(entry->irequest_),
+        "deleting pooled inference request");
+  }
+  delete entry;
+}
+
+}  // namespace
+
+class InferRequestPool::ModelPool {
+ public:
+  ModelPool(
+      InferRequestPool* owner, const std::string& model_name,
+      const int64_t model_version)
+      : owner_(owner),
+        hits_(owner->hits_family_, Labels(model_name, model_version)),
+        misses_(owner->misses_family_, Labels(model_name, model_version)),
+        discards_(owner->discards_family_, Labels(model_name, model_version)),
+        idle_gauge_(owner->idle_family_, Labels(model_name, model_version))
+  {
+  }
+
+  ~ModelPool()
+  {
+    for (auto entry : idle_) {
+      DeleteEntry(entry);
+    }
+  }
+
+  // Returns an idle request with its callbacks cleared, or nullptr if
+  // there is none.
+  Entry* Get()
+  {
+    Entry* entry = nullptr;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      if (!idle_.empty()) {
+        entry = idle_.back();
+        idle_.pop_back();
+        idle_gauge_.Set(idle_.size());
+      }
+    }
+    if (entry != nullptr) {
+      if (ClearCallbacks(entry->irequest_)) {
+        hits_.Increment(1);
+      } else {
+        discards_.Increment(1);
+        DeleteEntry(entry);
+        entry = nullptr;
+      }
+    }
+    return entry;
+  }
+
+  // Records a request that had to be created.
+  void Miss() { misses_.Increment(1); }
+
+  void Put(Entry* entry)
+  {
+    bool reuse =
+        entry->reusable_ &&
+        ((std::chrono::steady_clock::now() - entry->created_) <
+         owner_->max_age_) &&
+        ResetRequest(entry->irequest_);
+    if (reuse) {
+      entry->reusable_ = true;
+      entry->userp_ = nullptr;
+      std::lock_guard<std::mutex> lk(mu_);
+      reuse = (idle_.size() < owner_->max_idle_);
+      if (reuse) {
+        idle_.push_back(entry);
+        idle_gauge_.Set(idle_.size());
+      }
+    }
+    if (!reuse) {
+      discards_.Increment(1);
+      DeleteEntry(entry);
+    }
+  }
+
+  // Deletes the idle requests that reached the maximum age.
+  void Trim()
+  {
+    const auto now = std::chrono::steady_clock::now();
+    std::vector<Entry*> expired;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      auto it = idle_.begin();
+      while (it != idle_.end()) {
+        if ((now - (*it)->created_) >= owner_->max_age_) {
+          expired.push_back(*it);
+          it = idle_.erase(it);
+        } else {
+          ++it;
+        }
+      }
+      idle_gauge_.Set(idle_.size());
+    }
+    for (auto entry : expired) {
+      discards_.Increment(1);
+      DeleteEntry(entry);
+    }
+  }
+
+ private:
+  static std::vector<std::pair<std::string, std::string>> Labels(
+      const std::string& model_name, const int64_t model_version)
+  {
+    return {{"model", model_name}, {"version", std::to_string(model_version)}};
+  }
+
+  InferRequestPool* owner_;
+
+  FrontendMetric hits_;
+  FrontendMetric misses_;
+  FrontendMetric discards_;
+  FrontendMetric idle_gauge_;
+
+  std::mutex mu_;
+  std::vector<Entry*> idle_;
+};
+
+InferRequestPool::InferRequestPool(
+    const std::shared_ptr<TRITONSERVER_Server>& server,
+    const uint32_t max_idle, const uint32_t max_age_ms)
+    : server_(server), max_idle_(max_idle), max_age_(max_age_ms),
+      hits_family_(
+          TRITONSERVER_METRIC_KIND_COUNTER, "nv_inference_request_pool_hits",
+          "Number of inference requests reused from the request pool"),
+      misses_family_(
+          TRITONSERVER_METRIC_KIND_COUNTER, "nv_inference_request_pool_misses",
+          "Number of inference requests created because the request pool "
+          "was empty"),
+      discards_family_(
+          TRITONSERVER_METRIC_KIND_COUNTER,
+          "nv_inference_request_pool_discards",
+          "Number of inference requests deleted instead of returned to the "
+          "request pool"),
+      idle_family_(
+          TRITONSERVER_METRIC_KIND_GAUGE, "nv_inference_request_pool_idle",
+          "Number of idle inference requests in the request pool"),
+      exiting_(false)
+{
+  thread_ = std::thread([this] {
+    std::unique_lock<std::mutex> lk(mu_);
+    while (!exiting_) {
+      cv_.wait_for(lk, max_age_);
+      if (!exiting_) {
+        lk.unlock();
+        Trim();
+        lk.lock();
+      }
+    }
+  });
+}
+
+InferRequestPool::~InferRequestPool()
+{
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    exiting_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+  pools_.clear();
+}
+
+TRITONSERVER_Error*
+InferRequestPool::Acquire(
+    const std::string& model_name, const int64_t model_version,
+    Entry** entry)
+{
+  ModelPool* pool = nullptr;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = pools_.find(model_name);
+    if (it != pools_.end()) {
+      auto vit = it->second.find(model_version);
+      if (vit != it->second.end()) {
+        pool = vit->second.get();
+      }
+    }
+  }
+
+  if (pool != nullptr) {
+    *entry = pool->Get();
+    if (*entry != nullptr) {
+      return nullptr;  // success
+    }
+  }
+
+  std::unique_ptr<Entry> new_entry(new Entry());
+  RETURN_IF_ERR(TRITONSERVER_InferenceRequestNew(
+      &new_entry->irequest_, server_.get(), model_name.c_str(),
+      model_version));
+  new_entry->created_ = std::chrono::steady_clock::now();
+
+  // Only create the pool of a model once a request could be created for
+  // it, requests for unknown models must not grow the pools.
+  if (pool == nullptr) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto& model_pool = pools_[model_name][model_version];
+    if (model_pool == nullptr) {
+      model_pool.reset(new ModelPool(this, model_name, model_version));
+    }
+    pool = model_pool.get();
+  }
+  pool->Miss();
+  new_entry->pool_ = pool;
+  *entry = new_entry.release();
+  return nullptr;  // success
+}
+
+void
+InferRequestPool::Release(Entry* entry)
+{
+  entry->pool_->Put(entry);
+}
+
+void
+InferRequestPool::Trim()
+{
+  std::vector<ModelPool*> pools;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    for (const auto& model : pools_) {
+      for (const auto& version : model.second) {
+        pools.push_back(version.second.get());
+      }
+    }
+  }
+  for (auto pool : pools) {
+    pool->Trim();
+  }
+}
+
+TRITONSERVER_Error*
+ThreadLocalBufferAttributes(TRITONSERVER_BufferAttributes** buffer_attributes)
+{
+  thread_local ThreadBufferAttributes attributes;
+  if (attributes.buffer_attributes_ == nullptr) {
+    RETURN_IF_ERR(
+        TRITONSERVER_BufferAttributesNew(&attributes.buffer_attributes_));
+  }
+  *buffer_attributes = attributes.buffer_attributes_;
+  return nullptr;  // success
+}
+
+}}  // namespace triton::server
@@ -0,0 +1,139 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frontend_metrics.h"
+#include "triton/core/tritonserver.h"
+
+namespace triton { namespace server {
+
+//
+// InferRequestPool
+//
+// Per-model pools of TRITONSERVER_InferenceRequest objects. Instead of
+// deleting a request once the core releases it, the frontends return
+// it to the pool where it is reset for the next request of the same
+// model, which saves the creation and destruction of the request for
+// models with a fixed signature.
+//
+// A pooled request holds a reference on the model version it was
+// created for. So that pooled requests neither delay the unload of a
+// model nor keep sending requests to a version that is no longer the
+// latest, a request is only reused for 'max_age_ms' after its
+// creation, idle requests older than that are deleted in the
+// background.
+//
+class InferRequestPool {
+ public:
+  class ModelPool;
+
+  // A request acquired from the pool.
+  struct Entry {
+    TRITONSERVER_InferenceRequest* irequest_{nullptr};
+
+    // Whether the request can be reset and reused when it is released.
+    // Must be cleared by the frontend when it sets state that cannot
+    // be reset, such as custom request parameters.
+    bool reusable_{true};
+
+    // Free for the frontend, e.g. to own data referenced by the request
+    // until it is released. Must be cleaned up by the frontend before
+    // releasing the entry.
+    void* userp_{nullptr};
+
+   private:
+    friend class InferRequestPool;
+    ModelPool* pool_{nullptr};
+    std::chrono::steady_clock::time_point created_;
+  };
+
+  /// Create a pool.
+  /// \param server The server that creates the requests.
+  /// \param max_idle The maximum number of idle requests kept for each
+  /// model version, at least 1.
+  /// \param max_age_ms The duration a request is reused for.
+  InferRequestPool(
+      const std::shared_ptr<TRITONSERVER_Server>& server,
+      const uint32_t max_idle, const uint32_t max_age_ms = 1000);
+
+  ~InferRequestPool();
+
+  /// Acquire a request for a model version, either a reset request of
+  /// the pool or a new request. The returned entry must be passed to
+  /// Release() once the request is released by the core, or if it is
+  /// not issued.
+  TRITONSERVER_Error* Acquire(
+      const std::string& model_name, const int64_t model_version,
+      Entry** entry);
+
+  /// Return a request to the pool, or delete it if it can't be reused.
+  /// Thread-safe, in particular callable from the request release
+  /// callback.
+  static void Release(Entry* entry);
+
+ private:
+  void Trim();
+
+  std::shared_ptr<TRITONSERVER_Server> server_;
+  const uint32_t max_idle_;
+  const std::chrono::milliseconds max_age_;
+
+  // Must outlive the model pools and their metrics.
+  FrontendMetricFamily hits_family_;
+  FrontendMetricFamily misses_family_;
+  FrontendMetricFamily discards_family_;
+  FrontendMetricFamily idle_family_;
+
+  // The model pools by model name and requested version. Model pools
+  // are never removed so that the entries can refer to them.
+  std::mutex mu_;
+  std::map<std::string, std::map<int64_t, std::unique_ptr<ModelPool>>>
+      pools_;
+
+  std::condition_variable cv_;
+  bool exiting_;
+  std::thread thread_;
+};
+
+/// Get the buffer attributes object of the calling thread, created on
+/// first use. The attributes are copied when appending input data with
+/// TRITONSERVER_InferenceRequestAppendInputDataWithBufferAttributes, so
+/// the object can be reused for every input, provided all its
+/// attributes are set each time. The object must not be deleted.
+TRITONSERVER_Error* ThreadLocalBufferAttributes(
+    TRITONSERVER_BufferAttributes** buffer_attributes);
+
+}}  // namespace triton::server
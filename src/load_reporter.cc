@@ -0,0 +1,215 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "load_reporter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#include "triton/common/logging.h"
+
+namespace triton { namespace server {
+
+namespace {
+
+// Returns the value of the label 'name' of a Prometheus sample line,
+// or an empty string if the sample doesn't have the label.
+std::string
+LabelValue(const std::string& line, const std::string& name)
+{
+  const std::string key = name + "=\"";
+  size_t begin = line.find(key);
+  if (begin == std::string::npos) {
+    return "";
+  }
+  begin += key.size();
+  const size_t end = line.find('"', begin);
+  if (end == std::string::npos) {
+    return "";
+  }
+  return line.substr(begin, end - begin);
+}
+
+// Returns the value of a Prometheus sample line.
+double
+SampleValue(const std::string& line)
+{
+  const size_t pos = line.find_last_of(' ');
+  if (pos == std::string::npos) {
+    return 0;
+  }
+  try {
+    return std::stod(line.substr(pos + 1));
+  }
+  catch (const std::exception&) {
+    return 0;
+  }
+}
+
+bool
+StartsWith(const std::string& str, const char* prefix)
+{
+  return str.compare(0, strlen(prefix), prefix) == 0;
+}
+
+}  // namespace
+
+std::string
+LoadReport::ToText() const
+{
+  std::ostringstream text;
+  text << "TEXT cpu_utilization=" << cpu_utilization_
+       << ", rps_fractional=" << requests_per_second_
+       << ", named_metrics.inflight_requests=" << inflight_requests_
+       << ", named_metrics.shed_rate=" << shed_per_second_;
+  for (const auto& depth : queue_depth_) {
+    // Skip the names that can't be represented in the format.
+    if (depth.first.find_first_of(",= ") != std::string::npos) {
+      continue;
+    }
+    text << ", named_metrics.queue_depth." << depth.first << "="
+         << depth.second;
+  }
+  return text.str();
+}
+
+LoadReporter::LoadReporter(
+    const std::shared_ptr<TRITONSERVER_Server>& server,
+    const uint32_t interval_ms)
+    : server_(server), interval_ms_(std::max(interval_ms, 1u)), inflight_(0),
+      started_(0), shed_(0), last_started_(0), last_shed_(0),
+      last_refresh_(std::chrono::steady_clock::now()),
+      report_(std::make_shared<LoadReport>()), exiting_(false)
+{
+  thread_ = std::thread([this]() {
+    std::unique_lock<std::mutex> lock(mu_);
+    while (!exiting_) {
+      cv_.wait_for(lock, std::chrono::milliseconds(interval_ms_));
+      if (!exiting_) {
+        lock.unlock();
+        Refresh();
+        lock.lock();
+      }
+    }
+  });
+}
+
+LoadReporter::~LoadReporter()
+{
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    exiting_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void
+LoadReporter::RequestStarted()
+{
+  inflight_++;
+  started_++;
+}
+
+void
+LoadReporter::RequestDone()
+{
+  inflight_--;
+}
+
+void
+LoadReporter::RequestShed()
+{
+  shed_++;
+}
+
+std::shared_ptr<const LoadReport>
+LoadReporter::Report() const
+{
+  return std::atomic_load(&report_);
+}
+
+void
+LoadReporter::Refresh()
+{
+  std::shared_ptr<LoadReport> report = std::make_shared<LoadReport>();
+
+  const auto now = std::chrono::steady_clock::now();
+  const double elapsed_secs =
+      std::chrono::duration<double>(now - last_refresh_).count();
+  const uint64_t started = started_;
+  const uint64_t shed = shed_;
+  if (elapsed_secs > 0) {
+    report->requests_per_second_ = (started - last_started_) / elapsed_secs;
+    report->shed_per_second_ = (shed - last_shed_) / elapsed_secs;
+  }
+  last_refresh_ = now;
+  last_started_ = started;
+  last_shed_ = shed;
+  report->inflight_requests_ = inflight_;
+
+  // The queue depth and the CPU utilization are tracked by the metrics
+  // of the server, which are only available if metrics are enabled.
+  TRITONSERVER_Metrics* metrics = nullptr;
+  TRITONSERVER_Error* err = TRITONSERVER_ServerMetrics(server_.get(), &metrics);
+  if (err == nullptr) {
+    const char* base;
+    size_t byte_size;
+    err = TRITONSERVER_MetricsFormatted(
+        metrics, TRITONSERVER_METRIC_PROMETHEUS, &base, &byte_size);
+    if (err == nullptr) {
+      std::istringstream lines(std::string(base, byte_size));
+      std::string line;
+      while (std::getline(lines, line)) {
+        if (StartsWith(line, "nv_inference_pending_request_count{")) {
+          const std::string model = LabelValue(line, "model");
+          if (!model.empty()) {
+            report->queue_depth_[model] +=
+                static_cast<uint64_t>(SampleValue(line));
+          }
+        } else if (StartsWith(line, "nv_cpu_utilization ")) {
+          report->cpu_utilization_ = SampleValue(line);
+        }
+      }
+    }
+  }
+  if (err != nullptr) {
+    LOG_VERBOSE(1) << "unable to collect the load of the server: "
+                   << TRITONSERVER_ErrorMessage(err);
+    TRITONSERVER_ErrorDelete(err);
+  }
+  if (metrics != nullptr) {
+    TRITONSERVER_MetricsDelete(metrics);
+  }
+
+  std::atomic_store(
+      &report_, std::shared_ptr<const LoadReport>(std::move(report)));
+}
+
+}}  // namespace triton::server
@@ -0,0 +1,119 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "triton/core/tritonserver.h"
+
+namespace triton { namespace server {
+
+//
+// A snapshot of the load of the server, reported to load balancers so
+// that they can weigh the replicas by their load.
+//
+struct LoadReport {
+  // The CPU utilization of the host, between 0 and 1.
+  double cpu_utilization_{0};
+  // The inference requests received and shed per second since the
+  // previous snapshot. A request is shed if it is rejected with an
+  // 'unavailable' error, e.g. because the queue of the model is full.
+  double requests_per_second_{0};
+  double shed_per_second_{0};
+  // The inference requests received by the frontends and not completed.
+  uint64_t inflight_requests_{0};
+  // The requests waiting in the queue of each model, by model name.
+  std::map<std::string, uint64_t> queue_depth_;
+
+  // The report in the ORCA native text format used by the
+  // 'endpoint-load-metrics' header, e.g.
+  // "TEXT cpu_utilization=0.3, named_metrics.inflight_requests=5".
+  std::string ToText() const;
+};
+
+//
+// LoadReporter
+//
+// Tracks the inference requests of the frontends and periodically
+// takes a snapshot of the load of the server. The frontends attach
+// the latest snapshot to their responses and serve it on request.
+//
+class LoadReporter {
+ public:
+  /// Create a reporter.
+  /// \param server The server whose metrics provide the queue depth of
+  /// the models and the CPU utilization.
+  /// \param interval_ms The interval between snapshots, at least 1.
+  LoadReporter(
+      const std::shared_ptr<TRITONSERVER_Server>& server,
+      const uint32_t interval_ms);
+
+  ~LoadReporter();
+
+  uint32_t IntervalMs() const { return interval_ms_; }
+
+  /// Record the start and completion of an inference request. A shed
+  /// request must still be recorded as done.
+  void RequestStarted();
+  void RequestDone();
+  void RequestShed();
+
+  /// \return the latest snapshot, never nullptr.
+  std::shared_ptr<const LoadReport> Report() const;
+
+ private:
+  void Refresh();
+
+  std::shared_ptr<TRITONSERVER_Server> server_;
+  const uint32_t interval_ms_;
+
+  std::atomic<uint64_t> inflight_;
+  std::atomic<uint64_t> started_;
+  std::atomic<uint64_t> shed_;
+
+  // Only accessed by the reporting thread.
+  uint64_t last_started_;
+  uint64_t last_shed_;
+  std::chrono::steady_clock::time_point last_refresh_;
+
+  // Accessed with the atomic operations of std::shared_ptr.
+  std::shared_ptr<const LoadReport> report_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool exiting_;
+  std::thread thread_;
+};
+
+}}  // namespace triton::server
@@ -55,6 +55,11 @@
 
 #include "command_line_parser.h"
 #include "common.h"
+#include "control_plane_executor.h"
+#include "infer_request_pool.h"
+#include "load_reporter.h"
+#include "shared_memory_fd_server.h"
+#include "shared_memory_ring_server.h"
 #include "shared_memory_manager.h"
 #include "tracer.h"
 #include "triton/common/logging.h"
@@ -109,11 +114,15 @@ StartGrpcService(
     std::unique_ptr<triton::server::grpc::Server>* service,
     const std::shared_ptr<TRITONSERVER_Server>& server,
     triton::server::TraceManager* trace_manager,
-    const std::shared_ptr<triton::server::SharedMemoryManager>& shm_manager)
+    const std::shared_ptr<triton::server::SharedMemoryManager>& shm_manager,
+    const std::shared_ptr<triton::server::ControlPlaneExecutor>&
+        control_plane_executor,
+    const std::shared_ptr<triton::server::LoadReporter>& load_reporter,
+    const std::shared_ptr<triton::server::InferRequestPool>& request_pool)
 {
   TRITONSERVER_Error* err = triton::server::grpc::Server::Create(
-      server, trace_manager, shm_manager, g_triton_params.grpc_options_,
-      service);
+      server, trace_manager, shm_manager, control_plane_executor,
+      load_reporter, request_pool, g_triton_params.grpc_options_, service);
   if (err == nullptr) {
     err = (*service)->Start();
   }
@@ -132,13 +141,23 @@ StartHttpService(
     std::unique_ptr<triton::server::HTTPServer>* service,
     const std::shared_ptr<TRITONSERVER_Server>& server,
     triton::server::TraceManager* trace_manager,
-    const std::shared_ptr<triton::server::SharedMemoryManager>& shm_manager)
+    const std::shared_ptr<triton::server::SharedMemoryManager>& shm_manager,
+    const std::shared_ptr<triton::server::ControlPlaneExecutor>&
+        control_plane_executor,
+    const std::shared_ptr<triton::server::LoadReporter>& load_reporter,
+    const std::shared_ptr<triton::server::InferRequestPool>& request_pool,
+    const std::shared_ptr<triton::server::SharedMemoryRingServer>&
+        shm_ring_server)
 {
   TRITONSERVER_Error* err = triton::server::HTTPAPIServer::Create(
-      server, trace_manager, shm_manager, g_triton_params.http_port_,
+      server, trace_manager, shm_manager, control_plane_executor,
+      load_reporter, request_pool, shm_ring_server, g_triton_params.http_port_,
       g_triton_params.reuse_http_port_, g_triton_params.http_address_,
       g_triton_params.http_forward_header_pattern_,
-      g_triton_params.http_thread_cnt_, service);
+      g_triton_params.http_thread_cnt_,
+      g_triton_params.http_generate_response_buffer_bytes_,
+      g_triton_params.http_generate_response_buffer_count_,
+      g_triton_params.http_stage_metrics_, service);
   if (err == nullptr) {
     err = (*service)->Start();
   }
@@ -223,7 +242,13 @@ bool
 StartEndpoints(
     const std::shared_ptr<TRITONSERVER_Server>& server,
     triton::server::TraceManager* trace_manager,
-    const std::shared_ptr<triton::server::SharedMemoryManager>& shm_manager)
+    const std::shared_ptr<triton::server::SharedMemoryManager>& shm_manager,
+    const std::shared_ptr<triton::server::ControlPlaneExecutor>&
+        control_plane_executor,
+    const std::shared_ptr<triton::server::LoadReporter>& load_reporter,
+    const std::shared_ptr<triton::server::InferRequestPool>& request_pool,
+    const std::shared_ptr<triton::server::SharedMemoryRingServer>&
+        shm_ring_server)
 {
 #ifdef _WIN32
   WSADATA wsaData;
@@ -238,8 +263,9 @@ StartEndpoints(
 #ifdef TRITON_ENABLE_GRPC
   // Enable GRPC endpoints if requested...
   if (g_triton_params.allow_grpc_) {
-    TRITONSERVER_Error* err =
-        StartGrpcService(&g_grpc_service, server, trace_manager, shm_manager);
+    TRITONSERVER_Error* err = StartGrpcService(
+        &g_grpc_service, server, trace_manager, shm_manager,
+        control_plane_executor, load_reporter, request_pool);
     if (err != nullptr) {
       LOG_TRITONSERVER_ERROR(err, "failed to start GRPC service");
       return false;
@@ -250,8 +276,9 @@ StartEndpoints(
 #ifdef TRITON_ENABLE_HTTP
   // Enable HTTP endpoints if requested...
   if (g_triton_params.allow_http_) {
-    TRITONSERVER_Error* err =
-        StartHttpService(&g_http_service, server, trace_manager, shm_manager);
+    TRITONSERVER_Error* err = StartHttpService(
+        &g_http_service, server, trace_manager, shm_manager,
+        control_plane_executor, load_reporter, request_pool, shm_ring_server);
     if (err != nullptr) {
       LOG_TRITONSERVER_ERROR(err, "failed to start HTTP service");
       return false;
@@ -395,6 +422,21 @@ StartTracing(triton::server::TraceManager** trace_manager)
     *trace_manager = nullptr;
     return false;
   }
+
+  // Log the timelines of the flight recorder on SIGUSR2.
+  triton::server::TraceManager* manager = *trace_manager;
+  err = triton::server::RegisterDumpSignalHandler([manager] {
+    std::stringstream timelines;
+    TRITONSERVER_Error* dump_err = manager->DumpRecorder(timelines);
+    if (dump_err != nullptr) {
+      LOG_TRITONSERVER_ERROR(dump_err, "failed to dump flight recorder");
+      return;
+    }
+    LOG_INFO << "Flight recorder: " << timelines.str();
+  });
+  if (err != nullptr) {
+    LOG_TRITONSERVER_ERROR(err, "failed to register flight recorder dump");
+  }
 #endif  // TRITON_ENABLE_TRACING
 
   return true;
@@ -406,6 +448,9 @@ StopTracing(triton::server::TraceManager** trace_manager)
 #ifdef TRITON_ENABLE_TRACING
   // We assume that at this point Triton has been stopped gracefully,
   // so can delete the trace manager to finalize the output.
+  LOG_TRITONSERVER_ERROR(
+      triton::server::RegisterDumpSignalHandler(nullptr),
+      "failed to unregister flight recorder dump");
   delete (*trace_manager);
   *trace_manager = nullptr;
 #endif  // TRITON_ENABLE_TRACING
@@ -460,7 +505,15 @@ main(int argc, char** argv)
   triton::server::TraceManager* trace_manager;
 
   // Manager for shared memory blocks.
-  auto shm_manager = std::make_shared<triton::server::SharedMemoryManager>();
+  auto shm_manager = std::make_shared<triton::server::SharedMemoryManager>(
+      g_triton_params.shared_memory_hugetlbfs_dirs_);
+
+  // Executor for the control-plane requests of the endpoints, e.g. model
+  // load / unload, so that they don't hold up the inference threads.
+  auto control_plane_executor =
+      std::make_shared<triton::server::ControlPlaneExecutor>(
+          g_triton_params.control_plane_thread_count_,
+          g_triton_params.control_plane_queue_size_);
 
   // Create the server...
   TRITONSERVER_Server* server_ptr = nullptr;
@@ -483,8 +536,46 @@ main(int argc, char** argv)
     exit(1);
   }
 
+  // Reporter of the load of the server to load balancers, if enabled.
+  std::shared_ptr<triton::server::LoadReporter> load_reporter;
+  if (g_triton_params.load_reporting_) {
+    load_reporter = std::make_shared<triton::server::LoadReporter>(
+        server, g_triton_params.load_report_interval_ms_);
+  }
+
+  // Pool of inference requests reused by the endpoints, if enabled.
+  std::shared_ptr<triton::server::InferRequestPool> request_pool;
+  if (g_triton_params.infer_request_pool_size_ > 0) {
+    request_pool = std::make_shared<triton::server::InferRequestPool>(
+        server, g_triton_params.infer_request_pool_size_);
+  }
+
+  // Server of the shared memory rings of same-host clients, if allowed.
+  std::shared_ptr<triton::server::SharedMemoryRingServer> shm_ring_server;
+  if (g_triton_params.allow_shared_memory_ring_) {
+    shm_ring_server = std::make_shared<triton::server::SharedMemoryRingServer>(
+        server, shm_manager, g_triton_params.shared_memory_ring_poll_us_);
+  }
+
+  // Registration of shared memory passed by descriptor, if enabled.
+  std::unique_ptr<triton::server::SharedMemoryFdServer> shm_fd_server;
+  if (!g_triton_params.shared_memory_socket_.empty()) {
+    TRITONSERVER_Error* err = triton::server::SharedMemoryFdServer::Create(
+        shm_manager, g_triton_params.shared_memory_socket_, &shm_fd_server);
+    if (err == nullptr) {
+      err = shm_fd_server->Start();
+    }
+    if (err != nullptr) {
+      LOG_TRITONSERVER_ERROR(
+          err, "failed to start shared memory descriptor service");
+      exit(1);
+    }
+  }
+
   // Start the HTTP, GRPC, and metrics endpoints.
-  if (!StartEndpoints(server, trace_manager, shm_manager)) {
+  if (!StartEndpoints(
+          server, trace_manager, shm_manager, control_plane_executor,
+          load_reporter, request_pool, shm_ring_server)) {
     exit(1);
   }
 
@@ -518,6 +609,10 @@ main(int argc, char** argv)
     exit(1);
   }
 
+  // Complete the control-plane requests before the endpoints they
+  // reply through are stopped.
+  control_plane_executor->Stop();
+
   // Stop tracing and the HTTP, GRPC, and metrics endpoints.
   StopEndpoints();
   StopTracing(&trace_manager);
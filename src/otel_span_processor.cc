@@ -0,0 +1,152 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "otel_span_processor.h"
+
+#if !defined(_WIN32) && defined(TRITON_ENABLE_TRACING)
+
+#include "opentelemetry/sdk/trace/batch_span_processor_factory.h"
+
+namespace otel_trace_sdk = opentelemetry::sdk::trace;
+namespace otel_common_sdk = opentelemetry::sdk::common;
+
+namespace triton { namespace server {
+
+//
+// Exporter forwarding to the actual exporter and counting the spans that
+// leave the queue of BoundedSpanProcessor, successfully or not.
+//
+class BoundedSpanProcessor::CountingExporter
+    : public otel_trace_sdk::SpanExporter {
+ public:
+  CountingExporter(
+      std::unique_ptr<otel_trace_sdk::SpanExporter>&& exporter,
+      Counters* counters)
+      : exporter_(std::move(exporter)), counters_(counters)
+  {
+  }
+
+  std::unique_ptr<otel_trace_sdk::Recordable> MakeRecordable() noexcept
+      override
+  {
+    return exporter_->MakeRecordable();
+  }
+
+  otel_common_sdk::ExportResult Export(
+      const opentelemetry::nostd::span<
+          std::unique_ptr<otel_trace_sdk::Recordable>>& spans) noexcept
+      override
+  {
+    const auto result = exporter_->Export(spans);
+    if (result != otel_common_sdk::ExportResult::kSuccess) {
+      counters_->export_failed_.fetch_add(
+          spans.size(), std::memory_order_relaxed);
+      counters_->export_failed_metric_->Increment(spans.size());
+    }
+    counters_->pending_.fetch_sub(spans.size(), std::memory_order_relaxed);
+    return result;
+  }
+
+  bool Shutdown(std::chrono::microseconds timeout) noexcept override
+  {
+    return exporter_->Shutdown(timeout);
+  }
+
+ private:
+  std::unique_ptr<otel_trace_sdk::SpanExporter> exporter_;
+  Counters* counters_;
+};
+
+BoundedSpanProcessor::BoundedSpanProcessor(
+    std::unique_ptr<otel_trace_sdk::SpanExporter>&& exporter,
+    const otel_trace_sdk::BatchSpanProcessorOptions& options)
+    : max_queue_size_(options.max_queue_size),
+      dropped_family_(
+          TRITONSERVER_METRIC_KIND_COUNTER, "nv_trace_otel_dropped_spans",
+          "Number of OpenTelemetry spans dropped before reaching the "
+          "collector"),
+      queue_full_metric_(dropped_family_, {{"reason", "queue_full"}}),
+      export_failed_metric_(dropped_family_, {{"reason", "export_failed"}})
+{
+  counters_.queue_full_metric_ = &queue_full_metric_;
+  counters_.export_failed_metric_ = &export_failed_metric_;
+  // The queue of the batch processor never fills up as this processor
+  // stops handing spans over before that, so every dropped span is
+  // counted here.
+  std::unique_ptr<otel_trace_sdk::SpanExporter> counting_exporter(
+      new CountingExporter(std::move(exporter), &counters_));
+  processor_ = otel_trace_sdk::BatchSpanProcessorFactory::Create(
+      std::move(counting_exporter), options);
+}
+
+BoundedSpanProcessor::~BoundedSpanProcessor()
+{
+  // Export the queued spans while the counters are alive.
+  processor_.reset();
+}
+
+std::unique_ptr<otel_trace_sdk::Recordable>
+BoundedSpanProcessor::MakeRecordable() noexcept
+{
+  return processor_->MakeRecordable();
+}
+
+void
+BoundedSpanProcessor::OnStart(
+    otel_trace_sdk::Recordable& span,
+    const opentelemetry::trace::SpanContext& parent_context) noexcept
+{
+  processor_->OnStart(span, parent_context);
+}
+
+void
+BoundedSpanProcessor::OnEnd(
+    std::unique_ptr<otel_trace_sdk::Recordable>&& span) noexcept
+{
+  if (counters_.pending_.fetch_add(1, std::memory_order_relaxed) >=
+      max_queue_size_) {
+    counters_.pending_.fetch_sub(1, std::memory_order_relaxed);
+    counters_.queue_full_.fetch_add(1, std::memory_order_relaxed);
+    queue_full_metric_.Increment(1);
+    return;
+  }
+  processor_->OnEnd(std::move(span));
+}
+
+bool
+BoundedSpanProcessor::ForceFlush(std::chrono::microseconds timeout) noexcept
+{
+  return processor_->ForceFlush(timeout);
+}
+
+bool
+BoundedSpanProcessor::Shutdown(std::chrono::microseconds timeout) noexcept
+{
+  return processor_->Shutdown(timeout);
+}
+
+}}  // namespace triton::server
+
+#endif  // !_WIN32 && TRITON_ENABLE_TRACING
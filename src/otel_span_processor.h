@@ -0,0 +1,120 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#if !defined(_WIN32) && defined(TRITON_ENABLE_TRACING)
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include "frontend_metrics.h"
+#include "opentelemetry/sdk/trace/batch_span_processor_options.h"
+#include "opentelemetry/sdk/trace/exporter.h"
+#include "opentelemetry/sdk/trace/processor.h"
+
+namespace triton { namespace server {
+
+//
+// BoundedSpanProcessor
+//
+// Exports the ended spans in batches from a background thread so that
+// ending a span on a request handling thread never waits on the
+// collector. At most 'max_queue_size' spans are waiting to be exported
+// or being exported, spans ended while the queue is full are dropped.
+// The dropped spans and the spans the exporter failed to export,
+// including on export timeout, are counted and reported by the
+// 'nv_trace_otel_dropped_spans' metric.
+//
+class BoundedSpanProcessor
+    : public opentelemetry::sdk::trace::SpanProcessor {
+ public:
+  BoundedSpanProcessor(
+      std::unique_ptr<opentelemetry::sdk::trace::SpanExporter>&& exporter,
+      const opentelemetry::sdk::trace::BatchSpanProcessorOptions& options);
+  ~BoundedSpanProcessor() override;
+
+  std::unique_ptr<opentelemetry::sdk::trace::Recordable>
+  MakeRecordable() noexcept override;
+
+  void OnStart(
+      opentelemetry::sdk::trace::Recordable& span,
+      const opentelemetry::trace::SpanContext& parent_context) noexcept
+      override;
+
+  void OnEnd(std::unique_ptr<opentelemetry::sdk::trace::Recordable>&&
+                 span) noexcept override;
+
+  bool ForceFlush(
+      std::chrono::microseconds timeout =
+          (std::chrono::microseconds::max)()) noexcept override;
+
+  bool Shutdown(
+      std::chrono::microseconds timeout =
+          (std::chrono::microseconds::max)()) noexcept override;
+
+  // The number of spans dropped because the queue was full.
+  uint64_t DroppedQueueFull() const
+  {
+    return counters_.queue_full_.load(std::memory_order_relaxed);
+  }
+
+  // The number of spans the exporter failed to export.
+  uint64_t DroppedExportFailed() const
+  {
+    return counters_.export_failed_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  class CountingExporter;
+
+  // Shared with the exporter owned by 'processor_'.
+  struct Counters {
+    Counters() : pending_(0), queue_full_(0), export_failed_(0) {}
+    // The spans handed to 'processor_' and not yet exported.
+    std::atomic<size_t> pending_;
+    std::atomic<uint64_t> queue_full_;
+    std::atomic<uint64_t> export_failed_;
+    FrontendMetric* queue_full_metric_;
+    FrontendMetric* export_failed_metric_;
+  };
+
+  const size_t max_queue_size_;
+
+  // Declared before 'processor_' so that the exporter thread of the
+  // processor is joined while the metrics are alive.
+  FrontendMetricFamily dropped_family_;
+  FrontendMetric queue_full_metric_;
+  FrontendMetric export_failed_metric_;
+  Counters counters_;
+
+  std::unique_ptr<opentelemetry::sdk::trace::SpanProcessor> processor_;
+};
+
+}}  // namespace triton::server
+
+#endif  // !_WIN32 && TRITON_ENABLE_TRACING
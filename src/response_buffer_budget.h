@@ -0,0 +1,103 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "frontend_metrics.h"
+
+namespace triton { namespace server {
+
+//
+// ResponseBufferBudget
+//
+// Per-stream limit on the responses of a decoupled model that are
+// ready to be sent but are still held by the endpoint, typically
+// because the client reads slower than the model produces. A limit of
+// 0 means unlimited, the endpoints only create a budget when at least
+// one limit is set so that unbounded streams skip the accounting. How
+// the budget is enforced is up to the endpoint, the budget only decides
+// when it is exceeded and reports the buffered responses and the
+// budget-exceeded events of all the streams of the endpoint.
+//
+class ResponseBufferBudget {
+ public:
+  ResponseBufferBudget(
+      const std::string& endpoint, const size_t max_bytes,
+      const uint32_t max_count)
+      : max_bytes_(max_bytes), max_count_(max_count),
+        bytes_family_(
+            TRITONSERVER_METRIC_KIND_GAUGE,
+            "nv_" + endpoint + "_stream_buffered_response_bytes",
+            "Number of bytes of responses buffered by " + endpoint +
+                " streams waiting to be sent"),
+        count_family_(
+            TRITONSERVER_METRIC_KIND_GAUGE,
+            "nv_" + endpoint + "_stream_buffered_responses",
+            "Number of responses buffered by " + endpoint +
+                " streams waiting to be sent"),
+        exceeded_family_(
+            TRITONSERVER_METRIC_KIND_COUNTER,
+            "nv_" + endpoint + "_stream_buffer_budget_exceeded",
+            "Number of times a " + endpoint +
+                " stream exceeded its response buffer budget"),
+        bytes_(bytes_family_), count_(count_family_),
+        exceeded_(exceeded_family_)
+  {
+  }
+
+  // Returns whether a stream holding 'bytes' bytes in 'count'
+  // responses is over the budget.
+  bool Exceeded(const size_t bytes, const uint32_t count) const
+  {
+    return ((max_bytes_ != 0) && (bytes > max_bytes_)) ||
+           ((max_count_ != 0) && (count > max_count_));
+  }
+
+  // Reports a change of the responses buffered by a stream.
+  void ReportBuffered(const double bytes_delta, const double count_delta)
+  {
+    bytes_.Increment(bytes_delta);
+    count_.Increment(count_delta);
+  }
+
+  void ReportExceeded() { exceeded_.Increment(1); }
+
+ private:
+  const size_t max_bytes_;
+  const uint32_t max_count_;
+
+  FrontendMetricFamily bytes_family_;
+  FrontendMetricFamily count_family_;
+  FrontendMetricFamily exceeded_family_;
+  FrontendMetric bytes_;
+  FrontendMetric count_;
+  FrontendMetric exceeded_;
+};
+
+}}  // namespace triton::server
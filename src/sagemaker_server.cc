@@ -491,8 +491,9 @@ SagemakerAPIServer::SageMakerMMEHandleInfer(
       // Timestamps from evhtp are capture in 'req'. We record here
       // since this is the first place where we have access to trace
       // manager.
-      trace->CaptureTimestamp("HTTP_RECV_START", req->recv_start_ns);
-      trace->CaptureTimestamp("HTTP_RECV_END", req->recv_end_ns);
+      trace->CaptureTimestamp(
+          FrontendStage::HTTP_RECV_START, req->recv_start_ns);
+      trace->CaptureTimestamp(FrontendStage::HTTP_RECV_END, req->recv_end_ns);
     }
   }
 #endif  // TRITON_ENABLE_TRACING
@@ -0,0 +1,413 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "shared_memory_fd_server.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif  // !_WIN32
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include "common.h"
+#include "triton/common/logging.h"
+
+namespace triton { namespace server {
+
+#ifdef _WIN32
+SharedMemoryFdServer::SharedMemoryFdServer(
+    const std::shared_ptr<SharedMemoryManager>& shm_manager,
+    const std::string& socket_path, const int listen_fd)
+    : shm_manager_(shm_manager), socket_path_(socket_path),
+      listen_fd_(listen_fd), wake_fds_{-1, -1}
+{
+}
+
+SharedMemoryFdServer::~SharedMemoryFdServer() {}
+
+TRITONSERVER_Error*
+SharedMemoryFdServer::Create(
+    const std::shared_ptr<SharedMemoryManager>& shm_manager,
+    const std::string& socket_path,
+    std::unique_ptr<SharedMemoryFdServer>* server)
+{
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED,
+      "Shared memory feature is currently not supported on Windows");
+}
+
+TRITONSERVER_Error*
+SharedMemoryFdServer::Start()
+{
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED,
+      "Shared memory feature is currently not supported on Windows");
+}
+
+TRITONSERVER_Error*
+SharedMemoryFdServer::Stop()
+{
+  return nullptr;  // success
+}
+#else
+namespace {
+
+// The largest request, requests are small JSON objects.
+constexpr size_t kMaxRequestSize = 64 * 1024;
+
+TRITONSERVER_Error*
+ErrnoError(const std::string& msg)
+{
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_INTERNAL,
+      std::string(msg + ", errno: " + std::strerror(errno)).c_str());
+}
+
+}  // namespace
+
+SharedMemoryFdServer::SharedMemoryFdServer(
+    const std::shared_ptr<SharedMemoryManager>& shm_manager,
+    const std::string& socket_path, const int listen_fd)
+    : shm_manager_(shm_manager), socket_path_(socket_path),
+      listen_fd_(listen_fd), wake_fds_{-1, -1}
+{
+}
+
+SharedMemoryFdServer::~SharedMemoryFdServer()
+{
+  LOG_TRITONSERVER_ERROR(
+      Stop(), "failed to stop shared memory descriptor service");
+  close(listen_fd_);
+  unlink(socket_path_.c_str());
+}
+
+TRITONSERVER_Error*
+SharedMemoryFdServer::Create(
+    const std::shared_ptr<SharedMemoryManager>& shm_manager,
+    const std::string& socket_path,
+    std::unique_ptr<SharedMemoryFdServer>* server)
+{
+  struct sockaddr_un addr = {};
+  if (socket_path.empty() || (socket_path.size() >= sizeof(addr.sun_path))) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string("invalid shared memory socket path '" + socket_path + "'")
+            .c_str());
+  }
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+  // Messages keep their boundaries, so each request is one message.
+  const int listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (listen_fd == -1) {
+    return ErrnoError("unable to create shared memory socket");
+  }
+  unlink(socket_path.c_str());
+  if ((bind(
+           listen_fd, reinterpret_cast<struct sockaddr*>(&addr),
+           sizeof(addr)) == -1) ||
+      (listen(listen_fd, SOMAXCONN) == -1)) {
+    TRITONSERVER_Error* err = ErrnoError(
+        "unable to listen on shared memory socket '" + socket_path + "'");
+    close(listen_fd);
+    return err;
+  }
+
+  server->reset(new SharedMemoryFdServer(shm_manager, socket_path, listen_fd));
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+SharedMemoryFdServer::Start()
+{
+  if (thread_.joinable()) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_ALREADY_EXISTS,
+        "shared memory descriptor service is already running");
+  }
+  if (pipe2(wake_fds_, O_CLOEXEC) == -1) {
+    return ErrnoError("unable to create shared memory service pipe");
+  }
+
+  thread_ = std::thread([this] { Serve(); });
+  LOG_INFO << "Started shared memory descriptor service at " << socket_path_;
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+SharedMemoryFdServer::Stop()
+{
+  if (thread_.joinable()) {
+    const char wake = 0;
+    if (write(wake_fds_[1], &wake, 1) != 1) {
+      return ErrnoError("unable to stop shared memory descriptor service");
+    }
+    thread_.join();
+    close(wake_fds_[0]);
+    close(wake_fds_[1]);
+    wake_fds_[0] = wake_fds_[1] = -1;
+  }
+  return nullptr;  // success
+}
+
+void
+SharedMemoryFdServer::Serve()
+{
+  std::map<int, Regions> connections;
+  std::vector<struct pollfd> pollfds;
+  while (true) {
+    pollfds.clear();
+    pollfds.push_back({wake_fds_[0], POLLIN, 0});
+    pollfds.push_back({listen_fd_, POLLIN, 0});
+    for (const auto& connection : connections) {
+      pollfds.push_back({connection.first, POLLIN, 0});
+    }
+
+    if (poll(pollfds.data(), pollfds.size(), -1 /* timeout */) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_ERROR << "failed to poll shared memory socket: "
+                << std::strerror(errno);
+      break;
+    }
+    if (pollfds[0].revents != 0) {
+      break;
+    }
+
+    if ((pollfds[1].revents & POLLIN) != 0) {
+      // The connections are non-blocking so that a client that doesn't
+      // read its replies can't stall the service of the others.
+      const int conn_fd = accept4(
+          listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (conn_fd != -1) {
+        connections.emplace(conn_fd, Regions());
+      } else {
+        LOG_VERBOSE(1) << "failed to accept shared memory connection: "
+                       << std::strerror(errno);
+      }
+    }
+
+    for (size_t idx = 2; idx < pollfds.size(); ++idx) {
+      if (pollfds[idx].revents == 0) {
+        continue;
+      }
+      auto it = connections.find(pollfds[idx].fd);
+      if (!HandleMessage(it->first, &it->second)) {
+        CloseConnection(it->first, &it->second);
+        connections.erase(it);
+      }
+    }
+  }
+
+  for (auto& connection : connections) {
+    CloseConnection(connection.first, &connection.second);
+  }
+}
+
+bool
+SharedMemoryFdServer::HandleMessage(const int conn_fd, Regions* regions)
+{
+  std::vector<char> request(kMaxRequestSize);
+  union {
+    struct cmsghdr align;
+    char buffer[CMSG_SPACE(sizeof(int))];
+  } control;
+  struct iovec iov;
+  iov.iov_base = request.data();
+  iov.iov_len = request.size();
+  struct msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buffer;
+  msg.msg_controllen = sizeof(control.buffer);
+
+  const ssize_t byte_size = recvmsg(conn_fd, &msg, MSG_CMSG_CLOEXEC);
+  if (byte_size == -1) {
+    return (errno == EINTR) || (errno == EAGAIN);
+  }
+  if (byte_size == 0) {
+    return false;
+  }
+
+  // Own the received descriptors so that none leaks, whatever the
+  // request.
+  std::vector<int> fds;
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_RIGHTS)) {
+      const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      for (size_t idx = 0; idx < count; ++idx) {
+        int fd;
+        memcpy(&fd, CMSG_DATA(cmsg) + (idx * sizeof(int)), sizeof(int));
+        fds.push_back(fd);
+      }
+    }
+  }
+
+  uint64_t handle = 0;
+  TRITONSERVER_Error* err = nullptr;
+  if ((msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) != 0) {
+    err = TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "shared memory requests must be at most " +
+            std::to_string(kMaxRequestSize) +
+            " bytes and carry at most one descriptor")
+            .c_str());
+  } else {
+    err = HandleRequest(
+        request.data(), byte_size, fds.empty() ? -1 : fds[0], regions,
+        &handle);
+  }
+  for (const int fd : fds) {
+    close(fd);
+  }
+
+  triton::common::TritonJson::Value response(
+      triton::common::TritonJson::ValueType::OBJECT);
+  if (err != nullptr) {
+    const char* message = TRITONSERVER_ErrorMessage(err);
+    LOG_TRITONSERVER_ERROR(
+        response.AddString("error", message, strlen(message)),
+        "failed to add shared memory response error");
+    TRITONSERVER_ErrorDelete(err);
+  } else if (handle != 0) {
+    LOG_TRITONSERVER_ERROR(
+        response.AddUInt("handle", handle),
+        "failed to add shared memory response handle");
+  }
+  triton::common::TritonJson::WriteBuffer buffer;
+  LOG_TRITONSERVER_ERROR(
+      response.Write(&buffer), "failed to write shared memory response");
+
+  // A reply that can't be sent right away, because the client doesn't
+  // read its replies, closes the connection rather than being queued.
+  if (send(conn_fd, buffer.Base(), buffer.Size(), MSG_NOSIGNAL) == -1) {
+    LOG_VERBOSE(1) << "failed to send shared memory reply, closing: "
+                   << std::strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+TRITONSERVER_Error*
+SharedMemoryFdServer::HandleRequest(
+    const char* base, const size_t byte_size, const int shm_fd,
+    Regions* regions, uint64_t* handle)
+{
+  triton::common::TritonJson::Value request;
+  RETURN_MSG_IF_ERR(
+      request.Parse(base, byte_size), "failed to parse the request");
+  std::string action, name;
+  RETURN_MSG_IF_ERR(
+      request.MemberAsString("action", &action), "Unable to parse 'action'");
+  RETURN_MSG_IF_ERR(
+      request.MemberAsString("name", &name), "Unable to parse 'name'");
+
+  if (action == "register") {
+    if (shm_fd == -1) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          "Shared memory register request carries no descriptor");
+    }
+
+    uint64_t offset = 0;
+    triton::common::TritonJson::Value offset_json;
+    if (request.Find("offset", &offset_json)) {
+      RETURN_MSG_IF_ERR(
+          offset_json.AsUInt(&offset), "Unable to parse 'offset'");
+    }
+    uint64_t region_byte_size;
+    RETURN_MSG_IF_ERR(
+        request.MemberAsUInt("byte_size", &region_byte_size),
+        "Unable to parse 'byte_size'");
+    SharedMemoryManager::MappingOptions options;
+    RETURN_IF_ERR(SharedMemoryManager::ParseMappingOptions(request, &options));
+
+    RETURN_IF_ERR(shm_manager_->RegisterSystemSharedMemoryFd(
+        name, shm_fd, offset, region_byte_size, options, handle));
+    (*regions)[name] = *handle;
+  } else if (action == "unregister") {
+    auto it = regions->find(name);
+    if (it == regions->end()) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_NOT_FOUND,
+          std::string(
+              "shared memory region '" + name +
+              "' was not registered through this connection")
+              .c_str());
+    }
+    RETURN_IF_ERR(shm_manager_->UnregisterHandle(it->second));
+    regions->erase(it);
+  } else if (action == "release") {
+    auto it = regions->find(name);
+    if (it == regions->end()) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_NOT_FOUND,
+          std::string(
+              "shared memory region '" + name +
+              "' was not registered through this connection")
+              .c_str());
+    }
+    uint64_t offset, lease;
+    RETURN_MSG_IF_ERR(
+        request.MemberAsUInt("offset", &offset), "Unable to parse 'offset'");
+    RETURN_MSG_IF_ERR(
+        request.MemberAsUInt("lease", &lease), "Unable to parse 'lease'");
+    RETURN_IF_ERR(shm_manager_->ReleasePoolAllocation(
+        name, it->second, offset, lease));
+  } else {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string("unknown shared memory request action '" + action + "'")
+            .c_str());
+  }
+
+  return nullptr;  // success
+}
+
+void
+SharedMemoryFdServer::CloseConnection(const int conn_fd, Regions* regions)
+{
+  for (const auto& region : *regions) {
+    LOG_VERBOSE(1) << "unregistering shared memory region '" << region.first
+                   << "' of closed connection";
+    LOG_TRITONSERVER_ERROR(
+        shm_manager_->UnregisterHandle(region.second),
+        "failed to unregister shared memory region");
+  }
+  regions->clear();
+  close(conn_fd);
+}
+#endif  // _WIN32
+
+}}  // namespace triton::server
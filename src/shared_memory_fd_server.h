@@ -0,0 +1,91 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "shared_memory_manager.h"
+#include "triton/core/tritonserver.h"
+
+namespace triton { namespace server {
+
+//
+// SharedMemoryFdServer
+//
+// Registers system shared memory passed by descriptor over a Unix
+// domain socket, so that clients can share anonymous memory, like a
+// memfd, instead of named POSIX shared memory objects. Each message on
+// the socket is a JSON request, a register request carries the
+// descriptor of the memory as SCM_RIGHTS ancillary data. The regions
+// registered through a connection are unregistered when the
+// connection closes, so the regions of a client that exits are always
+// released.
+//
+class SharedMemoryFdServer {
+ public:
+  /// Create a server listening on 'socket_path', replacing any stale
+  /// socket at the path.
+  static TRITONSERVER_Error* Create(
+      const std::shared_ptr<SharedMemoryManager>& shm_manager,
+      const std::string& socket_path,
+      std::unique_ptr<SharedMemoryFdServer>* server);
+
+  ~SharedMemoryFdServer();
+
+  TRITONSERVER_Error* Start();
+  TRITONSERVER_Error* Stop();
+
+ private:
+  // The regions registered through a connection, by name.
+  using Regions = std::map<std::string, uint64_t>;
+
+  SharedMemoryFdServer(
+      const std::shared_ptr<SharedMemoryManager>& shm_manager,
+      const std::string& socket_path, const int listen_fd);
+
+  void Serve();
+
+  // Handle the next message of 'conn_fd', returns false if the
+  // connection is closed.
+  bool HandleMessage(const int conn_fd, Regions* regions);
+  TRITONSERVER_Error* HandleRequest(
+      const char* base, const size_t byte_size, const int shm_fd,
+      Regions* regions, uint64_t* handle);
+  void CloseConnection(const int conn_fd, Regions* regions);
+
+  std::shared_ptr<SharedMemoryManager> shm_manager_;
+  const std::string socket_path_;
+  int listen_fd_;
+
+  // Written to wake up the serving thread when stopping.
+  int wake_fds_[2];
+  std::thread thread_;
+};
+
+}}  // namespace triton::server
@@ -29,12 +29,51 @@
 // Not supporting shared memory for now
 #ifdef _WIN32
 namespace triton { namespace server {
+SharedMemoryManager::SharedMemoryManager(
+    const std::vector<std::string>& hugetlbfs_dirs)
+    : table_(nullptr), epoch_(0), next_handle_(1)
+{
+}
+
 SharedMemoryManager::~SharedMemoryManager() {}
 
+SharedMemoryManager::SharedMemoryInfo::~SharedMemoryInfo() {}
+
+TRITONSERVER_Error*
+SharedMemoryManager::ParseMappingOptions(
+    triton::common::TritonJson::Value& register_request,
+    MappingOptions* options)
+{
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED,
+      std::string("Shared memory feature is currently not supported on Windows")
+          .c_str());
+}
+
+TRITONSERVER_Error*
+SharedMemoryManager::CheckNumaNode(const int64_t numa_node)
+{
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED,
+      std::string("Shared memory feature is currently not supported on Windows")
+          .c_str());
+}
+
 TRITONSERVER_Error*
 SharedMemoryManager::RegisterSystemSharedMemory(
     const std::string& name, const std::string& shm_key, const size_t offset,
-    const size_t byte_size)
+    const size_t byte_size, const MappingOptions& options, uint64_t* handle)
+{
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED,
+      std::string("Shared memory feature is currently not supported on Windows")
+          .c_str());
+}
+
+TRITONSERVER_Error*
+SharedMemoryManager::RegisterSystemSharedMemoryFd(
+    const std::string& name, const int shm_fd, const size_t offset,
+    const size_t byte_size, const MappingOptions& options, uint64_t* handle)
 {
   return TRITONSERVER_ErrorNew(
       TRITONSERVER_ERROR_UNSUPPORTED,
@@ -46,7 +85,7 @@ SharedMemoryManager::RegisterSystemSharedMemory(
 TRITONSERVER_Error*
 SharedMemoryManager::RegisterCUDASharedMemory(
     const std::string& name, const cudaIpcMemHandle_t* cuda_shm_handle,
-    const size_t byte_size, const int device_id)
+    const size_t byte_size, const int device_id, uint64_t* handle)
 {
   return TRITONSERVER_ErrorNew(
       TRITONSERVER_ERROR_UNSUPPORTED,
@@ -56,7 +95,8 @@ SharedMemoryManager::RegisterCUDASharedMemory(
 
 TRITONSERVER_Error*
 SharedMemoryManager::GetCUDAHandle(
-    const std::string& name, cudaIpcMemHandle_t** cuda_mem_handle)
+    const std::string& name, const uint64_t handle,
+    cudaIpcMemHandle_t** cuda_mem_handle)
 {
   return TRITONSERVER_ErrorNew(
       TRITONSERVER_ERROR_UNSUPPORTED,
@@ -67,8 +107,21 @@ SharedMemoryManager::GetCUDAHandle(
 
 TRITONSERVER_Error*
 SharedMemoryManager::GetMemoryInfo(
-    const std::string& name, size_t offset, void** shm_mapped_addr,
-    TRITONSERVER_MemoryType* memory_type, int64_t* device_id)
+    const std::string& name, const uint64_t handle, size_t offset,
+    void** shm_mapped_addr, TRITONSERVER_MemoryType* memory_type,
+    int64_t* device_id, Reference* reference, size_t* byte_size,
+    SharedMemoryPool** pool)
+{
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED,
+      std::string("Shared memory feature is currently not supported on Windows")
+          .c_str());
+}
+
+TRITONSERVER_Error*
+SharedMemoryManager::ReleasePoolAllocation(
+    const std::string& name, const uint64_t handle, const size_t offset,
+    const uint64_t lease)
 {
   return TRITONSERVER_ErrorNew(
       TRITONSERVER_ERROR_UNSUPPORTED,
@@ -106,9 +159,30 @@ SharedMemoryManager::UnregisterAll(TRITONSERVER_MemoryType memory_type)
           .c_str());
 }
 
+TRITONSERVER_Error*
+SharedMemoryManager::UnregisterHandle(const uint64_t handle)
+{
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED,
+      std::string("Shared memory feature is currently not supported on Windows")
+          .c_str());
+}
+
+TRITONSERVER_Error*
+SharedMemoryManager::AppendStatus(
+    const SharedMemoryInfo& info,
+    triton::common::TritonJson::Value* shm_status)
+{
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED,
+      std::string("Shared memory feature is currently not supported on Windows")
+          .c_str());
+}
+
 TRITONSERVER_Error*
 SharedMemoryManager::UnregisterHelper(
-    const std::string& name, TRITONSERVER_MemoryType memory_type)
+    const std::string& name, TRITONSERVER_MemoryType memory_type,
+    SharedMemoryTable* table)
 {
   return TRITONSERVER_ErrorNew(
       TRITONSERVER_ERROR_UNSUPPORTED,
@@ -120,7 +194,18 @@ SharedMemoryManager::UnregisterHelper(
 #include <errno.h>
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <sys/vfs.h>
+#endif  // __linux__
+
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include <vector>
 
 #include "common.h"
 #include "triton/common/logging.h"
@@ -129,10 +214,182 @@ namespace triton { namespace server {
 
 namespace {
 
+#ifdef __linux__
+// From linux/magic.h and linux/mempolicy.h, which are not always
+// installed.
+constexpr long kHugetlbfsMagic = 0x958458f6;
+constexpr int kMpolBind = 2;
+constexpr unsigned kMpolMfMove = 1 << 1;
+#endif  // __linux__
+
+// POSIX shared memory object names have no '/' other than the leading
+// one, any other key is the path of a file to map.
+bool
+IsFileKey(const std::string& shm_key)
+{
+  return shm_key.find('/', 1) != std::string::npos;
+}
+
+// Returns the path of 'shm_fd', e.g. "/memfd:name (deleted)" for a
+// memfd, to report the region.
+std::string
+DescriptorPath(const int shm_fd)
+{
+#ifdef __linux__
+  char path[PATH_MAX];
+  const std::string link = "/proc/self/fd/" + std::to_string(shm_fd);
+  const ssize_t len = readlink(link.c_str(), path, sizeof(path));
+  if (len > 0) {
+    return std::string(path, len);
+  }
+#endif  // __linux__
+  return std::string();
+}
+
+// Checks that the memory of 'shm_fd' covers the block and can be
+// mapped writable, outputs are written in place. Returns in 'sealed'
+// whether the memory can no longer shrink.
+TRITONSERVER_Error*
+CheckDescriptor(
+    const int shm_fd, const size_t offset, const size_t byte_size,
+    bool* sealed)
+{
+  *sealed = false;
+#if defined(__linux__) && defined(F_GET_SEALS)
+  const int seals = fcntl(shm_fd, F_GET_SEALS);
+  if (seals != -1) {
+    int write_seals = F_SEAL_WRITE;
+#ifdef F_SEAL_FUTURE_WRITE
+    write_seals |= F_SEAL_FUTURE_WRITE;
+#endif  // F_SEAL_FUTURE_WRITE
+    if ((seals & write_seals) != 0) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          "write sealed memory can't be registered as shared memory");
+    }
+    *sealed = ((seals & F_SEAL_SHRINK) != 0);
+  }
+#endif  // __linux__ && F_GET_SEALS
+
+  struct stat st;
+  if (fstat(shm_fd, &st) == -1) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        std::string(
+            "unable to stat shared memory descriptor, errno: " +
+            std::string(std::strerror(errno)))
+            .c_str());
+  }
+  const size_t size = st.st_size;
+  if ((offset > size) || (byte_size > (size - offset))) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "offset " + std::to_string(offset) + " and byte size " +
+            std::to_string(byte_size) + " exceed the " +
+            std::to_string(size) + " bytes of the shared memory descriptor")
+            .c_str());
+  }
+  return nullptr;
+}
+
+// Returns in 'page_size' the size of the huge pages backing 'shm_fd', or
+// 0 if 'shm_fd' is not a hugetlbfs file.
 TRITONSERVER_Error*
-OpenSharedMemoryRegion(const std::string& shm_key, int* shm_fd)
+HugetlbfsPageSize(const int shm_fd, size_t* page_size)
+{
+  *page_size = 0;
+#ifdef __linux__
+  struct statfs fs;
+  if (fstatfs(shm_fd, &fs) == -1) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        std::string(
+            "unable to stat shared memory file system, errno: " +
+            std::string(std::strerror(errno)))
+            .c_str());
+  }
+  if (static_cast<long>(fs.f_type) == kHugetlbfsMagic) {
+    *page_size = fs.f_bsize;
+  }
+#endif  // __linux__
+  return nullptr;
+}
+
+// Returns the canonical path of 'path', or an empty string if it can't
+// be resolved.
+std::string
+CanonicalPath(const std::string& path)
+{
+  char resolved[PATH_MAX];
+  if (realpath(path.c_str(), resolved) == nullptr) {
+    return std::string();
+  }
+  return std::string(resolved);
+}
+
+// Returns whether the canonical path 'path' is in one of 'dirs'.
+bool
+IsInDirectory(const std::string& path, const std::vector<std::string>& dirs)
+{
+  for (const auto& dir : dirs) {
+    if ((path.size() > dir.size()) && (path.compare(0, dir.size(), dir) == 0) &&
+        ((dir.back() == '/') || (path[dir.size()] == '/'))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Opens the hugetlbfs file 'shm_key'. The key comes from the clients so
+// the file must be in one of 'hugetlbfs_dirs', and is checked again
+// once opened in case the path was changed meanwhile.
+TRITONSERVER_Error*
+OpenHugetlbfsFile(
+    const std::string& shm_key, const std::vector<std::string>& hugetlbfs_dirs,
+    int* shm_fd)
+{
+  const TRITONSERVER_Error_Code code = TRITONSERVER_ERROR_INVALID_ARG;
+  const std::string error =
+      "Unable to register shared memory region '" + shm_key +
+      "': only files on a hugetlbfs mount under a directory given with "
+      "--shared-memory-hugetlbfs-dir can be registered by path";
+  if (!IsInDirectory(CanonicalPath(shm_key), hugetlbfs_dirs)) {
+    return TRITONSERVER_ErrorNew(code, error.c_str());
+  }
+
+  *shm_fd = open(shm_key.c_str(), O_RDWR | O_NONBLOCK | O_NOCTTY | O_CLOEXEC);
+  if (*shm_fd == -1) {
+    LOG_VERBOSE(1) << "open failed, errno: " << errno;
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        std::string("Unable to open shared memory region: '" + shm_key + "'")
+            .c_str());
+  }
+
+  size_t page_size = 0;
+  TRITONSERVER_Error* err = HugetlbfsPageSize(*shm_fd, &page_size);
+  if ((err == nullptr) &&
+      ((page_size == 0) ||
+       !IsInDirectory(DescriptorPath(*shm_fd), hugetlbfs_dirs))) {
+    err = TRITONSERVER_ErrorNew(code, error.c_str());
+  }
+  if (err != nullptr) {
+    close(*shm_fd);
+    *shm_fd = -1;
+  }
+  return err;
+}
+
+TRITONSERVER_Error*
+OpenSharedMemoryRegion(
+    const std::string& shm_key, const std::vector<std::string>& hugetlbfs_dirs,
+    int* shm_fd)
 {
   // get shared memory region descriptor
+  if (IsFileKey(shm_key)) {
+    return OpenHugetlbfsFile(shm_key, hugetlbfs_dirs, shm_fd);
+  }
   *shm_fd = shm_open(shm_key.c_str(), O_RDWR, S_IRUSR | S_IWUSR);
   if (*shm_fd == -1) {
     LOG_VERBOSE(1) << "shm_open failed, errno: " << errno;
@@ -145,14 +402,97 @@ OpenSharedMemoryRegion(const std::string& shm_key, int* shm_fd)
   return nullptr;
 }
 
+// Returns the highest NUMA node the system can have, from the nodes
+// the kernel reports as possible, e.g. "0-3". A system without NUMA
+// support only has node 0.
+int
+MaxNumaNode()
+{
+  static const int max_node = []() {
+    int node = 0;
+#ifdef __linux__
+    std::ifstream possible("/sys/devices/system/node/possible");
+    std::string nodes;
+    if (std::getline(possible, nodes)) {
+      const size_t pos = nodes.find_last_of("-,");
+      const std::string last =
+          (pos == std::string::npos) ? nodes : nodes.substr(pos + 1);
+      char* end = nullptr;
+      const long parsed = std::strtol(last.c_str(), &end, 10);
+      if ((end != last.c_str()) && (parsed > 0) && (parsed < INT_MAX)) {
+        node = parsed;
+      }
+    }
+#endif  // __linux__
+    return node;
+  }();
+  return max_node;
+}
+
+// Binds the pages of the mapping to 'numa_node'. Pages already faulted
+// in by this process are migrated, pages shared with the client stay
+// where they are.
+TRITONSERVER_Error*
+BindSharedMemory(void* mapped_addr, const size_t byte_size, const int numa_node)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+  constexpr size_t kBitsPerWord = sizeof(unsigned long) * CHAR_BIT;
+  std::vector<unsigned long> nodemask((numa_node / kBitsPerWord) + 1, 0);
+  nodemask[numa_node / kBitsPerWord] |= 1UL << (numa_node % kBitsPerWord);
+  if (syscall(
+          SYS_mbind, mapped_addr, byte_size, kMpolBind, nodemask.data(),
+          nodemask.size() * kBitsPerWord + 1, kMpolMfMove) == -1) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "unable to bind shared memory to NUMA node " +
+            std::to_string(numa_node) +
+            ", errno: " + std::string(std::strerror(errno)))
+            .c_str());
+  }
+  return nullptr;
+#else
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED,
+      "NUMA binding of shared memory is not supported on this platform");
+#endif  // __linux__ && SYS_mbind
+}
+
+// Faults in every page of the mapping.
+void
+PrefaultSharedMemory(void* mapped_addr, const size_t byte_size)
+{
+#ifdef MADV_POPULATE_WRITE
+  if (madvise(mapped_addr, byte_size, MADV_POPULATE_WRITE) == 0) {
+    return;
+  }
+#endif  // MADV_POPULATE_WRITE
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  const volatile char* base = reinterpret_cast<char*>(mapped_addr);
+  for (size_t idx = 0; idx < byte_size; idx += page_size) {
+    (void)base[idx];
+  }
+}
+
 TRITONSERVER_Error*
 MapSharedMemory(
     const int shm_fd, const size_t offset, const size_t byte_size,
-    void** mapped_addr)
+    const SharedMemoryManager::MappingOptions& options, void** mapped_addr)
 {
+  // Huge pages and NUMA binding must be set before the pages are
+  // faulted in, so MAP_POPULATE is only used when neither is requested.
+  const bool populate_after_map =
+      options.prefault_ && (options.huge_pages_ || (options.numa_node_ >= 0));
+  int flags = MAP_SHARED;
+  if (options.prefault_ && !populate_after_map) {
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif  // MAP_POPULATE
+  }
+
   // map shared memory to process address space
   *mapped_addr =
-      mmap(NULL, byte_size, PROT_WRITE | PROT_READ, MAP_SHARED, shm_fd, offset);
+      mmap(NULL, byte_size, PROT_WRITE | PROT_READ, flags, shm_fd, offset);
   if (*mapped_addr == MAP_FAILED) {
     return TRITONSERVER_ErrorNew(
         TRITONSERVER_ERROR_INTERNAL, std::string(
@@ -161,7 +501,44 @@ MapSharedMemory(
                                          .c_str());
   }
 
-  return nullptr;
+  TRITONSERVER_Error* err = nullptr;
+  if (options.huge_pages_) {
+#ifdef MADV_HUGEPAGE
+    if (madvise(*mapped_addr, byte_size, MADV_HUGEPAGE) == -1) {
+      err = TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          std::string(
+              "unable to use huge pages for shared memory, errno: " +
+              std::string(std::strerror(errno)))
+              .c_str());
+    }
+#else
+    err = TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_UNSUPPORTED,
+        "huge pages for shared memory are not supported on this platform");
+#endif  // MADV_HUGEPAGE
+  }
+  if ((err == nullptr) && (options.numa_node_ >= 0)) {
+    err = BindSharedMemory(*mapped_addr, byte_size, options.numa_node_);
+  }
+  if ((err == nullptr) && populate_after_map) {
+    PrefaultSharedMemory(*mapped_addr, byte_size);
+  }
+  if ((err == nullptr) && options.lock_) {
+    if (mlock(*mapped_addr, byte_size) == -1) {
+      err = TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          std::string(
+              "unable to lock shared memory, errno: " +
+              std::string(std::strerror(errno)))
+              .c_str());
+    }
+  }
+
+  if (err != nullptr) {
+    munmap(*mapped_addr, byte_size);
+  }
+  return err;
 }
 
 TRITONSERVER_Error*
@@ -219,73 +596,331 @@ OpenCudaIPCRegion(
 }
 #endif  // TRITON_ENABLE_GPU
 
+// Returns the reader slot of the calling thread. Threads are spread
+// over the slots in the order of their first lookup.
+size_t
+ReaderSlotIndex(const size_t slot_count)
+{
+  static std::atomic<size_t> next_slot{0};
+  thread_local const size_t slot = next_slot.fetch_add(1);
+  return slot % slot_count;
+}
+
 }  // namespace
 
+SharedMemoryManager::SharedMemoryManager(
+    const std::vector<std::string>& hugetlbfs_dirs)
+    : table_(new SharedMemoryTable()), epoch_(0), next_handle_(1)
+{
+  for (auto& slot : reader_slots_) {
+    slot.readers_[0] = 0;
+    slot.readers_[1] = 0;
+  }
+  for (const auto& dir : hugetlbfs_dirs) {
+    const std::string path = CanonicalPath(dir);
+    if (path.empty()) {
+      LOG_WARNING << "Unable to resolve hugetlbfs directory '" << dir
+                  << "', files in it can't be registered as shared memory";
+    } else {
+      hugetlbfs_dirs_.push_back(path);
+    }
+  }
+}
+
 SharedMemoryManager::~SharedMemoryManager()
 {
   UnregisterAll(TRITONSERVER_MEMORY_CPU);
   UnregisterAll(TRITONSERVER_MEMORY_GPU);
+  delete table_.load();
+}
+
+SharedMemoryManager::SharedMemoryInfo::~SharedMemoryInfo()
+{
+  if (kind_ == TRITONSERVER_MEMORY_CPU) {
+    LOG_TRITONSERVER_ERROR(
+        UnmapSharedMemory(mapped_addr_, byte_size_),
+        "failed to unmap shared memory region '" + name_ + "'");
+  } else {
+#ifdef TRITON_ENABLE_GPU
+    cudaError_t err = cudaIpcCloseMemHandle(mapped_addr_);
+    if (err != cudaSuccess) {
+      LOG_ERROR << "failed to close CUDA IPC handle of CUDA shared memory "
+                << "region '" << name_ << "': " << cudaGetErrorString(err);
+    }
+#endif  // TRITON_ENABLE_GPU
+  }
 }
 
+template <typename Fn>
 TRITONSERVER_Error*
-SharedMemoryManager::RegisterSystemSharedMemory(
-    const std::string& name, const std::string& shm_key, const size_t offset,
-    const size_t byte_size)
+SharedMemoryManager::Find(
+    const std::string& name, const uint64_t handle, Fn&& fn)
 {
-  std::lock_guard<std::mutex> lock(mu_);
+  // Enter the current epoch, retrying if a writer advanced it before
+  // this reader was visible.
+  ReaderSlot& slot = reader_slots_[ReaderSlotIndex(kReaderSlotCount)];
+  uint64_t epoch = epoch_.load();
+  while (true) {
+    slot.readers_[epoch & 1].fetch_add(1);
+    const uint64_t current = epoch_.load();
+    if (current == epoch) {
+      break;
+    }
+    slot.readers_[epoch & 1].fetch_sub(1);
+    epoch = current;
+  }
 
-  if (shared_memory_map_.find(name) != shared_memory_map_.end()) {
-    return TRITONSERVER_ErrorNew(
-        TRITONSERVER_ERROR_ALREADY_EXISTS,
-        std::string("shared memory region '" + name + "' already in manager")
+  const SharedMemoryTable* table = table_.load();
+  const std::shared_ptr<SharedMemoryInfo>* info = nullptr;
+  if (handle != 0) {
+    auto it = table->by_handle_.find(handle);
+    if (it != table->by_handle_.end()) {
+      info = &it->second;
+    }
+  } else {
+    auto it = table->by_name_.find(name);
+    if (it != table->by_name_.end()) {
+      info = &it->second;
+    }
+  }
+
+  TRITONSERVER_Error* err = nullptr;
+  if (info != nullptr) {
+    fn(*info);
+  } else if (handle != 0) {
+    err = TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_NOT_FOUND,
+        std::string(
+            "Unable to find shared memory region with handle " +
+            std::to_string(handle))
+            .c_str());
+  } else {
+    err = TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_NOT_FOUND,
+        std::string("Unable to find shared memory region: '" + name + "'")
             .c_str());
   }
 
-  // register
-  void* mapped_addr;
-  int shm_fd = -1;
+  slot.readers_[epoch & 1].fetch_sub(1);
+  return err;
+}
 
-  // don't re-open if shared memory is already open
-  for (auto itr = shared_memory_map_.begin(); itr != shared_memory_map_.end();
-       ++itr) {
-    if (itr->second->shm_key_ == shm_key) {
-      shm_fd = itr->second->shm_fd_;
-      break;
+void
+SharedMemoryManager::Publish(std::unique_ptr<SharedMemoryTable>&& table)
+{
+  // Must hold the lock on mu_ while calling this function.
+  std::unique_ptr<SharedMemoryTable> previous(table_.exchange(table.release()));
+
+  // Readers that entered the previous epoch may still use the previous
+  // table, the readers entering from now on see the new table.
+  const uint64_t epoch = epoch_.fetch_add(1);
+  for (auto& slot : reader_slots_) {
+    while (slot.readers_[epoch & 1].load() != 0) {
+      std::this_thread::yield();
     }
   }
+}
 
-  // open and set new shm_fd if new shared memory key
-  if (shm_fd == -1) {
-    RETURN_IF_ERR(OpenSharedMemoryRegion(shm_key, &shm_fd));
+TRITONSERVER_Error*
+SharedMemoryManager::CheckNumaNode(const int64_t numa_node)
+{
+  // The node mask passed to mbind() is sized by the node, so the node is
+  // bounded by the nodes of the system rather than by INT_MAX.
+  if ((numa_node < 0) || (numa_node > MaxNumaNode())) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "'numa_node' must be a NUMA node of the system, from 0 to " +
+            std::to_string(MaxNumaNode()))
+            .c_str());
   }
+  return nullptr;
+}
 
-  // Mmap and then close the shared memory descriptor
-  TRITONSERVER_Error* err_mmap =
-      MapSharedMemory(shm_fd, offset, byte_size, &mapped_addr);
+TRITONSERVER_Error*
+SharedMemoryManager::ParseMappingOptions(
+    triton::common::TritonJson::Value& register_request,
+    MappingOptions* options)
+{
+  triton::common::TritonJson::Value option_json;
+  if (register_request.Find("prefault", &option_json)) {
+    RETURN_MSG_IF_ERR(
+        option_json.AsBool(&options->prefault_), "Unable to parse 'prefault'");
+  }
+  if (register_request.Find("huge_pages", &option_json)) {
+    RETURN_MSG_IF_ERR(
+        option_json.AsBool(&options->huge_pages_),
+        "Unable to parse 'huge_pages'");
+  }
+  if (register_request.Find("lock", &option_json)) {
+    RETURN_MSG_IF_ERR(
+        option_json.AsBool(&options->lock_), "Unable to parse 'lock'");
+  }
+  if (register_request.Find("numa_node", &option_json)) {
+    int64_t numa_node;
+    RETURN_MSG_IF_ERR(
+        option_json.AsInt(&numa_node), "Unable to parse 'numa_node'");
+    RETURN_IF_ERR(CheckNumaNode(numa_node));
+    options->numa_node_ = numa_node;
+  }
+  if (register_request.Find("pool", &option_json)) {
+    RETURN_MSG_IF_ERR(
+        option_json.AsBool(&options->pool_), "Unable to parse 'pool'");
+  }
+  if (register_request.Find("pool_block_size", &option_json)) {
+    uint64_t block_size;
+    RETURN_MSG_IF_ERR(
+        option_json.AsUInt(&block_size), "Unable to parse 'pool_block_size'");
+    options->pool_block_size_ = block_size;
+  }
+  if (register_request.Find("pool_lease_ms", &option_json)) {
+    RETURN_MSG_IF_ERR(
+        option_json.AsUInt(&options->pool_lease_ms_),
+        "Unable to parse 'pool_lease_ms'");
+  }
+
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+SharedMemoryManager::RegisterSystemSharedMemory(
+    const std::string& name, const std::string& shm_key, const size_t offset,
+    const size_t byte_size, const MappingOptions& options, uint64_t* handle)
+{
+  // The descriptor is closed once the region is mapped so it is opened
+  // for every region, even if the key is shared.
+  int shm_fd = -1;
+  RETURN_IF_ERR(OpenSharedMemoryRegion(shm_key, hugetlbfs_dirs_, &shm_fd));
+  TRITONSERVER_Error* err_register = RegisterSystemSharedMemoryHelper(
+      name, shm_key, shm_fd, false /* by_descriptor */, offset, byte_size,
+      options, handle);
   TRITONSERVER_Error* err_close = CloseSharedMemoryRegion(shm_fd);
-  if (err_mmap != nullptr) {
+  if (err_register != nullptr) {
+    if (err_close != nullptr) {
+      TRITONSERVER_ErrorDelete(err_close);
+    }
+    return err_register;
+  }
+  if (err_close != nullptr) {
     return TRITONSERVER_ErrorNew(
         TRITONSERVER_ERROR_INVALID_ARG,
         std::string(
             "failed to register shared memory region '" + name +
-            "': " + TRITONSERVER_ErrorMessage(err_mmap))
+            "': " + TRITONSERVER_ErrorMessage(err_close))
             .c_str());
   }
+  return nullptr;  // success
+}
 
-  if (err_close != nullptr) {
+TRITONSERVER_Error*
+SharedMemoryManager::RegisterSystemSharedMemoryFd(
+    const std::string& name, const int shm_fd, const size_t offset,
+    const size_t byte_size, const MappingOptions& options, uint64_t* handle)
+{
+  return RegisterSystemSharedMemoryHelper(
+      name, DescriptorPath(shm_fd), shm_fd, true /* by_descriptor */, offset,
+      byte_size, options, handle);
+}
+
+TRITONSERVER_Error*
+SharedMemoryManager::RegisterSystemSharedMemoryHelper(
+    const std::string& name, const std::string& shm_key, const int shm_fd,
+    const bool by_descriptor, const size_t offset, const size_t byte_size,
+    const MappingOptions& options, uint64_t* handle)
+{
+  // Serialize all operations that modify the shared memory regions
+  std::lock_guard<std::mutex> lock(mu_);
+  const SharedMemoryTable* table = table_.load();
+  if (table->by_name_.find(name) != table->by_name_.end()) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_ALREADY_EXISTS,
+        std::string("shared memory region '" + name + "' already in manager")
+            .c_str());
+  }
+
+  if (options.numa_node_ < -1) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "invalid NUMA node " + std::to_string(options.numa_node_) +
+            " for shared memory region '" + name + "'")
+            .c_str());
+  }
+
+  if (options.pool_ &&
+      ((options.pool_block_size_ == 0) ||
+       (options.pool_block_size_ > byte_size))) {
     return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "invalid pool block size " +
+            std::to_string(options.pool_block_size_) +
+            " for shared memory region '" + name + "' of " +
+            std::to_string(byte_size) + " bytes")
+            .c_str());
+  }
+
+  // The client of a descriptor may have created it with any size, a
+  // mapping past its end would fault in the server.
+  bool sealed = false;
+  TRITONSERVER_Error* err_mmap = nullptr;
+  if (by_descriptor) {
+    err_mmap = CheckDescriptor(shm_fd, offset, byte_size, &sealed);
+  }
+
+  // Mappings of hugetlbfs files must be aligned to the huge page size.
+  size_t huge_page_size = 0;
+  if (err_mmap == nullptr) {
+    err_mmap = HugetlbfsPageSize(shm_fd, &huge_page_size);
+  }
+  if ((err_mmap == nullptr) && (huge_page_size != 0) &&
+      (((offset % huge_page_size) != 0) ||
+       ((byte_size % huge_page_size) != 0))) {
+    err_mmap = TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "offset and byte size must be multiples of the huge page size " +
+            std::to_string(huge_page_size) + " of '" + shm_key + "'")
+            .c_str());
+  }
+
+  void* mapped_addr;
+  if (err_mmap == nullptr) {
+    err_mmap =
+        MapSharedMemory(shm_fd, offset, byte_size, options, &mapped_addr);
+  }
+  if (err_mmap != nullptr) {
+    TRITONSERVER_Error* err = TRITONSERVER_ErrorNew(
         TRITONSERVER_ERROR_INVALID_ARG,
         std::string(
             "failed to register shared memory region '" + name +
-            "': " + TRITONSERVER_ErrorMessage(err_close))
+            "': " + TRITONSERVER_ErrorMessage(err_mmap))
             .c_str());
+    TRITONSERVER_ErrorDelete(err_mmap);
+    return err;
   }
 
-  shared_memory_map_.insert(std::make_pair(
-      name, std::unique_ptr<SharedMemoryInfo>(new SharedMemoryInfo(
-                name, shm_key, offset, byte_size, shm_fd, mapped_addr,
-                TRITONSERVER_MEMORY_CPU, 0))));
+  const uint64_t region_handle = next_handle_++;
+  std::shared_ptr<SharedMemoryInfo> info(new SharedMemoryInfo(
+      name, shm_key, offset, byte_size, shm_fd, mapped_addr,
+      TRITONSERVER_MEMORY_CPU, 0, region_handle));
+  info->options_ = options;
+  info->hugetlbfs_ = (huge_page_size != 0);
+  info->sealed_ = sealed;
+  if (options.pool_) {
+    // The mapping starts at 'offset' in the shared memory object.
+    info->pool_.reset(new SharedMemoryPool(
+        mapped_addr, byte_size, options.pool_block_size_,
+        options.pool_lease_ms_));
+  }
+  std::unique_ptr<SharedMemoryTable> new_table(new SharedMemoryTable(*table));
+  new_table->by_name_.emplace(name, info);
+  new_table->by_handle_.emplace(region_handle, info);
+  Publish(std::move(new_table));
 
+  if (handle != nullptr) {
+    *handle = region_handle;
+  }
   return nullptr;  // success
 }
 
@@ -293,14 +928,15 @@ SharedMemoryManager::RegisterSystemSharedMemory(
 TRITONSERVER_Error*
 SharedMemoryManager::RegisterCUDASharedMemory(
     const std::string& name, const cudaIpcMemHandle_t* cuda_shm_handle,
-    const size_t byte_size, const int device_id)
+    const size_t byte_size, const int device_id, uint64_t* handle)
 {
-  // Serialize all operations that write/read current shared memory regions
+  // Serialize all operations that modify the shared memory regions
   std::lock_guard<std::mutex> lock(mu_);
+  const SharedMemoryTable* table = table_.load();
 
-  // If name is already in shared_memory_map_ then return error saying already
+  // If name is already in the table then return error saying already
   // registered
-  if (shared_memory_map_.find(name) != shared_memory_map_.end()) {
+  if (table->by_name_.find(name) != table->by_name_.end()) {
     return TRITONSERVER_ErrorNew(
         TRITONSERVER_ERROR_ALREADY_EXISTS,
         std::string("shared memory region '" + name + "' already in manager")
@@ -322,63 +958,84 @@ SharedMemoryManager::RegisterCUDASharedMemory(
             .c_str());
   }
 
-  shared_memory_map_.insert(std::make_pair(
-      name, std::unique_ptr<CUDASharedMemoryInfo>(new CUDASharedMemoryInfo(
-                name, "", 0, byte_size, 0, mapped_addr, TRITONSERVER_MEMORY_GPU,
-                device_id, cuda_shm_handle))));
+  const uint64_t region_handle = next_handle_++;
+  std::shared_ptr<SharedMemoryInfo> info(new CUDASharedMemoryInfo(
+      name, "", 0, byte_size, 0, mapped_addr, TRITONSERVER_MEMORY_GPU,
+      device_id, region_handle, cuda_shm_handle));
+  std::unique_ptr<SharedMemoryTable> new_table(new SharedMemoryTable(*table));
+  new_table->by_name_.emplace(name, info);
+  new_table->by_handle_.emplace(region_handle, info);
+  Publish(std::move(new_table));
 
+  if (handle != nullptr) {
+    *handle = region_handle;
+  }
   return nullptr;  // success
 }
 #endif  // TRITON_ENABLE_GPU
 
 TRITONSERVER_Error*
 SharedMemoryManager::GetMemoryInfo(
-    const std::string& name, size_t offset, void** shm_mapped_addr,
-    TRITONSERVER_MemoryType* memory_type, int64_t* device_id)
+    const std::string& name, const uint64_t handle, size_t offset,
+    void** shm_mapped_addr, TRITONSERVER_MemoryType* memory_type,
+    int64_t* device_id, Reference* reference, size_t* byte_size,
+    SharedMemoryPool** pool)
 {
-  // protect shared_memory_map_ from concurrent access
-  std::lock_guard<std::mutex> lock(mu_);
+  return Find(
+      name, handle, [&](const std::shared_ptr<SharedMemoryInfo>& info) {
+        // System shared memory is mapped from the offset of the block,
+        // so the mapping starts at the block like CUDA shared memory.
+        *shm_mapped_addr = (void*)((uint8_t*)info->mapped_addr_ + offset);
+        *memory_type = info->kind_;
+        *device_id = info->device_id_;
+        if (reference != nullptr) {
+          *reference = info;
+        }
+        if (byte_size != nullptr) {
+          *byte_size = info->byte_size_;
+        }
+        if (pool != nullptr) {
+          *pool = info->pool_.get();
+        }
+      });
+}
 
-  auto it = shared_memory_map_.find(name);
-  if (it == shared_memory_map_.end()) {
+TRITONSERVER_Error*
+SharedMemoryManager::ReleasePoolAllocation(
+    const std::string& name, const uint64_t handle, const size_t offset,
+    const uint64_t lease)
+{
+  SharedMemoryPool* pool = nullptr;
+  Reference reference;
+  RETURN_IF_ERR(Find(
+      name, handle, [&](const std::shared_ptr<SharedMemoryInfo>& info) {
+        pool = info->pool_.get();
+        reference = info;
+      }));
+  if (pool == nullptr) {
     return TRITONSERVER_ErrorNew(
-        TRITONSERVER_ERROR_NOT_FOUND,
-        std::string("Unable to find shared memory region: '" + name + "'")
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "shared memory region '" +
+            (name.empty() ? std::to_string(handle) : name) +
+            "' is not an output pool")
             .c_str());
   }
-  if (it->second->kind_ == TRITONSERVER_MEMORY_CPU) {
-    *shm_mapped_addr = (void*)((uint8_t*)it->second->mapped_addr_ +
-                               it->second->offset_ + offset);
-  } else {
-    *shm_mapped_addr = (void*)((uint8_t*)it->second->mapped_addr_ + offset);
-  }
-
-  *memory_type = it->second->kind_;
-  *device_id = it->second->device_id_;
-
-  return nullptr;
+  return pool->Release(offset, lease);
 }
 
 #ifdef TRITON_ENABLE_GPU
 TRITONSERVER_Error*
 SharedMemoryManager::GetCUDAHandle(
-    const std::string& name, cudaIpcMemHandle_t** cuda_mem_handle)
+    const std::string& name, const uint64_t handle,
+    cudaIpcMemHandle_t** cuda_mem_handle)
 {
-  // protect shared_memory_map_ from concurrent access
-  std::lock_guard<std::mutex> lock(mu_);
-
-  auto it = shared_memory_map_.find(name);
-  if (it == shared_memory_map_.end()) {
-    return TRITONSERVER_ErrorNew(
-        TRITONSERVER_ERROR_NOT_FOUND,
-        std::string("Unable to find shared memory region: '" + name + "'")
-            .c_str());
-  }
-  CUDASharedMemoryInfo& shm_info =
-      reinterpret_cast<CUDASharedMemoryInfo&>(*(it->second));
-  *cuda_mem_handle = &(shm_info.cuda_ipc_handle_);
-
-  return nullptr;
+  return Find(
+      name, handle, [&](const std::shared_ptr<SharedMemoryInfo>& info) {
+        CUDASharedMemoryInfo& shm_info =
+            reinterpret_cast<CUDASharedMemoryInfo&>(*info);
+        *cuda_mem_handle = &(shm_info.cuda_ipc_handle_);
+      });
 }
 #endif
 
@@ -387,32 +1044,19 @@ SharedMemoryManager::GetStatus(
     const std::string& name, TRITONSERVER_MemoryType memory_type,
     triton::common::TritonJson::Value* shm_status)
 {
+  // Status requests are rare, read the table under the lock rather than
+  // as a reader.
   std::lock_guard<std::mutex> lock(mu_);
-
+  const SharedMemoryTable* table = table_.load();
   if (name.empty()) {
-    for (const auto& shm_info : shared_memory_map_) {
+    for (const auto& shm_info : table->by_name_) {
       if (shm_info.second->kind_ == memory_type) {
-        triton::common::TritonJson::Value shm_region(
-            *shm_status, triton::common::TritonJson::ValueType::OBJECT);
-        RETURN_IF_ERR(shm_region.AddString(
-            "name", shm_info.first.c_str(), shm_info.first.size()));
-        if (memory_type == TRITONSERVER_MEMORY_CPU) {
-          RETURN_IF_ERR(shm_region.AddString(
-              "key", shm_info.second->shm_key_.c_str(),
-              shm_info.second->shm_key_.size()));
-          RETURN_IF_ERR(shm_region.AddUInt("offset", shm_info.second->offset_));
-        } else {
-          RETURN_IF_ERR(
-              shm_region.AddUInt("device_id", shm_info.second->device_id_));
-        }
-        RETURN_IF_ERR(
-            shm_region.AddUInt("byte_size", shm_info.second->byte_size_));
-        RETURN_IF_ERR(shm_status->Append(std::move(shm_region)));
+        RETURN_IF_ERR(AppendStatus(*shm_info.second, shm_status));
       }
     }
   } else {
-    auto it = shared_memory_map_.find(name);
-    if (it == shared_memory_map_.end()) {
+    auto it = table->by_name_.find(name);
+    if (it == table->by_name_.end()) {
       return TRITONSERVER_ErrorNew(
           TRITONSERVER_ERROR_NOT_FOUND,
           std::string(
@@ -440,20 +1084,48 @@ SharedMemoryManager::GetStatus(
       }
     }
 
-    triton::common::TritonJson::Value shm_region(
-        *shm_status, triton::common::TritonJson::ValueType::OBJECT);
+    RETURN_IF_ERR(AppendStatus(*it->second, shm_status));
+  }
+
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+SharedMemoryManager::AppendStatus(
+    const SharedMemoryInfo& info,
+    triton::common::TritonJson::Value* shm_status)
+{
+  triton::common::TritonJson::Value shm_region(
+      *shm_status, triton::common::TritonJson::ValueType::OBJECT);
+  RETURN_IF_ERR(
+      shm_region.AddString("name", info.name_.c_str(), info.name_.size()));
+  if (info.kind_ == TRITONSERVER_MEMORY_CPU) {
     RETURN_IF_ERR(shm_region.AddString(
-        "name", it->second->name_.c_str(), it->second->name_.size()));
-    if (memory_type == TRITONSERVER_MEMORY_CPU) {
-      RETURN_IF_ERR(shm_region.AddString(
-          "key", it->second->shm_key_.c_str(), it->second->shm_key_.size()));
-      RETURN_IF_ERR(shm_region.AddUInt("offset", it->second->offset_));
-    } else {
-      RETURN_IF_ERR(shm_region.AddUInt("device_id", it->second->device_id_));
+        "key", info.shm_key_.c_str(), info.shm_key_.size()));
+    RETURN_IF_ERR(shm_region.AddUInt("offset", info.offset_));
+  } else {
+    RETURN_IF_ERR(shm_region.AddUInt("device_id", info.device_id_));
+  }
+  RETURN_IF_ERR(shm_region.AddUInt("byte_size", info.byte_size_));
+  RETURN_IF_ERR(shm_region.AddUInt("handle", info.handle_));
+  if (info.kind_ == TRITONSERVER_MEMORY_CPU) {
+    RETURN_IF_ERR(shm_region.AddBool("prefault", info.options_.prefault_));
+    RETURN_IF_ERR(
+        shm_region.AddBool("huge_pages", info.options_.huge_pages_));
+    RETURN_IF_ERR(shm_region.AddBool("hugetlbfs", info.hugetlbfs_));
+    RETURN_IF_ERR(shm_region.AddBool("lock", info.options_.lock_));
+    RETURN_IF_ERR(shm_region.AddInt("numa_node", info.options_.numa_node_));
+    RETURN_IF_ERR(shm_region.AddBool("sealed", info.sealed_));
+    RETURN_IF_ERR(shm_region.AddBool("pool", info.pool_ != nullptr));
+    if (info.pool_ != nullptr) {
+      RETURN_IF_ERR(
+          shm_region.AddUInt("pool_block_size", info.pool_->BlockSize()));
+      RETURN_IF_ERR(shm_region.AddUInt("pool_lease_ms", info.pool_->LeaseMs()));
+      RETURN_IF_ERR(
+          shm_region.AddUInt("pool_used_bytes", info.pool_->UsedBytes()));
     }
-    RETURN_IF_ERR(shm_region.AddUInt("byte_size", it->second->byte_size_));
-    RETURN_IF_ERR(shm_status->Append(std::move(shm_region)));
   }
+  RETURN_IF_ERR(shm_status->Append(std::move(shm_region)));
 
   return nullptr;  // success
 }
@@ -462,45 +1134,43 @@ TRITONSERVER_Error*
 SharedMemoryManager::Unregister(
     const std::string& name, TRITONSERVER_MemoryType memory_type)
 {
-  // Serialize all operations that write/read current shared memory regions
+  // Serialize all operations that modify the shared memory regions
   std::lock_guard<std::mutex> lock(mu_);
-
-  return UnregisterHelper(name, memory_type);
+  std::unique_ptr<SharedMemoryTable> new_table(
+      new SharedMemoryTable(*table_.load()));
+  RETURN_IF_ERR(UnregisterHelper(name, memory_type, new_table.get()));
+  Publish(std::move(new_table));
+  return nullptr;
 }
 
 TRITONSERVER_Error*
 SharedMemoryManager::UnregisterAll(TRITONSERVER_MemoryType memory_type)
 {
+  // Serialize all operations that modify the shared memory regions
   std::lock_guard<std::mutex> lock(mu_);
+  std::unique_ptr<SharedMemoryTable> new_table(
+      new SharedMemoryTable(*table_.load()));
   std::string error_message = "Failed to unregister the following ";
   std::vector<std::string> unregister_fails;
   if (memory_type == TRITONSERVER_MEMORY_CPU) {
-    // Serialize all operations that write/read current shared memory regions
     error_message += "system shared memory regions: ";
-    for (auto it = shared_memory_map_.cbegin(), next_it = it;
-         it != shared_memory_map_.cend(); it = next_it) {
-      ++next_it;
-      if (it->second->kind_ == TRITONSERVER_MEMORY_CPU) {
-        TRITONSERVER_Error* err = UnregisterHelper(it->first, memory_type);
-        if (err != nullptr) {
-          unregister_fails.push_back(it->first);
-        }
-      }
-    }
   } else if (memory_type == TRITONSERVER_MEMORY_GPU) {
     error_message += "cuda shared memory regions: ";
-    for (auto it = shared_memory_map_.cbegin(), next_it = it;
-         it != shared_memory_map_.cend(); it = next_it) {
-      ++next_it;
-      if (it->second->kind_ == TRITONSERVER_MEMORY_GPU) {
-        TRITONSERVER_Error* err = UnregisterHelper(it->first, memory_type);
-        ;
-        if (err != nullptr) {
-          unregister_fails.push_back(it->first);
-        }
+  }
+  for (auto it = new_table->by_name_.cbegin(), next_it = it;
+       it != new_table->by_name_.cend(); it = next_it) {
+    ++next_it;
+    if (it->second->kind_ == memory_type) {
+      const std::string name = it->first;
+      TRITONSERVER_Error* err =
+          UnregisterHelper(name, memory_type, new_table.get());
+      if (err != nullptr) {
+        unregister_fails.push_back(name);
+        TRITONSERVER_ErrorDelete(err);
       }
     }
   }
+  Publish(std::move(new_table));
 
   if (!unregister_fails.empty()) {
     for (auto unreg_fail : unregister_fails) {
@@ -514,39 +1184,46 @@ SharedMemoryManager::UnregisterAll(TRITONSERVER_MemoryType memory_type)
   return nullptr;
 }
 
+TRITONSERVER_Error*
+SharedMemoryManager::UnregisterHandle(const uint64_t handle)
+{
+  // Serialize all operations that modify the shared memory regions
+  std::lock_guard<std::mutex> lock(mu_);
+  const SharedMemoryTable* table = table_.load();
+  auto it = table->by_handle_.find(handle);
+  if (it == table->by_handle_.end()) {
+    return nullptr;  // already unregistered
+  }
+  std::unique_ptr<SharedMemoryTable> new_table(new SharedMemoryTable(*table));
+  RETURN_IF_ERR(UnregisterHelper(
+      it->second->name_, it->second->kind_, new_table.get()));
+  Publish(std::move(new_table));
+  return nullptr;
+}
+
 TRITONSERVER_Error*
 SharedMemoryManager::UnregisterHelper(
-    const std::string& name, TRITONSERVER_MemoryType memory_type)
+    const std::string& name, TRITONSERVER_MemoryType memory_type,
+    SharedMemoryTable* table)
 {
-  // Must hold the lock on register_mu_ while calling this function.
-  auto it = shared_memory_map_.find(name);
-  if (it != shared_memory_map_.end() && it->second->kind_ == memory_type) {
-    if (it->second->kind_ == TRITONSERVER_MEMORY_CPU) {
-      RETURN_IF_ERR(
-          UnmapSharedMemory(it->second->mapped_addr_, it->second->byte_size_));
-    } else {
-#ifdef TRITON_ENABLE_GPU
-      cudaError_t err = cudaIpcCloseMemHandle(it->second->mapped_addr_);
-      if (err != cudaSuccess) {
-        return TRITONSERVER_ErrorNew(
-            TRITONSERVER_ERROR_INTERNAL,
-            std::string(
-                "failed to close CUDA IPC handle: " +
-                std::string(cudaGetErrorString(err)))
-                .c_str());
-      }
-#else
+  // Must hold the lock on mu_ while calling this function. The region is
+  // unmapped when the last reference to it is released.
+  auto it = table->by_name_.find(name);
+  if (it != table->by_name_.end() && it->second->kind_ == memory_type) {
+#ifndef TRITON_ENABLE_GPU
+    if (it->second->kind_ != TRITONSERVER_MEMORY_CPU) {
       return TRITONSERVER_ErrorNew(
           TRITONSERVER_ERROR_INVALID_ARG,
           std::string(
               "failed to unregister CUDA shared memory region: '" + name +
               "', GPUs not supported")
               .c_str());
-#endif  // TRITON_ENABLE_GPU
     }
+#endif  // TRITON_ENABLE_GPU
 
-    // Remove region information from shared_memory_map_
-    shared_memory_map_.erase(it);
+    // Remove region information from the table
+    table->by_handle_.erase(it->second->handle_);
+    table->by_name_.erase(it);
   }
 
   return nullptr;
@@ -25,11 +25,15 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 
+#include "shared_memory_pool.h"
 #include "triton/core/tritonserver.h"
 
 #define TRITONJSON_STATUSTYPE TRITONSERVER_Error*
@@ -44,24 +48,120 @@
 
 namespace triton { namespace server {
 
+//
+// SharedMemoryManager
+//
+// The shared memory blocks registered by the clients. Looking up a
+// block, done for every tensor in shared memory, doesn't lock: the
+// blocks are kept in an immutable table that registering and
+// unregistering replace. A block is unmapped once it is unregistered
+// and no longer referenced, so that in-flight requests can keep using
+// a block that is unregistered concurrently.
+//
 class SharedMemoryManager {
  public:
-  SharedMemoryManager() = default;
+  /// Keeps a shared memory block mapped while held, even after the
+  /// block is unregistered.
+  using Reference = std::shared_ptr<const void>;
+
+  /// How a system shared memory block is mapped into the server. Keys
+  /// that are file paths are opened as files instead of POSIX shared
+  /// memory objects, only files on a hugetlbfs mount under one of the
+  /// configured directories are accepted.
+  struct MappingOptions {
+    MappingOptions()
+        : prefault_(false), huge_pages_(false), lock_(false), numa_node_(-1),
+          pool_(false), pool_block_size_(4096), pool_lease_ms_(0)
+    {
+    }
+
+    /// Fault in all the pages of the block at registration so that
+    /// inferences don't take the page faults.
+    bool prefault_;
+
+    /// Ask for the block to be backed by transparent huge pages.
+    bool huge_pages_;
+
+    /// Lock the pages of the block in memory.
+    bool lock_;
+
+    /// The NUMA node to allocate the pages of the block on, -1 to use
+    /// the default policy.
+    int numa_node_;
+
+    /// Use the block as a pool that the server allocates the outputs
+    /// in, see SharedMemoryPool.
+    bool pool_;
+
+    /// The granularity of the allocations in the pool.
+    size_t pool_block_size_;
+
+    /// How long an allocation in the pool is guaranteed to stay
+    /// allocated if not released, 0 for until it is released.
+    uint64_t pool_lease_ms_;
+  };
+
+  /// \param hugetlbfs_dirs The directories, on hugetlbfs mounts, that
+  /// the files registered by path must be in. Registering by path is
+  /// rejected if empty.
+  explicit SharedMemoryManager(
+      const std::vector<std::string>& hugetlbfs_dirs =
+          std::vector<std::string>());
   ~SharedMemoryManager();
 
+  /// Parse the mapping options of a system shared memory register
+  /// request, the options that are not in 'register_request' are left
+  /// unchanged in 'options'.
+  /// \param register_request The JSON register request.
+  /// \param options Returns the mapping options.
+  /// \return a TRITONSERVER_Error indicating success or failure.
+  static TRITONSERVER_Error* ParseMappingOptions(
+      triton::common::TritonJson::Value& register_request,
+      MappingOptions* options);
+
+  /// Check that 'numa_node', requested by a client, is a NUMA node that
+  /// the system can have.
+  /// \param numa_node The NUMA node.
+  /// \return a TRITONSERVER_Error indicating success or failure.
+  static TRITONSERVER_Error* CheckNumaNode(const int64_t numa_node);
+
   /// Add a shared memory block representing shared memory in system
   /// (CPU) memory to the manager. Return TRITONSERVER_ERROR_ALREADY_EXISTS
   /// if a shared memory block of the same name already exists in the manager.
   /// \param name The name of the memory block.
   /// \param shm_key The name of the posix shared memory object
-  /// containing the block of memory.
+  /// containing the block of memory, or the path of a hugetlbfs file
+  /// under one of the configured directories.
   /// \param offset The offset within the shared memory object to the
   /// start of the block.
   /// \param byte_size The size, in bytes of the block.
+  /// \param options How to map the block.
+  /// \param handle Returns the handle of the block, which can be used
+  /// instead of the name to refer to the block. Handles are never
+  /// reused.
   /// \return a TRITONSERVER_Error indicating success or failure.
   TRITONSERVER_Error* RegisterSystemSharedMemory(
       const std::string& name, const std::string& shm_key, const size_t offset,
-      const size_t byte_size);
+      const size_t byte_size, const MappingOptions& options = MappingOptions(),
+      uint64_t* handle = nullptr);
+
+  /// Add a shared memory block in system (CPU) memory backed by a file
+  /// descriptor the client passed to the server, for example a memfd.
+  /// Return TRITONSERVER_ERROR_ALREADY_EXISTS if a shared memory block
+  /// of the same name already exists in the manager.
+  /// \param name The name of the memory block.
+  /// \param shm_fd The descriptor of the memory. The caller keeps
+  /// ownership, it can be closed once the block is registered.
+  /// \param offset The offset within the descriptor to the start of the
+  /// block.
+  /// \param byte_size The size, in bytes of the block.
+  /// \param options How to map the block.
+  /// \param handle Returns the handle of the block.
+  /// \return a TRITONSERVER_Error indicating success or failure.
+  TRITONSERVER_Error* RegisterSystemSharedMemoryFd(
+      const std::string& name, const int shm_fd, const size_t offset,
+      const size_t byte_size, const MappingOptions& options = MappingOptions(),
+      uint64_t* handle = nullptr);
 
 #ifdef TRITON_ENABLE_GPU
   /// Add a shared memory block representing shared memory in CUDA
@@ -72,36 +172,67 @@ class SharedMemoryManager {
   /// memory block.
   /// \param byte_size The size, in bytes of the block.
   /// \param device id The GPU number the shared memory region is in.
+  /// \param handle Returns the handle of the block, which can be used
+  /// instead of the name to refer to the block. Handles are never
+  /// reused.
   /// \return a TRITONSERVER_Error indicating success or failure.
   TRITONSERVER_Error* RegisterCUDASharedMemory(
       const std::string& name, const cudaIpcMemHandle_t* cuda_shm_handle,
-      const size_t byte_size, const int device_id);
+      const size_t byte_size, const int device_id, uint64_t* handle = nullptr);
 #endif  // TRITON_ENABLE_GPU
 
   /// Get the access information for the shared memory block
-  /// with the specified name. Return TRITONSERVER_ERROR_NOT_FOUND
-  /// if named block doesn't exist.
+  /// with the specified handle, or name if the handle is 0. Return
+  /// TRITONSERVER_ERROR_NOT_FOUND if the block doesn't exist.
   /// \param name The name of the shared memory block to get.
+  /// \param handle The handle of the shared memory block to get, 0 to
+  /// get the block by name.
   /// \param offset The offset in the block
   /// \param shm_mapped_addr Returns the pointer to the shared
   /// memory block with the specified name and offset
   /// \param memory_type Returns the type of the memory
   /// \param device_id Returns the device id associated with the
   /// memory block
+  /// \param reference If not nullptr, returns a reference that keeps the
+  /// block mapped. Must be held while 'shm_mapped_addr' is in use if the
+  /// block may be unregistered meanwhile.
+  /// \param byte_size If not nullptr, returns the size of the block.
+  /// \param pool If not nullptr, returns the pool of the block if it was
+  /// registered as a pool, nullptr otherwise. The pool lives as long as
+  /// the block is referenced.
   /// \return a TRITONSERVER_Error indicating success or failure.
   TRITONSERVER_Error* GetMemoryInfo(
-      const std::string& name, size_t offset, void** shm_mapped_addr,
-      TRITONSERVER_MemoryType* memory_type, int64_t* device_id);
+      const std::string& name, const uint64_t handle, size_t offset,
+      void** shm_mapped_addr, TRITONSERVER_MemoryType* memory_type,
+      int64_t* device_id, Reference* reference = nullptr,
+      size_t* byte_size = nullptr, SharedMemoryPool** pool = nullptr);
+
+  /// Release an allocation of an output in the block with the specified
+  /// handle, or name if the handle is 0, that was registered as a pool.
+  /// \param name The name of the shared memory block.
+  /// \param handle The handle of the shared memory block, 0 to get the
+  /// block by name.
+  /// \param offset The offset of the allocation in the block.
+  /// \param lease The lease of the allocation.
+  /// \return a TRITONSERVER_Error indicating success or failure.
+  TRITONSERVER_Error* ReleasePoolAllocation(
+      const std::string& name, const uint64_t handle, const size_t offset,
+      const uint64_t lease);
 
 #ifdef TRITON_ENABLE_GPU
-  /// Get the CUDA memory handle associated with the block name.
-  /// Return TRITONSERVER_ERROR_NOT_FOUND if named block doesn't exist.
+  /// Get the CUDA memory handle associated with the block handle, or
+  /// name if the handle is 0. Return TRITONSERVER_ERROR_NOT_FOUND if the
+  /// block doesn't exist. The memory handle is valid while the block is
+  /// referenced.
   /// \param name The name of the shared memory block to get.
+  /// \param handle The handle of the shared memory block to get, 0 to
+  /// get the block by name.
   /// \param cuda_mem_handle Returns the cuda memory handle with the memory
   /// block.
   /// \return a TRITONSERVER_Error indicating success or failure.
   TRITONSERVER_Error* GetCUDAHandle(
-      const std::string& name, cudaIpcMemHandle_t** cuda_mem_handle);
+      const std::string& name, const uint64_t handle,
+      cudaIpcMemHandle_t** cuda_mem_handle);
 #endif
 
   /// Populates the status of active system/CUDA shared memory regions
@@ -118,7 +249,8 @@ class SharedMemoryManager {
   /// Removes the named shared memory block of the specified type from
   /// the manager. Any future attempt to get the details of this block
   /// will result in an array till another block with the same name is
-  /// added to the manager.
+  /// added to the manager. The block is unmapped once it is no longer
+  /// referenced.
   /// \param name The name of the shared memory block to remove.
   /// \param memory_type The type of memory to unregister.
   /// \return a TRITONSERVER_Error indicating success or failure.
@@ -130,26 +262,29 @@ class SharedMemoryManager {
   /// \return a TRITONSERVER_Error indicating success or failure.
   TRITONSERVER_Error* UnregisterAll(TRITONSERVER_MemoryType memory_type);
 
- private:
-  /// A helper function to remove the named shared memory blocks of
-  /// specified type
-  TRITONSERVER_Error* UnregisterHelper(
-      const std::string& name, TRITONSERVER_MemoryType memory_type);
+  /// Removes the shared memory block with 'handle' from the manager, if
+  /// it is still registered.
+  /// \param handle The handle of the shared memory block to remove.
+  /// \return a TRITONSERVER_Error indicating success or failure.
+  TRITONSERVER_Error* UnregisterHandle(const uint64_t handle);
 
+ private:
   /// A struct that records the shared memory regions registered by the shared
-  /// memory manager.
+  /// memory manager. Unmaps the region when destroyed.
   struct SharedMemoryInfo {
     SharedMemoryInfo(
         const std::string& name, const std::string& shm_key,
         const size_t offset, const size_t byte_size, int shm_fd,
         void* mapped_addr, const TRITONSERVER_MemoryType kind,
-        const int64_t device_id)
+        const int64_t device_id, const uint64_t handle)
         : name_(name), shm_key_(shm_key), offset_(offset),
           byte_size_(byte_size), shm_fd_(shm_fd), mapped_addr_(mapped_addr),
-          kind_(kind), device_id_(device_id)
+          kind_(kind), device_id_(device_id), handle_(handle)
     {
     }
 
+    virtual ~SharedMemoryInfo();
+
     std::string name_;
     std::string shm_key_;
     size_t offset_;
@@ -158,6 +293,16 @@ class SharedMemoryManager {
     void* mapped_addr_;
     TRITONSERVER_MemoryType kind_;
     int64_t device_id_;
+    uint64_t handle_;
+
+    // Only used by system shared memory blocks.
+    MappingOptions options_;
+    bool hugetlbfs_ = false;
+    // Whether the size of the memory is sealed, only set for blocks
+    // registered by descriptor.
+    bool sealed_ = false;
+    // The allocator of the outputs if the block is a pool.
+    std::unique_ptr<SharedMemoryPool> pool_;
   };
 
 #ifdef TRITON_ENABLE_GPU
@@ -166,10 +311,11 @@ class SharedMemoryManager {
         const std::string& name, const std::string& shm_key,
         const size_t offset, const size_t byte_size, int shm_fd,
         void* mapped_addr, const TRITONSERVER_MemoryType kind,
-        const int64_t device_id, const cudaIpcMemHandle_t* cuda_ipc_handle)
+        const int64_t device_id, const uint64_t handle,
+        const cudaIpcMemHandle_t* cuda_ipc_handle)
         : SharedMemoryInfo(
               name, shm_key, offset, byte_size, shm_fd, mapped_addr, kind,
-              device_id),
+              device_id, handle),
           cuda_ipc_handle_(*cuda_ipc_handle)
     {
     }
@@ -178,12 +324,66 @@ class SharedMemoryManager {
   };
 #endif
 
-  using SharedMemoryStateMap =
-      std::map<std::string, std::unique_ptr<SharedMemoryInfo>>;
-  // A map between the name and the details of the associated
-  // shared memory block
-  SharedMemoryStateMap shared_memory_map_;
-  // A mutex to protect the concurrent access to shared_memory_map_
+  // The registered shared memory blocks, by name and by handle. A table
+  // is never modified once published.
+  struct SharedMemoryTable {
+    std::map<std::string, std::shared_ptr<SharedMemoryInfo>> by_name_;
+    std::unordered_map<uint64_t, std::shared_ptr<SharedMemoryInfo>>
+        by_handle_;
+  };
+
+  // Lookups announce themselves in the reader slot of their thread, for
+  // the parity of the epoch they start in. A writer that replaces the
+  // table advances the epoch and waits for the readers of the previous
+  // epoch to leave before deleting the previous table. The slots are
+  // padded so that readers on different threads don't share a cache
+  // line.
+  static constexpr size_t kReaderSlotCount = 64;
+  struct alignas(64) ReaderSlot {
+    std::atomic<uint64_t> readers_[2];
+  };
+
+  /// Find the block with 'handle', or 'name' if 'handle' is 0, in the
+  /// current table and call 'fn' with it while the table is protected.
+  template <typename Fn>
+  TRITONSERVER_Error* Find(
+      const std::string& name, const uint64_t handle, Fn&& fn);
+
+  /// Map 'shm_fd' and add the block to the manager, 'shm_key' is only
+  /// used to report the block.
+  TRITONSERVER_Error* RegisterSystemSharedMemoryHelper(
+      const std::string& name, const std::string& shm_key, const int shm_fd,
+      const bool by_descriptor, const size_t offset, const size_t byte_size,
+      const MappingOptions& options, uint64_t* handle);
+
+  /// Publish 'table' and delete the previous table once no lookup uses
+  /// it. Must hold 'mu_'.
+  void Publish(std::unique_ptr<SharedMemoryTable>&& table);
+
+  /// Append the status of 'info' to 'shm_status'.
+  static TRITONSERVER_Error* AppendStatus(
+      const SharedMemoryInfo& info,
+      triton::common::TritonJson::Value* shm_status);
+
+  /// A helper function to remove the named shared memory blocks of
+  /// specified type from 'table'.
+  TRITONSERVER_Error* UnregisterHelper(
+      const std::string& name, TRITONSERVER_MemoryType memory_type,
+      SharedMemoryTable* table);
+
+  // The current table, replaced by Publish().
+  std::atomic<SharedMemoryTable*> table_;
+  std::atomic<uint64_t> epoch_;
+  ReaderSlot reader_slots_[kReaderSlotCount];
+
+  // The handle of the next registered block.
+  uint64_t next_handle_;
+
+  // The canonical paths of the directories that the files registered by
+  // path must be in.
+  std::vector<std::string> hugetlbfs_dirs_;
+
+  // A mutex to serialize the modifications of the table
   std::mutex mu_;
 };
 }}  // namespace triton::server
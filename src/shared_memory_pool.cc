@@ -0,0 +1,382 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "shared_memory_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <string>
+
+namespace triton { namespace server {
+
+namespace {
+
+constexpr uint64_t kBlockCountMask = 0xFFFFFFFFull;
+
+// The bits of word 'word' that are in the 'count' blocks from 'first'.
+uint64_t
+RangeMask(const size_t first, const size_t count, const size_t word)
+{
+  const size_t word_begin = word * 64;
+  const size_t lo = std::max(first, word_begin) - word_begin;
+  const size_t hi = std::min(first + count, word_begin + 64) - word_begin;
+  const size_t bits = hi - lo;
+  return ((bits == 64) ? ~0ull : ((1ull << bits) - 1)) << lo;
+}
+
+}  // namespace
+
+SharedMemoryPool::SharedMemoryPool(
+    void* base, const size_t byte_size, const size_t block_size,
+    const uint64_t lease_ms)
+    : base_(base), block_size_(block_size),
+      block_count_(byte_size / block_size), lease_ms_(lease_ms),
+      word_count_((block_count_ + kWordBits - 1) / kWordBits),
+      bitmap_(new std::atomic<uint64_t>[word_count_]),
+      records_(new std::atomic<uint64_t>[block_count_]), next_block_(0),
+      next_lease_(0), used_blocks_(0)
+{
+  for (size_t w = 0; w < word_count_; ++w) {
+    bitmap_[w].store(0);
+  }
+  if ((block_count_ % kWordBits) != 0) {
+    bitmap_[word_count_ - 1].store(~0ull << (block_count_ % kWordBits));
+  }
+  for (size_t b = 0; b < block_count_; ++b) {
+    records_[b].store(0);
+  }
+  if (lease_ms_ != 0) {
+    deadlines_.reset(new std::atomic<uint64_t>[block_count_]);
+    for (size_t b = 0; b < block_count_; ++b) {
+      deadlines_[b].store(0);
+    }
+  }
+}
+
+TRITONSERVER_Error*
+SharedMemoryPool::Allocate(
+    const size_t byte_size, size_t* offset, uint64_t* lease)
+{
+  *offset = 0;
+  *lease = 0;
+  if (byte_size == 0) {
+    return nullptr;  // success
+  }
+
+  const size_t count = (byte_size + block_size_ - 1) / block_size_;
+  if ((count <= block_count_) && (count <= kBlockCountMask)) {
+    // When the pool is full, reclaim the expired leases once and retry.
+    for (int attempt = 0; attempt < 2; ++attempt) {
+      size_t hint = next_block_.load(std::memory_order_relaxed);
+      if (hint >= block_count_) {
+        hint = 0;
+      }
+
+      // Another allocation may claim the run between finding and
+      // claiming it, in which case look again.
+      size_t first;
+      while (FindRun(hint, count, &first) ||
+             ((hint != 0) && FindRun(0, count, &first))) {
+        if (!Claim(first, count)) {
+          continue;
+        }
+
+        uint32_t lease_id;
+        do {
+          lease_id = next_lease_.fetch_add(1, std::memory_order_relaxed) + 1;
+        } while (lease_id == 0);
+        if (lease_ms_ != 0) {
+          deadlines_[first].store(UINT64_MAX, std::memory_order_relaxed);
+        }
+        records_[first].store(
+            (static_cast<uint64_t>(lease_id) << 32) | count,
+            std::memory_order_release);
+        used_blocks_.fetch_add(count, std::memory_order_relaxed);
+        next_block_.store(first + count, std::memory_order_relaxed);
+
+        *offset = first * block_size_;
+        *lease = lease_id;
+        return nullptr;  // success
+      }
+
+      if ((lease_ms_ == 0) || (ReclaimExpired() == 0)) {
+        break;
+      }
+    }
+  }
+
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNAVAILABLE,
+      std::string(
+          "shared memory pool has no free space for " +
+          std::to_string(byte_size) + " bytes, " +
+          std::to_string(UsedBytes()) + " of " +
+          std::to_string(block_count_ * block_size_) + " bytes are in use")
+          .c_str());
+}
+
+TRITONSERVER_Error*
+SharedMemoryPool::Release(const size_t offset, const uint64_t lease)
+{
+  size_t first;
+  uint64_t record;
+  if (FindRecord(offset, lease, &first, &record) &&
+      ReleaseRecord(first, record)) {
+    return nullptr;  // success
+  }
+
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_NOT_FOUND,
+      std::string(
+          "no allocation at offset " + std::to_string(offset) +
+          " with lease " + std::to_string(lease) + " in shared memory pool")
+          .c_str());
+}
+
+TRITONSERVER_Error*
+SharedMemoryPool::StartLease(const size_t offset, const uint64_t lease)
+{
+  size_t first;
+  uint64_t record;
+  if (!FindRecord(offset, lease, &first, &record)) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_NOT_FOUND,
+        std::string(
+            "no allocation at offset " + std::to_string(offset) +
+            " with lease " + std::to_string(lease) + " in shared memory pool")
+            .c_str());
+  }
+
+  if (lease_ms_ != 0) {
+    deadlines_[first].store(
+        NowNs() + lease_ms_ * 1000000, std::memory_order_relaxed);
+  }
+  return nullptr;  // success
+}
+
+size_t
+SharedMemoryPool::ReclaimExpired()
+{
+  if (lease_ms_ == 0) {
+    return 0;
+  }
+
+  const uint64_t now = NowNs();
+  size_t reclaimed = 0;
+  for (size_t b = 0; b < block_count_; ++b) {
+    const uint64_t record = records_[b].load(std::memory_order_acquire);
+    if ((record != 0) &&
+        (deadlines_[b].load(std::memory_order_relaxed) <= now) &&
+        ReleaseRecord(b, record)) {
+      ++reclaimed;
+    }
+  }
+
+  return reclaimed;
+}
+
+bool
+SharedMemoryPool::FindRun(
+    const size_t begin, const size_t count, size_t* first) const
+{
+  size_t run = 0;
+  size_t b = begin;
+  while (b < block_count_) {
+    const uint64_t word =
+        bitmap_[b / kWordBits].load(std::memory_order_relaxed);
+    const size_t bit = b % kWordBits;
+
+    // Skip whole words at once when possible. The bits past the last
+    // block are set so a free word only has blocks of the pool.
+    if ((bit == 0) && (word == ~0ull)) {
+      run = 0;
+      b += kWordBits;
+      continue;
+    }
+    if ((bit == 0) && (word == 0)) {
+      if (run == 0) {
+        *first = b;
+      }
+      run += kWordBits;
+      b += kWordBits;
+    } else {
+      if (((word >> bit) & 1) != 0) {
+        run = 0;
+      } else {
+        if (run == 0) {
+          *first = b;
+        }
+        ++run;
+      }
+      ++b;
+    }
+
+    if (run >= count) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool
+SharedMemoryPool::Claim(const size_t first, const size_t count)
+{
+  const size_t first_word = first / kWordBits;
+  const size_t last_word = (first + count - 1) / kWordBits;
+  for (size_t w = first_word; w <= last_word; ++w) {
+    const uint64_t mask = RangeMask(first, count, w);
+    uint64_t word = bitmap_[w].load(std::memory_order_relaxed);
+    do {
+      if ((word & mask) != 0) {
+        // Give back the words claimed so far.
+        for (size_t u = first_word; u < w; ++u) {
+          bitmap_[u].fetch_and(
+              ~RangeMask(first, count, u), std::memory_order_release);
+        }
+        return false;
+      }
+    } while (!bitmap_[w].compare_exchange_weak(
+        word, word | mask, std::memory_order_acq_rel,
+        std::memory_order_relaxed));
+  }
+
+  return true;
+}
+
+void
+SharedMemoryPool::Unclaim(const size_t first, const size_t count)
+{
+  const size_t last_word = (first + count - 1) / kWordBits;
+  for (size_t w = first / kWordBits; w <= last_word; ++w) {
+    bitmap_[w].fetch_and(
+        ~RangeMask(first, count, w), std::memory_order_release);
+  }
+}
+
+bool
+SharedMemoryPool::FindRecord(
+    const size_t offset, const uint64_t lease, size_t* first,
+    uint64_t* record) const
+{
+  if (((offset % block_size_) != 0) ||
+      ((offset / block_size_) >= block_count_) || (lease == 0) ||
+      (lease > UINT32_MAX)) {
+    return false;
+  }
+
+  *first = offset / block_size_;
+  *record = records_[*first].load(std::memory_order_acquire);
+  return (*record >> 32) == lease;
+}
+
+bool
+SharedMemoryPool::ReleaseRecord(const size_t first, uint64_t record)
+{
+  // Only one of concurrent releases of an allocation clears its record,
+  // and the blocks are freed after so a new allocation of them can't
+  // have its record cleared.
+  if (!records_[first].compare_exchange_strong(
+          record, 0, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+    return false;
+  }
+  const size_t count = record & kBlockCountMask;
+  Unclaim(first, count);
+  used_blocks_.fetch_sub(count, std::memory_order_relaxed);
+  return true;
+}
+
+uint64_t
+SharedMemoryPool::NowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void
+SharedMemoryPoolAllocations::Add(
+    SharedMemoryPool* pool, const std::shared_ptr<const void>& reference,
+    const size_t offset, const uint64_t lease, const uint32_t response)
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  allocations_.emplace_back(
+      Allocation{pool, reference, offset, lease, response});
+}
+
+void
+SharedMemoryPoolAllocations::Deliver(const uint32_t count)
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  auto it = allocations_.begin();
+  while (it != allocations_.end()) {
+    if (it->response_ < count) {
+      // The client may already have released the allocation.
+      TRITONSERVER_Error* err = it->pool_->StartLease(it->offset_, it->lease_);
+      if (err != nullptr) {
+        TRITONSERVER_ErrorDelete(err);
+      }
+      it = allocations_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void
+SharedMemoryPoolAllocations::ReleaseResponse(const uint32_t response)
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  auto it = allocations_.begin();
+  while (it != allocations_.end()) {
+    if (it->response_ == response) {
+      TRITONSERVER_Error* err = it->pool_->Release(it->offset_, it->lease_);
+      if (err != nullptr) {
+        TRITONSERVER_ErrorDelete(err);
+      }
+      it = allocations_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void
+SharedMemoryPoolAllocations::Release()
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  for (const auto& allocation : allocations_) {
+    TRITONSERVER_Error* err =
+        allocation.pool_->Release(allocation.offset_, allocation.lease_);
+    if (err != nullptr) {
+      TRITONSERVER_ErrorDelete(err);
+    }
+  }
+  allocations_.clear();
+}
+
+}}  // namespace triton::server
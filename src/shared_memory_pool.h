@@ -0,0 +1,205 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "triton/core/tritonserver.h"
+
+namespace triton { namespace server {
+
+//
+// SharedMemoryPool
+//
+// Sub-allocates the outputs of inferences in a system shared memory
+// region that the client registered as an output pool. The pool is
+// divided in fixed size blocks tracked by a bitmap, and an output takes
+// a run of consecutive blocks. Allocating and releasing only use atomic
+// operations on the bitmap so that the response allocators of
+// concurrent inferences never wait on each other.
+//
+// Every allocation is identified by a lease, which must be given back
+// with its offset to release it. If the pool has a lease duration, the
+// blocks of an allocation that isn't released in time after its lease
+// is started are reclaimed when the pool runs out of space, so a client
+// that loses track of an output doesn't leak it.
+//
+class SharedMemoryPool {
+ public:
+  /// Create a pool over the 'byte_size' bytes at 'base'.
+  /// \param block_size The granularity of the allocations.
+  /// \param lease_ms How long an allocation is guaranteed to stay
+  /// allocated, 0 for until it is released.
+  SharedMemoryPool(
+      void* base, const size_t byte_size, const size_t block_size,
+      const uint64_t lease_ms);
+
+  /// Allocate 'byte_size' bytes. Return TRITONSERVER_ERROR_UNAVAILABLE
+  /// if the pool has no run of free blocks large enough. An allocation
+  /// of 0 bytes takes no block and has lease 0. The allocation isn't
+  /// reclaimed until its lease is started with StartLease().
+  /// \param byte_size The size of the allocation.
+  /// \param offset Returns the offset of the allocation in the pool.
+  /// \param lease Returns the lease of the allocation.
+  /// \return a TRITONSERVER_Error indicating success or failure.
+  TRITONSERVER_Error* Allocate(
+      const size_t byte_size, size_t* offset, uint64_t* lease);
+
+  /// Release the allocation at 'offset'. Return
+  /// TRITONSERVER_ERROR_NOT_FOUND if 'offset' and 'lease' don't identify
+  /// a live allocation, for example because it was already released or
+  /// its lease expired and it was reclaimed.
+  /// \param offset The offset of the allocation in the pool.
+  /// \param lease The lease of the allocation.
+  /// \return a TRITONSERVER_Error indicating success or failure.
+  TRITONSERVER_Error* Release(const size_t offset, const uint64_t lease);
+
+  /// Start the lease of the allocation at 'offset', once it is handed
+  /// to the client. Does nothing if the pool has no lease duration.
+  /// Return TRITONSERVER_ERROR_NOT_FOUND if 'offset' and 'lease' don't
+  /// identify a live allocation.
+  /// \param offset The offset of the allocation in the pool.
+  /// \param lease The lease of the allocation.
+  /// \return a TRITONSERVER_Error indicating success or failure.
+  TRITONSERVER_Error* StartLease(const size_t offset, const uint64_t lease);
+
+  /// Reclaim the allocations whose lease expired.
+  /// \return the number of allocations reclaimed.
+  size_t ReclaimExpired();
+
+  void* Base() const { return base_; }
+  size_t BlockSize() const { return block_size_; }
+  size_t BlockCount() const { return block_count_; }
+  uint64_t LeaseMs() const { return lease_ms_; }
+  size_t UsedBytes() const { return used_blocks_.load() * block_size_; }
+
+ private:
+  static constexpr size_t kWordBits = 64;
+
+  /// Find a run of 'count' free blocks from block 'begin' in the current
+  /// bitmap. Return false if there is none.
+  bool FindRun(const size_t begin, const size_t count, size_t* first) const;
+
+  /// Atomically mark the 'count' blocks from 'first' as used. Return
+  /// false, and leave the bitmap unchanged, if one of the blocks is
+  /// already used.
+  bool Claim(const size_t first, const size_t count);
+
+  /// Mark the 'count' blocks from 'first' as free.
+  void Unclaim(const size_t first, const size_t count);
+
+  /// Return the block of the live allocation at 'offset' with 'lease' in
+  /// 'first' and its record in 'record'. Return false if there is none.
+  bool FindRecord(
+      const size_t offset, const uint64_t lease, size_t* first,
+      uint64_t* record) const;
+
+  /// Release the allocation at block 'first' if its record is still
+  /// 'record'.
+  bool ReleaseRecord(const size_t first, uint64_t record);
+
+  static uint64_t NowNs();
+
+  void* base_;
+  const size_t block_size_;
+  const size_t block_count_;
+  const uint64_t lease_ms_;
+
+  // One bit per block, set if the block is used. The bits past the
+  // last block are always set.
+  const size_t word_count_;
+  std::unique_ptr<std::atomic<uint64_t>[]> bitmap_;
+
+  // The record of the allocation that starts at each block, 0 if none:
+  // the lease in the upper 32 bits and the number of blocks in the
+  // lower ones. Used to validate releases.
+  std::unique_ptr<std::atomic<uint64_t>[]> records_;
+
+  // The time in nanoseconds at which the lease of the allocation that
+  // starts at each block expires, UINT64_MAX until the lease is
+  // started. Only used if 'lease_ms_' is not 0.
+  std::unique_ptr<std::atomic<uint64_t>[]> deadlines_;
+
+  // Where the next allocation starts looking for free blocks, so that
+  // concurrent allocations tend to claim different words.
+  std::atomic<size_t> next_block_;
+  std::atomic<uint32_t> next_lease_;
+  std::atomic<size_t> used_blocks_;
+};
+
+//
+// SharedMemoryPoolAllocations
+//
+// The allocations in shared memory pools of the outputs of the
+// responses of a request, from their allocation until the responses
+// are handed to the client. The client can't release the allocations
+// of a response it never received, so those are released instead.
+// Responses are identified by their index and handed to the client in
+// order.
+//
+class SharedMemoryPoolAllocations {
+ public:
+  SharedMemoryPoolAllocations() = default;
+  SharedMemoryPoolAllocations(const SharedMemoryPoolAllocations&) = delete;
+  SharedMemoryPoolAllocations& operator=(const SharedMemoryPoolAllocations&) =
+      delete;
+  ~SharedMemoryPoolAllocations() { Release(); }
+
+  /// Track the allocation at 'offset' with 'lease' in 'pool' of the
+  /// output of response 'response'. 'reference' keeps the pool alive.
+  void Add(
+      SharedMemoryPool* pool, const std::shared_ptr<const void>& reference,
+      const size_t offset, const uint64_t lease, const uint32_t response = 0);
+
+  /// Hand the allocations of the first 'count' responses to the client,
+  /// which releases them from now on. Starts their leases.
+  void Deliver(const uint32_t count = UINT32_MAX);
+
+  /// Release the allocations of response 'response'.
+  void ReleaseResponse(const uint32_t response);
+
+  /// Release all the allocations.
+  void Release();
+
+ private:
+  struct Allocation {
+    SharedMemoryPool* pool_;
+    std::shared_ptr<const void> reference_;
+    size_t offset_;
+    uint64_t lease_;
+    uint32_t response_;
+  };
+
+  std::mutex mu_;
+  std::vector<Allocation> allocations_;
+};
+
+}}  // namespace triton::server
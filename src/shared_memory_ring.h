@@ -0,0 +1,156 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace triton { namespace server { namespace shmring {
+
+//
+// Layout of a shared memory ring, the local transport of same-host
+// clients.
+//
+// A ring lives in a registered system shared memory region: a Header
+// followed by 'slot_count_' Slots. The client submits an inference by
+// filling a free slot with a descriptor of the request, whose tensors
+// are in registered system shared memory regions identified by their
+// handles, and marking it SLOT_SUBMITTED. The server marks the slot
+// SLOT_RUNNING, runs the inference reading the inputs and writing the
+// outputs in place, fills in the shapes and sizes of the outputs and
+// marks the slot SLOT_COMPLETED. The client reads the result and marks
+// the slot SLOT_FREE again.
+//
+// After submitting, the client increments 'submit_doorbell_' and, if
+// 'server_waiting_' is set, wakes the server with FUTEX_WAKE on
+// 'submit_doorbell_'. The server does the same with
+// 'complete_doorbell_' and 'client_waiting_' after completing a slot.
+// All fields are in the byte order of the host.
+//
+
+constexpr uint32_t kMagic = 0x474e5254;  // "TRNG"
+constexpr uint32_t kVersion = 1;
+
+constexpr size_t kMaxModelNameSize = 128;
+constexpr size_t kMaxTensorNameSize = 64;
+constexpr size_t kMaxDatatypeSize = 16;
+constexpr size_t kMaxErrorSize = 256;
+constexpr size_t kMaxDims = 8;
+constexpr size_t kMaxTensors = 8;
+
+enum SlotState : uint32_t {
+  SLOT_FREE = 0,
+  SLOT_SUBMITTED = 1,
+  SLOT_RUNNING = 2,
+  SLOT_COMPLETED = 3
+};
+
+// A tensor of a request. Strings are NUL-terminated unless they fill
+// their array.
+struct Tensor {
+  char name_[kMaxTensorNameSize];
+
+  // The datatype as named by the inference protocol, e.g. "FP32". Set
+  // by the server for outputs.
+  char datatype_[kMaxDatatypeSize];
+
+  // The handle of the system shared memory region holding the data, as
+  // returned by the register request, and the offset of the data in
+  // the region.
+  uint64_t region_handle_;
+  uint64_t offset_;
+
+  // For inputs the size of the data. For outputs the size available in
+  // the region when submitting, and the size of the output once
+  // completed.
+  uint64_t byte_size_;
+
+  // The shape. Set by the server for outputs.
+  uint32_t dims_count_;
+  uint32_t reserved_;
+  int64_t shape_[kMaxDims];
+};
+
+struct alignas(64) Slot {
+  std::atomic<uint32_t> state_;
+
+  uint32_t input_count_;
+  uint32_t output_count_;
+
+  // Set by the server, non-zero if the inference failed, in which case
+  // 'error_code_' is the TRITONSERVER_Error_Code of the failure.
+  uint32_t failed_;
+  uint32_t error_code_;
+  uint32_t reserved_;
+
+  // Free for the client to match completions to submissions.
+  uint64_t id_;
+
+  // The model version to use, -1 for the version chosen by the
+  // version policy of the model.
+  int64_t model_version_;
+  char model_name_[kMaxModelNameSize];
+
+  Tensor inputs_[kMaxTensors];
+  Tensor outputs_[kMaxTensors];
+
+  char error_[kMaxErrorSize];
+};
+
+struct alignas(64) Header {
+  // Set by the client when creating the ring.
+  uint32_t magic_;
+  uint32_t version_;
+  uint32_t slot_count_;
+  uint32_t slot_byte_size_;
+
+  alignas(64) std::atomic<uint32_t> submit_doorbell_;
+  std::atomic<uint32_t> server_waiting_;
+
+  alignas(64) std::atomic<uint32_t> complete_doorbell_;
+  std::atomic<uint32_t> client_waiting_;
+};
+
+static_assert(
+    std::atomic<uint32_t>::is_always_lock_free,
+    "shared memory rings require lock-free 32-bit atomics");
+
+/// Returns the size of a ring with 'slot_count' slots.
+inline size_t
+RingByteSize(const uint32_t slot_count)
+{
+  return sizeof(Header) + (static_cast<size_t>(slot_count) * sizeof(Slot));
+}
+
+/// Returns the slots of the ring starting at 'header'.
+inline Slot*
+RingSlots(Header* header)
+{
+  return reinterpret_cast<Slot*>(header + 1);
+}
+
+}}}  // namespace triton::server::shmring
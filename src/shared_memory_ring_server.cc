@@ -0,0 +1,718 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "shared_memory_ring_server.h"
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // __linux__
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "common.h"
+#include "shared_memory_ring.h"
+#include "triton/common/logging.h"
+
+namespace triton { namespace server {
+
+namespace {
+
+// The longest a ring thread sleeps without checking whether it is
+// detached.
+constexpr std::chrono::milliseconds kMaxSleep(100);
+
+// Sleeps until '*word' is no longer 'expected' or 'timeout' elapsed.
+// The futexes are not private since they are shared with the clients.
+void
+FutexWait(
+    std::atomic<uint32_t>* word, const uint32_t expected,
+    const std::chrono::microseconds timeout)
+{
+#ifdef __linux__
+  struct timespec ts;
+  ts.tv_sec = timeout.count() / 1000000;
+  ts.tv_nsec = (timeout.count() % 1000000) * 1000;
+  syscall(
+      SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, &ts,
+      nullptr, 0);
+#else
+  if (word->load() == expected) {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+#endif  // __linux__
+}
+
+void
+FutexWake(std::atomic<uint32_t>* word)
+{
+#ifdef __linux__
+  syscall(
+      SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX,
+      nullptr, nullptr, 0);
+#endif  // __linux__
+}
+
+// Returns the string in the fixed-size array 'str', which is not
+// NUL-terminated if it fills the array.
+std::string
+FixedString(const char* str, const size_t size)
+{
+  return std::string(str, strnlen(str, size));
+}
+
+void
+CopyFixedString(char* dst, const size_t size, const char* src)
+{
+  const size_t len = std::min(strlen(src), size - 1);
+  memcpy(dst, src, len);
+  dst[len] = '\0';
+}
+
+}  // namespace
+
+//
+// SharedMemoryRingServer::Ring
+//
+class SharedMemoryRingServer::Ring
+    : public std::enable_shared_from_this<SharedMemoryRingServer::Ring> {
+ public:
+  Ring(
+      const std::string& name,
+      const std::shared_ptr<TRITONSERVER_Server>& server,
+      const std::shared_ptr<SharedMemoryManager>& shm_manager,
+      const std::shared_ptr<TRITONSERVER_ResponseAllocator>& allocator,
+      const uint32_t poll_us, SharedMemoryManager::Reference&& reference,
+      shmring::Header* header)
+      : name_(name), server_(server), shm_manager_(shm_manager),
+        allocator_(allocator), poll_(poll_us), reference_(std::move(reference)),
+        header_(header), slots_(shmring::RingSlots(header)),
+        slot_count_(header->slot_count_), exiting_(false), submitted_(0),
+        completed_(0)
+  {
+  }
+
+  ~Ring() { Stop(); }
+
+  void Start() { thread_ = std::thread([this] { Serve(); }); }
+
+  void Stop()
+  {
+    if (thread_.joinable()) {
+      exiting_ = true;
+      thread_.join();
+    }
+  }
+
+  TRITONSERVER_Error* AppendStatus(
+      triton::common::TritonJson::Value* ring_status);
+
+  // The response allocator callbacks, shared by all rings.
+  static TRITONSERVER_Error* ResponseAlloc(
+      TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
+      size_t byte_size, TRITONSERVER_MemoryType preferred_memory_type,
+      int64_t preferred_memory_type_id, void* userp, void** buffer,
+      void** buffer_userp, TRITONSERVER_MemoryType* actual_memory_type,
+      int64_t* actual_memory_type_id);
+  static TRITONSERVER_Error* ResponseRelease(
+      TRITONSERVER_ResponseAllocator* allocator, void* buffer,
+      void* buffer_userp, size_t byte_size, TRITONSERVER_MemoryType memory_type,
+      int64_t memory_type_id);
+
+ private:
+  // The state of an inference submitted through the ring. Deleted, and
+  // the slot completed, once both the request is released and the
+  // final response is received so that the client can't reuse the
+  // input buffers while the core may still read them.
+  struct InferPayload {
+    InferPayload(const std::shared_ptr<Ring>& ring, shmring::Slot* slot)
+        : ring_(ring), slot_(slot), error_(nullptr), pending_(2)
+    {
+    }
+
+    struct Output {
+      void* base_;
+      size_t byte_size_;
+      shmring::Tensor* tensor_;
+    };
+
+    std::shared_ptr<Ring> ring_;
+    shmring::Slot* slot_;
+
+    // Keeps the regions of the tensors mapped.
+    std::vector<SharedMemoryManager::Reference> references_;
+    std::unordered_map<std::string, Output> outputs_;
+
+    // The first error of the inference.
+    TRITONSERVER_Error* error_;
+    std::atomic<int> pending_;
+  };
+
+  void Serve();
+  void Issue(shmring::Slot* slot);
+  TRITONSERVER_Error* PrepareRequest(
+      InferPayload* payload, TRITONSERVER_InferenceRequest** irequest);
+  TRITONSERVER_Error* MapTensor(
+      const shmring::Tensor& tensor, InferPayload* payload, void** base);
+  void Complete(shmring::Slot* slot, TRITONSERVER_Error* err);
+
+  static void Done(InferPayload* payload);
+  static void RequestRelease(
+      TRITONSERVER_InferenceRequest* request, const uint32_t flags,
+      void* userp);
+  static void ResponseComplete(
+      TRITONSERVER_InferenceResponse* response, const uint32_t flags,
+      void* userp);
+  static TRITONSERVER_Error* WriteOutputs(
+      TRITONSERVER_InferenceResponse* response);
+
+  const std::string name_;
+  std::shared_ptr<TRITONSERVER_Server> server_;
+  std::shared_ptr<SharedMemoryManager> shm_manager_;
+  std::shared_ptr<TRITONSERVER_ResponseAllocator> allocator_;
+  const std::chrono::microseconds poll_;
+
+  // Keeps the region of the ring mapped.
+  SharedMemoryManager::Reference reference_;
+  shmring::Header* header_;
+  shmring::Slot* slots_;
+  const uint32_t slot_count_;
+
+  std::atomic<bool> exiting_;
+  std::atomic<uint64_t> submitted_;
+  std::atomic<uint64_t> completed_;
+  std::thread thread_;
+};
+
+void
+SharedMemoryRingServer::Ring::Serve()
+{
+  auto last_issue = std::chrono::steady_clock::now();
+  while (!exiting_) {
+    bool issued = false;
+    for (uint32_t idx = 0; idx < slot_count_; ++idx) {
+      uint32_t expected = shmring::SLOT_SUBMITTED;
+      if (slots_[idx].state_.compare_exchange_strong(
+              expected, shmring::SLOT_RUNNING)) {
+        Issue(&slots_[idx]);
+        issued = true;
+      }
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (issued) {
+      last_issue = now;
+      continue;
+    }
+
+    // Keep polling for a while after the last submission, a client
+    // with a steady stream of requests then never waits for a wakeup.
+    if ((now - last_issue) < poll_) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    // Announce that the thread is about to sleep and check the slots
+    // again, a client that submits after the check sees the
+    // announcement and rings the doorbell.
+    const uint32_t doorbell = header_->submit_doorbell_.load();
+    header_->server_waiting_.store(1);
+    bool submitted = false;
+    for (uint32_t idx = 0; idx < slot_count_; ++idx) {
+      if (slots_[idx].state_.load() == shmring::SLOT_SUBMITTED) {
+        submitted = true;
+        break;
+      }
+    }
+    if (!submitted) {
+      FutexWait(&header_->submit_doorbell_, doorbell, kMaxSleep);
+    }
+    header_->server_waiting_.store(0);
+    last_issue = std::chrono::steady_clock::now();
+  }
+}
+
+void
+SharedMemoryRingServer::Ring::Issue(shmring::Slot* slot)
+{
+  submitted_++;
+  InferPayload* payload = new InferPayload(shared_from_this(), slot);
+  TRITONSERVER_InferenceRequest* irequest = nullptr;
+  TRITONSERVER_Error* err = PrepareRequest(payload, &irequest);
+  if (err == nullptr) {
+    err = TRITONSERVER_InferenceRequestSetReleaseCallback(
+        irequest, RequestRelease, payload);
+  }
+  if (err == nullptr) {
+    err = TRITONSERVER_InferenceRequestSetResponseCallback(
+        irequest, allocator_.get(), payload, ResponseComplete, payload);
+  }
+  if (err == nullptr) {
+    err = TRITONSERVER_ServerInferAsync(
+        server_.get(), irequest, nullptr /* trace */);
+  }
+
+  // The callbacks are not invoked if the request is not issued.
+  if (err != nullptr) {
+    if (irequest != nullptr) {
+      LOG_TRITONSERVER_ERROR(
+          TRITONSERVER_InferenceRequestDelete(irequest),
+          "deleting shared memory ring inference request");
+    }
+    payload->error_ = err;
+    payload->pending_ = 1;
+    Done(payload);
+  }
+}
+
+TRITONSERVER_Error*
+SharedMemoryRingServer::Ring::PrepareRequest(
+    InferPayload* payload, TRITONSERVER_InferenceRequest** irequest)
+{
+  shmring::Slot* slot = payload->slot_;
+  const uint32_t input_count = slot->input_count_;
+  const uint32_t output_count = slot->output_count_;
+  if ((input_count > shmring::kMaxTensors) ||
+      (output_count > shmring::kMaxTensors)) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "shared memory ring requests have at most " +
+            std::to_string(shmring::kMaxTensors) + " inputs and outputs")
+            .c_str());
+  }
+
+  const std::string model_name =
+      FixedString(slot->model_name_, shmring::kMaxModelNameSize);
+  RETURN_IF_ERR(TRITONSERVER_InferenceRequestNew(
+      irequest, server_.get(), model_name.c_str(), slot->model_version_));
+
+  for (uint32_t idx = 0; idx < input_count; ++idx) {
+    // Work on a copy, the client shares the slot.
+    const shmring::Tensor input = slot->inputs_[idx];
+    const std::string name =
+        FixedString(input.name_, shmring::kMaxTensorNameSize);
+    const TRITONSERVER_DataType datatype = TRITONSERVER_StringToDataType(
+        FixedString(input.datatype_, shmring::kMaxDatatypeSize).c_str());
+    if (datatype == TRITONSERVER_TYPE_INVALID) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          std::string("invalid datatype for input '" + name + "'").c_str());
+    }
+    if (input.dims_count_ > shmring::kMaxDims) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          std::string("too many dimensions for input '" + name + "'").c_str());
+    }
+
+    void* base;
+    RETURN_IF_ERR(MapTensor(input, payload, &base));
+    RETURN_IF_ERR(TRITONSERVER_InferenceRequestAddInput(
+        *irequest, name.c_str(), datatype, input.shape_, input.dims_count_));
+    RETURN_IF_ERR(TRITONSERVER_InferenceRequestAppendInputData(
+        *irequest, name.c_str(), base, input.byte_size_,
+        TRITONSERVER_MEMORY_CPU, 0 /* memory_type_id */));
+  }
+
+  for (uint32_t idx = 0; idx < output_count; ++idx) {
+    const shmring::Tensor output = slot->outputs_[idx];
+    const std::string name =
+        FixedString(output.name_, shmring::kMaxTensorNameSize);
+
+    void* base;
+    RETURN_IF_ERR(MapTensor(output, payload, &base));
+    RETURN_IF_ERR(TRITONSERVER_InferenceRequestAddRequestedOutput(
+        *irequest, name.c_str()));
+    payload->outputs_[name] = {base, output.byte_size_, &slot->outputs_[idx]};
+  }
+
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+SharedMemoryRingServer::Ring::MapTensor(
+    const shmring::Tensor& tensor, InferPayload* payload, void** base)
+{
+  const std::string name =
+      FixedString(tensor.name_, shmring::kMaxTensorNameSize);
+  if (tensor.region_handle_ == 0) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string("no shared memory region for tensor '" + name + "'")
+            .c_str());
+  }
+
+  void* region_base;
+  TRITONSERVER_MemoryType memory_type;
+  int64_t memory_type_id;
+  SharedMemoryManager::Reference reference;
+  size_t region_byte_size;
+  RETURN_IF_ERR(shm_manager_->GetMemoryInfo(
+      "" /* name */, tensor.region_handle_, 0 /* offset */, &region_base,
+      &memory_type, &memory_type_id, &reference, &region_byte_size));
+  if (memory_type != TRITONSERVER_MEMORY_CPU) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "tensor '" + name +
+            "' must be in system shared memory to use a shared memory ring")
+            .c_str());
+  }
+  if ((tensor.offset_ > region_byte_size) ||
+      (tensor.byte_size_ > (region_byte_size - tensor.offset_))) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "tensor '" + name +
+            "' exceeds the bounds of its shared memory region")
+            .c_str());
+  }
+
+  *base = reinterpret_cast<char*>(region_base) + tensor.offset_;
+  payload->references_.emplace_back(std::move(reference));
+  return nullptr;  // success
+}
+
+void
+SharedMemoryRingServer::Ring::Complete(
+    shmring::Slot* slot, TRITONSERVER_Error* err)
+{
+  if (err != nullptr) {
+    slot->failed_ = 1;
+    slot->error_code_ = TRITONSERVER_ErrorCode(err);
+    CopyFixedString(
+        slot->error_, shmring::kMaxErrorSize, TRITONSERVER_ErrorMessage(err));
+    TRITONSERVER_ErrorDelete(err);
+  } else {
+    slot->failed_ = 0;
+    slot->error_code_ = 0;
+    slot->error_[0] = '\0';
+  }
+
+  slot->state_.store(shmring::SLOT_COMPLETED);
+  header_->complete_doorbell_.fetch_add(1);
+  if (header_->client_waiting_.load() != 0) {
+    FutexWake(&header_->complete_doorbell_);
+  }
+  completed_++;
+}
+
+void
+SharedMemoryRingServer::Ring::Done(InferPayload* payload)
+{
+  if (payload->pending_.fetch_sub(1) == 1) {
+    payload->ring_->Complete(payload->slot_, payload->error_);
+    delete payload;
+  }
+}
+
+void
+SharedMemoryRingServer::Ring::RequestRelease(
+    TRITONSERVER_InferenceRequest* request, const uint32_t flags, void* userp)
+{
+  LOG_TRITONSERVER_ERROR(
+      TRITONSERVER_InferenceRequestDelete(request),
+      "deleting shared memory ring inference request");
+  Done(reinterpret_cast<InferPayload*>(userp));
+}
+
+void
+SharedMemoryRingServer::Ring::ResponseComplete(
+    TRITONSERVER_InferenceResponse* response, const uint32_t flags,
+    void* userp)
+{
+  InferPayload* payload = reinterpret_cast<InferPayload*>(userp);
+  if (response != nullptr) {
+    TRITONSERVER_Error* err = TRITONSERVER_InferenceResponseError(response);
+    if (err == nullptr) {
+      err = WriteOutputs(response);
+    }
+    if (err != nullptr) {
+      if (payload->error_ == nullptr) {
+        payload->error_ = err;
+      } else {
+        TRITONSERVER_ErrorDelete(err);
+      }
+    }
+    LOG_TRITONSERVER_ERROR(
+        TRITONSERVER_InferenceResponseDelete(response),
+        "deleting shared memory ring inference response");
+  }
+
+  if ((flags & TRITONSERVER_RESPONSE_COMPLETE_FINAL) != 0) {
+    Done(payload);
+  }
+}
+
+TRITONSERVER_Error*
+SharedMemoryRingServer::Ring::WriteOutputs(
+    TRITONSERVER_InferenceResponse* response)
+{
+  uint32_t output_count;
+  RETURN_IF_ERR(
+      TRITONSERVER_InferenceResponseOutputCount(response, &output_count));
+  for (uint32_t idx = 0; idx < output_count; ++idx) {
+    const char* name;
+    TRITONSERVER_DataType datatype;
+    const int64_t* shape;
+    uint64_t dim_count;
+    const void* base;
+    size_t byte_size;
+    TRITONSERVER_MemoryType memory_type;
+    int64_t memory_type_id;
+    void* userp;
+    RETURN_IF_ERR(TRITONSERVER_InferenceResponseOutput(
+        response, idx, &name, &datatype, &shape, &dim_count, &base, &byte_size,
+        &memory_type, &memory_type_id, &userp));
+    if (dim_count > shmring::kMaxDims) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          std::string(
+              "output '" + std::string(name) +
+              "' has too many dimensions for a shared memory ring")
+              .c_str());
+    }
+
+    // The allocator set 'userp' to the tensor of the output in the slot.
+    shmring::Tensor* tensor = reinterpret_cast<shmring::Tensor*>(userp);
+    CopyFixedString(
+        tensor->datatype_, shmring::kMaxDatatypeSize,
+        TRITONSERVER_DataTypeString(datatype));
+    tensor->dims_count_ = dim_count;
+    for (uint64_t dim = 0; dim < dim_count; ++dim) {
+      tensor->shape_[dim] = shape[dim];
+    }
+    tensor->byte_size_ = byte_size;
+  }
+
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+SharedMemoryRingServer::Ring::ResponseAlloc(
+    TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
+    size_t byte_size, TRITONSERVER_MemoryType preferred_memory_type,
+    int64_t preferred_memory_type_id, void* userp, void** buffer,
+    void** buffer_userp, TRITONSERVER_MemoryType* actual_memory_type,
+    int64_t* actual_memory_type_id)
+{
+  InferPayload* payload = reinterpret_cast<InferPayload*>(userp);
+  auto it = payload->outputs_.find(tensor_name);
+  if (it == payload->outputs_.end()) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        std::string(
+            "unexpected output '" + std::string(tensor_name) +
+            "' for shared memory ring request")
+            .c_str());
+  }
+  if (byte_size > it->second.byte_size_) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "shared memory size specified with the request for output '" +
+            std::string(tensor_name) + "' (" +
+            std::to_string(it->second.byte_size_) +
+            " bytes) should be at least " + std::to_string(byte_size) +
+            " bytes to hold the results")
+            .c_str());
+  }
+
+  *buffer = it->second.base_;
+  *buffer_userp = it->second.tensor_;
+  *actual_memory_type = TRITONSERVER_MEMORY_CPU;
+  *actual_memory_type_id = 0;
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+SharedMemoryRingServer::Ring::ResponseRelease(
+    TRITONSERVER_ResponseAllocator* allocator, void* buffer,
+    void* buffer_userp, size_t byte_size, TRITONSERVER_MemoryType memory_type,
+    int64_t memory_type_id)
+{
+  // The outputs are in the shared memory of the client.
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+SharedMemoryRingServer::Ring::AppendStatus(
+    triton::common::TritonJson::Value* ring_status)
+{
+  triton::common::TritonJson::Value ring_json(
+      *ring_status, triton::common::TritonJson::ValueType::OBJECT);
+  RETURN_IF_ERR(ring_json.AddString("name", name_.c_str(), name_.size()));
+  RETURN_IF_ERR(ring_json.AddUInt("slot_count", slot_count_));
+  RETURN_IF_ERR(ring_json.AddUInt("submitted", submitted_));
+  RETURN_IF_ERR(ring_json.AddUInt("completed", completed_));
+  RETURN_IF_ERR(ring_status->Append(std::move(ring_json)));
+  return nullptr;  // success
+}
+
+//
+// SharedMemoryRingServer
+//
+SharedMemoryRingServer::SharedMemoryRingServer(
+    const std::shared_ptr<TRITONSERVER_Server>& server,
+    const std::shared_ptr<SharedMemoryManager>& shm_manager,
+    const uint32_t poll_us)
+    : server_(server), shm_manager_(shm_manager), poll_us_(poll_us)
+{
+  TRITONSERVER_ResponseAllocator* allocator = nullptr;
+  FAIL_IF_ERR(
+      TRITONSERVER_ResponseAllocatorNew(
+          &allocator, Ring::ResponseAlloc, Ring::ResponseRelease,
+          nullptr /* start_fn */),
+      "creating shared memory ring response allocator");
+  allocator_.reset(allocator, [](TRITONSERVER_ResponseAllocator* allocator) {
+    LOG_TRITONSERVER_ERROR(
+        TRITONSERVER_ResponseAllocatorDelete(allocator),
+        "deleting shared memory ring response allocator");
+  });
+}
+
+SharedMemoryRingServer::~SharedMemoryRingServer()
+{
+  LOG_TRITONSERVER_ERROR(Detach(""), "detaching shared memory rings");
+}
+
+TRITONSERVER_Error*
+SharedMemoryRingServer::Attach(const std::string& region_name)
+{
+  void* base;
+  TRITONSERVER_MemoryType memory_type;
+  int64_t memory_type_id;
+  SharedMemoryManager::Reference reference;
+  size_t byte_size;
+  RETURN_IF_ERR(shm_manager_->GetMemoryInfo(
+      region_name, 0 /* handle */, 0 /* offset */, &base, &memory_type,
+      &memory_type_id, &reference, &byte_size));
+  if (memory_type != TRITONSERVER_MEMORY_CPU) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "shared memory ring '" + region_name +
+            "' must be in system shared memory")
+            .c_str());
+  }
+
+  shmring::Header* header = reinterpret_cast<shmring::Header*>(base);
+  if (((reinterpret_cast<uintptr_t>(base) % alignof(shmring::Header)) != 0) ||
+      (byte_size < sizeof(shmring::Header)) ||
+      (header->magic_ != shmring::kMagic) ||
+      (header->version_ != shmring::kVersion) ||
+      (header->slot_byte_size_ != sizeof(shmring::Slot)) ||
+      (header->slot_count_ == 0) ||
+      (shmring::RingByteSize(header->slot_count_) > byte_size)) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "shared memory region '" + region_name +
+            "' does not hold a valid shared memory ring")
+            .c_str());
+  }
+
+  std::lock_guard<std::mutex> lock(mu_);
+  if (rings_.find(region_name) != rings_.end()) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_ALREADY_EXISTS,
+        std::string(
+            "shared memory ring '" + region_name + "' is already attached")
+            .c_str());
+  }
+
+  std::shared_ptr<Ring> ring(new Ring(
+      region_name, server_, shm_manager_, allocator_, poll_us_,
+      std::move(reference), header));
+  ring->Start();
+  rings_.emplace(region_name, std::move(ring));
+  LOG_VERBOSE(1) << "attached shared memory ring '" << region_name << "'";
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+SharedMemoryRingServer::Detach(const std::string& region_name)
+{
+  // Stop the rings outside the lock, a ring thread may be issuing a
+  // request.
+  std::vector<std::shared_ptr<Ring>> detached;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (region_name.empty()) {
+      for (auto& ring : rings_) {
+        detached.emplace_back(std::move(ring.second));
+      }
+      rings_.clear();
+    } else {
+      auto it = rings_.find(region_name);
+      if (it == rings_.end()) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_NOT_FOUND,
+            std::string(
+                "shared memory ring '" + region_name + "' is not attached")
+                .c_str());
+      }
+      detached.emplace_back(std::move(it->second));
+      rings_.erase(it);
+    }
+  }
+
+  for (auto& ring : detached) {
+    ring->Stop();
+  }
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+SharedMemoryRingServer::GetStatus(
+    const std::string& region_name,
+    triton::common::TritonJson::Value* ring_status)
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  if (region_name.empty()) {
+    for (auto& ring : rings_) {
+      RETURN_IF_ERR(ring.second->AppendStatus(ring_status));
+    }
+  } else {
+    auto it = rings_.find(region_name);
+    if (it == rings_.end()) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_NOT_FOUND,
+          std::string(
+              "shared memory ring '" + region_name + "' is not attached")
+              .c_str());
+    }
+    RETURN_IF_ERR(it->second->AppendStatus(ring_status));
+  }
+  return nullptr;  // success
+}
+
+}}  // namespace triton::server
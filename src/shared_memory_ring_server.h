@@ -0,0 +1,99 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "shared_memory_manager.h"
+#include "triton/core/tritonserver.h"
+
+#define TRITONJSON_STATUSTYPE TRITONSERVER_Error*
+#define TRITONJSON_STATUSRETURN(M) \
+  return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INTERNAL, (M).c_str())
+#define TRITONJSON_STATUSSUCCESS nullptr
+#include "triton/common/triton_json.h"
+
+namespace triton { namespace server {
+
+//
+// SharedMemoryRingServer
+//
+// Serves the inferences submitted by same-host clients through shared
+// memory rings, see shared_memory_ring.h for the layout of a ring. A
+// ring is a registered system shared memory region that the client
+// attaches to the server. Each attached ring is served by a thread that
+// polls the ring for 'poll_us' after the last submission and then
+// sleeps until the client rings the doorbell. Inputs are passed to the
+// core and outputs are allocated in place in the shared memory regions
+// named by the request, so the data is never copied.
+//
+class SharedMemoryRingServer {
+ public:
+  SharedMemoryRingServer(
+      const std::shared_ptr<TRITONSERVER_Server>& server,
+      const std::shared_ptr<SharedMemoryManager>& shm_manager,
+      const uint32_t poll_us);
+  ~SharedMemoryRingServer();
+
+  /// Start serving the ring in the registered system shared memory
+  /// region 'region_name'.
+  /// \return a TRITONSERVER_Error indicating success or failure.
+  TRITONSERVER_Error* Attach(const std::string& region_name);
+
+  /// Stop serving the ring in 'region_name', or all rings if
+  /// 'region_name' is empty. Inferences in flight complete in the ring,
+  /// which stays mapped until they do.
+  /// \return a TRITONSERVER_Error indicating success or failure.
+  TRITONSERVER_Error* Detach(const std::string& region_name);
+
+  /// Populates the status of the attached rings, or of the ring in
+  /// 'region_name' if not empty.
+  /// \return a TRITONSERVER_Error indicating success or failure.
+  TRITONSERVER_Error* GetStatus(
+      const std::string& region_name,
+      triton::common::TritonJson::Value* ring_status);
+
+ private:
+  class Ring;
+
+  std::shared_ptr<TRITONSERVER_Server> server_;
+  std::shared_ptr<SharedMemoryManager> shm_manager_;
+  const uint32_t poll_us_;
+  // Shared with the rings, which can outlive the server while they
+  // have inferences in flight.
+  std::shared_ptr<TRITONSERVER_ResponseAllocator> allocator_;
+
+  std::mutex mu_;
+  std::map<std::string, std::shared_ptr<Ring>> rings_;
+};
+
+}}  // namespace triton::server
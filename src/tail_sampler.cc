@@ -0,0 +1,148 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "tail_sampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace triton { namespace server {
+
+TailSampler::TailSampler(const Options& options)
+    : options_(options), observed_(0),
+      percentile_threshold_ns_(std::numeric_limits<uint64_t>::max()),
+      second_(0), emitted_in_second_(0)
+{
+  for (auto& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+bool
+TailSampler::Sample(
+    const Latency& latency, const bool failed, const uint64_t now_ns)
+{
+  bool emit = failed;
+  if (options_.percentile_ != 0) {
+    // Compare against the threshold of the last window before the
+    // latency is added to the current one.
+    emit |= (latency.total_ns_ > PercentileThreshold());
+    RecordLatency(latency.total_ns_);
+  }
+  emit |= (options_.latency_ns_ != 0) &&
+          (latency.total_ns_ >= options_.latency_ns_);
+  emit |= (options_.queue_latency_ns_ != 0) &&
+          (latency.queue_ns_ >= options_.queue_latency_ns_);
+  emit |= (options_.compute_latency_ns_ != 0) &&
+          (latency.compute_ns_ >= options_.compute_latency_ns_);
+
+  return emit && Admit(now_ns);
+}
+
+size_t
+TailSampler::BucketIndex(const uint64_t value)
+{
+  if (value < 4) {
+    return value;
+  }
+  size_t msb = 2;
+  while ((value >> (msb + 1)) != 0) {
+    ++msb;
+  }
+  return (msb - 1) * 4 + ((value >> (msb - 2)) & 3);
+}
+
+uint64_t
+TailSampler::BucketLowerBound(const size_t index)
+{
+  if (index < 4) {
+    return index;
+  }
+  const size_t msb = index / 4 + 1;
+  return (uint64_t(1) << msb) + (uint64_t(index % 4) << (msb - 2));
+}
+
+void
+TailSampler::RecordLatency(const uint64_t latency_ns)
+{
+  buckets_[BucketIndex(latency_ns)].fetch_add(1, std::memory_order_relaxed);
+  if (((observed_.fetch_add(1, std::memory_order_relaxed) + 1) %
+       kPercentileWindow) != 0) {
+    return;
+  }
+
+  // The window is complete, the thread completing it estimates the
+  // percentile and starts the next window. Latencies recorded by other
+  // threads meanwhile may land in either window, which is fine for an
+  // estimate.
+  uint64_t counts[kBucketCount];
+  uint64_t total = 0;
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    counts[i] = buckets_[i].exchange(0, std::memory_order_relaxed);
+    total += counts[i];
+  }
+  if (total == 0) {
+    return;
+  }
+
+  const uint64_t rank = std::min(
+      total, std::max(
+                 uint64_t(1), static_cast<uint64_t>(std::ceil(
+                                  total * options_.percentile_ / 100))));
+  uint64_t cumulative = 0;
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    cumulative += counts[i];
+    if (cumulative >= rank) {
+      // Latencies in the buckets above the one holding the percentile
+      // are above the threshold.
+      const uint64_t threshold = (i + 1 < kBucketCount)
+                                     ? BucketLowerBound(i + 1) - 1
+                                     : std::numeric_limits<uint64_t>::max();
+      percentile_threshold_ns_.store(threshold, std::memory_order_relaxed);
+      break;
+    }
+  }
+}
+
+bool
+TailSampler::Admit(const uint64_t now_ns)
+{
+  if (options_.max_per_second_ == 0) {
+    return true;
+  }
+
+  // The count is reset by the first trace of a new second, a trace
+  // racing with the reset may be admitted beyond the limit.
+  const uint64_t second = now_ns / 1000000000;
+  uint64_t current = second_.load(std::memory_order_relaxed);
+  if ((second != current) && second_.compare_exchange_strong(current, second)) {
+    emitted_in_second_.store(0, std::memory_order_relaxed);
+  }
+  return emitted_in_second_.fetch_add(1, std::memory_order_relaxed) <
+         options_.max_per_second_;
+}
+
+}}  // namespace triton::server
@@ -0,0 +1,129 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace triton { namespace server {
+
+//
+// TailSampler
+//
+// Decides which traces are emitted when tracing samples on latency
+// rather than on the request count. The activities of a trace are
+// recorded as usual but held until the trace completes, the trace is
+// then emitted only if the request failed or was slower than one of
+// the thresholds. At most 'max_per_second_' traces are emitted per
+// second so that a latency spike can't flood the trace output.
+//
+class TailSampler {
+ public:
+  struct Options {
+    Options()
+        : latency_ns_(0), queue_latency_ns_(0), compute_latency_ns_(0),
+          percentile_(0), max_per_second_(0)
+    {
+    }
+
+    // Whether any threshold is set, otherwise traces are not sampled on
+    // latency.
+    bool Enabled() const
+    {
+      return (latency_ns_ != 0) || (queue_latency_ns_ != 0) ||
+             (compute_latency_ns_ != 0) || (percentile_ != 0);
+    }
+
+    // Emit the traces with an end-to-end, queue or compute latency at or
+    // above the value, 0 if the latency is not checked.
+    uint64_t latency_ns_;
+    uint64_t queue_latency_ns_;
+    uint64_t compute_latency_ns_;
+    // Emit the traces with an end-to-end latency above the given
+    // percentile of the recent end-to-end latencies, 0 if not used.
+    double percentile_;
+    // The maximum number of traces emitted per second, 0 for no limit.
+    uint32_t max_per_second_;
+  };
+
+  // The latencies of a completed trace.
+  struct Latency {
+    Latency() : total_ns_(0), queue_ns_(0), compute_ns_(0) {}
+    uint64_t total_ns_;
+    uint64_t queue_ns_;
+    uint64_t compute_ns_;
+  };
+
+  explicit TailSampler(const Options& options);
+
+  const Options& Config() const { return options_; }
+
+  /// Record the latency of a completed trace and return whether the
+  /// trace should be emitted.
+  /// \param latency The latencies of the trace.
+  /// \param failed Whether the request of the trace failed, failed
+  /// requests are emitted regardless of their latency.
+  /// \param now_ns Steady timestamp used to enforce the per second
+  /// limit.
+  bool Sample(const Latency& latency, const bool failed, const uint64_t now_ns);
+
+  /// The end-to-end latency at the configured percentile of the last
+  /// complete window of latencies, UINT64_MAX before the first window
+  /// completes.
+  uint64_t PercentileThreshold() const
+  {
+    return percentile_threshold_ns_.load(std::memory_order_relaxed);
+  }
+
+  // The number of latencies in the window the percentile is estimated
+  // from.
+  static constexpr uint64_t kPercentileWindow = 1000;
+
+ private:
+  // Log-linear buckets, 4 per power of 2, so the percentile estimate is
+  // within 25% of the actual latency.
+  static constexpr size_t kBucketCount = 252;
+  static size_t BucketIndex(const uint64_t value);
+  static uint64_t BucketLowerBound(const size_t index);
+
+  // Add 'latency_ns' to the histogram, recomputing the threshold and
+  // starting a new window when the current one is complete.
+  void RecordLatency(const uint64_t latency_ns);
+  // Take one of the traces allowed in the current second.
+  bool Admit(const uint64_t now_ns);
+
+  const Options options_;
+
+  std::atomic<uint64_t> buckets_[kBucketCount];
+  std::atomic<uint64_t> observed_;
+  std::atomic<uint64_t> percentile_threshold_ns_;
+
+  std::atomic<uint64_t> second_;
+  std::atomic<uint32_t> emitted_in_second_;
+};
+
+}}  // namespace triton::server
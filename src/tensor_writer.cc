@@ -0,0 +1,219 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "tensor_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif  // !_WIN32
+
+#include "triton/common/logging.h"
+
+namespace triton { namespace server {
+
+TensorWriter::TensorWriter(const std::string& file_name, const Options& options)
+    : file_name_(file_name), max_pending_bytes_(options.max_pending_bytes_),
+      segment_size_(options.segment_size_), next_offset_(0), pending_bytes_(0),
+      dropped_(0), stopped_(false), failed_(false), written_(0)
+#ifndef _WIN32
+      ,
+      fd_(-1), segment_(nullptr), segment_offset_(0)
+#endif  // !_WIN32
+{
+#ifdef _WIN32
+  segment_size_ = 0;
+#else
+  if (segment_size_ != 0) {
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    segment_size_ = ((segment_size_ + page_size - 1) / page_size) * page_size;
+  }
+#endif  // _WIN32
+  thread_ = std::thread(&TensorWriter::Run, this);
+}
+
+TensorWriter::~TensorWriter()
+{
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    stopped_ = true;
+  }
+  cv_.notify_one();
+  thread_.join();
+}
+
+bool
+TensorWriter::Write(const void* base, const size_t byte_size, uint64_t* offset)
+{
+  // Reserve the bytes first so that the copy is made without the lock.
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (stopped_ || (pending_bytes_ + byte_size > max_pending_bytes_)) {
+      ++dropped_;
+      return false;
+    }
+    pending_bytes_ += byte_size;
+  }
+
+  Tensor tensor;
+  tensor.data_.reset(new char[byte_size]);
+  tensor.byte_size_ = byte_size;
+  std::memcpy(tensor.data_.get(), base, byte_size);
+
+  // The tensors are written in the order they are queued, the offset is
+  // assigned with the same lock.
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    *offset = next_offset_;
+    next_offset_ += byte_size;
+    queue_.emplace_back(std::move(tensor));
+  }
+  cv_.notify_one();
+  return true;
+}
+
+uint64_t
+TensorWriter::Dropped()
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  return dropped_;
+}
+
+void
+TensorWriter::Run()
+{
+  std::unique_lock<std::mutex> lk(mu_);
+  while (true) {
+    cv_.wait(lk, [this] { return stopped_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      break;
+    }
+    Tensor tensor = std::move(queue_.front());
+    queue_.pop_front();
+    lk.unlock();
+
+    // Once a write fails the offsets of the following tensors no longer
+    // match the file, stop writing.
+    if (!failed_ && !WriteTensor(tensor)) {
+      failed_ = true;
+      LOG_ERROR << "failed writing traced tensors to '" << file_name_
+                << "': " << strerror(errno);
+    }
+
+    lk.lock();
+    pending_bytes_ -= tensor.byte_size_;
+  }
+  lk.unlock();
+
+  Close();
+}
+
+bool
+TensorWriter::WriteTensor(const Tensor& tensor)
+{
+  if (segment_size_ != 0) {
+    return WriteMapped(tensor.data_.get(), tensor.byte_size_);
+  }
+
+  if (!file_.is_open()) {
+    file_.open(file_name_, std::ios::binary | std::ios::trunc);
+  }
+  file_.write(tensor.data_.get(), tensor.byte_size_);
+  written_ += tensor.byte_size_;
+  return file_.good();
+}
+
+bool
+TensorWriter::WriteMapped(const char* data, size_t byte_size)
+{
+#ifndef _WIN32
+  if (fd_ == -1) {
+    fd_ = open(file_name_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ == -1) {
+      return false;
+    }
+  }
+  while (byte_size > 0) {
+    // Map the next segment once the current one is full.
+    if ((segment_ == nullptr) ||
+        (written_ == (segment_offset_ + segment_size_))) {
+      if (segment_ != nullptr) {
+        munmap(segment_, segment_size_);
+        segment_ = nullptr;
+      }
+      segment_offset_ = written_;
+      const int err = posix_fallocate(fd_, segment_offset_, segment_size_);
+      if (err != 0) {
+        errno = err;
+        return false;
+      }
+      void* addr = mmap(
+          nullptr, segment_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_,
+          segment_offset_);
+      if (addr == MAP_FAILED) {
+        return false;
+      }
+      segment_ = static_cast<char*>(addr);
+    }
+    const size_t copy_size =
+        std::min(byte_size, segment_offset_ + segment_size_ - written_);
+    std::memcpy(segment_ + (written_ - segment_offset_), data, copy_size);
+    data += copy_size;
+    byte_size -= copy_size;
+    written_ += copy_size;
+  }
+#endif  // !_WIN32
+  return true;
+}
+
+void
+TensorWriter::Close()
+{
+  if (file_.is_open()) {
+    file_.close();
+  }
+#ifndef _WIN32
+  if (segment_ != nullptr) {
+    munmap(segment_, segment_size_);
+    segment_ = nullptr;
+  }
+  if (fd_ != -1) {
+    // Drop the preallocated space past the last tensor.
+    if (ftruncate(fd_, written_) != 0) {
+      LOG_ERROR << "failed truncating traced tensors file '" << file_name_
+                << "': " << strerror(errno);
+    }
+    close(fd_);
+    fd_ = -1;
+  }
+#endif  // !_WIN32
+}
+
+}}  // namespace triton::server
@@ -0,0 +1,123 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace triton { namespace server {
+
+//
+// TensorWriter
+//
+// Writes the raw bytes of traced tensors to a file from a dedicated
+// thread. Each tensor is assigned the offset it is written at when it is
+// queued, so the trace only has to refer to the offset and the length of
+// the tensor. The bytes of the queued tensors are bounded, tensors that
+// would exceed the bound are dropped instead of growing the memory or
+// blocking the request.
+//
+// By default the tensors are written with buffered file writes. If
+// 'segment_size_' is set the file is instead grown in preallocated
+// segments of that size that are mapped into memory and the tensors are
+// copied into the mapping, which avoids a system call per tensor for
+// small tensors. Mapping is not supported on Windows.
+//
+class TensorWriter {
+ public:
+  static constexpr size_t kDefaultMaxPendingBytes = 256 * 1024 * 1024;
+
+  struct Options {
+    // The maximum total bytes of the tensors queued to be written.
+    size_t max_pending_bytes_ = kDefaultMaxPendingBytes;
+    // The size of the mapped segments, rounded up to the page size. 0
+    // writes the tensors through the file stream.
+    size_t segment_size_ = 0;
+  };
+
+  /// Create a writer of the tensors to 'file_name' and start its thread.
+  /// The file is created when the first tensor is written.
+  TensorWriter(const std::string& file_name, const Options& options);
+
+  /// Write out the queued tensors and close the file.
+  ~TensorWriter();
+
+  /// Copy 'byte_size' bytes at 'base' and queue them to be written.
+  /// Return false if the tensor is dropped, otherwise 'offset' returns
+  /// the offset of the tensor in the file.
+  bool Write(const void* base, const size_t byte_size, uint64_t* offset);
+
+  const std::string& FileName() const { return file_name_; }
+
+  /// The number of tensors dropped so far.
+  uint64_t Dropped();
+
+ private:
+  struct Tensor {
+    std::unique_ptr<char[]> data_;
+    size_t byte_size_;
+  };
+
+  void Run();
+  // Write 'tensor' at the end of the file, return false on error.
+  bool WriteTensor(const Tensor& tensor);
+  bool WriteMapped(const char* data, size_t byte_size);
+  void Close();
+
+  const std::string file_name_;
+  const size_t max_pending_bytes_;
+  size_t segment_size_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<Tensor> queue_;
+  // The offset of the next queued tensor.
+  uint64_t next_offset_;
+  size_t pending_bytes_;
+  uint64_t dropped_;
+  bool stopped_;
+
+  // Only accessed by the thread of the writer.
+  bool failed_;
+  uint64_t written_;
+  std::ofstream file_;
+#ifndef _WIN32
+  int fd_;
+  char* segment_;
+  uint64_t segment_offset_;
+#endif  // !_WIN32
+
+  std::thread thread_;
+};
+
+}}  // namespace triton::server
@@ -0,0 +1,151 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "epoch_snapshot.h"
+
+namespace ts = triton::server;
+
+namespace {
+
+// A snapshot that records whether it was used after being deleted.
+struct Snapshot {
+  explicit Snapshot(const uint64_t version) : version_(version), live_(true)
+  {
+  }
+  ~Snapshot() { live_ = false; }
+
+  uint64_t version_;
+  std::atomic<bool> live_;
+};
+
+TEST(EpochSnapshotTest, ReadPublished)
+{
+  ts::EpochSnapshot<std::string> snapshot(
+      std::unique_ptr<std::string>(new std::string("first")));
+  EXPECT_EQ(
+      snapshot.Read([](const std::string& value) { return value; }), "first");
+
+  snapshot.Publish(std::unique_ptr<std::string>(new std::string("second")));
+  EXPECT_EQ(
+      snapshot.Read([](const std::string& value) { return value.size(); }),
+      6u);
+
+  std::string copy;
+  snapshot.Read([&copy](const std::string& value) { copy = value; });
+  EXPECT_EQ(copy, "second");
+}
+
+TEST(EpochSnapshotTest, PublishWaitsForReaders)
+{
+  ts::EpochSnapshot<Snapshot> snapshot(
+      std::unique_ptr<Snapshot>(new Snapshot(0)));
+
+  // The reader holds the first snapshot until the publication started.
+  std::atomic<bool> entered(false);
+  std::atomic<bool> published(false);
+  std::thread reader([&]() {
+    snapshot.Read([&](const Snapshot& current) {
+      entered = true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      EXPECT_TRUE(current.live_);
+      EXPECT_FALSE(published);
+    });
+  });
+  while (!entered) {
+    std::this_thread::yield();
+  }
+  snapshot.Publish(std::unique_ptr<Snapshot>(new Snapshot(1)));
+  published = true;
+  reader.join();
+
+  EXPECT_EQ(
+      snapshot.Read([](const Snapshot& current) { return current.version_; }),
+      1u);
+}
+
+TEST(EpochSnapshotTest, ConcurrentReaders)
+{
+  ts::EpochSnapshot<Snapshot> snapshot(
+      std::unique_ptr<Snapshot>(new Snapshot(0)));
+
+  // More readers than reader slots so that the slots are shared.
+  constexpr size_t kReaderCount = 72;
+  constexpr uint64_t kPublishCount = 200;
+  std::atomic<size_t> started(0);
+  std::atomic<bool> done(false);
+  std::atomic<size_t> failures(0);
+  std::vector<std::thread> readers;
+  for (size_t i = 0; i < kReaderCount; ++i) {
+    readers.emplace_back([&]() {
+      uint64_t last = 0;
+      ++started;
+      while (!done) {
+        snapshot.Read([&](const Snapshot& current) {
+          // A snapshot is never used once deleted and the readers never
+          // see an older snapshot than they have seen.
+          if (!current.live_ || (current.version_ < last)) {
+            ++failures;
+          }
+          last = current.version_;
+        });
+        std::this_thread::yield();
+      }
+    });
+  }
+
+  while (started < kReaderCount) {
+    std::this_thread::yield();
+  }
+  for (uint64_t version = 1; version <= kPublishCount; ++version) {
+    snapshot.Publish(std::unique_ptr<Snapshot>(new Snapshot(version)));
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  EXPECT_EQ(failures, 0u);
+  EXPECT_EQ(
+      snapshot.Read([](const Snapshot& current) { return current.version_; }),
+      kPublishCount);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
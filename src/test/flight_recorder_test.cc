@@ -0,0 +1,179 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+// Undefine the FAIL() macro inside Triton code to avoid redefine error
+// from gtest.
+#ifdef FAIL
+#undef FAIL
+#endif
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flight_recorder.h"
+
+namespace ts = triton::server;
+
+namespace {
+
+// Return the number of non-overlapping occurrences of 'needle'.
+size_t
+Count(const std::string& haystack, const std::string& needle)
+{
+  size_t count = 0;
+  for (size_t pos = haystack.find(needle); pos != std::string::npos;
+       pos = haystack.find(needle, pos + needle.size())) {
+    ++count;
+  }
+  return count;
+}
+
+void
+RecordRequest(
+    ts::FlightRecorder& recorder, const uint64_t trace_id,
+    const uint64_t start_ns)
+{
+  ts::FlightRecorder::Timeline timeline;
+  timeline.SetRequest(trace_id, "simple", 1);
+  // Added out of order as the core and the frontend threads may do.
+  timeline.Add(recorder.NameId("COMPUTE_START"), start_ns + 20);
+  timeline.Add(recorder.NameId("REQUEST_START"), start_ns + 10);
+  timeline.Add(recorder.NameId("HTTP_RECV_START"), start_ns);
+  recorder.Record(timeline);
+}
+
+TEST(FlightRecorderTest, NameId)
+{
+  ts::FlightRecorder recorder(4);
+  const uint8_t id = recorder.NameId("QUEUE_START");
+  EXPECT_EQ(recorder.NameId("QUEUE_START"), id);
+  EXPECT_NE(recorder.NameId("COMPUTE_START"), id);
+
+  for (size_t i = 0; i < 100; ++i) {
+    recorder.NameId(("NAME_" + std::to_string(i)).c_str());
+  }
+  EXPECT_EQ(recorder.NameId("NAME_99"), ts::FlightRecorder::kInvalidName);
+  EXPECT_EQ(recorder.NameId("QUEUE_START"), id);
+}
+
+TEST(FlightRecorderTest, Dump)
+{
+  ts::FlightRecorder recorder(4);
+  RecordRequest(recorder, 2, 2000);
+  RecordRequest(recorder, 1, 1000);
+
+  std::stringstream out;
+  recorder.Dump(out);
+  EXPECT_EQ(
+      out.str(),
+      "[{\"id\":1,\"model_name\":\"simple\",\"model_version\":1,"
+      "\"timestamps\":[{\"name\":\"HTTP_RECV_START\",\"ns\":1000},"
+      "{\"name\":\"REQUEST_START\",\"ns\":1010},"
+      "{\"name\":\"COMPUTE_START\",\"ns\":1020}]},"
+      "{\"id\":2,\"model_name\":\"simple\",\"model_version\":1,"
+      "\"timestamps\":[{\"name\":\"HTTP_RECV_START\",\"ns\":2000},"
+      "{\"name\":\"REQUEST_START\",\"ns\":2010},"
+      "{\"name\":\"COMPUTE_START\",\"ns\":2020}]}]");
+}
+
+TEST(FlightRecorderTest, Overwrite)
+{
+  ts::FlightRecorder recorder(4);
+  for (uint64_t i = 1; i <= 10; ++i) {
+    RecordRequest(recorder, i, i * 1000);
+  }
+
+  std::stringstream out;
+  recorder.Dump(out);
+  const std::string dump = out.str();
+  EXPECT_EQ(Count(dump, "\"id\":"), 4u);
+  EXPECT_EQ(dump.find("\"id\":6,"), std::string::npos);
+  EXPECT_NE(dump.find("\"id\":7,"), std::string::npos);
+  EXPECT_NE(dump.find("\"id\":10,"), std::string::npos);
+}
+
+TEST(FlightRecorderTest, Timestamps)
+{
+  ts::FlightRecorder recorder(4);
+  ts::FlightRecorder::Timeline timeline;
+  timeline.SetRequest(1, std::string(100, 'm').c_str(), 1);
+  const uint8_t id = recorder.NameId("EVENT");
+  for (uint64_t i = 0; i < 2 * ts::FlightRecorder::kMaxTimestamps; ++i) {
+    timeline.Add(id, i);
+  }
+  recorder.Record(timeline);
+
+  std::stringstream out;
+  recorder.Dump(out);
+  const std::string dump = out.str();
+  // The timestamps beyond the capacity of the timeline are dropped and
+  // the model name is truncated.
+  EXPECT_EQ(Count(dump, "EVENT"), ts::FlightRecorder::kMaxTimestamps);
+  EXPECT_NE(
+      dump.find(
+          "\"" + std::string(ts::FlightRecorder::kMaxModelNameLength, 'm') +
+          "\""),
+      std::string::npos);
+}
+
+TEST(FlightRecorderTest, Threads)
+{
+  ts::FlightRecorder recorder(8);
+  std::vector<std::thread> threads;
+  for (uint64_t t = 0; t < 4; ++t) {
+    threads.emplace_back([&recorder, t] {
+      for (uint64_t i = 0; i < 100; ++i) {
+        RecordRequest(recorder, t * 100 + i, t * 100000 + i * 100);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // Each thread keeps its own last timelines.
+  std::stringstream out;
+  recorder.Dump(out);
+  const std::string dump = out.str();
+  EXPECT_EQ(Count(dump, "\"id\":"), 32u);
+  for (uint64_t t = 0; t < 4; ++t) {
+    EXPECT_NE(
+        dump.find("\"id\":" + std::to_string(t * 100 + 99) + ","),
+        std::string::npos);
+  }
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,135 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+// Undefine the FAIL() macro inside Triton code to avoid redefine error
+// from gtest.
+#ifdef FAIL
+#undef FAIL
+#endif
+
+#include <string>
+
+#include "frontend_stage.h"
+
+namespace ts = triton::server;
+
+namespace {
+
+TEST(FrontendStageTest, Name)
+{
+  EXPECT_STREQ(
+      ts::FrontendStageName(ts::FrontendStage::HTTP_RECV_START),
+      "HTTP_RECV_START");
+  EXPECT_STREQ(
+      ts::FrontendStageName(ts::FrontendStage::INFER_RESPONSE_COMPLETE),
+      "INFER_RESPONSE_COMPLETE");
+  EXPECT_STREQ(
+      ts::FrontendStageName(ts::FrontendStage::GRPC_SEND_END),
+      "GRPC_SEND_END");
+}
+
+TEST(FrontendStageTest, Capture)
+{
+  ts::FrontendTimestamps timestamps;
+  EXPECT_TRUE(timestamps.Empty());
+  timestamps.Capture(ts::FrontendStage::PARSE_START, 10);
+  timestamps.Capture(ts::FrontendStage::PARSE_END, 20);
+
+  size_t count = 0;
+  for (const auto& timestamp : timestamps) {
+    EXPECT_EQ(
+        timestamp.first, (count == 0) ? ts::FrontendStage::PARSE_START
+                                      : ts::FrontendStage::PARSE_END);
+    EXPECT_EQ(timestamp.second, (count + 1) * 10);
+    ++count;
+  }
+  EXPECT_EQ(count, 2u);
+
+  timestamps.Clear();
+  EXPECT_TRUE(timestamps.Empty());
+}
+
+TEST(FrontendStageTest, ServerTiming)
+{
+  ts::FrontendTimestamps timestamps;
+  EXPECT_EQ(timestamps.ServerTiming(), "");
+
+  timestamps.Capture(ts::FrontendStage::PARSE_START, 1000000);
+  timestamps.Capture(ts::FrontendStage::PARSE_END, 1500000);
+  timestamps.Capture(ts::FrontendStage::INPUT_SETUP_START, 1500000);
+  timestamps.Capture(ts::FrontendStage::INPUT_SETUP_END, 1750000);
+  timestamps.Capture(ts::FrontendStage::INFER_RESPONSE_COMPLETE, 4750000);
+  // The serialization didn't complete, it is not reported.
+  timestamps.Capture(ts::FrontendStage::OUTPUT_SERIALIZE_START, 4800000);
+  EXPECT_EQ(
+      timestamps.ServerTiming(),
+      "parse;dur=0.500, input;dur=0.250, infer;dur=3.000");
+}
+
+TEST(FrontendStageTest, ServerTimingFirstTimestamp)
+{
+  // A stage captured for each response of a request is reported from
+  // its first timestamp.
+  ts::FrontendTimestamps timestamps;
+  timestamps.Capture(ts::FrontendStage::OUTPUT_SERIALIZE_START, 0);
+  timestamps.Capture(ts::FrontendStage::OUTPUT_SERIALIZE_END, 2000);
+  timestamps.Capture(ts::FrontendStage::OUTPUT_SERIALIZE_START, 5000000);
+  timestamps.Capture(ts::FrontendStage::OUTPUT_SERIALIZE_END, 9000000);
+  EXPECT_EQ(timestamps.ServerTiming(), "output;dur=0.002");
+}
+
+TEST(FrontendStageTest, Duration)
+{
+  ts::FrontendTimestamps timestamps;
+  timestamps.Capture(ts::FrontendStage::INFER_RESPONSE_COMPLETE, 1000);
+  timestamps.Capture(ts::FrontendStage::HTTP_SEND_START, 4000);
+  timestamps.Capture(ts::FrontendStage::COMPRESS_END, 500);
+
+  uint64_t duration_ns = 0;
+  EXPECT_TRUE(timestamps.Duration(
+      ts::FrontendStage::INFER_RESPONSE_COMPLETE,
+      ts::FrontendStage::HTTP_SEND_START, &duration_ns));
+  EXPECT_EQ(duration_ns, 3000u);
+  // Not captured.
+  EXPECT_FALSE(timestamps.Duration(
+      ts::FrontendStage::HTTP_SEND_START, ts::FrontendStage::HTTP_SEND_END,
+      &duration_ns));
+  // The end precedes the start.
+  EXPECT_FALSE(timestamps.Duration(
+      ts::FrontendStage::INFER_RESPONSE_COMPLETE,
+      ts::FrontendStage::COMPRESS_END, &duration_ns));
+  EXPECT_EQ(duration_ns, 3000u);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,277 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+// Undefine the FAIL() macro inside Triton code to avoid redefine error
+// from gtest.
+#ifdef FAIL
+#undef FAIL
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include "grpc/infer_handler.h"
+
+namespace tsg = triton::server::grpc;
+
+//
+// Global allocation counter. Every heap allocation made by the process
+// goes through the replaced operator new below so that the number of
+// allocations performed while building a message can be measured.
+//
+static std::atomic<uint64_t> g_alloc_count(0);
+
+void*
+operator new(size_t size)
+{
+  g_alloc_count++;
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void
+operator delete(void* ptr, size_t size) noexcept
+{
+  std::free(ptr);
+}
+
+namespace {
+
+constexpr size_t kTensorCount = 4;
+constexpr size_t kTensorByteSize = 16 * 1024;
+constexpr size_t kWarmupIterations = 16;
+constexpr size_t kIterations = 10000;
+
+// Fill 'request' the same way a client would for a 4-input / 4-output
+// inference request.
+void
+PopulateRequest(inference::ModelInferRequest* request)
+{
+  request->set_model_name("benchmark_model");
+  request->set_model_version("1");
+  request->set_id("request_id_0123456789");
+  (*request->mutable_parameters())["sequence_id"].set_int64_param(1);
+  (*request->mutable_parameters())["priority"].set_int64_param(2);
+  for (size_t i = 0; i < kTensorCount; ++i) {
+    auto input = request->add_inputs();
+    input->set_name("INPUT" + std::to_string(i));
+    input->set_datatype("FP32");
+    input->add_shape(1);
+    input->add_shape(kTensorByteSize / sizeof(float));
+    (*input->mutable_parameters())["binary_data_size"].set_int64_param(
+        kTensorByteSize);
+    request->add_raw_input_contents()->assign(kTensorByteSize, '\1');
+
+    auto output = request->add_outputs();
+    output->set_name("OUTPUT" + std::to_string(i));
+    (*output->mutable_parameters())["binary_data"].set_bool_param(true);
+  }
+}
+
+// Fill 'response' the same way InferResponseCompleteCommon does for a
+// 4-output response.
+void
+PopulateResponse(inference::ModelInferResponse* response)
+{
+  response->set_model_name("benchmark_model");
+  response->set_model_version("1");
+  response->set_id("request_id_0123456789");
+  (*response->mutable_parameters())["triton_final_response"].set_bool_param(
+      true);
+  for (size_t i = 0; i < kTensorCount; ++i) {
+    auto output = response->add_outputs();
+    output->set_name("OUTPUT" + std::to_string(i));
+    output->set_datatype("FP32");
+    output->add_shape(1);
+    output->add_shape(kTensorByteSize / sizeof(float));
+    response->add_raw_output_contents()->resize(kTensorByteSize);
+  }
+}
+
+struct BenchmarkResult {
+  double allocs_per_iteration_;
+  double ns_per_iteration_;
+};
+
+// Run 'fn' for 'kIterations' after a short warmup and report the
+// average number of heap allocations and latency per iteration.
+template <typename Fn>
+BenchmarkResult
+RunBenchmark(const std::string& name, Fn fn)
+{
+  for (size_t i = 0; i < kWarmupIterations; ++i) {
+    fn();
+  }
+
+  const uint64_t start_allocs = g_alloc_count;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < kIterations; ++i) {
+    fn();
+  }
+  const auto end = std::chrono::steady_clock::now();
+  const uint64_t end_allocs = g_alloc_count;
+
+  BenchmarkResult result;
+  result.allocs_per_iteration_ =
+      static_cast<double>(end_allocs - start_allocs) / kIterations;
+  result.ns_per_iteration_ =
+      static_cast<double>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+              .count()) /
+      kIterations;
+
+  std::cout << name << ": " << result.allocs_per_iteration_
+            << " allocations/iteration, " << result.ns_per_iteration_
+            << " ns/iteration" << std::endl;
+  return result;
+}
+
+class GrpcMessageArenaTest : public ::testing::Test {};
+
+TEST_F(GrpcMessageArenaTest, RequestResponseAllocations)
+{
+  // Baseline: persistent heap messages cleared between uses, which is
+  // what the handler states did before the messages moved to arenas.
+  inference::ModelInferRequest heap_request;
+  inference::ModelInferResponse heap_response;
+  auto heap = RunBenchmark("heap (Clear)", [&]() {
+    heap_request.Clear();
+    heap_response.Clear();
+    PopulateRequest(&heap_request);
+    PopulateResponse(&heap_response);
+  });
+
+  // Arena: request on a per-state arena and response on the response
+  // queue, both reset between uses exactly like InferHandlerState::Reset().
+  tsg::MessageArena request_arena;
+  inference::ModelInferRequest* request = nullptr;
+  tsg::ResponseQueue<inference::ModelInferResponse> response_queue;
+  auto arena = RunBenchmark("arena (Reset)", [&]() {
+    if (!request_arena.Reset() || (request == nullptr)) {
+      request = request_arena.Create<inference::ModelInferRequest>();
+    }
+    response_queue.Reset();
+    PopulateRequest(request);
+    PopulateResponse(response_queue.GetNonDecoupledResponse());
+  });
+
+  // The remaining heap allocations of the arena case are the temporaries
+  // and the map keys longer than the small string buffer created by this
+  // test, and the tensor payloads of the iterations where the arena grew
+  // beyond its initial block and released its messages.
+  EXPECT_LT(arena.allocs_per_iteration_, heap.allocs_per_iteration_)
+      << "arena allocation should reduce the number of heap allocations";
+}
+
+TEST_F(GrpcMessageArenaTest, PayloadCapacityKeptAcrossReset)
+{
+  tsg::MessageArena arena;
+  auto request = arena.Create<inference::ModelInferRequest>();
+  tsg::ResponseQueue<inference::ModelInferResponse> response_queue;
+  auto response = response_queue.GetNonDecoupledResponse();
+  for (size_t i = 0; i < kTensorCount; ++i) {
+    request->add_raw_input_contents()->assign(kTensorByteSize, '\1');
+    response->add_raw_output_contents()->resize(kTensorByteSize);
+  }
+
+  // The messages are cleared, not released, so the payload strings are
+  // re-used with their capacity.
+  ASSERT_TRUE(arena.Reset());
+  response_queue.Reset();
+  EXPECT_EQ(request->raw_input_contents_size(), 0);
+  ASSERT_EQ(response_queue.GetNonDecoupledResponse(), response);
+  EXPECT_EQ(response->raw_output_contents_size(), 0);
+
+  const uint64_t start_allocs = g_alloc_count;
+  for (size_t i = 0; i < kTensorCount; ++i) {
+    request->add_raw_input_contents()->assign(kTensorByteSize, '\1');
+    response->add_raw_output_contents()->resize(kTensorByteSize);
+  }
+  EXPECT_EQ(g_alloc_count - start_allocs, 0u)
+      << "the tensor payloads should not be allocated again after a reset";
+}
+
+TEST_F(GrpcMessageArenaTest, GrownArenaReleasesMessages)
+{
+  tsg::MessageArena arena;
+  auto request = arena.Create<inference::ModelInferRequest>();
+  for (size_t i = 0; i < 256; ++i) {
+    request->add_inputs()->set_name("INPUT" + std::to_string(i));
+  }
+  ASSERT_GT(arena.SpaceAllocated(), GRPC_STATE_ARENA_INITIAL_BLOCK_SIZE);
+
+  // An arena that grew beyond its initial block releases its messages
+  // so that the memory held by a state is bounded.
+  EXPECT_FALSE(arena.Reset());
+  EXPECT_EQ(arena.SpaceAllocated(), GRPC_STATE_ARENA_INITIAL_BLOCK_SIZE);
+  EXPECT_TRUE(arena.Reset());
+}
+
+TEST_F(GrpcMessageArenaTest, ResponseQueueReset)
+{
+  tsg::ResponseQueue<inference::ModelInferResponse> response_queue;
+  for (size_t i = 0; i < kTensorCount; ++i) {
+    response_queue.AllocateResponse();
+    PopulateResponse(response_queue.GetLastAllocatedResponse());
+    ASSERT_TRUE(response_queue.MarkNextResponseComplete());
+  }
+  EXPECT_TRUE(response_queue.HasReadyResponse());
+
+  response_queue.Reset();
+  EXPECT_TRUE(response_queue.IsEmpty());
+  EXPECT_FALSE(response_queue.HasReadyResponse());
+
+  // Responses allocated after a reset must start out empty.
+  response_queue.AllocateResponse();
+  auto response = response_queue.GetLastAllocatedResponse();
+  ASSERT_TRUE(response != nullptr);
+  EXPECT_EQ(response->outputs_size(), 0);
+  EXPECT_EQ(response->raw_output_contents_size(), 0);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
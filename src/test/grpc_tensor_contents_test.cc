@@ -0,0 +1,203 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "grpc/tensor_contents.h"
+
+namespace tsg = triton::server::grpc;
+
+namespace {
+
+constexpr size_t kBenchmarkElementCount = 1000000;
+constexpr size_t kBenchmarkIterations = 20;
+
+// Reference conversion matching the per-element append previously done
+// by InferGRPCToInput.
+template <typename SrcType, typename DstType>
+std::string
+ReferenceNarrow(const std::vector<SrcType>& src)
+{
+  std::string serialized;
+  serialized.reserve(src.size() * sizeof(DstType));
+  for (const auto& element : src) {
+    serialized.append(
+        reinterpret_cast<const char*>(&element), sizeof(DstType));
+  }
+  return serialized;
+}
+
+template <typename SrcType, typename DstType>
+std::vector<SrcType>
+RandomContents(size_t count)
+{
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int64_t> dist(
+      std::numeric_limits<DstType>::min(), std::numeric_limits<DstType>::max());
+  std::vector<SrcType> contents(count);
+  for (auto& element : contents) {
+    element = static_cast<SrcType>(dist(gen));
+  }
+  return contents;
+}
+
+template <typename Fn>
+double
+AverageNs(Fn fn)
+{
+  fn();
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < kBenchmarkIterations; ++i) {
+    fn();
+  }
+  const auto end = std::chrono::steady_clock::now();
+  return static_cast<double>(
+             std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+                 .count()) /
+         kBenchmarkIterations;
+}
+
+template <typename SrcType, typename DstType>
+void
+CheckNarrow(
+    bool (*narrow)(const SrcType*, size_t, DstType*), const std::string& name)
+{
+  // Sizes that exercise the vector body, the scalar remainder and both.
+  for (size_t count : {0, 1, 7, 15, 16, 31, 32, 33, 1000, 1027}) {
+    auto src = RandomContents<SrcType, DstType>(count);
+    std::vector<DstType> dst(count);
+    ASSERT_TRUE(narrow(src.data(), count, dst.data()))
+        << name << ": unexpected out of range for count " << count;
+    auto expected = ReferenceNarrow<SrcType, DstType>(src);
+    ASSERT_EQ(
+        std::memcmp(expected.data(), dst.data(), count * sizeof(DstType)), 0)
+        << name << ": mismatch for count " << count;
+  }
+
+  // Range boundaries, both in the vector body and in the remainder.
+  for (size_t pos : {0, 5, 40, 99}) {
+    std::vector<SrcType> src(100, 0);
+    std::vector<DstType> dst(src.size());
+    src[pos] = std::numeric_limits<DstType>::max();
+    EXPECT_TRUE(narrow(src.data(), src.size(), dst.data())) << name;
+    src[pos] = std::numeric_limits<DstType>::min();
+    EXPECT_TRUE(narrow(src.data(), src.size(), dst.data())) << name;
+    src[pos] = static_cast<SrcType>(
+        static_cast<int64_t>(std::numeric_limits<DstType>::max()) + 1);
+    EXPECT_FALSE(narrow(src.data(), src.size(), dst.data())) << name;
+    src[pos] = static_cast<SrcType>(
+        static_cast<int64_t>(std::numeric_limits<DstType>::min()) - 1);
+    EXPECT_FALSE(narrow(src.data(), src.size(), dst.data())) << name;
+  }
+
+  // Benchmark on a 1M element tensor against the reference conversion.
+  auto src = RandomContents<SrcType, DstType>(kBenchmarkElementCount);
+  double reference_ns =
+      AverageNs([&]() { ReferenceNarrow<SrcType, DstType>(src); });
+  double narrow_ns = AverageNs([&]() {
+    std::string serialized;
+    serialized.resize(src.size() * sizeof(DstType));
+    narrow(
+        src.data(), src.size(), reinterpret_cast<DstType*>(&serialized[0]));
+  });
+  std::cout << name << " (" << kBenchmarkElementCount
+            << " elements): per-element append " << reference_ns / 1000
+            << " us, narrow " << narrow_ns / 1000 << " us" << std::endl;
+}
+
+TEST(GrpcTensorContentsTest, NarrowInt8)
+{
+  CheckNarrow<int32_t, int8_t>(tsg::NarrowInt32ToInt8, "INT8");
+}
+
+TEST(GrpcTensorContentsTest, NarrowInt16)
+{
+  CheckNarrow<int32_t, int16_t>(tsg::NarrowInt32ToInt16, "INT16");
+}
+
+TEST(GrpcTensorContentsTest, NarrowUint8)
+{
+  CheckNarrow<uint32_t, uint8_t>(tsg::NarrowUint32ToUint8, "UINT8");
+}
+
+TEST(GrpcTensorContentsTest, NarrowUint16)
+{
+  CheckNarrow<uint32_t, uint16_t>(tsg::NarrowUint32ToUint16, "UINT16");
+}
+
+TEST(GrpcTensorContentsTest, SerializeBytes)
+{
+  google::protobuf::RepeatedPtrField<std::string> contents;
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<size_t> len_dist(0, 16);
+  for (size_t i = 0; i < kBenchmarkElementCount; ++i) {
+    contents.Add()->assign(len_dist(gen), 'a' + (i % 26));
+  }
+
+  // Reference serialization matching the per-element append previously
+  // done by InferGRPCToInput.
+  auto reference = [&contents]() {
+    std::string serialized;
+    for (const auto& element : contents) {
+      uint32_t len{(uint32_t)element.size()};
+      serialized.append(reinterpret_cast<const char*>(&len), sizeof(uint32_t));
+      if (element.size() > 0) {
+        serialized.append(element.c_str(), len);
+      }
+    }
+    return serialized;
+  };
+  auto serialize = [&contents]() {
+    std::string serialized;
+    serialized.resize(tsg::SerializedBytesContentsByteSize(contents));
+    tsg::SerializeBytesContents(contents, &serialized[0]);
+    return serialized;
+  };
+  ASSERT_EQ(reference(), serialize());
+
+  double reference_ns = AverageNs(reference);
+  double serialize_ns = AverageNs(serialize);
+  std::cout << "BYTES (" << kBenchmarkElementCount
+            << " elements): per-element append " << reference_ns / 1000
+            << " us, serialize " << serialize_ns / 1000 << " us" << std::endl;
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
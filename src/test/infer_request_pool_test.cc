@@ -0,0 +1,515 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+#include "gtest/gtest.h"
+#include "gtest/gtest.h"
+
+// Undefine the FAIL() macro inside Triton code to avoid redefine error
+// from gtest.
+#ifdef FAIL
+#undef FAIL
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+
+#include "infer_request_pool.h"
+
+namespace ts = triton::server;
+
+namespace {
+
+struct TritonServerError {
+  TritonServerError(TRITONSERVER_Error_Code code, const char* msg)
+      : code_(code), msg_(msg)
+  {
+  }
+  TRITONSERVER_Error_Code code_;
+  std::string msg_;
+};
+
+// The state of an inference request that the pool must reset, kept by
+// the request functions below in place of the core.
+struct FakeRequest {
+  std::string model_name_;
+  int64_t model_version_{0};
+  std::set<std::string> inputs_;
+  std::set<std::string> outputs_;
+  std::map<std::string, std::string> parameters_;
+  std::string id_;
+  uint32_t flags_{0};
+  uint64_t correlation_id_{0};
+  uint64_t priority_{0};
+  uint64_t timeout_us_{0};
+  bool cancelled_{false};
+  TRITONSERVER_InferenceRequestReleaseFn_t release_fn_{nullptr};
+  void* release_userp_{nullptr};
+  TRITONSERVER_InferenceResponseCompleteFn_t response_fn_{nullptr};
+  void* response_userp_{nullptr};
+};
+
+std::atomic<int> created_requests{0};
+std::atomic<int> deleted_requests{0};
+
+FakeRequest*
+Fake(TRITONSERVER_InferenceRequest* irequest)
+{
+  return reinterpret_cast<FakeRequest*>(irequest);
+}
+
+}  // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+TRITONSERVER_Error*
+TRITONSERVER_ErrorNew(TRITONSERVER_Error_Code code, const char* msg)
+{
+  return reinterpret_cast<TRITONSERVER_Error*>(
+      new TritonServerError(code, msg));
+}
+
+void
+TRITONSERVER_ErrorDelete(TRITONSERVER_Error* error)
+{
+  delete reinterpret_cast<TritonServerError*>(error);
+}
+
+TRITONSERVER_Error_Code
+TRITONSERVER_ErrorCode(TRITONSERVER_Error* error)
+{
+  return (reinterpret_cast<TritonServerError*>(error))->code_;
+}
+
+const char*
+TRITONSERVER_ErrorMessage(TRITONSERVER_Error* error)
+{
+  return (reinterpret_cast<TritonServerError*>(error))->msg_.c_str();
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestNew(
+    TRITONSERVER_InferenceRequest** inference_request,
+    TRITONSERVER_Server* server, const char* model_name,
+    const int64_t model_version)
+{
+  FakeRequest* request = new FakeRequest();
+  request->model_name_ = model_name;
+  request->model_version_ = model_version;
+  *inference_request =
+      reinterpret_cast<TRITONSERVER_InferenceRequest*>(request);
+  created_requests++;
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestDelete(
+    TRITONSERVER_InferenceRequest* inference_request)
+{
+  delete Fake(inference_request);
+  deleted_requests++;
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestIsCancelled(
+    TRITONSERVER_InferenceRequest* inference_request, bool* is_cancelled)
+{
+  *is_cancelled = Fake(inference_request)->cancelled_;
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestAddInput(
+    TRITONSERVER_InferenceRequest* inference_request, const char* name,
+    const TRITONSERVER_DataType datatype, const int64_t* shape,
+    uint64_t dim_count)
+{
+  if (!Fake(inference_request)->inputs_.emplace(name).second) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        (std::string("input '") + name + "' already exists").c_str());
+  }
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestRemoveAllInputs(
+    TRITONSERVER_InferenceRequest* inference_request)
+{
+  Fake(inference_request)->inputs_.clear();
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestAddRequestedOutput(
+    TRITONSERVER_InferenceRequest* inference_request, const char* name)
+{
+  if (!Fake(inference_request)->outputs_.emplace(name).second) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        (std::string("output '") + name + "' already requested").c_str());
+  }
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestRemoveAllRequestedOutputs(
+    TRITONSERVER_InferenceRequest* inference_request)
+{
+  Fake(inference_request)->outputs_.clear();
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestSetStringParameter(
+    TRITONSERVER_InferenceRequest* inference_request, const char* key,
+    const char* value)
+{
+  Fake(inference_request)->parameters_[key] = value;
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestSetId(
+    TRITONSERVER_InferenceRequest* inference_request, const char* id)
+{
+  Fake(inference_request)->id_ = id;
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestSetFlags(
+    TRITONSERVER_InferenceRequest* inference_request, uint32_t flags)
+{
+  Fake(inference_request)->flags_ = flags;
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestSetCorrelationId(
+    TRITONSERVER_InferenceRequest* inference_request, uint64_t correlation_id)
+{
+  Fake(inference_request)->correlation_id_ = correlation_id;
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestSetPriorityUInt64(
+    TRITONSERVER_InferenceRequest* inference_request, uint64_t priority)
+{
+  Fake(inference_request)->priority_ = priority;
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestSetTimeoutMicroseconds(
+    TRITONSERVER_InferenceRequest* inference_request, uint64_t timeout_us)
+{
+  Fake(inference_request)->timeout_us_ = timeout_us;
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestSetReleaseCallback(
+    TRITONSERVER_InferenceRequest* inference_request,
+    TRITONSERVER_InferenceRequestReleaseFn_t request_release_fn,
+    void* request_release_userp)
+{
+  Fake(inference_request)->release_fn_ = request_release_fn;
+  Fake(inference_request)->release_userp_ = request_release_userp;
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestSetResponseCallback(
+    TRITONSERVER_InferenceRequest* inference_request,
+    TRITONSERVER_ResponseAllocator* response_allocator,
+    void* response_allocator_userp,
+    TRITONSERVER_InferenceResponseCompleteFn_t response_fn,
+    void* response_userp)
+{
+  Fake(inference_request)->response_fn_ = response_fn;
+  Fake(inference_request)->response_userp_ = response_userp;
+  return nullptr;  // success
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+namespace {
+
+void
+ReleaseFn(
+    TRITONSERVER_InferenceRequest* request, const uint32_t flags, void* userp)
+{
+}
+
+void
+ResponseFn(
+    TRITONSERVER_InferenceResponse* response, const uint32_t flags, void* userp)
+{
+}
+
+// Sets up 'irequest' the way a frontend does for an inference of
+// 'inputs' and 'outputs'.
+void
+Prepare(
+    TRITONSERVER_InferenceRequest* irequest,
+    const std::vector<std::string>& inputs,
+    const std::vector<std::string>& outputs, const std::string& id)
+{
+  const int64_t shape[] = {1, 16};
+  for (const auto& input : inputs) {
+    TRITONSERVER_Error* err = TRITONSERVER_InferenceRequestAddInput(
+        irequest, input.c_str(), TRITONSERVER_TYPE_FP32, shape, 2);
+    ASSERT_EQ(err, nullptr) << TRITONSERVER_ErrorMessage(err);
+  }
+  for (const auto& output : outputs) {
+    TRITONSERVER_Error* err = TRITONSERVER_InferenceRequestAddRequestedOutput(
+        irequest, output.c_str());
+    ASSERT_EQ(err, nullptr) << TRITONSERVER_ErrorMessage(err);
+  }
+  ASSERT_EQ(TRITONSERVER_InferenceRequestSetId(irequest, id.c_str()), nullptr);
+  ASSERT_EQ(
+      TRITONSERVER_InferenceRequestSetFlags(
+          irequest, TRITONSERVER_REQUEST_FLAG_SEQUENCE_START),
+      nullptr);
+  ASSERT_EQ(
+      TRITONSERVER_InferenceRequestSetCorrelationId(irequest, 7), nullptr);
+  ASSERT_EQ(
+      TRITONSERVER_InferenceRequestSetPriorityUInt64(irequest, 2), nullptr);
+  ASSERT_EQ(
+      TRITONSERVER_InferenceRequestSetTimeoutMicroseconds(irequest, 100),
+      nullptr);
+  ASSERT_EQ(
+      TRITONSERVER_InferenceRequestSetReleaseCallback(
+          irequest, ReleaseFn, irequest),
+      nullptr);
+  ASSERT_EQ(
+      TRITONSERVER_InferenceRequestSetResponseCallback(
+          irequest, nullptr, nullptr, ResponseFn, irequest),
+      nullptr);
+}
+
+// Expect 'irequest' to be in the state of a new request of 'model_name'.
+void
+ExpectCleared(
+    TRITONSERVER_InferenceRequest* irequest, const std::string& model_name)
+{
+  const FakeRequest* request = Fake(irequest);
+  EXPECT_EQ(request->model_name_, model_name);
+  EXPECT_TRUE(request->inputs_.empty());
+  EXPECT_TRUE(request->outputs_.empty());
+  EXPECT_TRUE(request->parameters_.empty());
+  EXPECT_EQ(request->id_, "");
+  EXPECT_EQ(request->flags_, 0u);
+  EXPECT_EQ(request->correlation_id_, 0u);
+  EXPECT_EQ(request->priority_, 0u);
+  EXPECT_EQ(request->timeout_us_, 0u);
+  EXPECT_EQ(request->release_fn_, nullptr);
+  EXPECT_EQ(request->release_userp_, nullptr);
+  EXPECT_EQ(request->response_fn_, nullptr);
+  EXPECT_EQ(request->response_userp_, nullptr);
+}
+
+class InferRequestPoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    created_requests = 0;
+    deleted_requests = 0;
+  }
+
+  void TearDown() override
+  {
+    EXPECT_EQ(created_requests.load(), deleted_requests.load());
+  }
+
+  // The pool never uses the server itself, it is only passed to the
+  // request functions.
+  std::shared_ptr<TRITONSERVER_Server> server_;
+};
+
+TEST_F(InferRequestPoolTest, ReuseClearsRequest)
+{
+  ts::InferRequestPool pool(server_, 4 /* max_idle */, 60000 /* max_age_ms */);
+
+  ts::InferRequestPool::Entry* entry = nullptr;
+  ASSERT_EQ(pool.Acquire("model", -1, &entry), nullptr);
+  TRITONSERVER_InferenceRequest* irequest = entry->irequest_;
+  ExpectCleared(irequest, "model");
+  Prepare(irequest, {"INPUT0", "INPUT1"}, {"OUTPUT0"}, "first");
+  ts::InferRequestPool::Release(entry);
+
+  // Back-to-back requests of the same model with different inputs and
+  // outputs get the same request, reset in between.
+  ASSERT_EQ(pool.Acquire("model", -1, &entry), nullptr);
+  EXPECT_EQ(entry->irequest_, irequest);
+  EXPECT_TRUE(entry->reusable_);
+  EXPECT_EQ(entry->userp_, nullptr);
+  ExpectCleared(irequest, "model");
+  Prepare(irequest, {"INPUT1"}, {"OUTPUT0", "OUTPUT1"}, "second");
+  EXPECT_EQ(Fake(irequest)->inputs_, std::set<std::string>({"INPUT1"}));
+  entry->userp_ = &pool;
+  ts::InferRequestPool::Release(entry);
+
+  ASSERT_EQ(pool.Acquire("model", -1, &entry), nullptr);
+  EXPECT_EQ(entry->irequest_, irequest);
+  EXPECT_EQ(entry->userp_, nullptr);
+  ExpectCleared(irequest, "model");
+  Prepare(irequest, {"INPUT0", "INPUT1"}, {}, "third");
+  ts::InferRequestPool::Release(entry);
+
+  EXPECT_EQ(created_requests.load(), 1);
+  EXPECT_EQ(deleted_requests.load(), 0);
+}
+
+TEST_F(InferRequestPoolTest, ParametersAreNotReused)
+{
+  ts::InferRequestPool pool(server_, 4 /* max_idle */, 60000 /* max_age_ms */);
+
+  // The parameters of a request can't be removed, the frontends mark
+  // requests with parameters as not reusable.
+  ts::InferRequestPool::Entry* entry = nullptr;
+  ASSERT_EQ(pool.Acquire("model", -1, &entry), nullptr);
+  TRITONSERVER_InferenceRequest* irequest = entry->irequest_;
+  Prepare(irequest, {"INPUT0"}, {"OUTPUT0"}, "first");
+  ASSERT_EQ(
+      TRITONSERVER_InferenceRequestSetStringParameter(irequest, "key", "value"),
+      nullptr);
+  entry->reusable_ = false;
+  ts::InferRequestPool::Release(entry);
+  EXPECT_EQ(deleted_requests.load(), 1);
+
+  ASSERT_EQ(pool.Acquire("model", -1, &entry), nullptr);
+  EXPECT_TRUE(entry->reusable_);
+  ExpectCleared(entry->irequest_, "model");
+  ts::InferRequestPool::Release(entry);
+
+  EXPECT_EQ(created_requests.load(), 2);
+}
+
+TEST_F(InferRequestPoolTest, CancelledRequestIsNotReused)
+{
+  ts::InferRequestPool pool(server_, 4 /* max_idle */, 60000 /* max_age_ms */);
+
+  ts::InferRequestPool::Entry* entry = nullptr;
+  ASSERT_EQ(pool.Acquire("model", -1, &entry), nullptr);
+  Prepare(entry->irequest_, {"INPUT0"}, {"OUTPUT0"}, "first");
+  Fake(entry->irequest_)->cancelled_ = true;
+  ts::InferRequestPool::Release(entry);
+  EXPECT_EQ(deleted_requests.load(), 1);
+
+  ASSERT_EQ(pool.Acquire("model", -1, &entry), nullptr);
+  ExpectCleared(entry->irequest_, "model");
+  ts::InferRequestPool::Release(entry);
+
+  EXPECT_EQ(created_requests.load(), 2);
+}
+
+TEST_F(InferRequestPoolTest, ModelVersionsArePooledApart)
+{
+  ts::InferRequestPool pool(server_, 4 /* max_idle */, 60000 /* max_age_ms */);
+
+  ts::InferRequestPool::Entry* entry = nullptr;
+  ASSERT_EQ(pool.Acquire("model", 1, &entry), nullptr);
+  TRITONSERVER_InferenceRequest* irequest = entry->irequest_;
+  ts::InferRequestPool::Release(entry);
+
+  ASSERT_EQ(pool.Acquire("model", 2, &entry), nullptr);
+  EXPECT_NE(entry->irequest_, irequest);
+  EXPECT_EQ(Fake(entry->irequest_)->model_version_, 2);
+  ts::InferRequestPool::Release(entry);
+
+  ASSERT_EQ(pool.Acquire("other", 1, &entry), nullptr);
+  EXPECT_NE(entry->irequest_, irequest);
+  ExpectCleared(entry->irequest_, "other");
+  ts::InferRequestPool::Release(entry);
+
+  ASSERT_EQ(pool.Acquire("model", 1, &entry), nullptr);
+  EXPECT_EQ(entry->irequest_, irequest);
+  ts::InferRequestPool::Release(entry);
+
+  EXPECT_EQ(created_requests.load(), 3);
+}
+
+TEST_F(InferRequestPoolTest, MaxIdle)
+{
+  ts::InferRequestPool pool(server_, 2 /* max_idle */, 60000 /* max_age_ms */);
+
+  std::vector<ts::InferRequestPool::Entry*> entries(3);
+  for (auto& entry : entries) {
+    ASSERT_EQ(pool.Acquire("model", -1, &entry), nullptr);
+  }
+  for (auto entry : entries) {
+    ts::InferRequestPool::Release(entry);
+  }
+  EXPECT_EQ(created_requests.load(), 3);
+  EXPECT_EQ(deleted_requests.load(), 1);
+
+  for (auto& entry : entries) {
+    ASSERT_EQ(pool.Acquire("model", -1, &entry), nullptr);
+  }
+  EXPECT_EQ(created_requests.load(), 4);
+  for (auto entry : entries) {
+    ts::InferRequestPool::Release(entry);
+  }
+}
+
+TEST_F(InferRequestPoolTest, ExpiredRequestIsNotReused)
+{
+  ts::InferRequestPool pool(server_, 4 /* max_idle */, 200 /* max_age_ms */);
+
+  // A request released past its maximum age is deleted.
+  ts::InferRequestPool::Entry* entry = nullptr;
+  ASSERT_EQ(pool.Acquire("model", -1, &entry), nullptr);
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  ts::InferRequestPool::Release(entry);
+  EXPECT_EQ(deleted_requests.load(), 1);
+
+  // An idle request is deleted in the background once it reaches it.
+  ASSERT_EQ(pool.Acquire("model", -1, &entry), nullptr);
+  ts::InferRequestPool::Release(entry);
+  EXPECT_EQ(deleted_requests.load(), 1);
+  for (int i = 0; (i < 100) && (deleted_requests.load() < 2); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(deleted_requests.load(), 2);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
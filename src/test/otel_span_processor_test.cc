@@ -0,0 +1,166 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+// Undefine the FAIL() macro inside Triton code to avoid redefine error
+// from gtest.
+#ifdef FAIL
+#undef FAIL
+#endif
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+#include "opentelemetry/sdk/trace/span_data.h"
+#include "otel_span_processor.h"
+
+namespace ts = triton::server;
+namespace otel_trace_sdk = opentelemetry::sdk::trace;
+namespace otel_common_sdk = opentelemetry::sdk::common;
+
+namespace {
+
+// Stands in for a collector, the exports wait while 'blocked_' is set.
+struct CollectorState {
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool blocked_ = false;
+  size_t exported_ = 0;
+  otel_common_sdk::ExportResult result_ =
+      otel_common_sdk::ExportResult::kSuccess;
+
+  void Unblock()
+  {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      blocked_ = false;
+    }
+    cv_.notify_all();
+  }
+};
+
+class TestExporter : public otel_trace_sdk::SpanExporter {
+ public:
+  explicit TestExporter(std::shared_ptr<CollectorState> state)
+      : state_(state)
+  {
+  }
+
+  std::unique_ptr<otel_trace_sdk::Recordable> MakeRecordable() noexcept
+      override
+  {
+    return std::unique_ptr<otel_trace_sdk::Recordable>(
+        new otel_trace_sdk::SpanData());
+  }
+
+  otel_common_sdk::ExportResult Export(
+      const opentelemetry::nostd::span<
+          std::unique_ptr<otel_trace_sdk::Recordable>>& spans) noexcept
+      override
+  {
+    std::unique_lock<std::mutex> lk(state_->mu_);
+    state_->cv_.wait(lk, [this] { return !state_->blocked_; });
+    state_->exported_ += spans.size();
+    return state_->result_;
+  }
+
+  bool Shutdown(std::chrono::microseconds /* timeout */) noexcept override
+  {
+    return true;
+  }
+
+ private:
+  std::shared_ptr<CollectorState> state_;
+};
+
+otel_trace_sdk::BatchSpanProcessorOptions
+TestOptions()
+{
+  otel_trace_sdk::BatchSpanProcessorOptions options;
+  options.max_queue_size = 4;
+  options.max_export_batch_size = 2;
+  options.schedule_delay_millis = std::chrono::milliseconds(1);
+  return options;
+}
+
+TEST(OtelSpanProcessorTest, SlowCollectorDoesNotBlock)
+{
+  auto state = std::make_shared<CollectorState>();
+  state->blocked_ = true;
+  ts::BoundedSpanProcessor processor(
+      std::unique_ptr<otel_trace_sdk::SpanExporter>(new TestExporter(state)),
+      TestOptions());
+
+  // Ending the spans returns while the collector is stuck, the spans
+  // beyond the queue size are dropped.
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < 10; ++i) {
+    processor.OnEnd(processor.MakeRecordable());
+  }
+  EXPECT_LT(
+      std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+  EXPECT_EQ(processor.DroppedQueueFull(), 6u);
+
+  state->Unblock();
+  EXPECT_TRUE(processor.ForceFlush());
+  {
+    std::lock_guard<std::mutex> lk(state->mu_);
+    EXPECT_EQ(state->exported_, 4u);
+  }
+  EXPECT_EQ(processor.DroppedExportFailed(), 0u);
+
+  // The queue has room again once the spans are exported.
+  processor.OnEnd(processor.MakeRecordable());
+  EXPECT_TRUE(processor.ForceFlush());
+  EXPECT_EQ(processor.DroppedQueueFull(), 6u);
+}
+
+TEST(OtelSpanProcessorTest, ExportFailures)
+{
+  auto state = std::make_shared<CollectorState>();
+  state->result_ = otel_common_sdk::ExportResult::kFailure;
+  ts::BoundedSpanProcessor processor(
+      std::unique_ptr<otel_trace_sdk::SpanExporter>(new TestExporter(state)),
+      TestOptions());
+
+  for (size_t i = 0; i < 3; ++i) {
+    processor.OnEnd(processor.MakeRecordable());
+  }
+  EXPECT_TRUE(processor.ForceFlush());
+  EXPECT_EQ(processor.DroppedExportFailed(), 3u);
+  EXPECT_EQ(processor.DroppedQueueFull(), 0u);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,311 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+#include "gtest/gtest.h"
+
+// Undefine the FAIL() macro inside Triton code to avoid redefine error
+// from gtest.
+#ifdef FAIL
+#undef FAIL
+#endif
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "shared_memory_manager.h"
+
+namespace ts = triton::server;
+
+namespace {
+
+// Expect 'err' to be an error of 'code' and delete it.
+void
+ExpectError(TRITONSERVER_Error* err, const TRITONSERVER_Error_Code code)
+{
+  ASSERT_NE(err, nullptr);
+  EXPECT_EQ(TRITONSERVER_ErrorCode(err), code);
+  TRITONSERVER_ErrorDelete(err);
+}
+
+// Two POSIX shared memory objects of a page each, filled with 'a' and
+// 'b', that the tests register in a manager.
+class SharedMemoryManagerTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    page_size_ = sysconf(_SC_PAGESIZE);
+    for (const char fill : {'a', 'b'}) {
+      const std::string key = "/shared_memory_manager_test_" +
+                              std::to_string(getpid()) + "_" + fill;
+      const int fd = shm_open(key.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+      ASSERT_NE(fd, -1);
+      ASSERT_EQ(ftruncate(fd, page_size_), 0);
+      void* addr =
+          mmap(nullptr, page_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      ASSERT_NE(addr, MAP_FAILED);
+      memset(addr, fill, page_size_);
+      munmap(addr, page_size_);
+      close(fd);
+      keys_.push_back(key);
+    }
+  }
+
+  void TearDown() override
+  {
+    for (const auto& key : keys_) {
+      shm_unlink(key.c_str());
+    }
+  }
+
+  // Return the number of mappings of the shared memory object 'key' in
+  // the process.
+  static size_t MappingCount(const std::string& key)
+  {
+    std::ifstream maps("/proc/self/maps");
+    size_t count = 0;
+    std::string line;
+    while (std::getline(maps, line)) {
+      if (line.find(key) != std::string::npos) {
+        ++count;
+      }
+    }
+    return count;
+  }
+
+  // Look up the block by 'name' or 'handle' and return the first byte
+  // of its contents in 'value'.
+  static TRITONSERVER_Error* Read(
+      ts::SharedMemoryManager& manager, const std::string& name,
+      const uint64_t handle, char* value,
+      ts::SharedMemoryManager::Reference* reference = nullptr)
+  {
+    void* addr;
+    TRITONSERVER_MemoryType memory_type;
+    int64_t memory_type_id;
+    TRITONSERVER_Error* err = manager.GetMemoryInfo(
+        name, handle, 0 /* offset */, &addr, &memory_type, &memory_type_id,
+        reference);
+    if (err == nullptr) {
+      *value = *reinterpret_cast<const char*>(addr);
+    }
+    return err;
+  }
+
+  size_t page_size_;
+  std::vector<std::string> keys_;
+};
+
+TEST_F(SharedMemoryManagerTest, LookupByHandleAndName)
+{
+  ts::SharedMemoryManager manager;
+  uint64_t handle_a = 0;
+  uint64_t handle_b = 0;
+  ASSERT_EQ(
+      manager.RegisterSystemSharedMemory(
+          "a", keys_[0], 0 /* offset */, page_size_,
+          ts::SharedMemoryManager::MappingOptions(), &handle_a),
+      nullptr);
+  ASSERT_EQ(
+      manager.RegisterSystemSharedMemory(
+          "b", keys_[1], 0 /* offset */, page_size_,
+          ts::SharedMemoryManager::MappingOptions(), &handle_b),
+      nullptr);
+  EXPECT_NE(handle_a, 0u);
+  EXPECT_NE(handle_b, 0u);
+  EXPECT_NE(handle_a, handle_b);
+
+  char value = 0;
+  ASSERT_EQ(Read(manager, "a", 0 /* handle */, &value), nullptr);
+  EXPECT_EQ(value, 'a');
+  ASSERT_EQ(Read(manager, "", handle_b, &value), nullptr);
+  EXPECT_EQ(value, 'b');
+  // The name is ignored if a handle is given.
+  ASSERT_EQ(Read(manager, "a", handle_b, &value), nullptr);
+  EXPECT_EQ(value, 'b');
+
+  ExpectError(
+      Read(manager, "c", 0 /* handle */, &value), TRITONSERVER_ERROR_NOT_FOUND);
+  ExpectError(
+      Read(manager, "a", handle_b + 1, &value), TRITONSERVER_ERROR_NOT_FOUND);
+
+  // Once unregistered the block is found neither by name nor by handle,
+  // and the handle isn't reused when the name is registered again.
+  ASSERT_EQ(manager.Unregister("a", TRITONSERVER_MEMORY_CPU), nullptr);
+  ExpectError(
+      Read(manager, "a", 0 /* handle */, &value), TRITONSERVER_ERROR_NOT_FOUND);
+  ExpectError(
+      Read(manager, "", handle_a, &value), TRITONSERVER_ERROR_NOT_FOUND);
+  uint64_t new_handle_a = 0;
+  ASSERT_EQ(
+      manager.RegisterSystemSharedMemory(
+          "a", keys_[0], 0 /* offset */, page_size_,
+          ts::SharedMemoryManager::MappingOptions(), &new_handle_a),
+      nullptr);
+  EXPECT_NE(new_handle_a, handle_a);
+  EXPECT_NE(new_handle_a, handle_b);
+  ExpectError(
+      Read(manager, "", handle_a, &value), TRITONSERVER_ERROR_NOT_FOUND);
+  ASSERT_EQ(Read(manager, "", new_handle_a, &value), nullptr);
+  EXPECT_EQ(value, 'a');
+
+  // Unregistering by handle.
+  ASSERT_EQ(manager.UnregisterHandle(handle_b), nullptr);
+  ExpectError(
+      Read(manager, "b", 0 /* handle */, &value), TRITONSERVER_ERROR_NOT_FOUND);
+  ASSERT_EQ(manager.UnregisterAll(TRITONSERVER_MEMORY_CPU), nullptr);
+}
+
+TEST_F(SharedMemoryManagerTest, UnregisterWhileReferenced)
+{
+  ts::SharedMemoryManager manager;
+  uint64_t handle = 0;
+  ASSERT_EQ(
+      manager.RegisterSystemSharedMemory(
+          "a", keys_[0], 0 /* offset */, page_size_,
+          ts::SharedMemoryManager::MappingOptions(), &handle),
+      nullptr);
+  ASSERT_EQ(MappingCount(keys_[0]), 1u);
+
+  void* addr;
+  TRITONSERVER_MemoryType memory_type;
+  int64_t memory_type_id;
+  ts::SharedMemoryManager::Reference reference;
+  ASSERT_EQ(
+      manager.GetMemoryInfo(
+          "", handle, 0 /* offset */, &addr, &memory_type, &memory_type_id,
+          &reference),
+      nullptr);
+  ASSERT_NE(reference, nullptr);
+
+  // The block stays mapped while referenced, even though it can't be
+  // found anymore and its name can be registered again.
+  ASSERT_EQ(manager.Unregister("a", TRITONSERVER_MEMORY_CPU), nullptr);
+  char value = 0;
+  ExpectError(
+      Read(manager, "", handle, &value), TRITONSERVER_ERROR_NOT_FOUND);
+  EXPECT_EQ(MappingCount(keys_[0]), 1u);
+  EXPECT_EQ(*reinterpret_cast<const char*>(addr), 'a');
+
+  ASSERT_EQ(
+      manager.RegisterSystemSharedMemory(
+          "a", keys_[1], 0 /* offset */, page_size_),
+      nullptr);
+  ASSERT_EQ(Read(manager, "a", 0 /* handle */, &value), nullptr);
+  EXPECT_EQ(value, 'b');
+  EXPECT_EQ(*reinterpret_cast<const char*>(addr), 'a');
+
+  // The block is unmapped with the last reference.
+  reference.reset();
+  EXPECT_EQ(MappingCount(keys_[0]), 0u);
+  EXPECT_EQ(MappingCount(keys_[1]), 1u);
+}
+
+TEST_F(SharedMemoryManagerTest, ConcurrentReaders)
+{
+  // Readers look up a block that stays registered and a block that is
+  // registered and unregistered repeatedly, by name and by handle.
+  ts::SharedMemoryManager manager;
+  uint64_t stable_handle = 0;
+  ASSERT_EQ(
+      manager.RegisterSystemSharedMemory(
+          "stable", keys_[0], 0 /* offset */, page_size_,
+          ts::SharedMemoryManager::MappingOptions(), &stable_handle),
+      nullptr);
+
+  constexpr size_t kReaderCount = 8;
+  constexpr size_t kRegisterCount = 500;
+  std::atomic<uint64_t> churn_handle(0);
+  std::atomic<bool> done(false);
+  std::atomic<size_t> failures(0);
+  std::vector<std::thread> readers;
+  for (size_t i = 0; i < kReaderCount; ++i) {
+    readers.emplace_back([&, i]() {
+      while (!done) {
+        char value = 0;
+        TRITONSERVER_Error* err =
+            (i % 2 == 0) ? Read(manager, "stable", 0 /* handle */, &value)
+                         : Read(manager, "", stable_handle, &value);
+        if ((err != nullptr) || (value != 'a')) {
+          ++failures;
+        }
+        TRITONSERVER_ErrorDelete(err);
+
+        // The churned block may be found or not, but if found its
+        // contents are mapped until the reference is released.
+        ts::SharedMemoryManager::Reference reference;
+        value = 0;
+        err = (i % 2 == 0)
+                  ? Read(manager, "churn", 0 /* handle */, &value, &reference)
+                  : Read(manager, "", churn_handle, &value, &reference);
+        if (err == nullptr) {
+          std::this_thread::yield();
+          if ((value != 'b') || (reference == nullptr)) {
+            ++failures;
+          }
+        } else if (
+            TRITONSERVER_ErrorCode(err) != TRITONSERVER_ERROR_NOT_FOUND) {
+          ++failures;
+        }
+        TRITONSERVER_ErrorDelete(err);
+      }
+    });
+  }
+
+  for (size_t i = 0; i < kRegisterCount; ++i) {
+    // Not asserted so that the readers are always joined.
+    uint64_t handle = 0;
+    EXPECT_EQ(
+        manager.RegisterSystemSharedMemory(
+            "churn", keys_[1], 0 /* offset */, page_size_,
+            ts::SharedMemoryManager::MappingOptions(), &handle),
+        nullptr);
+    churn_handle = handle;
+    EXPECT_EQ(manager.Unregister("churn", TRITONSERVER_MEMORY_CPU), nullptr);
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  EXPECT_EQ(failures, 0u);
+  EXPECT_EQ(MappingCount(keys_[1]), 0u);
+  ASSERT_EQ(manager.Unregister("stable", TRITONSERVER_MEMORY_CPU), nullptr);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
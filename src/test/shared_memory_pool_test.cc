@@ -0,0 +1,283 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+// Undefine the FAIL() macro inside Triton code to avoid redefine error
+// from gtest.
+#ifdef FAIL
+#undef FAIL
+#endif
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "shared_memory_manager.h"
+#include "shared_memory_pool.h"
+
+namespace ts = triton::server;
+
+namespace {
+
+// Expect 'err' to be an error of 'code' and delete it.
+void
+ExpectError(TRITONSERVER_Error* err, const TRITONSERVER_Error_Code code)
+{
+  ASSERT_NE(err, nullptr);
+  EXPECT_EQ(TRITONSERVER_ErrorCode(err), code);
+  TRITONSERVER_ErrorDelete(err);
+}
+
+class SharedMemoryPoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override { memory_.resize(1 << 20); }
+
+  std::vector<char> memory_;
+};
+
+TEST_F(SharedMemoryPoolTest, AllocateAndRelease)
+{
+  // The tail that doesn't fill a block isn't used.
+  ts::SharedMemoryPool pool(memory_.data(), 64 * 1024 + 100, 1024, 0);
+  ASSERT_EQ(pool.BlockCount(), 64u);
+
+  size_t offset;
+  uint64_t lease;
+  ASSERT_EQ(pool.Allocate(0, &offset, &lease), nullptr);
+  EXPECT_EQ(lease, 0u);
+  EXPECT_EQ(pool.UsedBytes(), 0u);
+
+  size_t small_offset;
+  uint64_t small_lease;
+  ASSERT_EQ(pool.Allocate(1, &small_offset, &small_lease), nullptr);
+  EXPECT_EQ(small_offset, 0u);
+  EXPECT_NE(small_lease, 0u);
+
+  // A run of blocks that spans bitmap words.
+  size_t large_offset;
+  uint64_t large_lease;
+  ASSERT_EQ(pool.Allocate(62 * 1024 + 1, &large_offset, &large_lease), nullptr);
+  EXPECT_EQ(large_offset, 1024u);
+  EXPECT_EQ(pool.UsedBytes(), 64u * 1024);
+  ExpectError(
+      pool.Allocate(1, &offset, &lease), TRITONSERVER_ERROR_UNAVAILABLE);
+
+  // Releases must name a live allocation.
+  ExpectError(
+      pool.Release(small_offset, small_lease + 1),
+      TRITONSERVER_ERROR_NOT_FOUND);
+  ExpectError(pool.Release(512, small_lease), TRITONSERVER_ERROR_NOT_FOUND);
+  ASSERT_EQ(pool.Release(small_offset, small_lease), nullptr);
+  ExpectError(
+      pool.Release(small_offset, small_lease), TRITONSERVER_ERROR_NOT_FOUND);
+  ASSERT_EQ(pool.Release(large_offset, large_lease), nullptr);
+  EXPECT_EQ(pool.UsedBytes(), 0u);
+
+  // The whole pool is free again.
+  ASSERT_EQ(pool.Allocate(64 * 1024, &offset, &lease), nullptr);
+  EXPECT_EQ(offset, 0u);
+  ASSERT_EQ(pool.Release(offset, lease), nullptr);
+}
+
+TEST_F(SharedMemoryPoolTest, LeaseExpiry)
+{
+  ts::SharedMemoryPool pool(memory_.data(), 8 * 1024, 1024, 1 /* lease_ms */);
+
+  size_t offset;
+  uint64_t lease;
+  ASSERT_EQ(pool.Allocate(8 * 1024, &offset, &lease), nullptr);
+  const uint64_t expired_lease = lease;
+
+  // The allocation isn't reclaimed before its lease is started.
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  ExpectError(
+      pool.Allocate(1024, &offset, &lease), TRITONSERVER_ERROR_UNAVAILABLE);
+  ExpectError(
+      pool.StartLease(0, expired_lease + 1), TRITONSERVER_ERROR_NOT_FOUND);
+  ASSERT_EQ(pool.StartLease(0, expired_lease), nullptr);
+
+  // The allocation is reclaimed once its lease expired and the pool is
+  // out of space.
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  ASSERT_EQ(pool.Allocate(1024, &offset, &lease), nullptr);
+  EXPECT_EQ(pool.UsedBytes(), 1024u);
+  ExpectError(pool.Release(0, expired_lease), TRITONSERVER_ERROR_NOT_FOUND);
+  ASSERT_EQ(pool.Release(offset, lease), nullptr);
+}
+
+TEST_F(SharedMemoryPoolTest, UndeliveredAllocations)
+{
+  ts::SharedMemoryPool pool(memory_.data(), 8 * 1024, 1024, 1 /* lease_ms */);
+
+  // One output of each of three responses.
+  size_t offsets[3];
+  uint64_t leases[3];
+  {
+    ts::SharedMemoryPoolAllocations allocations;
+    for (uint32_t r = 0; r < 3; ++r) {
+      ASSERT_EQ(pool.Allocate(1024, &offsets[r], &leases[r]), nullptr);
+      allocations.Add(&pool, nullptr, offsets[r], leases[r], r);
+    }
+
+    // The first response failed, the second one is delivered and the
+    // third one never is.
+    allocations.ReleaseResponse(0);
+    EXPECT_EQ(pool.UsedBytes(), 2048u);
+    allocations.Deliver(2);
+    EXPECT_EQ(pool.UsedBytes(), 2048u);
+  }
+  EXPECT_EQ(pool.UsedBytes(), 1024u);
+
+  // Only the lease of the delivered allocation started.
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  EXPECT_EQ(pool.ReclaimExpired(), 1u);
+  EXPECT_EQ(pool.UsedBytes(), 0u);
+}
+
+TEST_F(SharedMemoryPoolTest, ConcurrentAllocations)
+{
+  ts::SharedMemoryPool pool(memory_.data(), memory_.size(), 256, 0);
+
+  // Each thread fills its allocations with its own value and checks that
+  // no other thread wrote to them before releasing.
+  constexpr int kThreadCount = 8;
+  std::atomic<bool> overlap(false);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreadCount; ++t) {
+    threads.emplace_back([&pool, &overlap, t]() {
+      for (int i = 0; i < 10000; ++i) {
+        const size_t byte_size = 1 + ((i * 7919 + t) % 8192);
+        size_t offset;
+        uint64_t lease;
+        TRITONSERVER_Error* err = pool.Allocate(byte_size, &offset, &lease);
+        if (err != nullptr) {
+          TRITONSERVER_ErrorDelete(err);
+          continue;
+        }
+        char* base = reinterpret_cast<char*>(pool.Base()) + offset;
+        std::fill(base, base + byte_size, static_cast<char>(t));
+        for (size_t idx = 0; idx < byte_size; idx += 64) {
+          if (base[idx] != static_cast<char>(t)) {
+            overlap = true;
+          }
+        }
+        err = pool.Release(offset, lease);
+        if (err != nullptr) {
+          TRITONSERVER_ErrorDelete(err);
+          overlap = true;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_FALSE(overlap);
+  EXPECT_EQ(pool.UsedBytes(), 0u);
+}
+
+TEST_F(SharedMemoryPoolTest, RegisteredWithOffset)
+{
+  // A region registered at a nonzero offset of the shared memory object
+  // is mapped from that offset, so the pool must cover exactly the
+  // region and start where the client sees it.
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  const size_t offset = 2 * page_size;
+  const size_t byte_size = 4 * page_size;
+  const std::string key =
+      "/shared_memory_pool_test_" + std::to_string(getpid());
+  const int fd = shm_open(key.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  ASSERT_NE(fd, -1);
+  ASSERT_EQ(ftruncate(fd, offset + byte_size), 0);
+  void* client_addr =
+      mmap(nullptr, offset + byte_size, PROT_READ, MAP_SHARED, fd, 0);
+  ASSERT_NE(client_addr, MAP_FAILED);
+  const char* client_base = reinterpret_cast<const char*>(client_addr);
+
+  {
+    ts::SharedMemoryManager manager;
+    ts::SharedMemoryManager::MappingOptions options;
+    options.pool_ = true;
+    options.pool_block_size_ = page_size;
+    ASSERT_EQ(
+        manager.RegisterSystemSharedMemory(
+            "pool", key, offset, byte_size, options),
+        nullptr);
+
+    void* region_base;
+    TRITONSERVER_MemoryType memory_type;
+    int64_t memory_type_id;
+    size_t region_byte_size;
+    ts::SharedMemoryPool* pool = nullptr;
+    ASSERT_EQ(
+        manager.GetMemoryInfo(
+            "pool", 0 /* handle */, 0 /* offset */, &region_base,
+            &memory_type, &memory_type_id, nullptr /* reference */,
+            &region_byte_size, &pool),
+        nullptr);
+    ASSERT_NE(pool, nullptr);
+    EXPECT_EQ(pool->Base(), region_base);
+    EXPECT_EQ(pool->BlockCount(), 4u);
+
+    // The allocation at the top of the pool is written at the end of the
+    // region as seen by the client.
+    size_t pool_offset;
+    uint64_t lease;
+    ASSERT_EQ(pool->Allocate(page_size, &pool_offset, &lease), nullptr);
+    ASSERT_EQ(pool->Allocate(3 * page_size, &pool_offset, &lease), nullptr);
+    EXPECT_EQ(pool_offset, page_size);
+    char* output = reinterpret_cast<char*>(pool->Base()) + pool_offset;
+    std::fill(output, output + 3 * page_size, 'x');
+    EXPECT_EQ(client_base[offset + pool_offset], 'x');
+    EXPECT_EQ(client_base[offset + byte_size - 1], 'x');
+    EXPECT_EQ(client_base[offset - 1], '\0');
+    ASSERT_EQ(pool->Release(pool_offset, lease), nullptr);
+
+    ASSERT_EQ(
+        manager.Unregister("pool", TRITONSERVER_MEMORY_CPU), nullptr);
+  }
+
+  munmap(client_addr, offset + byte_size);
+  close(fd);
+  shm_unlink(key.c_str());
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,375 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Latency and throughput of inferences submitted through a shared
+// memory ring. Meant to be compared against the GRPC endpoint with
+// system shared memory, e.g. 'perf_analyzer -i grpc --shared-memory
+// system', on the same model. The server must run with
+// --allow-shared-memory-ring=true.
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <netdb.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "shared_memory_ring.h"
+
+namespace shmring = triton::server::shmring;
+
+namespace {
+
+void
+Usage(char** argv, const std::string& msg = std::string())
+{
+  if (!msg.empty()) {
+    std::cerr << "error: " << msg << std::endl;
+  }
+
+  std::cerr << "Usage: " << argv[0] << " [options]" << std::endl;
+  std::cerr << "\t-u <HTTP host:port>, default is localhost:8000" << std::endl;
+  std::cerr << "\t-m <model name>, default is identity_fp32" << std::endl;
+  std::cerr << "\t-e <elements per request>, default is 16" << std::endl;
+  std::cerr << "\t-c <concurrency>, default is 1" << std::endl;
+  std::cerr << "\t-n <request count>, default is 100000" << std::endl;
+  std::cerr << std::endl;
+  std::cerr << "The model must have a FP32 input INPUT0 with shape [1, -1] "
+               "and an output OUTPUT0 that is a copy of it."
+            << std::endl;
+
+  exit(1);
+}
+
+void
+Fail(const std::string& msg)
+{
+  std::cerr << "error: " << msg << std::endl;
+  exit(1);
+}
+
+// Sends a request to the HTTP endpoint and returns the body of the
+// response, failing if the request doesn't succeed.
+std::string
+HttpRequest(
+    const std::string& url, const std::string& method, const std::string& path,
+    const std::string& body = std::string())
+{
+  const size_t colon = url.rfind(':');
+  const std::string host = url.substr(0, colon);
+  const std::string port =
+      (colon == std::string::npos) ? "8000" : url.substr(colon + 1);
+
+  struct addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo* addrs;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addrs) != 0) {
+    Fail("failed to resolve " + url);
+  }
+  int fd = socket(addrs->ai_family, addrs->ai_socktype, addrs->ai_protocol);
+  if ((fd < 0) || (connect(fd, addrs->ai_addr, addrs->ai_addrlen) != 0)) {
+    Fail("failed to connect to " + url);
+  }
+  freeaddrinfo(addrs);
+
+  const std::string request =
+      method + " " + path + " HTTP/1.1\r\nHost: " + url +
+      "\r\nContent-Type: application/json\r\nContent-Length: " +
+      std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+  size_t sent = 0;
+  while (sent < request.size()) {
+    ssize_t n = send(fd, request.data() + sent, request.size() - sent, 0);
+    if (n <= 0) {
+      Fail("failed to send " + path);
+    }
+    sent += n;
+  }
+
+  std::string response;
+  char buffer[4096];
+  ssize_t n;
+  while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+    response.append(buffer, n);
+  }
+  close(fd);
+
+  const size_t body_start = response.find("\r\n\r\n");
+  if ((response.compare(0, 12, "HTTP/1.1 200") != 0) ||
+      (body_start == std::string::npos)) {
+    Fail(path + " failed: " + response);
+  }
+  return response.substr(body_start + 4);
+}
+
+// Creates and maps a system shared memory region of 'byte_size' bytes
+// and registers it as 'name', returning its handle.
+void*
+CreateRegion(
+    const std::string& url, const std::string& name, const size_t byte_size,
+    uint64_t* handle)
+{
+  const std::string key = "/" + name;
+  int fd = shm_open(key.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+  if ((fd < 0) || (ftruncate(fd, byte_size) != 0)) {
+    Fail("failed to create shared memory " + key);
+  }
+  void* base =
+      mmap(nullptr, byte_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    Fail("failed to map shared memory " + key);
+  }
+
+  const std::string body = "{\"key\":\"" + key +
+                           "\",\"offset\":0,\"byte_size\":" +
+                           std::to_string(byte_size) + ",\"prefault\":true}";
+  const std::string response = HttpRequest(
+      url, "POST", "/v2/systemsharedmemory/region/" + name + "/register", body);
+  const size_t pos = response.find("\"handle\":");
+  if (pos == std::string::npos) {
+    Fail("no handle registering " + name + ": " + response);
+  }
+  *handle = std::stoull(response.substr(pos + 9));
+  return base;
+}
+
+void
+DeleteRegion(
+    const std::string& url, const std::string& name, void* base,
+    const size_t byte_size)
+{
+  HttpRequest(
+      url, "POST", "/v2/systemsharedmemory/region/" + name + "/unregister");
+  munmap(base, byte_size);
+  shm_unlink(("/" + name).c_str());
+}
+
+void
+SetTensor(
+    shmring::Tensor* tensor, const char* name, const uint64_t handle,
+    const uint64_t offset, const uint64_t byte_size, const int64_t elements)
+{
+  strncpy(tensor->name_, name, shmring::kMaxTensorNameSize);
+  strncpy(tensor->datatype_, "FP32", shmring::kMaxDatatypeSize);
+  tensor->region_handle_ = handle;
+  tensor->offset_ = offset;
+  tensor->byte_size_ = byte_size;
+  tensor->dims_count_ = 2;
+  tensor->shape_[0] = 1;
+  tensor->shape_[1] = elements;
+}
+
+void
+Submit(shmring::Header* header, shmring::Slot* slot)
+{
+  slot->state_.store(shmring::SLOT_SUBMITTED);
+  header->submit_doorbell_.fetch_add(1);
+  if (header->server_waiting_.load() != 0) {
+    syscall(
+        SYS_futex, reinterpret_cast<uint32_t*>(&header->submit_doorbell_),
+        FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+  }
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  std::string url("localhost:8000");
+  std::string model_name("identity_fp32");
+  int64_t elements = 16;
+  uint32_t concurrency = 1;
+  uint64_t request_count = 100000;
+
+  // Parse commandline...
+  int opt;
+  while ((opt = getopt(argc, argv, "u:m:e:c:n:")) != -1) {
+    switch (opt) {
+      case 'u':
+        url = optarg;
+        break;
+      case 'm':
+        model_name = optarg;
+        break;
+      case 'e':
+        elements = atoll(optarg);
+        break;
+      case 'c':
+        concurrency = atoi(optarg);
+        break;
+      case 'n':
+        request_count = strtoull(optarg, nullptr, 10);
+        break;
+      case '?':
+        Usage(argv);
+        break;
+    }
+  }
+
+  if (elements < 1) {
+    Usage(argv, "-e must be at least 1");
+  }
+  if (concurrency < 1) {
+    Usage(argv, "-c must be at least 1");
+  }
+  if (request_count < 1) {
+    Usage(argv, "-n must be at least 1");
+  }
+  if (model_name.size() >= shmring::kMaxModelNameSize) {
+    Usage(argv, "model name is too long");
+  }
+
+  // One slot per outstanding request, each with its own input and
+  // output buffers in the data region.
+  const size_t tensor_byte_size = elements * sizeof(float);
+  const size_t ring_byte_size = shmring::RingByteSize(concurrency);
+  const size_t data_byte_size = 2 * concurrency * tensor_byte_size;
+  uint64_t ring_handle, data_handle;
+  void* ring_base =
+      CreateRegion(url, "ring_perf", ring_byte_size, &ring_handle);
+  void* data_base =
+      CreateRegion(url, "ring_perf_data", data_byte_size, &data_handle);
+
+  shmring::Header* header = reinterpret_cast<shmring::Header*>(ring_base);
+  header->magic_ = shmring::kMagic;
+  header->version_ = shmring::kVersion;
+  header->slot_count_ = concurrency;
+  header->slot_byte_size_ = sizeof(shmring::Slot);
+  shmring::Slot* slots = shmring::RingSlots(header);
+  float* data = reinterpret_cast<float*>(data_base);
+  for (uint32_t idx = 0; idx < concurrency; ++idx) {
+    shmring::Slot* slot = &slots[idx];
+    strncpy(slot->model_name_, model_name.c_str(), shmring::kMaxModelNameSize);
+    slot->model_version_ = -1;
+    slot->input_count_ = 1;
+    slot->output_count_ = 1;
+    const uint64_t input_offset = 2 * idx * tensor_byte_size;
+    SetTensor(
+        &slot->inputs_[0], "INPUT0", data_handle, input_offset,
+        tensor_byte_size, elements);
+    for (int64_t e = 0; e < elements; ++e) {
+      data[(input_offset / sizeof(float)) + e] = idx + e;
+    }
+  }
+  HttpRequest(url, "POST", "/v2/sharedmemoryring/region/ring_perf/attach");
+
+  std::vector<std::chrono::steady_clock::time_point> submit_times(
+      concurrency);
+  std::vector<uint64_t> latencies_ns;
+  latencies_ns.reserve(request_count);
+
+  auto submit = [&](const uint32_t idx) {
+    shmring::Slot* slot = &slots[idx];
+    SetTensor(
+        &slot->outputs_[0], "OUTPUT0", data_handle,
+        (2 * idx + 1) * tensor_byte_size, tensor_byte_size, 0);
+    submit_times[idx] = std::chrono::steady_clock::now();
+    Submit(header, slot);
+  };
+
+  const auto start = std::chrono::steady_clock::now();
+  uint64_t submitted = 0;
+  for (uint32_t idx = 0; (idx < concurrency) && (submitted < request_count);
+       ++idx, ++submitted) {
+    submit(idx);
+  }
+
+  uint64_t completed = 0;
+  while (completed < request_count) {
+    const uint32_t doorbell = header->complete_doorbell_.load();
+    bool found = false;
+    for (uint32_t idx = 0; idx < concurrency; ++idx) {
+      shmring::Slot* slot = &slots[idx];
+      if (slot->state_.load() != shmring::SLOT_COMPLETED) {
+        continue;
+      }
+      found = true;
+      latencies_ns.push_back(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - submit_times[idx])
+              .count());
+      if (slot->failed_ != 0) {
+        Fail("inference failed: " + std::string(slot->error_));
+      }
+      const float* input = data + (2 * idx * elements);
+      const float* output = data + ((2 * idx + 1) * elements);
+      if ((slot->outputs_[0].byte_size_ != tensor_byte_size) ||
+          !std::equal(input, input + elements, output)) {
+        Fail("unexpected output of slot " + std::to_string(idx));
+      }
+      ++completed;
+      slot->state_.store(shmring::SLOT_FREE);
+      if (submitted < request_count) {
+        submit(idx);
+        ++submitted;
+      }
+    }
+
+    // Sleep until the server completes a slot.
+    if (!found) {
+      header->client_waiting_.store(1);
+      syscall(
+          SYS_futex, reinterpret_cast<uint32_t*>(&header->complete_doorbell_),
+          FUTEX_WAIT, doorbell, nullptr, nullptr, 0);
+      header->client_waiting_.store(0);
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  HttpRequest(url, "POST", "/v2/sharedmemoryring/region/ring_perf/detach");
+  DeleteRegion(url, "ring_perf", ring_base, ring_byte_size);
+  DeleteRegion(url, "ring_perf_data", data_base, data_byte_size);
+
+  std::sort(latencies_ns.begin(), latencies_ns.end());
+  auto percentile_us = [&latencies_ns](const double p) {
+    return latencies_ns[std::min(
+               latencies_ns.size() - 1,
+               static_cast<size_t>(p * latencies_ns.size()))] /
+           1000.0;
+  };
+  const double seconds = std::chrono::duration<double>(end - start).count();
+  std::cout << "Model: " << model_name << ", elements: " << elements
+            << ", concurrency: " << concurrency << std::endl;
+  std::cout << "Throughput: " << (request_count / seconds) << " infer/sec"
+            << std::endl;
+  std::cout << "p50 latency: " << percentile_us(0.50) << " usec" << std::endl;
+  std::cout << "p90 latency: " << percentile_us(0.90) << " usec" << std::endl;
+  std::cout << "p99 latency: " << percentile_us(0.99) << " usec" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,120 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+// Undefine the FAIL() macro inside Triton code to avoid redefine error
+// from gtest.
+#ifdef FAIL
+#undef FAIL
+#endif
+
+#include <cstdint>
+#include <limits>
+
+#include "tail_sampler.h"
+
+namespace ts = triton::server;
+
+namespace {
+
+ts::TailSampler::Latency
+MakeLatency(
+    const uint64_t total_ns, const uint64_t queue_ns = 0,
+    const uint64_t compute_ns = 0)
+{
+  ts::TailSampler::Latency latency;
+  latency.total_ns_ = total_ns;
+  latency.queue_ns_ = queue_ns;
+  latency.compute_ns_ = compute_ns;
+  return latency;
+}
+
+TEST(TailSamplerTest, Thresholds)
+{
+  ts::TailSampler::Options options;
+  options.latency_ns_ = 1000;
+  options.queue_latency_ns_ = 200;
+  options.compute_latency_ns_ = 500;
+  ts::TailSampler sampler(options);
+
+  EXPECT_FALSE(sampler.Sample(MakeLatency(999, 199, 499), false, 0));
+  EXPECT_TRUE(sampler.Sample(MakeLatency(1000), false, 0));
+  EXPECT_TRUE(sampler.Sample(MakeLatency(10, 200), false, 0));
+  EXPECT_TRUE(sampler.Sample(MakeLatency(10, 0, 500), false, 0));
+  // Failed requests are emitted regardless of the latency.
+  EXPECT_TRUE(sampler.Sample(MakeLatency(10), true, 0));
+}
+
+TEST(TailSamplerTest, Percentile)
+{
+  ts::TailSampler::Options options;
+  options.percentile_ = 99;
+  ts::TailSampler sampler(options);
+
+  // Nothing is emitted on latency until the first window completes.
+  EXPECT_EQ(
+      sampler.PercentileThreshold(), std::numeric_limits<uint64_t>::max());
+  size_t emitted = 0;
+  for (uint64_t i = 0; i < ts::TailSampler::kPercentileWindow; ++i) {
+    emitted += sampler.Sample(MakeLatency(1000 + i), false, 0) ? 1 : 0;
+  }
+  EXPECT_EQ(emitted, 0u);
+
+  // The 99th percentile of [1000, 2000) is reported within the bucket
+  // precision.
+  const uint64_t threshold = sampler.PercentileThreshold();
+  EXPECT_GE(threshold, 1990u);
+  EXPECT_LE(threshold, 1990u * 5 / 4);
+  EXPECT_FALSE(sampler.Sample(MakeLatency(1500), false, 0));
+  EXPECT_TRUE(sampler.Sample(MakeLatency(10000), false, 0));
+}
+
+TEST(TailSamplerTest, MaxPerSecond)
+{
+  ts::TailSampler::Options options;
+  options.latency_ns_ = 1;
+  options.max_per_second_ = 3;
+  ts::TailSampler sampler(options);
+
+  const uint64_t second = 1000000000;
+  size_t emitted = 0;
+  for (size_t i = 0; i < 10; ++i) {
+    emitted += sampler.Sample(MakeLatency(100), false, 5 * second) ? 1 : 0;
+  }
+  EXPECT_EQ(emitted, 3u);
+
+  // The limit applies per second.
+  EXPECT_TRUE(sampler.Sample(MakeLatency(100), false, 6 * second + 1));
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
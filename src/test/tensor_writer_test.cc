@@ -0,0 +1,131 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+// Undefine the FAIL() macro inside Triton code to avoid redefine error
+// from gtest.
+#ifdef FAIL
+#undef FAIL
+#endif
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "tensor_writer.h"
+
+namespace ts = triton::server;
+
+namespace {
+
+std::string
+TempFileName(const std::string& name)
+{
+  return "/tmp/tensor_writer_test_" + std::to_string(getpid()) + "_" + name;
+}
+
+std::string
+ReadFile(const std::string& file_name)
+{
+  std::ifstream file(file_name, std::ios::binary);
+  return std::string(
+      std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Write tensors of increasing size and check that each is found at its
+// offset once the writer is destroyed.
+void
+CheckTensors(const ts::TensorWriter::Options& options)
+{
+  const std::string file_name = TempFileName("tensors");
+  std::vector<std::string> tensors;
+  std::vector<uint64_t> offsets;
+  {
+    ts::TensorWriter writer(file_name, options);
+    for (size_t i = 0; i < 20; ++i) {
+      tensors.emplace_back(i * 1000, static_cast<char>('a' + i));
+      uint64_t offset;
+      ASSERT_TRUE(
+          writer.Write(tensors.back().data(), tensors.back().size(), &offset));
+      offsets.push_back(offset);
+    }
+    EXPECT_EQ(writer.Dropped(), 0u);
+  }
+
+  const std::string content = ReadFile(file_name);
+  uint64_t expected_offset = 0;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    EXPECT_EQ(offsets[i], expected_offset);
+    EXPECT_EQ(content.substr(offsets[i], tensors[i].size()), tensors[i]);
+    expected_offset += tensors[i].size();
+  }
+  // The preallocated space past the last tensor is dropped.
+  EXPECT_EQ(content.size(), expected_offset);
+  std::remove(file_name.c_str());
+}
+
+TEST(TensorWriterTest, Stream)
+{
+  CheckTensors(ts::TensorWriter::Options());
+}
+
+TEST(TensorWriterTest, Mapped)
+{
+  // The tensors span several segments of a page.
+  ts::TensorWriter::Options options;
+  options.segment_size_ = 1;
+  CheckTensors(options);
+}
+
+TEST(TensorWriterTest, MaxPendingBytes)
+{
+  const std::string file_name = TempFileName("pending");
+  ts::TensorWriter::Options options;
+  options.max_pending_bytes_ = 100;
+  {
+    ts::TensorWriter writer(file_name, options);
+    const std::string tensor(101, 'x');
+    uint64_t offset;
+    EXPECT_FALSE(writer.Write(tensor.data(), tensor.size(), &offset));
+    EXPECT_TRUE(writer.Write(tensor.data(), 100, &offset));
+    EXPECT_EQ(offset, 0u);
+    EXPECT_GE(writer.Dropped(), 1u);
+  }
+  std::remove(file_name.c_str());
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
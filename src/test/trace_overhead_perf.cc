@@ -0,0 +1,609 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Cost of tracing on the throughput, the latency and the CPU usage of
+// inferences run through the in-process API, as 'simple' does. The
+// inferences are first run with tracing off and then for each trace
+// mode, level and rate, each configuration is reported as a line of
+// JSON so that runs can be compared against each other.
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common.h"
+#include "tracer.h"
+#include "triton/core/tritonserver.h"
+
+namespace ts = triton::server;
+
+namespace {
+
+void
+Usage(char** argv, const std::string& msg = std::string())
+{
+  if (!msg.empty()) {
+    std::cerr << "error: " << msg << std::endl;
+  }
+
+  std::cerr << "Usage: " << argv[0] << " [options]" << std::endl;
+  std::cerr << "\t-r [model repository absolute path]" << std::endl;
+  std::cerr << "\t-m <model name>, may be repeated, default is identity_fp32 "
+               "and repeat_int32"
+            << std::endl;
+  std::cerr << "\t-e <elements per request>, default is 16" << std::endl;
+  std::cerr << "\t-c <concurrency>, default is 4" << std::endl;
+  std::cerr << "\t-n <request count per configuration>, default is 10000"
+            << std::endl;
+  std::cerr << "\t-w <warmup request count per configuration>, default is "
+               "1000"
+            << std::endl;
+  std::cerr << "\t-t <comma separated trace rates>, default is 1,10,100"
+            << std::endl;
+  std::cerr << "\t-d <directory of the trace files>, default is /tmp"
+            << std::endl;
+  std::cerr << "\t-u <OTLP HTTP exporter url>, default is "
+               "localhost:4318/v1/traces"
+            << std::endl;
+  std::cerr << "\t-v Enable verbose logging" << std::endl;
+  std::cerr << std::endl;
+  std::cerr << "identity_fp32 is sent a FP32 tensor of the given elements, "
+               "repeat_int32 is asked for a response per element."
+            << std::endl;
+
+  exit(1);
+}
+
+// A tracing configuration to run the inferences with.
+struct Config {
+  // "off" runs without a trace manager, "recorder" with a trace
+  // manager that only feeds the flight recorder.
+  std::string mode_;
+  TRITONSERVER_InferenceTraceLevel level_;
+  uint32_t rate_;
+};
+
+struct Input {
+  std::string name_;
+  TRITONSERVER_DataType datatype_;
+  std::vector<int64_t> shape_;
+  std::vector<char> data_;
+};
+
+template <typename T>
+Input
+MakeInput(
+    const std::string& name, const TRITONSERVER_DataType datatype,
+    const std::vector<int64_t>& shape, const size_t elements, const T value)
+{
+  Input input{name, datatype, shape, std::vector<char>(elements * sizeof(T))};
+  T* data = reinterpret_cast<T*>(input.data_.data());
+  for (size_t i = 0; i < elements; ++i) {
+    data[i] = value + static_cast<T>(i);
+  }
+  return input;
+}
+
+std::vector<Input>
+ModelInputs(const std::string& model_name, const int64_t elements)
+{
+  std::vector<Input> inputs;
+  if (model_name == "identity_fp32") {
+    inputs.emplace_back(MakeInput<float>(
+        "INPUT0", TRITONSERVER_TYPE_FP32, {1, elements}, elements, 0.5f));
+  } else if (model_name == "repeat_int32") {
+    // One response per element of 'IN', without delay.
+    inputs.emplace_back(MakeInput<int32_t>(
+        "IN", TRITONSERVER_TYPE_INT32, {elements}, elements, 0));
+    inputs.emplace_back(MakeInput<uint32_t>(
+        "DELAY", TRITONSERVER_TYPE_UINT32, {elements}, elements, 0));
+    Input wait = MakeInput<uint32_t>(
+        "WAIT", TRITONSERVER_TYPE_UINT32, {1}, 1, 0);
+    inputs.emplace_back(std::move(wait));
+  } else {
+    FAIL("unsupported model '" + model_name + "'");
+  }
+  return inputs;
+}
+
+TRITONSERVER_Error*
+ResponseAlloc(
+    TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
+    size_t byte_size, TRITONSERVER_MemoryType preferred_memory_type,
+    int64_t preferred_memory_type_id, void* userp, void** buffer,
+    void** buffer_userp, TRITONSERVER_MemoryType* actual_memory_type,
+    int64_t* actual_memory_type_id)
+{
+  *actual_memory_type = TRITONSERVER_MEMORY_CPU;
+  *actual_memory_type_id = 0;
+  *buffer = (byte_size == 0) ? nullptr : malloc(byte_size);
+  *buffer_userp = nullptr;
+  if ((byte_size != 0) && (*buffer == nullptr)) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL, "failed to allocate output buffer");
+  }
+  return nullptr;  // Success
+}
+
+TRITONSERVER_Error*
+ResponseRelease(
+    TRITONSERVER_ResponseAllocator* allocator, void* buffer, void* buffer_userp,
+    size_t byte_size, TRITONSERVER_MemoryType memory_type,
+    int64_t memory_type_id)
+{
+  free(buffer);
+  return nullptr;  // Success
+}
+
+uint64_t
+CpuTimeUs()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+         usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+struct Result {
+  double throughput_;
+  double p50_us_;
+  double p99_us_;
+  double cpu_us_per_request_;
+};
+
+//
+// Keeps 'concurrency' inferences of a model in flight, a new inference
+// is issued as soon as one completes. The inferences are traced the
+// way the frontends trace them.
+//
+class Benchmark {
+ public:
+  Benchmark(
+      const std::shared_ptr<TRITONSERVER_Server>& server,
+      TRITONSERVER_ResponseAllocator* allocator, const std::string& model_name,
+      const int64_t elements, const uint32_t concurrency)
+      : server_(server), allocator_(allocator), model_name_(model_name),
+        inputs_(ModelInputs(model_name, elements)), slots_(concurrency)
+  {
+    for (size_t idx = 0; idx < slots_.size(); ++idx) {
+      slots_[idx].benchmark_ = this;
+      slots_[idx].index_ = idx;
+    }
+  }
+
+  // Run 'request_count' inferences traced by 'manager', nullptr to run
+  // them without tracing.
+  Result Run(ts::TraceManager* manager, const uint64_t request_count);
+
+ private:
+  struct Slot {
+    Benchmark* benchmark_;
+    size_t index_;
+    std::shared_ptr<ts::TraceManager::Trace> trace_;
+    std::chrono::steady_clock::time_point start_;
+    uint64_t latency_ns_;
+  };
+
+  void Submit(ts::TraceManager* manager, Slot* slot);
+
+  static void RequestRelease(
+      TRITONSERVER_InferenceRequest* request, const uint32_t flags,
+      void* userp);
+  static void ResponseComplete(
+      TRITONSERVER_InferenceResponse* response, const uint32_t flags,
+      void* userp);
+
+  std::shared_ptr<TRITONSERVER_Server> server_;
+  TRITONSERVER_ResponseAllocator* allocator_;
+  const std::string model_name_;
+  const std::vector<Input> inputs_;
+  std::vector<Slot> slots_;
+
+  // The index of the slots whose inference completed.
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<size_t> completed_;
+};
+
+Result
+Benchmark::Run(ts::TraceManager* manager, const uint64_t request_count)
+{
+  std::vector<uint64_t> latencies_ns;
+  latencies_ns.reserve(request_count);
+
+  const auto start = std::chrono::steady_clock::now();
+  const uint64_t start_cpu_us = CpuTimeUs();
+  uint64_t submitted = 0;
+  for (; (submitted < slots_.size()) && (submitted < request_count);
+       ++submitted) {
+    Submit(manager, &slots_[submitted]);
+  }
+
+  while (latencies_ns.size() < request_count) {
+    size_t idx;
+    {
+      std::unique_lock<std::mutex> lk(mu_);
+      cv_.wait(lk, [this] { return !completed_.empty(); });
+      idx = completed_.front();
+      completed_.pop_front();
+    }
+    Slot* slot = &slots_[idx];
+    latencies_ns.push_back(slot->latency_ns_);
+    slot->trace_.reset();
+    if (submitted < request_count) {
+      Submit(manager, slot);
+      ++submitted;
+    }
+  }
+  const uint64_t cpu_us = CpuTimeUs() - start_cpu_us;
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+
+  std::sort(latencies_ns.begin(), latencies_ns.end());
+  auto percentile_us = [&latencies_ns](const double p) {
+    return latencies_ns[std::min(
+               latencies_ns.size() - 1,
+               static_cast<size_t>(p * latencies_ns.size()))] /
+           1000.0;
+  };
+  Result result;
+  result.throughput_ = request_count / seconds;
+  result.p50_us_ = percentile_us(0.50);
+  result.p99_us_ = percentile_us(0.99);
+  result.cpu_us_per_request_ = static_cast<double>(cpu_us) / request_count;
+  return result;
+}
+
+void
+Benchmark::Submit(ts::TraceManager* manager, Slot* slot)
+{
+  TRITONSERVER_InferenceRequest* irequest = nullptr;
+  FAIL_IF_ERR(
+      TRITONSERVER_InferenceRequestNew(
+          &irequest, server_.get(), model_name_.c_str(),
+          -1 /* model_version */),
+      "creating inference request");
+  for (const auto& input : inputs_) {
+    FAIL_IF_ERR(
+        TRITONSERVER_InferenceRequestAddInput(
+            irequest, input.name_.c_str(), input.datatype_,
+            input.shape_.data(), input.shape_.size()),
+        "setting input meta-data for the request");
+    FAIL_IF_ERR(
+        TRITONSERVER_InferenceRequestAppendInputData(
+            irequest, input.name_.c_str(), input.data_.data(),
+            input.data_.size(), TRITONSERVER_MEMORY_CPU,
+            0 /* memory_type_id */),
+        "assigning input data");
+  }
+  FAIL_IF_ERR(
+      TRITONSERVER_InferenceRequestSetReleaseCallback(
+          irequest, RequestRelease, nullptr /* request_release_userp */),
+      "setting request release callback");
+  FAIL_IF_ERR(
+      TRITONSERVER_InferenceRequestSetResponseCallback(
+          irequest, allocator_, nullptr /* response_allocator_userp */,
+          ResponseComplete, reinterpret_cast<void*>(slot)),
+      "setting response callback");
+
+  TRITONSERVER_InferenceTrace* triton_trace = nullptr;
+  if (manager != nullptr) {
+    slot->trace_ = manager->SampleTrace(model_name_);
+    if (slot->trace_ != nullptr) {
+      triton_trace = slot->trace_->trace_;
+    }
+  }
+
+  slot->start_ = std::chrono::steady_clock::now();
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerInferAsync(server_.get(), irequest, triton_trace),
+      "running inference");
+  // Ownership of the trace is passed to the core.
+  if (slot->trace_ != nullptr) {
+    slot->trace_->trace_ = nullptr;
+  }
+}
+
+void
+Benchmark::RequestRelease(
+    TRITONSERVER_InferenceRequest* request, const uint32_t flags, void* userp)
+{
+  if ((flags & TRITONSERVER_REQUEST_RELEASE_ALL) != 0) {
+    FAIL_IF_ERR(
+        TRITONSERVER_InferenceRequestDelete(request),
+        "deleting inference request");
+  }
+}
+
+void
+Benchmark::ResponseComplete(
+    TRITONSERVER_InferenceResponse* response, const uint32_t flags, void* userp)
+{
+  Slot* slot = reinterpret_cast<Slot*>(userp);
+  if (response != nullptr) {
+    FAIL_IF_ERR(
+        TRITONSERVER_InferenceResponseError(response), "response status");
+    FAIL_IF_ERR(
+        TRITONSERVER_InferenceResponseDelete(response),
+        "deleting inference response");
+  }
+  if ((flags & TRITONSERVER_RESPONSE_COMPLETE_FINAL) == 0) {
+    return;
+  }
+
+  const auto now = std::chrono::steady_clock::now();
+  slot->latency_ns_ =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - slot->start_)
+          .count();
+  if (slot->trace_ != nullptr) {
+    slot->trace_->CaptureTimestamp(
+        ts::FrontendStage::INFER_RESPONSE_COMPLETE,
+        ts::TraceManager::CaptureTimestamp());
+  }
+
+  Benchmark* benchmark = slot->benchmark_;
+  {
+    std::lock_guard<std::mutex> lk(benchmark->mu_);
+    benchmark->completed_.push_back(slot->index_);
+  }
+  benchmark->cv_.notify_one();
+}
+
+std::vector<uint32_t>
+ParseRates(char** argv, const std::string& arg)
+{
+  std::vector<uint32_t> rates;
+  std::stringstream ss(arg);
+  std::string rate;
+  while (std::getline(ss, rate, ',')) {
+    const int value = atoi(rate.c_str());
+    if (value < 1) {
+      Usage(argv, "-t rates must be at least 1");
+    }
+    rates.push_back(value);
+  }
+  if (rates.empty()) {
+    Usage(argv, "-t must specify at least one rate");
+  }
+  return rates;
+}
+
+std::vector<Config>
+Configs(const std::vector<uint32_t>& rates)
+{
+  std::vector<Config> configs;
+  configs.push_back({"off", TRITONSERVER_TRACE_LEVEL_DISABLED, 0});
+  configs.push_back({"recorder", TRITONSERVER_TRACE_LEVEL_DISABLED, 0});
+  for (const auto rate : rates) {
+    configs.push_back({"triton", TRITONSERVER_TRACE_LEVEL_TIMESTAMPS, rate});
+    configs.push_back({"triton", TRITONSERVER_TRACE_LEVEL_TENSORS, rate});
+    // The OpenTelemetry mode doesn't trace tensors.
+    configs.push_back(
+        {"opentelemetry", TRITONSERVER_TRACE_LEVEL_TIMESTAMPS, rate});
+  }
+  return configs;
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  std::string model_repository_path;
+  std::vector<std::string> model_names;
+  int64_t elements = 16;
+  uint32_t concurrency = 4;
+  uint64_t request_count = 10000;
+  uint64_t warmup_count = 1000;
+  std::string rates_arg("1,10,100");
+  std::string trace_dir("/tmp");
+  std::string otel_url("localhost:4318/v1/traces");
+  int verbose_level = 0;
+
+  // Parse commandline...
+  int opt;
+  while ((opt = getopt(argc, argv, "vr:m:e:c:n:w:t:d:u:")) != -1) {
+    switch (opt) {
+      case 'r':
+        model_repository_path = optarg;
+        break;
+      case 'm':
+        model_names.push_back(optarg);
+        break;
+      case 'e':
+        elements = atoll(optarg);
+        break;
+      case 'c':
+        concurrency = atoi(optarg);
+        break;
+      case 'n':
+        request_count = strtoull(optarg, nullptr, 10);
+        break;
+      case 'w':
+        warmup_count = strtoull(optarg, nullptr, 10);
+        break;
+      case 't':
+        rates_arg = optarg;
+        break;
+      case 'd':
+        trace_dir = optarg;
+        break;
+      case 'u':
+        otel_url = optarg;
+        break;
+      case 'v':
+        verbose_level = 1;
+        break;
+      case '?':
+        Usage(argv);
+        break;
+    }
+  }
+
+  if (model_repository_path.empty()) {
+    Usage(argv, "-r must be used to specify model repository path");
+  }
+  if (model_names.empty()) {
+    model_names = {"identity_fp32", "repeat_int32"};
+  }
+  if (elements < 1) {
+    Usage(argv, "-e must be at least 1");
+  }
+  if (concurrency < 1) {
+    Usage(argv, "-c must be at least 1");
+  }
+  if (request_count < 1) {
+    Usage(argv, "-n must be at least 1");
+  }
+  const std::vector<Config> configs = Configs(ParseRates(argv, rates_arg));
+
+  TRITONSERVER_ServerOptions* server_options = nullptr;
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsNew(&server_options),
+      "creating server options");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsSetModelRepositoryPath(
+          server_options, model_repository_path.c_str()),
+      "setting model repository path");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsSetLogVerbose(server_options, verbose_level),
+      "setting verbose logging level");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsSetBackendDirectory(
+          server_options, "/opt/tritonserver/backends"),
+      "setting backend directory");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsSetRepoAgentDirectory(
+          server_options, "/opt/tritonserver/repoagents"),
+      "setting repository agent directory");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsSetStrictModelConfig(server_options, true),
+      "setting strict model configuration");
+
+  TRITONSERVER_Server* server_ptr = nullptr;
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerNew(&server_ptr, server_options),
+      "creating server object");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsDelete(server_options),
+      "deleting server options");
+  std::shared_ptr<TRITONSERVER_Server> server(
+      server_ptr, TRITONSERVER_ServerDelete);
+
+  for (const auto& model_name : model_names) {
+    size_t health_iters = 0;
+    bool is_ready = false;
+    while (!is_ready) {
+      FAIL_IF_ERR(
+          TRITONSERVER_ServerModelIsReady(
+              server.get(), model_name.c_str(), 1 /* model_version */,
+              &is_ready),
+          "unable to get model readiness");
+      if (!is_ready) {
+        if (++health_iters >= 10) {
+          FAIL("model '" + model_name + "' failed to be ready");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+      }
+    }
+  }
+
+  TRITONSERVER_ResponseAllocator* allocator = nullptr;
+  FAIL_IF_ERR(
+      TRITONSERVER_ResponseAllocatorNew(
+          &allocator, ResponseAlloc, ResponseRelease, nullptr /* start_fn */),
+      "creating response allocator");
+
+  for (const auto& model_name : model_names) {
+    Benchmark benchmark(server, allocator, model_name, elements, concurrency);
+    for (const auto& config : configs) {
+      // Every configuration runs with a trace manager of its own so that
+      // the traces of the previous configuration are written out.
+      std::unique_ptr<ts::TraceManager> manager;
+      if (config.mode_ != "off") {
+        const ts::InferenceTraceMode mode =
+            (config.mode_ == "opentelemetry") ? ts::TRACE_MODE_OPENTELEMETRY
+                                              : ts::TRACE_MODE_TRITON;
+        ts::TraceConfigMap config_map;
+        if (config.mode_ == "recorder") {
+          config_map[""] = {{"recorder-size", "256"}};
+        }
+        if (mode == ts::TRACE_MODE_OPENTELEMETRY) {
+          config_map[std::to_string(ts::TRACE_MODE_OPENTELEMETRY)] = {
+              {"url", otel_url}};
+        }
+        const std::string trace_file =
+            trace_dir + "/trace_overhead_" + model_name + "_" + config.mode_ +
+            "_" + TRITONSERVER_InferenceTraceLevelString(config.level_) +
+            "_" + std::to_string(config.rate_) + ".json";
+        ts::TraceManager* manager_ptr = nullptr;
+        FAIL_IF_ERR(
+            ts::TraceManager::Create(
+                &manager_ptr, config.level_, std::max(config.rate_, 1u),
+                -1 /* count */, 0 /* log_frequency */, trace_file, mode,
+                config_map),
+            "creating trace manager");
+        manager.reset(manager_ptr);
+      }
+
+      if (warmup_count != 0) {
+        benchmark.Run(manager.get(), warmup_count);
+      }
+      const Result result = benchmark.Run(manager.get(), request_count);
+
+      std::cout << "{\"model\":\"" << model_name << "\",\"mode\":\""
+                << config.mode_ << "\",\"level\":\""
+                << TRITONSERVER_InferenceTraceLevelString(config.level_)
+                << "\",\"rate\":" << config.rate_
+                << ",\"elements\":" << elements
+                << ",\"concurrency\":" << concurrency
+                << ",\"requests\":" << request_count
+                << ",\"throughput\":" << result.throughput_
+                << ",\"p50_us\":" << result.p50_us_
+                << ",\"p99_us\":" << result.p99_us_
+                << ",\"cpu_us_per_request\":" << result.cpu_us_per_request_
+                << "}" << std::endl;
+    }
+  }
+
+  FAIL_IF_ERR(
+      TRITONSERVER_ResponseAllocatorDelete(allocator),
+      "deleting response allocator");
+
+  return 0;
+}
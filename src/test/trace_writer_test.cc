@@ -0,0 +1,144 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+// Undefine the FAIL() macro inside Triton code to avoid redefine error
+// from gtest.
+#ifdef FAIL
+#undef FAIL
+#endif
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "trace_writer.h"
+
+namespace ts = triton::server;
+
+namespace {
+
+TEST(TraceWriterTest, RecordsInOrder)
+{
+  constexpr size_t kThreads = 4;
+  constexpr uint64_t kRecords = 100000;
+
+  // Only touched by the writer thread until Stop() returns.
+  std::vector<uint64_t> next(kThreads, 0);
+  bool in_order = true;
+  ts::TraceWriter writer(1024, [&](std::vector<ts::TraceRecord>& records) {
+    for (const auto& record : records) {
+      in_order &= (record.value_ == next[record.group_id_]++);
+    }
+  });
+
+  std::vector<std::thread> producers;
+  for (size_t t = 0; t < kThreads; ++t) {
+    producers.emplace_back([&writer, t] {
+      for (uint64_t i = 0; i < kRecords; ++i) {
+        ts::TraceRecord record(ts::TraceRecord::TIMESTAMP, t, t);
+        record.value_ = i;
+        ASSERT_TRUE(writer.PushWait(record));
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  writer.Stop();
+
+  EXPECT_TRUE(in_order);
+  for (size_t t = 0; t < kThreads; ++t) {
+    EXPECT_EQ(next[t], kRecords);
+  }
+  EXPECT_EQ(writer.Dropped(), 0u);
+}
+
+TEST(TraceWriterTest, DropWhenFull)
+{
+  // Block the writer in the handler so that the queue fills up.
+  std::mutex mu;
+  std::condition_variable cv;
+  bool blocked = false;
+  bool unblock = false;
+  size_t written = 0;
+  ts::TraceWriter writer(8, [&](std::vector<ts::TraceRecord>& records) {
+    std::unique_lock<std::mutex> lk(mu);
+    blocked = true;
+    cv.notify_all();
+    cv.wait(lk, [&] { return unblock; });
+    written += records.size();
+  });
+
+  ts::TraceRecord record;
+  ASSERT_TRUE(writer.Push(record));
+  {
+    std::unique_lock<std::mutex> lk(mu);
+    cv.wait(lk, [&] { return blocked; });
+  }
+
+  size_t pushed = 0;
+  while (writer.Push(record)) {
+    ++pushed;
+  }
+  EXPECT_EQ(pushed, 8u);
+  EXPECT_EQ(writer.Dropped(), 1u);
+  EXPECT_FALSE(writer.Push(record));
+  EXPECT_EQ(writer.Dropped(), 2u);
+
+  {
+    std::lock_guard<std::mutex> lk(mu);
+    unblock = true;
+  }
+  cv.notify_all();
+  writer.Stop();
+  EXPECT_EQ(written, 1u + pushed);
+
+  // Nothing is queued once stopped.
+  EXPECT_FALSE(writer.Push(record));
+  EXPECT_FALSE(writer.PushWait(record));
+  EXPECT_EQ(writer.Dropped(), 4u);
+}
+
+TEST(TraceWriterTest, TruncateName)
+{
+  ts::TraceRecord record;
+  const std::string name(100, 'a');
+  record.SetName(name.c_str(), name.size());
+  EXPECT_EQ(
+      std::string(record.name_),
+      std::string(ts::TraceRecord::kMaxNameLength, 'a'));
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,226 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "trace_writer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "triton/common/logging.h"
+
+namespace triton { namespace server {
+
+namespace {
+
+size_t
+QueueCapacity(const size_t queue_size)
+{
+  size_t capacity = 2;
+  while (capacity < queue_size) {
+    capacity <<= 1;
+  }
+  return capacity;
+}
+
+}  // namespace
+
+void
+TraceRecord::SetName(const char* name, const size_t length)
+{
+  const size_t copy_length = std::min(length, kMaxNameLength);
+  std::memcpy(name_, name, copy_length);
+  name_[copy_length] = '\0';
+}
+
+TraceWriter::TraceWriter(const size_t queue_size, Handler handler)
+    : handler_(std::move(handler)), mask_(QueueCapacity(queue_size) - 1),
+      cells_(new Cell[mask_ + 1]), enqueue_pos_(0), dequeue_pos_(0),
+      dropped_(0), reported_dropped_(0),
+      dropped_family_(
+          TRITONSERVER_METRIC_KIND_COUNTER, "nv_trace_dropped_records",
+          "Number of trace records dropped because the trace writer queue "
+          "was full"),
+      stopped_(false)
+{
+  for (size_t i = 0; i <= mask_; ++i) {
+    cells_[i].sequence_.store(i, std::memory_order_relaxed);
+  }
+  batch_.reserve(kBatchSize);
+  dropped_metric_.reset(new FrontendMetric(dropped_family_));
+  thread_ = std::thread(&TraceWriter::Run, this);
+}
+
+TraceWriter::~TraceWriter()
+{
+  Stop();
+  // The metric must be destroyed before its family.
+  dropped_metric_.reset();
+}
+
+bool
+TraceWriter::TryPush(const TraceRecord& record)
+{
+  // Bounded queue of D. Vyukov, every cell has a sequence number telling
+  // whether it is free for the producer of position 'pos' or holds the
+  // record for the consumer.
+  uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+  Cell* cell;
+  while (true) {
+    cell = &cells_[pos & mask_];
+    const uint64_t sequence = cell->sequence_.load(std::memory_order_acquire);
+    const int64_t diff =
+        static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+    if (diff == 0) {
+      if (enqueue_pos_.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+  cell->record_ = record;
+  cell->sequence_.store(pos + 1, std::memory_order_release);
+
+  // Wake up the writer every batch instead of waiting for the flush
+  // interval so that the queue doesn't fill up under load.
+  if (((pos + 1) % kBatchSize) == 0) {
+    cv_.notify_one();
+  }
+  return true;
+}
+
+bool
+TraceWriter::HasRecord() const
+{
+  return cells_[dequeue_pos_ & mask_].sequence_.load(
+             std::memory_order_acquire) == (dequeue_pos_ + 1);
+}
+
+bool
+TraceWriter::TryPop(TraceRecord* record)
+{
+  if (!HasRecord()) {
+    return false;
+  }
+  Cell* cell = &cells_[dequeue_pos_ & mask_];
+  *record = cell->record_;
+  cell->sequence_.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+  ++dequeue_pos_;
+  return true;
+}
+
+bool
+TraceWriter::Push(const TraceRecord& record)
+{
+  if (stopped_.load(std::memory_order_relaxed) || !TryPush(record)) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+bool
+TraceWriter::PushWait(const TraceRecord& record)
+{
+  while (!stopped_.load(std::memory_order_relaxed)) {
+    if (TryPush(record)) {
+      return true;
+    }
+    cv_.notify_one();
+    std::this_thread::yield();
+  }
+  dropped_.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+bool
+TraceWriter::Drain()
+{
+  bool drained = false;
+  TraceRecord record;
+  while (TryPop(&record)) {
+    drained = true;
+    batch_.push_back(record);
+    if (batch_.size() == kBatchSize) {
+      handler_(batch_);
+      batch_.clear();
+    }
+  }
+  if (!batch_.empty()) {
+    handler_(batch_);
+    batch_.clear();
+  }
+
+  const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+  if (dropped != reported_dropped_) {
+    if (reported_dropped_ == 0) {
+      LOG_WARNING << "trace writer queue is full, dropping trace records. "
+                     "Consider increasing the queue-size trace setting";
+    }
+    dropped_metric_->Increment(dropped - reported_dropped_);
+    reported_dropped_ = dropped;
+  }
+  return drained;
+}
+
+void
+TraceWriter::Run()
+{
+  while (!stopped_.load()) {
+    if (Drain()) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lk(mu_);
+    cv_.wait_for(
+        lk, kFlushInterval, [this] { return stopped_.load() || HasRecord(); });
+  }
+}
+
+void
+TraceWriter::Stop()
+{
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (stopped_) {
+      return;
+    }
+    stopped_ = true;
+  }
+  cv_.notify_one();
+  thread_.join();
+
+  // The thread is done, pick up the records queued before it stopped.
+  Drain();
+  if (reported_dropped_ != 0) {
+    LOG_WARNING << "trace writer dropped " << reported_dropped_
+                << " trace records";
+  }
+}
+
+}}  // namespace triton::server
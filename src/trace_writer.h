@@ -0,0 +1,174 @@
+// Copyright 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "frontend_metrics.h"
+
+namespace triton { namespace server {
+
+//
+// A fixed size record of a trace activity. The records are copied into
+// the queue of a TraceWriter as is, anything that doesn't fit in a
+// record is kept in heap allocated 'payload_' owned by the record.
+//
+struct TraceRecord {
+  enum Kind : uint8_t {
+    // A timestamp, 'value_' is the timestamp in nanoseconds, 'name_' the
+    // name of the activity and 'activity_' the activity if reported by
+    // Triton core.
+    TIMESTAMP,
+    // The details of a request, 'value_' is the parent trace id,
+    // 'model_version_' the model version and 'payload_' a std::string
+    // holding the model name and the request id separated by '\0'.
+    REQUEST,
+    // A tensor, 'payload_' is a std::string holding the serialized
+    // tensor.
+    TENSOR,
+    // The end of the trace group, no more records of the group follow.
+    // 'payload_' is owned by the consumer of the records.
+    END
+  };
+
+  static constexpr size_t kMaxNameLength = 39;
+
+  TraceRecord()
+      : kind_(TIMESTAMP), activity_(-1), group_id_(0), trace_id_(0), value_(0),
+        model_version_(0), payload_(nullptr)
+  {
+    name_[0] = '\0';
+  }
+  TraceRecord(const Kind kind, const uint64_t group_id, const uint64_t trace_id)
+      : kind_(kind), activity_(-1), group_id_(group_id), trace_id_(trace_id),
+        value_(0), model_version_(0), payload_(nullptr)
+  {
+    name_[0] = '\0';
+  }
+
+  // Copy 'name' into the record, truncated to 'kMaxNameLength'.
+  void SetName(const char* name, const size_t length);
+
+  Kind kind_;
+  // The TRITONSERVER_InferenceTraceActivity of a timestamp, -1 for the
+  // timestamps captured by the frontends.
+  int32_t activity_;
+  // The id of the group of traces the record belongs to, which is the
+  // id of the trace sampled by the frontend. The records of the traces
+  // spawned from it have the same group id.
+  uint64_t group_id_;
+  uint64_t trace_id_;
+  uint64_t value_;
+  int64_t model_version_;
+  void* payload_;
+  char name_[kMaxNameLength + 1];
+};
+
+//
+// TraceWriter
+//
+// Moves trace records off the threads that produce them. Producers copy
+// a record into a bounded lock-free queue and a dedicated thread hands
+// the queued records to 'handler' in batches, so producing a record
+// never waits on formatting or file I/O. When the queue is full the
+// record is dropped and counted instead of blocking the producer.
+//
+class TraceWriter {
+ public:
+  using Handler = std::function<void(std::vector<TraceRecord>& records)>;
+
+  /// Create a writer and start its thread.
+  /// \param queue_size The number of records that can be queued, rounded
+  /// up to a power of 2.
+  /// \param handler Called on the thread of the writer with the records
+  /// in the order they were queued.
+  TraceWriter(const size_t queue_size, Handler handler);
+  ~TraceWriter();
+
+  /// Queue 'record'. Return false and count the record as dropped if the
+  /// queue is full or the writer is stopped, in which case the caller
+  /// keeps the ownership of the payload of the record.
+  bool Push(const TraceRecord& record);
+
+  /// Queue 'record', waiting for space if the queue is full. Used for
+  /// the records that must not be dropped. Return false if the writer is
+  /// stopped.
+  bool PushWait(const TraceRecord& record);
+
+  /// Hand all the queued records to the handler and stop the thread.
+  /// Records pushed after return are dropped.
+  void Stop();
+
+  /// The number of records dropped so far.
+  uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  struct Cell {
+    std::atomic<uint64_t> sequence_;
+    TraceRecord record_;
+  };
+
+  bool TryPush(const TraceRecord& record);
+  // Whether the record at the head of the queue is ready to be popped.
+  bool HasRecord() const;
+  bool TryPop(TraceRecord* record);
+  // Hand the queued records to the handler in batches, return whether
+  // there was any record.
+  bool Drain();
+  void Run();
+
+  static constexpr size_t kBatchSize = 1024;
+  static constexpr std::chrono::milliseconds kFlushInterval{100};
+
+  const Handler handler_;
+  const size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  alignas(64) std::atomic<uint64_t> enqueue_pos_;
+  // Only accessed by the thread draining the queue.
+  alignas(64) uint64_t dequeue_pos_;
+  std::vector<TraceRecord> batch_;
+
+  std::atomic<uint64_t> dropped_;
+  uint64_t reported_dropped_;
+  FrontendMetricFamily dropped_family_;
+  std::unique_ptr<FrontendMetric> dropped_metric_;
+
+  std::atomic<bool> stopped_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::thread thread_;
+};
+
+}}  // namespace triton::server
@@ -28,9 +28,13 @@
 
 #include <stdlib.h>
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include <unordered_map>
 
 #include "common.h"
+#include "otel_span_processor.h"
 #include "triton/common/logging.h"
 #ifdef TRITON_ENABLE_GPU
 #include <cuda_runtime_api.h>
@@ -39,6 +43,8 @@
 #include "opentelemetry/exporters/ostream/span_exporter_factory.h"
 #include "opentelemetry/exporters/otlp/otlp_http_exporter_factory.h"
 #include "opentelemetry/sdk/resource/semantic_conventions.h"
+#include "opentelemetry/sdk/trace/batch_span_processor_options.h"
+#include "opentelemetry/sdk/trace/tracer_provider.h"
 namespace otlp = opentelemetry::exporter::otlp;
 namespace otel_trace_sdk = opentelemetry::sdk::trace;
 namespace otel_trace_api = opentelemetry::trace;
@@ -48,6 +54,241 @@ namespace otel_resource = opentelemetry::sdk::resource;
 
 namespace triton { namespace server {
 
+namespace {
+
+// Release the payload of 'record'.
+void
+ReleaseRecord(const TraceRecord& record)
+{
+  if ((record.kind_ == TraceRecord::REQUEST) ||
+      (record.kind_ == TraceRecord::TENSOR)) {
+    delete reinterpret_cast<std::string*>(record.payload_);
+  }
+}
+
+// Release the payloads of 'records'.
+void
+ReleaseRecords(const std::vector<TraceRecord>& records)
+{
+  for (const auto& record : records) {
+    ReleaseRecord(record);
+  }
+}
+
+// Parse a tail sampling latency threshold given in microseconds.
+uint64_t
+ParseLatencyUs(const std::string& value)
+{
+  return std::stoull(value) * 1000;
+}
+
+// Write the records of a trace group as JSON trace objects, the
+// activity of the same trace is grouped together for more readable
+// output.
+void
+WriteJsonTrace(const std::vector<TraceRecord>& records, std::ostream& out)
+{
+  std::vector<uint64_t> trace_ids;
+  std::unordered_map<uint64_t, std::vector<const TraceRecord*>> traces;
+  for (const auto& record : records) {
+    auto& trace = traces[record.trace_id_];
+    if (trace.empty()) {
+      trace_ids.push_back(record.trace_id_);
+    }
+    trace.push_back(&record);
+  }
+
+  bool first = true;
+  for (const auto trace_id : trace_ids) {
+    for (const auto record : traces[trace_id]) {
+      if (!first) {
+        out << ",";
+      }
+      first = false;
+      switch (record->kind_) {
+        case TraceRecord::TIMESTAMP: {
+          out << "{\"id\":" << record->trace_id_ << ",\"timestamps\":["
+              << "{\"name\":\"" << record->name_
+              << "\",\"ns\":" << record->value_ << "}]}";
+          break;
+        }
+        case TraceRecord::REQUEST: {
+          const auto details =
+              reinterpret_cast<const std::string*>(record->payload_);
+          const char* model_name = details->c_str();
+          const char* request_id = model_name + strlen(model_name) + 1;
+          out << "{\"id\":" << record->trace_id_ << ",\"model_name\":\""
+              << model_name << "\",\"model_version\":"
+              << record->model_version_;
+          if (request_id[0] != '\0') {
+            out << ",\"request_id\":\"" << request_id << "\"";
+          }
+          if (record->value_ != 0) {
+            out << ",\"parent_id\":" << record->value_;
+          }
+          out << "}";
+          break;
+        }
+        case TraceRecord::TENSOR: {
+          out << *reinterpret_cast<const std::string*>(record->payload_);
+          break;
+        }
+        default:
+          break;
+      }
+    }
+  }
+}
+
+// Write the elements of a tensor as the comma separated values of the
+// JSON trace. Return false if the tensor can't be serialized.
+bool
+WriteTensorData(
+    const TRITONSERVER_DataType datatype, const void* buffer_base,
+    const size_t byte_size, const size_t element_count, std::ostream& out)
+{
+  switch (datatype) {
+    case TRITONSERVER_TYPE_BOOL: {
+      const uint8_t* bool_base =
+          reinterpret_cast<const uint8_t*>(buffer_base);
+      for (size_t e = 0; e < element_count; ++e) {
+        out << ((bool_base[e] == 0) ? false : true);
+        if (e < (element_count - 1))
+          out << ",";
+      }
+      break;
+    }
+    case TRITONSERVER_TYPE_UINT8: {
+      const uint8_t* cbase = reinterpret_cast<const uint8_t*>(buffer_base);
+      for (size_t e = 0; e < element_count; ++e) {
+        out << cbase[e];
+        if (e < (element_count - 1))
+          out << ",";
+      }
+      break;
+    }
+    case TRITONSERVER_TYPE_UINT16: {
+      const uint16_t* cbase = reinterpret_cast<const uint16_t*>(buffer_base);
+      for (size_t e = 0; e < element_count; ++e) {
+        out << cbase[e];
+        if (e < (element_count - 1))
+          out << ",";
+      }
+      break;
+    }
+    case TRITONSERVER_TYPE_UINT32: {
+      const uint32_t* cbase = reinterpret_cast<const uint32_t*>(buffer_base);
+      for (size_t e = 0; e < element_count; ++e) {
+        out << cbase[e];
+        if (e < (element_count - 1))
+          out << ",";
+      }
+      break;
+    }
+    case TRITONSERVER_TYPE_UINT64: {
+      const uint64_t* cbase = reinterpret_cast<const uint64_t*>(buffer_base);
+      for (size_t e = 0; e < element_count; ++e) {
+        out << cbase[e];
+        if (e < (element_count - 1))
+          out << ",";
+      }
+      break;
+    }
+    case TRITONSERVER_TYPE_INT8: {
+      const int8_t* cbase = reinterpret_cast<const int8_t*>(buffer_base);
+      for (size_t e = 0; e < element_count; ++e) {
+        out << cbase[e];
+        if (e < (element_count - 1))
+          out << ",";
+      }
+      break;
+    }
+    case TRITONSERVER_TYPE_INT16: {
+      const int16_t* cbase = reinterpret_cast<const int16_t*>(buffer_base);
+      for (size_t e = 0; e < element_count; ++e) {
+        out << cbase[e];
+        if (e < (element_count - 1))
+          out << ",";
+      }
+      break;
+    }
+    case TRITONSERVER_TYPE_INT32: {
+      const int32_t* cbase = reinterpret_cast<const int32_t*>(buffer_base);
+      for (size_t e = 0; e < element_count; ++e) {
+        out << cbase[e];
+        if (e < (element_count - 1))
+          out << ",";
+      }
+      break;
+    }
+    case TRITONSERVER_TYPE_INT64: {
+      const int64_t* cbase = reinterpret_cast<const int64_t*>(buffer_base);
+      for (size_t e = 0; e < element_count; ++e) {
+        out << cbase[e];
+        if (e < (element_count - 1))
+          out << ",";
+      }
+      break;
+    }
+
+    // FP16 / BF16 already handled as binary blobs, no need to manipulate
+    // here
+    case TRITONSERVER_TYPE_FP16: {
+      break;
+    }
+    case TRITONSERVER_TYPE_BF16: {
+      break;
+    }
+
+    case TRITONSERVER_TYPE_FP32: {
+      const float* cbase = reinterpret_cast<const float*>(buffer_base);
+      for (size_t e = 0; e < element_count; ++e) {
+        out << cbase[e];
+        if (e < (element_count - 1))
+          out << ",";
+      }
+      break;
+    }
+    case TRITONSERVER_TYPE_FP64: {
+      const double* cbase = reinterpret_cast<const double*>(buffer_base);
+      for (size_t e = 0; e < element_count; ++e) {
+        out << cbase[e];
+        if (e < (element_count - 1))
+          out << ",";
+      }
+      break;
+    }
+    case TRITONSERVER_TYPE_BYTES: {
+      const char* cbase = reinterpret_cast<const char*>(buffer_base);
+      size_t offset = 0;
+      for (size_t e = 0; e < element_count; ++e) {
+        if ((offset + sizeof(uint32_t)) > byte_size) {
+          return false;
+        }
+        const size_t len =
+            *(reinterpret_cast<const uint32_t*>(cbase + offset));
+        offset += sizeof(uint32_t);
+        if ((offset + len) > byte_size) {
+          return false;
+        }
+        std::string str(cbase + offset, len);
+        out << "\\\"" << str << "\\\"";
+        offset += len;
+
+        if (e < (element_count - 1))
+          out << ",";
+      }
+      break;
+    }
+    case TRITONSERVER_TYPE_INVALID: {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
 TRITONSERVER_Error*
 TraceManager::Create(
     TraceManager** manager, const TRITONSERVER_InferenceTraceLevel level,
@@ -69,25 +310,104 @@ TraceManager::TraceManager(
     const int32_t count, const uint32_t log_frequency,
     const std::string& filepath, const InferenceTraceMode mode,
     const TraceConfigMap& config_map)
+    : settings_(std::unique_ptr<TraceSettings>(new TraceSettings())),
+      format_(TRACE_FORMAT_JSON), compress_(false),
+      tensor_format_(TRACE_FORMAT_JSON), server_timing_(false)
 {
-  std::shared_ptr<TraceFile> file(new TraceFile(filepath));
+  // The global trace config holds the tail sampling, the flight
+  // recorder and the server timing options, the values are validated
+  // when the config is parsed.
+  TailSampler::Options tail_options;
+  size_t recorder_size = kDefaultRecorderSize;
+  auto global_options_it = config_map.find("");
+  if (global_options_it != config_map.end()) {
+    for (const auto& setting : global_options_it->second) {
+      if (setting.first == "tail-latency-us") {
+        tail_options.latency_ns_ = ParseLatencyUs(setting.second);
+      } else if (setting.first == "tail-queue-latency-us") {
+        tail_options.queue_latency_ns_ = ParseLatencyUs(setting.second);
+      } else if (setting.first == "tail-compute-latency-us") {
+        tail_options.compute_latency_ns_ = ParseLatencyUs(setting.second);
+      } else if (setting.first == "tail-percentile") {
+        tail_options.percentile_ = std::stod(setting.second);
+      } else if (setting.first == "tail-max-per-second") {
+        tail_options.max_per_second_ = std::stoul(setting.second);
+      } else if (setting.first == "recorder-size") {
+        recorder_size = std::stoul(setting.second);
+      } else if (setting.first == "server-timing") {
+        server_timing_ = (setting.second == "true");
+      }
+    }
+  }
+  if (tail_options.Enabled()) {
+    tail_sampler_.reset(new TailSampler(tail_options));
+  }
+  if (recorder_size != 0) {
+    recorder_.reset(new FlightRecorder(recorder_size));
+  }
+
+  if (mode == TRACE_MODE_TRITON) {
+    size_t queue_size = kDefaultTraceQueueSize;
+    auto triton_options_it =
+        config_map.find(std::to_string(TRACE_MODE_TRITON));
+    if (triton_options_it != config_map.end()) {
+      for (const auto& setting : triton_options_it->second) {
+        if (setting.first == "queue-size") {
+          queue_size = std::stoul(setting.second);
+        } else if (setting.first == "format") {
+          format_ = (setting.second == "binary") ? TRACE_FORMAT_BINARY
+                                                 : TRACE_FORMAT_JSON;
+        } else if (setting.first == "compression") {
+          compress_ = (setting.second == "zlib");
+        } else if (setting.first == "tensor-format") {
+          tensor_format_ = (setting.second == "binary") ? TRACE_FORMAT_BINARY
+                                                        : TRACE_FORMAT_JSON;
+        } else if (setting.first == "tensor-max-pending-bytes") {
+          tensor_options_.max_pending_bytes_ = std::stoull(setting.second);
+        } else if (setting.first == "tensor-segment-size") {
+          tensor_options_.segment_size_ = std::stoull(setting.second);
+        }
+      }
+    }
+    writer_.reset(new TraceWriter(
+        queue_size,
+        [this](std::vector<TraceRecord>& records) { WriteRecords(records); }));
+  }
+
+  std::shared_ptr<TraceFile> file(new TraceFile(
+      filepath, format_, compress_, tensor_format_, tensor_options_));
   global_default_.reset(new TraceSetting(
       level, rate, count, log_frequency, file, mode, config_map,
       false /*level_specified*/, false /*rate_specified*/,
       false /*count_specified*/, false /*log_frequency_specified*/,
       false /*filepath_specified*/, false /*mode_specified*/,
-      false /*config_map_specified*/));
+      false /*config_map_specified*/, writer_));
   global_setting_.reset(new TraceSetting(
       level, rate, count, log_frequency, file, mode, config_map,
       false /*level_specified*/, false /*rate_specified*/,
       false /*count_specified*/, false /*log_frequency_specified*/,
       false /*filepath_specified*/, false /*mode_specified*/,
-      false /*config_map_specified*/));
+      false /*config_map_specified*/, writer_));
   trace_files_.emplace(filepath, file);
+  PublishSettings();
 
   InitTracer(config_map);
 }
 
+TraceManager::~TraceManager()
+{
+  // Write out the traces that are queued before the settings are
+  // released.
+  if (writer_ != nullptr) {
+    writer_->Stop();
+  }
+  // The traces that are still alive won't be written.
+  for (const auto& trace : pending_traces_) {
+    ReleaseRecords(trace.second);
+  }
+  CleanupTracer();
+}
+
 TRITONSERVER_Error*
 TraceManager::UpdateTraceSetting(
     const std::string& model_name, const NewSetting& new_setting)
@@ -136,7 +456,7 @@ TraceManager::UpdateTraceSettingInternal(
   //    use the specified value
   TRITONSERVER_InferenceTraceLevel level = fallback_setting->level_;
   uint32_t rate = fallback_setting->rate_;
-  int32_t count = fallback_setting->count_;
+  int32_t count = fallback_setting->count_.load();
   uint32_t log_frequency = fallback_setting->log_frequency_;
   std::string filepath = fallback_setting->file_->FileName();
   InferenceTraceMode mode = fallback_setting->mode_;
@@ -182,7 +502,7 @@ TraceManager::UpdateTraceSettingInternal(
   }
   if (count_specified) {
     count = (new_setting.count_ != nullptr) ? *new_setting.count_
-                                            : current_setting->count_;
+                                            : current_setting->count_.load();
   }
   if (log_frequency_specified) {
     log_frequency = (new_setting.log_frequency_ != nullptr)
@@ -207,8 +527,8 @@ TraceManager::UpdateTraceSettingInternal(
       fallback_used_models_.erase(model_name);
     } else if (none_specified) {
       // Simply let the model uses global setting
-      std::lock_guard<std::mutex> r_lk(r_mu_);
       model_settings_.erase(model_name);
+      PublishSettings();
       return nullptr;
     } else {
       fallback_used_models_.emplace(model_name);
@@ -226,7 +546,8 @@ TraceManager::UpdateTraceSettingInternal(
     }
   }
   if (file == nullptr) {
-    file.reset(new TraceFile(filepath));
+    file.reset(new TraceFile(
+        filepath, format_, compress_, tensor_format_, tensor_options_));
     trace_files_.emplace(filepath, file);
   }
 
@@ -234,7 +555,7 @@ TraceManager::UpdateTraceSettingInternal(
       level, rate, count, log_frequency, file, mode, config_map,
       level_specified, rate_specified, count_specified, log_frequency_specified,
       filepath_specified, false /*mode_specified*/,
-      false /*config_map_specified*/));
+      false /*config_map_specified*/, writer_));
   // The only invalid setting allowed is if it disables tracing
   if ((!lts->Valid()) && (level != TRITONSERVER_TRACE_LEVEL_DISABLED)) {
     return TRITONSERVER_ErrorNew(
@@ -244,75 +565,152 @@ TraceManager::UpdateTraceSettingInternal(
             .c_str());
   }
 
-  // Update / Init the setting in read lock to exclude reader access,
-  // we replace the object instead of modifying the existing object in case
-  // of there are ongoing traces. This makes sure those traces are referring
-  // to the setting when the traces are sampled.
-  {
-    std::lock_guard<std::mutex> r_lk(r_mu_);
-    if (model_name.empty()) {
-      // global update
-      global_setting_ = std::move(lts);
+  // Update / Init the setting and publish it to the readers, we replace
+  // the object instead of modifying the existing object in case of there
+  // are ongoing traces. This makes sure those traces are referring to the
+  // setting when the traces are sampled.
+  if (model_name.empty()) {
+    // global update
+    global_setting_ = std::move(lts);
+  } else {
+    auto it = model_settings_.find(model_name);
+    if (it != model_settings_.end()) {
+      // Model update
+      it->second = std::move(lts);
     } else {
-      auto it = model_settings_.find(model_name);
-      if (it != model_settings_.end()) {
-        // Model update
-        it->second = std::move(lts);
-      } else {
-        // Model init
-        model_settings_.emplace(model_name, lts);
-      }
+      // Model init
+      model_settings_.emplace(model_name, lts);
     }
   }
+  PublishSettings();
 
   return nullptr;
 }
 
+void
+TraceManager::PublishSettings()
+{
+  std::unique_ptr<TraceSettings> settings(new TraceSettings());
+  settings->global_ = global_setting_;
+  settings->models_ = model_settings_;
+  settings_.Publish(std::move(settings));
+}
+
 void
 TraceManager::GetTraceSetting(
     const std::string& model_name, TRITONSERVER_InferenceTraceLevel* level,
     uint32_t* rate, int32_t* count, uint32_t* log_frequency,
     std::string* filepath)
 {
-  std::shared_ptr<TraceSetting> trace_setting;
-  {
-    std::lock_guard<std::mutex> r_lk(r_mu_);
-    auto m_it = model_settings_.find(model_name);
-    trace_setting =
-        (m_it == model_settings_.end()) ? global_setting_ : m_it->second;
-  }
-
-  *level = trace_setting->level_;
-  *rate = trace_setting->rate_;
-  *count = trace_setting->count_;
-  *log_frequency = trace_setting->log_frequency_;
-  *filepath = trace_setting->file_->FileName();
+  settings_.Read([&](const TraceSettings& settings) {
+    const TraceSetting* trace_setting = settings.Find(model_name).get();
+    *level = trace_setting->level_;
+    *rate = trace_setting->rate_;
+    *count = trace_setting->count_.load();
+    *log_frequency = trace_setting->log_frequency_;
+    *filepath = trace_setting->file_->FileName();
+  });
 }
 
 std::shared_ptr<TraceManager::Trace>
 TraceManager::SampleTrace(const std::string& model_name)
 {
-  std::shared_ptr<TraceSetting> trace_setting;
-  {
-    std::lock_guard<std::mutex> r_lk(r_mu_);
-    auto m_it = model_settings_.find(model_name);
-    trace_setting =
-        (m_it == model_settings_.end()) ? global_setting_ : m_it->second;
-  }
-  std::shared_ptr<Trace> ts = trace_setting->SampleTrace();
+  // The setting is only referenced by the trace if the request is
+  // sampled, otherwise the snapshot is read without copying the setting.
+  std::shared_ptr<Trace> ts =
+      settings_.Read([&](const TraceSettings& settings) {
+        const std::shared_ptr<TraceSetting>& trace_setting =
+            settings.Find(model_name);
+        std::shared_ptr<Trace> sampled =
+            trace_setting->SampleTrace(tail_sampler_);
+        if (sampled != nullptr) {
+          sampled->setting_ = trace_setting;
+        }
+        return sampled;
+      });
+  if ((ts == nullptr) && (recorder_ != nullptr)) {
+    // Only the timestamps are needed for the timeline of the request.
+    ts = NewTrace(TRITONSERVER_TRACE_LEVEL_TIMESTAMPS);
+  }
   if (ts != nullptr) {
-    ts->setting_ = trace_setting;
+    ts->recorder_ = recorder_;
   }
   return ts;
 }
 
+TRITONSERVER_Error*
+TraceManager::DumpRecorder(std::ostream& out)
+{
+  if (recorder_ == nullptr) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_UNAVAILABLE, "flight recorder is disabled");
+  }
+  recorder_->Dump(out);
+  return nullptr;  // success
+}
+
+std::shared_ptr<TraceManager::Trace>
+TraceManager::NewTrace(const TRITONSERVER_InferenceTraceLevel level)
+{
+  std::shared_ptr<TraceManager::Trace> lts(new Trace());
+  // Split 'Trace' management to frontend and Triton trace separately
+  // to avoid dependency between frontend request and Triton trace's
+  // liveness
+  auto trace_userp = new std::shared_ptr<TraceManager::Trace>(lts);
+  TRITONSERVER_InferenceTrace* trace;
+  TRITONSERVER_Error* err = TRITONSERVER_InferenceTraceTensorNew(
+      &trace, level, 0 /* parent_id */, TraceActivity, TraceTensorActivity,
+      TraceRelease, trace_userp);
+  if (err != nullptr) {
+    LOG_TRITONSERVER_ERROR(err, "creating inference trace object");
+    delete trace_userp;
+    return nullptr;
+  }
+  lts->trace_ = trace;
+  lts->trace_userp_ = trace_userp;
+  LOG_TRITONSERVER_ERROR(
+      TRITONSERVER_InferenceTraceId(trace, &lts->trace_id_),
+      "getting trace id");
+  return lts;
+}
+
 TraceManager::Trace::~Trace()
 {
+  if (recorder_ != nullptr) {
+    recorder_->Record(timeline_);
+  }
+  if (setting_ == nullptr) {
+    return;
+  }
+
+  // No other reference to the trace is left, the held records can be
+  // accessed without the lock.
+  if ((tail_sampler_ != nullptr) && !SampleTail()) {
+    ReleaseRecords(tail_records_);
+    return;
+  }
+
   if (setting_->mode_ == TRACE_MODE_TRITON) {
-    // Write trace now
-    setting_->WriteTrace(streams_);
+    for (const auto& record : tail_records_) {
+      if (!setting_->writer_->Push(record)) {
+        ReleaseRecord(record);
+      }
+    }
+    // No more activity of the trace, let the writer write out the trace
+    // group. The END record carries a reference to the setting as the
+    // trace is written according to it.
+    TraceRecord record(TraceRecord::END, trace_id_, trace_id_);
+    auto setting = new std::shared_ptr<TraceSetting>(setting_);
+    record.payload_ = setting;
+    if (!setting_->writer_->PushWait(record)) {
+      delete setting;
+    }
   } else if (setting_->mode_ == TRACE_MODE_OPENTELEMETRY) {
 #ifndef _WIN32
+    if (tail_sampler_ != nullptr) {
+      ReplayToOpenTelemetry();
+      ReleaseRecords(tail_records_);
+    }
     EndSpan(kRootSpan);
 #else
     LOG_ERROR << "Unsupported trace mode: "
@@ -325,27 +723,36 @@ void
 TraceManager::Trace::CaptureTimestamp(
     const std::string& name, uint64_t timestamp_ns)
 {
+  CaptureTimestamp(name.c_str(), name.size(), timestamp_ns);
+}
+
+void
+TraceManager::Trace::CaptureTimestamp(
+    const FrontendStage stage, uint64_t timestamp_ns)
+{
+  const char* name = FrontendStageName(stage);
+  CaptureTimestamp(name, strlen(name), timestamp_ns);
+}
+
+void
+TraceManager::Trace::CaptureTimestamp(
+    const char* name, const size_t name_len, uint64_t timestamp_ns)
+{
+  if (recorder_ != nullptr) {
+    timeline_.Add(recorder_->NameId(name), timestamp_ns);
+  }
+  if (setting_ == nullptr) {
+    return;
+  }
   if (setting_->level_ & TRITONSERVER_TRACE_LEVEL_TIMESTAMPS) {
-    if (setting_->mode_ == TRACE_MODE_TRITON) {
-      std::lock_guard<std::mutex> lk(mtx_);
-      std::stringstream* ss = nullptr;
-      {
-        if (streams_.find(trace_id_) == streams_.end()) {
-          std::unique_ptr<std::stringstream> stream(new std::stringstream());
-          ss = stream.get();
-          streams_.emplace(trace_id_, std::move(stream));
-        } else {
-          ss = streams_[trace_id_].get();
-          // If the string stream is not newly created, add "," as there is
-          // already content in the string stream
-          *ss << ",";
-        }
-      }
-      *ss << "{\"id\":" << trace_id_ << ",\"timestamps\":["
-          << "{\"name\":\"" << name << "\",\"ns\":" << timestamp_ns << "}]}";
+    if ((setting_->mode_ == TRACE_MODE_TRITON) || (tail_sampler_ != nullptr)) {
+      TraceRecord record(TraceRecord::TIMESTAMP, trace_id_, trace_id_);
+      record.value_ = timestamp_ns;
+      record.SetName(name, name_len);
+      QueueRecord(record);
     } else if (setting_->mode_ == TRACE_MODE_OPENTELEMETRY) {
 #ifndef _WIN32
-      AddEvent(kRootSpan, name, timestamp_ns);
+      AddEvent(kRootSpan, std::string(name, name_len), timestamp_ns);
 #else
       LOG_ERROR << "Unsupported trace mode: "
                 << TraceManager::InferenceTraceModeString(setting_->mode_);
@@ -354,6 +761,73 @@ TraceManager::Trace::CaptureTimestamp(
   }
 }
 
+bool
+TraceManager::Trace::QueueRecord(const TraceRecord& record)
+{
+  if (tail_sampler_ != nullptr) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    tail_records_.push_back(record);
+    return true;
+  }
+  return setting_->writer_->Push(record);
+}
+
+bool
+TraceManager::Trace::SampleTail()
+{
+  // The end-to-end latency spans all the timestamps of the trace, the
+  // stage latencies are the largest among the traces in the group so
+  // that a slow composing model of an ensemble selects the trace.
+  struct Stages {
+    uint64_t queue_start_ = 0;
+    uint64_t compute_start_ = 0;
+    uint64_t compute_end_ = 0;
+  };
+  std::unordered_map<uint64_t, Stages> stages;
+  uint64_t first_ns = std::numeric_limits<uint64_t>::max();
+  uint64_t last_ns = 0;
+  for (const auto& record : tail_records_) {
+    if (record.kind_ != TraceRecord::TIMESTAMP) {
+      continue;
+    }
+    first_ns = std::min(first_ns, record.value_);
+    last_ns = std::max(last_ns, record.value_);
+    switch (record.activity_) {
+      case TRITONSERVER_TRACE_QUEUE_START:
+        stages[record.trace_id_].queue_start_ = record.value_;
+        break;
+      case TRITONSERVER_TRACE_COMPUTE_START:
+        stages[record.trace_id_].compute_start_ = record.value_;
+        break;
+      case TRITONSERVER_TRACE_COMPUTE_END:
+        stages[record.trace_id_].compute_end_ = record.value_;
+        break;
+      default:
+        break;
+    }
+  }
+
+  TailSampler::Latency latency;
+  if (last_ns > first_ns) {
+    latency.total_ns_ = last_ns - first_ns;
+  }
+  for (const auto& stage : stages) {
+    const auto& s = stage.second;
+    if ((s.queue_start_ != 0) && (s.compute_start_ > s.queue_start_)) {
+      latency.queue_ns_ =
+          std::max(latency.queue_ns_, s.compute_start_ - s.queue_start_);
+    }
+    if ((s.compute_start_ != 0) && (s.compute_end_ > s.compute_start_)) {
+      latency.compute_ns_ =
+          std::max(latency.compute_ns_, s.compute_end_ - s.compute_start_);
+    }
+  }
+
+  return tail_sampler_->Sample(
+             latency, failed_, TraceManager::CaptureTimestamp()) &&
+         setting_->ClaimTrace();
+}
+
 void
 TraceManager::InitTracer(const triton::server::TraceConfigMap& config_map)
 {
@@ -361,6 +835,7 @@ TraceManager::InitTracer(const triton::server::TraceConfigMap& config_map)
     case TRACE_MODE_OPENTELEMETRY: {
 #if !defined(_WIN32) && defined(TRITON_ENABLE_TRACING)
       otlp::OtlpHttpExporterOptions opts;
+      otel_trace_sdk::BatchSpanProcessorOptions processor_options;
       otel_resource::ResourceAttributes attributes = {};
       attributes[otel_resource::SemanticConventions::kServiceName] =
           "triton-inference-server";
@@ -378,8 +853,28 @@ TraceManager::InitTracer(const triton::server::TraceConfigMap& config_map)
             auto value = setting.second.substr(pos + 1);
             attributes[key] = value;
           }
+          // The values of the span processor settings are validated
+          // when the config is parsed.
+          if (setting.first == "bsp-max-queue-size") {
+            processor_options.max_queue_size = std::stoul(setting.second);
+          }
+          if (setting.first == "bsp-max-export-batch-size") {
+            processor_options.max_export_batch_size =
+                std::stoul(setting.second);
+          }
+          if (setting.first == "bsp-schedule-delay") {
+            processor_options.schedule_delay_millis =
+                std::chrono::milliseconds(std::stoul(setting.second));
+          }
+          if (setting.first == "export-timeout") {
+            opts.timeout =
+                std::chrono::milliseconds(std::stoul(setting.second));
+          }
         }
       }
+      processor_options.max_export_batch_size = std::min(
+          processor_options.max_export_batch_size,
+          processor_options.max_queue_size);
       auto exporter = otlp::OtlpHttpExporterFactory::Create(opts);
       auto test_exporter = triton::server::GetEnvironmentVariableOrDefault(
           "TRITON_OPENTELEMETRY_TEST", "false");
@@ -387,8 +882,10 @@ TraceManager::InitTracer(const triton::server::TraceConfigMap& config_map)
         exporter = opentelemetry::exporter::trace::OStreamSpanExporterFactory::
             Create();
       }
-      auto processor = otel_trace_sdk::SimpleSpanProcessorFactory::Create(
-          std::move(exporter));
+      // Spans are exported in batches from the thread of the processor,
+      // ending a span never waits on the collector.
+      std::unique_ptr<otel_trace_sdk::SpanProcessor> processor(
+          new BoundedSpanProcessor(std::move(exporter), processor_options));
       auto resource = otel_resource::Resource::Create(attributes);
       std::shared_ptr<otel_trace_api::TracerProvider> provider =
           otel_trace_sdk::TracerProviderFactory::Create(
@@ -414,6 +911,10 @@ TraceManager::CleanupTracer()
   switch (global_setting_->mode_) {
     case TRACE_MODE_OPENTELEMETRY: {
 #if !defined(_WIN32) && defined(TRITON_ENABLE_TRACING)
+      // Export the spans still queued in the span processor.
+      auto provider = otel_trace_api::Provider::GetTracerProvider();
+      static_cast<otel_trace_sdk::TracerProvider*>(provider.get())
+          ->ForceFlush();
       std::shared_ptr<otel_trace_api::TracerProvider> none;
       otel_trace_api::Provider::SetTracerProvider(none);
       break;
@@ -440,6 +941,28 @@ TraceManager::Trace::StartSpan(
   LOG_TRITONSERVER_ERROR(
       TRITONSERVER_InferenceTraceParentId(trace, &parent_id),
       "getting trace parent id");
+  const char* model_name = "";
+  int64_t model_version = 0;
+  if (activity == TRITONSERVER_TRACE_REQUEST_START) {
+    LOG_TRITONSERVER_ERROR(
+        TRITONSERVER_InferenceTraceModelName(trace, &model_name),
+        "getting model name");
+    LOG_TRITONSERVER_ERROR(
+        TRITONSERVER_InferenceTraceModelVersion(trace, &model_version),
+        "getting model version");
+  }
+
+  StartSpan(
+      span_key, activity, timestamp_ns, trace_id, parent_id, model_name,
+      model_version);
+}
+
+void
+TraceManager::Trace::StartSpan(
+    std::string span_key, TRITONSERVER_InferenceTraceActivity activity,
+    uint64_t timestamp_ns, uint64_t trace_id, uint64_t parent_id,
+    const char* model_name, int64_t model_version)
+{
   std::string parent_span_key = "";
 
   // Currently, only 2 types of sub-spans are supported:
@@ -465,21 +988,13 @@ TraceManager::Trace::StartSpan(
   }
 
   std::string display_name = "compute";
-  const char* model_name;
   if (activity == TRITONSERVER_TRACE_REQUEST_START) {
-    LOG_TRITONSERVER_ERROR(
-        TRITONSERVER_InferenceTraceModelName(trace, &model_name),
-        "getting model name");
     display_name = model_name;
   }
 
   auto span = StartSpan(display_name, timestamp_ns, parent_span_key);
 
   if (activity == TRITONSERVER_TRACE_REQUEST_START) {
-    int64_t model_version;
-    LOG_TRITONSERVER_ERROR(
-        TRITONSERVER_InferenceTraceModelVersion(trace, &model_version),
-        "getting model version");
     span->SetAttribute("triton.model_name", model_name);
     span->SetAttribute("triton.model_version", model_version);
     span->SetAttribute("triton.trace_id", trace_id);
@@ -626,6 +1141,58 @@ TraceManager::Trace::AddEvent(
     span->AddEvent(event, time_offset_ + std::chrono::nanoseconds{timestamp});
   }
 }
+
+void
+TraceManager::Trace::ReplayToOpenTelemetry()
+{
+  auto root_span = StartSpan("InferRequest", start_ns_);
+  otel_context_ = opentelemetry::context::Context({kRootSpan, root_span});
+
+  // The details of a request are held before its timestamps.
+  std::unordered_map<uint64_t, const TraceRecord*> requests;
+  for (const auto& record : tail_records_) {
+    if (record.kind_ == TraceRecord::REQUEST) {
+      requests[record.trace_id_] = &record;
+      continue;
+    }
+    if (record.kind_ != TraceRecord::TIMESTAMP) {
+      continue;
+    }
+    if (record.activity_ < 0) {
+      AddEvent(kRootSpan, record.name_, record.value_);
+      continue;
+    }
+
+    const auto activity =
+        static_cast<TRITONSERVER_InferenceTraceActivity>(record.activity_);
+    const auto span_key = GetSpanKeyForActivity(activity, record.trace_id_);
+    if (span_key.empty()) {
+      continue;
+    }
+    if (activity == TRITONSERVER_TRACE_REQUEST_START ||
+        activity == TRITONSERVER_TRACE_COMPUTE_START) {
+      uint64_t parent_id = 0;
+      const char* model_name = "";
+      int64_t model_version = 0;
+      auto it = requests.find(record.trace_id_);
+      if (it != requests.end()) {
+        parent_id = it->second->value_;
+        model_name =
+            reinterpret_cast<const std::string*>(it->second->payload_)
+                ->c_str();
+        model_version = it->second->model_version_;
+      }
+      StartSpan(
+          span_key, activity, record.value_, record.trace_id_, parent_id,
+          model_name, model_version);
+    }
+    AddEvent(span_key, record.name_, record.value_);
+    if (activity == TRITONSERVER_TRACE_REQUEST_END ||
+        activity == TRITONSERVER_TRACE_COMPUTE_END) {
+      EndSpan(span_key, record.value_);
+    }
+  }
+}
 #endif
 
 void
@@ -675,13 +1242,40 @@ TraceManager::TraceActivity(
   auto ts =
       reinterpret_cast<std::shared_ptr<TraceManager::Trace>*>(userp)->get();
 
-  std::lock_guard<std::mutex> lk(ts->mtx_);
+  // The timeline only holds the activities of the request itself, not
+  // those of the requests it spawns.
+  if ((ts->recorder_ != nullptr) && (id == ts->trace_id_)) {
+    if (activity == TRITONSERVER_TRACE_REQUEST_START) {
+      const char* model_name;
+      int64_t model_version;
+      LOG_TRITONSERVER_ERROR(
+          TRITONSERVER_InferenceTraceModelName(trace, &model_name),
+          "getting model name");
+      LOG_TRITONSERVER_ERROR(
+          TRITONSERVER_InferenceTraceModelVersion(trace, &model_version),
+          "getting model version");
+      ts->timeline_.SetRequest(id, model_name, model_version);
+    }
+    ts->timeline_.Add(
+        ts->recorder_->NameId(
+            TRITONSERVER_InferenceTraceActivityString(activity)),
+        timestamp_ns);
+  }
+
+  std::unique_lock<std::mutex> lk(ts->mtx_);
   if (ts->spawned_traces_tracker_.find(id) ==
       ts->spawned_traces_tracker_.end()) {
     ts->spawned_traces_tracker_.emplace(id);
   }
+  // A trace that only feeds the flight recorder emits nothing.
+  if (ts->setting_ == nullptr) {
+    return;
+  }
 
-  if (ts->setting_->mode_ == TRACE_MODE_OPENTELEMETRY) {
+  // If sampled on latency, the activities are held as records in both
+  // modes and only reported to OpenTelemetry if the trace is emitted.
+  if ((ts->setting_->mode_ == TRACE_MODE_OPENTELEMETRY) &&
+      (ts->tail_sampler_ == nullptr)) {
 #ifndef _WIN32
     ts->ReportToOpenTelemetry(trace, activity, timestamp_ns);
 #else
@@ -690,21 +1284,11 @@ TraceManager::TraceActivity(
 #endif
     return;
   }
-  std::stringstream* ss = nullptr;
-  {
-    if (ts->streams_.find(id) == ts->streams_.end()) {
-      std::unique_ptr<std::stringstream> stream(new std::stringstream());
-      ss = stream.get();
-      ts->streams_.emplace(id, std::move(stream));
-    } else {
-      ss = ts->streams_[id].get();
-      // If the string stream is not newly created, add "," as there is
-      // already content in the string stream
-      *ss << ",";
-    }
-  }
+  // The records are queued to the writer without holding the lock.
+  lk.unlock();
+
   // If 'activity' is TRITONSERVER_TRACE_REQUEST_START then collect
-  // and serialize trace details.
+  // trace details, they are serialized by the trace writer.
   if (activity == TRITONSERVER_TRACE_REQUEST_START) {
     const char* model_name;
     int64_t model_version;
@@ -724,22 +1308,25 @@ TraceManager::TraceActivity(
         TRITONSERVER_InferenceTraceRequestId(trace, &request_id),
         "getting request id");
 
-    *ss << "{\"id\":" << id << ",\"model_name\":\"" << model_name
-        << "\",\"model_version\":" << model_version;
-
-    if (std::string(request_id) != "") {
-      *ss << ",\"request_id\":\"" << request_id << "\"";
+    TraceRecord record(TraceRecord::REQUEST, ts->trace_id_, id);
+    record.value_ = parent_id;
+    record.model_version_ = model_version;
+    auto details = new std::string(model_name);
+    details->push_back('\0');
+    details->append(request_id);
+    record.payload_ = details;
+    if (!ts->QueueRecord(record)) {
+      delete details;
     }
-
-    if (parent_id != 0) {
-      *ss << ",\"parent_id\":" << parent_id;
-    }
-    *ss << "},";
   }
 
-  *ss << "{\"id\":" << id << ",\"timestamps\":["
-      << "{\"name\":\"" << TRITONSERVER_InferenceTraceActivityString(activity)
-      << "\",\"ns\":" << timestamp_ns << "}]}";
+  TraceRecord record(TraceRecord::TIMESTAMP, ts->trace_id_, id);
+  record.activity_ = activity;
+  record.value_ = timestamp_ns;
+  const char* activity_name =
+      TRITONSERVER_InferenceTraceActivityString(activity);
+  record.SetName(activity_name, strlen(activity_name));
+  ts->QueueRecord(record);
 }
 
 void
@@ -788,21 +1375,12 @@ TraceManager::TraceTensorActivity(
     LOG_ERROR << "Tensor level tracing is not supported by the mode: "
               << TraceManager::InferenceTraceModeString(ts->setting_->mode_);
   } else if (ts->setting_->mode_ == TRACE_MODE_TRITON) {
-    std::lock_guard<std::mutex> lk(ts->mtx_);
-    std::stringstream* ss = nullptr;
     {
-      if (ts->streams_.find(id) == ts->streams_.end()) {
-        std::unique_ptr<std::stringstream> stream(new std::stringstream());
-        ss = stream.get();
-        ts->streams_.emplace(id, std::move(stream));
-        ts->spawned_traces_tracker_.emplace(id);
-      } else {
-        ss = ts->streams_[id].get();
-        // If the string stream is not newly created, add "," as there is
-        // already content in the string stream
-        *ss << ",";
-      }
+      std::lock_guard<std::mutex> lk(ts->mtx_);
+      ts->spawned_traces_tracker_.emplace(id);
     }
+    std::stringstream tensor_stream;
+    std::stringstream* ss = &tensor_stream;
 
     // collect and serialize trace details.
     *ss << "{\"id\":" << id << ",\"activity\":\""
@@ -811,150 +1389,28 @@ TraceManager::TraceTensorActivity(
     *ss << ",\"tensor\":{";
     // collect tensor name
     *ss << "\"name\":\"" << std::string(name) << "\"";
-    // collect tensor data
-    *ss << ",\"data\":\"";
-    size_t element_count = 1;
-    for (uint64_t i = 0; i < dim_count; i++) {
-      element_count *= shape[i];
-    }
-    switch (datatype) {
-      case TRITONSERVER_TYPE_BOOL: {
-        const uint8_t* bool_base =
-            reinterpret_cast<const uint8_t*>(buffer_base);
-        for (size_t e = 0; e < element_count; ++e) {
-          *ss << ((bool_base[e] == 0) ? false : true);
-          if (e < (element_count - 1))
-            *ss << ",";
-        }
-        break;
-      }
-      case TRITONSERVER_TYPE_UINT8: {
-        const uint8_t* cbase = reinterpret_cast<const uint8_t*>(buffer_base);
-        for (size_t e = 0; e < element_count; ++e) {
-          *ss << cbase[e];
-          if (e < (element_count - 1))
-            *ss << ",";
-        }
-        break;
-      }
-      case TRITONSERVER_TYPE_UINT16: {
-        const uint16_t* cbase = reinterpret_cast<const uint16_t*>(buffer_base);
-        for (size_t e = 0; e < element_count; ++e) {
-          *ss << cbase[e];
-          if (e < (element_count - 1))
-            *ss << ",";
-        }
-        break;
-      }
-      case TRITONSERVER_TYPE_UINT32: {
-        const uint32_t* cbase = reinterpret_cast<const uint32_t*>(buffer_base);
-        for (size_t e = 0; e < element_count; ++e) {
-          *ss << cbase[e];
-          if (e < (element_count - 1))
-            *ss << ",";
-        }
-        break;
-      }
-      case TRITONSERVER_TYPE_UINT64: {
-        const uint64_t* cbase = reinterpret_cast<const uint64_t*>(buffer_base);
-        for (size_t e = 0; e < element_count; ++e) {
-          *ss << cbase[e];
-          if (e < (element_count - 1))
-            *ss << ",";
-        }
-        break;
-      }
-      case TRITONSERVER_TYPE_INT8: {
-        const int8_t* cbase = reinterpret_cast<const int8_t*>(buffer_base);
-        for (size_t e = 0; e < element_count; ++e) {
-          *ss << cbase[e];
-          if (e < (element_count - 1))
-            *ss << ",";
-        }
-        break;
-      }
-      case TRITONSERVER_TYPE_INT16: {
-        const int16_t* cbase = reinterpret_cast<const int16_t*>(buffer_base);
-        for (size_t e = 0; e < element_count; ++e) {
-          *ss << cbase[e];
-          if (e < (element_count - 1))
-            *ss << ",";
-        }
-        break;
-      }
-      case TRITONSERVER_TYPE_INT32: {
-        const int32_t* cbase = reinterpret_cast<const int32_t*>(buffer_base);
-        for (size_t e = 0; e < element_count; ++e) {
-          *ss << cbase[e];
-          if (e < (element_count - 1))
-            *ss << ",";
-        }
-        break;
-      }
-      case TRITONSERVER_TYPE_INT64: {
-        const int64_t* cbase = reinterpret_cast<const int64_t*>(buffer_base);
-        for (size_t e = 0; e < element_count; ++e) {
-          *ss << cbase[e];
-          if (e < (element_count - 1))
-            *ss << ",";
-        }
-        break;
-      }
-
-      // FP16 / BF16 already handled as binary blobs, no need to manipulate
-      // here
-      case TRITONSERVER_TYPE_FP16: {
-        break;
-      }
-      case TRITONSERVER_TYPE_BF16: {
-        break;
-      }
-
-      case TRITONSERVER_TYPE_FP32: {
-        const float* cbase = reinterpret_cast<const float*>(buffer_base);
-        for (size_t e = 0; e < element_count; ++e) {
-          *ss << cbase[e];
-          if (e < (element_count - 1))
-            *ss << ",";
-        }
-        break;
-      }
-      case TRITONSERVER_TYPE_FP64: {
-        const double* cbase = reinterpret_cast<const double*>(buffer_base);
-        for (size_t e = 0; e < element_count; ++e) {
-          *ss << cbase[e];
-          if (e < (element_count - 1))
-            *ss << ",";
-        }
-        break;
-      }
-      case TRITONSERVER_TYPE_BYTES: {
-        const char* cbase = reinterpret_cast<const char*>(buffer_base);
-        size_t offset = 0;
-        for (size_t e = 0; e < element_count; ++e) {
-          if ((offset + sizeof(uint32_t)) > byte_size) {
-            return;
-          }
-          const size_t len =
-              *(reinterpret_cast<const uint32_t*>(cbase + offset));
-          offset += sizeof(uint32_t);
-          if ((offset + len) > byte_size) {
-            return;
-          }
-          std::string str(cbase + offset, len);
-          *ss << "\\\"" << str << "\\\"";
-          offset += len;
-
-          if (e < (element_count - 1))
-            *ss << ",";
-        }
-        break;
+    // collect tensor data, in binary tensor format the data is written to
+    // the tensor file and only referred to.
+    const auto& file = ts->setting_->file_;
+    bool serialized = true;
+    if (file->TensorFormat() == TRACE_FORMAT_BINARY) {
+      uint64_t offset;
+      if (file->Tensors()->Write(buffer_base, byte_size, &offset)) {
+        *ss << ",\"offset\":" << offset << ",\"length\":" << byte_size;
+      } else {
+        *ss << ",\"dropped\":true";
       }
-      case TRITONSERVER_TYPE_INVALID: {
-        return;
+    } else {
+      size_t element_count = 1;
+      for (uint64_t i = 0; i < dim_count; i++) {
+        element_count *= shape[i];
       }
+      *ss << ",\"data\":\"";
+      serialized = WriteTensorData(
+          datatype, buffer_base, byte_size, element_count, *ss);
+      *ss << "\"";
     }
-    *ss << "\",\"shape\":\"";
+    *ss << ",\"shape\":\"";
     for (uint64_t i = 0; i < dim_count; i++) {
       *ss << shape[i];
       if (i < (dim_count - 1)) {
@@ -963,6 +1419,15 @@ TraceManager::TraceTensorActivity(
     }
     *ss << "\",\"dtype\":\"" << TRITONSERVER_DataTypeString(datatype) << "\"}";
     *ss << "}";
+
+    if (serialized) {
+      TraceRecord record(TraceRecord::TENSOR, ts->trace_id_, id);
+      auto tensor = new std::string(tensor_stream.str());
+      record.payload_ = tensor;
+      if (!ts->QueueRecord(record)) {
+        delete tensor;
+      }
+    }
   }
 
   if (memory_type == TRITONSERVER_MEMORY_GPU) {
@@ -974,13 +1439,46 @@ TraceManager::TraceTensorActivity(
   }
 }
 
+void
+TraceManager::WriteRecords(std::vector<TraceRecord>& records)
+{
+  for (auto& record : records) {
+    if (record.kind_ != TraceRecord::END) {
+      pending_traces_[record.group_id_].push_back(record);
+      continue;
+    }
+
+    auto setting =
+        reinterpret_cast<std::shared_ptr<TraceSetting>*>(record.payload_);
+    auto it = pending_traces_.find(record.group_id_);
+    if (it == pending_traces_.end()) {
+      (*setting)->WriteTrace(record.group_id_, {});
+    } else {
+      (*setting)->WriteTrace(record.group_id_, it->second);
+      ReleaseRecords(it->second);
+      pending_traces_.erase(it);
+    }
+    delete setting;
+  }
+}
+
 TraceManager::TraceFile::~TraceFile()
 {
-  if (!first_write_) {
+  if (!first_write_ && (format_ == TRACE_FORMAT_JSON)) {
     trace_file_ << "]";
   }
 }
 
+TensorWriter*
+TraceManager::TraceFile::Tensors()
+{
+  std::lock_guard<std::mutex> lk(tensors_mu_);
+  if (tensors_ == nullptr) {
+    tensors_.reset(new TensorWriter(file_name_ + ".tensors", tensor_options_));
+  }
+  return tensors_.get();
+}
+
 void
 TraceManager::TraceFile::SaveTraces(
     std::stringstream& trace_stream, const bool to_index_file)
@@ -990,13 +1488,27 @@ TraceManager::TraceFile::SaveTraces(
       std::string file_name =
           file_name_ + "." + std::to_string(index_.fetch_add(1));
       std::ofstream file_stream;
-      file_stream.open(file_name);
-      file_stream << "[";
-      file_stream << trace_stream.rdbuf();
-      file_stream << "]";
+      if (format_ == TRACE_FORMAT_BINARY) {
+        file_stream.open(file_name, std::ios::binary);
+        file_stream.write(kBinaryTraceMagic, kBinaryTraceMagicSize);
+        file_stream << trace_stream.rdbuf();
+      } else {
+        file_stream.open(file_name);
+        file_stream << "[";
+        file_stream << trace_stream.rdbuf();
+        file_stream << "]";
+      }
     } else {
       std::lock_guard<std::mutex> lock(mu_);
-      if (first_write_) {
+      if (format_ == TRACE_FORMAT_BINARY) {
+        // Blocks are self-contained, the traces of different settings
+        // are simply appended as blocks.
+        if (first_write_) {
+          trace_file_.open(file_name_, std::ios::binary);
+          trace_file_.write(kBinaryTraceMagic, kBinaryTraceMagicSize);
+          first_write_ = false;
+        }
+      } else if (first_write_) {
         trace_file_.open(file_name_);
         trace_file_ << "[";
         first_write_ = false;
@@ -1014,42 +1526,48 @@ TraceManager::TraceFile::SaveTraces(
   }
 }
 
+bool
+TraceManager::TraceSetting::ClaimTrace()
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  const int32_t count = count_.load(std::memory_order_relaxed);
+  if (count == 0) {
+    return false;
+  }
+  if (count > 0) {
+    count_.store(count - 1, std::memory_order_relaxed);
+    ++created_;
+  }
+  return true;
+}
+
 std::shared_ptr<TraceManager::Trace>
-TraceManager::TraceSetting::SampleTrace()
+TraceManager::TraceSetting::SampleTrace(
+    const std::shared_ptr<TailSampler>& tail_sampler)
 {
-  bool create_trace = false;
-  {
-    std::lock_guard<std::mutex> lk(mu_);
-    if (!Valid()) {
-      return nullptr;
-    }
-    create_trace = (((++sample_) % rate_) == 0);
-    if (create_trace && (count_ > 0)) {
-      --count_;
-      ++created_;
-    }
+  if (!Valid()) {
+    return nullptr;
+  }
+  bool create_trace =
+      (((sample_.fetch_add(1, std::memory_order_relaxed) + 1) % rate_) == 0);
+  // With tail sampling the count applies to the emitted traces. The count
+  // may have been exhausted by another request since Valid() was checked.
+  if (create_trace && (tail_sampler == nullptr)) {
+    create_trace = ClaimTrace();
   }
   if (create_trace) {
-    std::shared_ptr<TraceManager::Trace> lts(new Trace());
-    // Split 'Trace' management to frontend and Triton trace separately
-    // to avoid dependency between frontend request and Triton trace's
-    // liveness
-    auto trace_userp = new std::shared_ptr<TraceManager::Trace>(lts);
-    TRITONSERVER_InferenceTrace* trace;
-    TRITONSERVER_Error* err = TRITONSERVER_InferenceTraceTensorNew(
-        &trace, level_, 0 /* parent_id */, TraceActivity, TraceTensorActivity,
-        TraceRelease, trace_userp);
-    if (err != nullptr) {
-      LOG_TRITONSERVER_ERROR(err, "creating inference trace object");
-      delete trace_userp;
+    std::shared_ptr<TraceManager::Trace> lts = NewTrace(level_);
+    if (lts == nullptr) {
       return nullptr;
     }
-    lts->trace_ = trace;
-    lts->trace_userp_ = trace_userp;
-    LOG_TRITONSERVER_ERROR(
-        TRITONSERVER_InferenceTraceId(trace, &lts->trace_id_),
-        "getting trace id");
-    if (mode_ == TRACE_MODE_OPENTELEMETRY) {
+    if (tail_sampler != nullptr) {
+      lts->tail_sampler_ = tail_sampler;
+      lts->tail_records_.reserve(kTailRecordsReserve);
+      lts->start_ns_ = TraceManager::CaptureTimestamp();
+    }
+    // With tail sampling the spans are only created if the trace is
+    // emitted.
+    if ((mode_ == TRACE_MODE_OPENTELEMETRY) && (tail_sampler == nullptr)) {
 #ifndef _WIN32
       auto steady_timestamp_ns =
           std::chrono::duration_cast<std::chrono::nanoseconds>(
@@ -1072,36 +1590,41 @@ TraceManager::TraceSetting::SampleTrace()
 
 void
 TraceManager::TraceSetting::WriteTrace(
-    const std::unordered_map<uint64_t, std::unique_ptr<std::stringstream>>&
-        streams)
+    const uint64_t group_id, const std::vector<TraceRecord>& records)
 {
+  std::stringstream trace;
+  if (encoder_ == nullptr) {
+    WriteJsonTrace(records, trace);
+  }
+
   std::unique_lock<std::mutex> lock(mu_);
 
-  if (sample_in_stream_ != 0) {
-    trace_stream_ << ",";
+  if (encoder_ != nullptr) {
+    encoder_->AppendTrace(group_id, records);
+  } else {
+    if (sample_in_stream_ != 0) {
+      trace_stream_ << ",";
+    }
+    trace_stream_ << trace.rdbuf();
   }
   ++sample_in_stream_;
   ++collected_;
 
-  size_t stream_count = 0;
-  for (const auto& stream : streams) {
-    trace_stream_ << stream.second->rdbuf();
-    // Need to add ',' unless it is the last trace in the group
-    ++stream_count;
-    if (stream_count != streams.size()) {
-      trace_stream_ << ",";
-    }
-  }
   // Write to file with index when one of the following is true
   // 1. trace_count is specified and that number of traces has been collected
   // 2. log_frequency is specified and that number of traces has been
   // collected
-  if (((count_ == 0) && (collected_ == sample_)) ||
+  if (((count_.load(std::memory_order_relaxed) == 0) &&
+       (collected_ == created_)) ||
       ((log_frequency_ != 0) && (sample_in_stream_ >= log_frequency_))) {
     // Reset variables and release lock before saving to file
     sample_in_stream_ = 0;
     std::stringstream stream;
-    trace_stream_.swap(stream);
+    if (encoder_ != nullptr) {
+      stream << encoder_->TakeBlock();
+    } else {
+      trace_stream_.swap(stream);
+    }
     lock.unlock();
 
     file_->SaveTraces(stream, true /* to_index_file */);
@@ -1115,9 +1638,10 @@ TraceManager::TraceSetting::TraceSetting(
     const TraceConfigMap& config_map, const bool level_specified,
     const bool rate_specified, const bool count_specified,
     const bool log_frequency_specified, const bool filepath_specified,
-    const bool mode_specified, const bool config_map_specified)
+    const bool mode_specified, const bool config_map_specified,
+    const std::shared_ptr<TraceWriter>& writer)
     : level_(level), rate_(rate), count_(count), log_frequency_(log_frequency),
-      file_(file), mode_(mode), config_map_(config_map),
+      file_(file), mode_(mode), config_map_(config_map), writer_(writer),
       level_specified_(level_specified), rate_specified_(rate_specified),
       count_specified_(count_specified),
       log_frequency_specified_(log_frequency_specified),
@@ -1132,13 +1656,24 @@ TraceManager::TraceSetting::TraceSetting(
   } else if (mode_ == TRACE_MODE_TRITON && file_->FileName().empty()) {
     invalid_reason_ = "trace file name is not given";
   }
+
+  if ((mode_ == TRACE_MODE_TRITON) &&
+      (file_->Format() == TRACE_FORMAT_BINARY)) {
+    encoder_.reset(new BinaryTraceEncoder(file_->Compress()));
+  }
 }
 
 TraceManager::TraceSetting::~TraceSetting()
 {
   // If log frequency is set, should log the remaining traces to indexed file.
   if (mode_ == TRACE_MODE_TRITON && sample_in_stream_ != 0) {
-    file_->SaveTraces(trace_stream_, (log_frequency_ != 0));
+    if (encoder_ != nullptr) {
+      std::stringstream stream;
+      stream << encoder_->TakeBlock();
+      file_->SaveTraces(stream, (log_frequency_ != 0));
+    } else {
+      file_->SaveTraces(trace_stream_, (log_frequency_ != 0));
+    }
   }
 }
 }}  // namespace triton::server
@@ -34,12 +34,12 @@
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #if !defined(_WIN32) && defined(TRITON_ENABLE_TRACING)
 #include "opentelemetry/nostd/shared_ptr.h"
 #include "opentelemetry/sdk/resource/resource.h"
 #include "opentelemetry/sdk/trace/processor.h"
-#include "opentelemetry/sdk/trace/simple_processor_factory.h"
 #include "opentelemetry/sdk/trace/tracer_provider_factory.h"
 #include "opentelemetry/trace/context.h"
 #include "opentelemetry/trace/provider.h"
@@ -47,6 +47,13 @@ namespace otel_trace_sdk = opentelemetry::sdk::trace;
 namespace otel_trace_api = opentelemetry::trace;
 #endif
 
+#include "binary_trace.h"
+#include "epoch_snapshot.h"
+#include "flight_recorder.h"
+#include "frontend_stage.h"
+#include "tail_sampler.h"
+#include "tensor_writer.h"
+#include "trace_writer.h"
 #include "triton/core/tritonserver.h"
 
 namespace triton { namespace server {
@@ -63,6 +70,18 @@ constexpr char kComputeSpan[] = "compute_span";
 // OTel tracer name
 constexpr char kTritonTracer[] = "triton-server";
 
+// Default number of records the Triton trace writer can queue.
+constexpr size_t kDefaultTraceQueueSize = 65536;
+
+// Default number of request timelines the flight recorder keeps per
+// thread. The recorder is opt-in since it needs a trace of every
+// request, sampled or not.
+constexpr size_t kDefaultRecorderSize = 0;
+
+// Number of records reserved for a trace sampled on latency, enough for
+// the timestamps of a request to a model that isn't an ensemble.
+constexpr size_t kTailRecordsReserve = 16;
+
 /// Trace modes.
 typedef enum tracemode_enum {
   /// Default is Triton tracing API
@@ -71,6 +90,14 @@ typedef enum tracemode_enum {
   TRACE_MODE_OPENTELEMETRY = 1
 } InferenceTraceMode;
 
+/// Trace file formats of the Triton trace mode.
+typedef enum traceformat_enum {
+  /// JSON array of trace objects
+  TRACE_FORMAT_JSON = 0,
+  /// Binary format encoded by BinaryTraceEncoder
+  TRACE_FORMAT_BINARY = 1
+} InferenceTraceFormat;
+
 //
 // Manager for tracing to a file.
 //
@@ -122,12 +149,24 @@ class TraceManager {
       const std::string& filepath, const InferenceTraceMode mode,
       const TraceConfigMap& config_map);
 
-  ~TraceManager() { CleanupTracer(); }
+  ~TraceManager();
 
   // Return a trace that should be used to collected trace activities
   // for an inference request. Return nullptr if no tracing should occur.
+  // If the flight recorder is enabled a trace is returned for every
+  // request, the trace only feeds the recorder if the request is not
+  // sampled.
   std::shared_ptr<Trace> SampleTrace(const std::string& model_name);
 
+  // Whether the frontends report the per-stage breakdown of a request
+  // to the client, in a 'Server-Timing' header for HTTP and in the
+  // trailing metadata for GRPC.
+  bool ServerTiming() const { return server_timing_; }
+
+  // Write the request timelines kept by the flight recorder as a JSON
+  // array. Return UNAVAILABLE if the flight recorder is disabled.
+  TRITONSERVER_Error* DumpRecorder(std::ostream& out);
+
   // Update global setting if 'model_name' is empty, otherwise, model setting is
   // updated.
   TRITONSERVER_Error* UpdateTraceSetting(
@@ -164,12 +203,12 @@ class TraceManager {
   void CleanupTracer();
 
   struct Trace {
-    Trace() : trace_(nullptr), trace_id_(0) {}
+    Trace() : trace_(nullptr), trace_id_(0), start_ns_(0), failed_(false) {}
     ~Trace();
+    // The setting the trace is sampled with, nullptr if the trace only
+    // feeds the flight recorder.
     std::shared_ptr<TraceSetting> setting_;
-    // Group the spawned traces by trace ID for better formatting
     std::mutex mtx_;
-    std::unordered_map<uint64_t, std::unique_ptr<std::stringstream>> streams_;
     // We use the set to track the number of spawned traces, so that
     // when TraceManager::TraceRelease() with 'trace_userp_' is called
     // we can safely release 'trace_userp_'
@@ -184,9 +223,42 @@ class TraceManager {
 
     uint64_t trace_id_;
 
+    // Set if the traces are sampled on latency, the records of the trace
+    // are then held in 'tail_records_' until the trace completes and
+    // only emitted if 'tail_sampler_' selects the trace.
+    std::shared_ptr<TailSampler> tail_sampler_;
+    std::vector<TraceRecord> tail_records_;
+    // Steady timestamp of when the trace is sampled, only used if the
+    // trace is sampled on latency.
+    uint64_t start_ns_;
+    std::atomic<bool> failed_;
+
+    // The flight recorder that the timeline of the request is recorded
+    // to when the trace completes, nullptr if disabled.
+    std::shared_ptr<FlightRecorder> recorder_;
+    FlightRecorder::Timeline timeline_;
+
     // Capture a timestamp generated outside of triton and associate it
     // with this trace.
     void CaptureTimestamp(const std::string& name, uint64_t timestamp_ns);
+    void CaptureTimestamp(const FrontendStage stage, uint64_t timestamp_ns);
+
+    // Capture the timestamp 'name' of 'name_len' characters.
+    void CaptureTimestamp(
+        const char* name, const size_t name_len, uint64_t timestamp_ns);
+
+    // Mark the request of the trace as failed, failed requests are always
+    // emitted if the traces are sampled on latency.
+    void MarkFailed() { failed_ = true; }
+
+    // Queue 'record' to the writer, or hold it if the trace is sampled
+    // on latency. Return false if the record is dropped, in which case
+    // the caller keeps the ownership of the payload of the record.
+    bool QueueRecord(const TraceRecord& record);
+
+    // Return whether the records held for tail sampling should be
+    // emitted, counting the emitted trace against the trace count.
+    bool SampleTail();
 
 #if !defined(_WIN32) && defined(TRITON_ENABLE_TRACING)
     /// Reports TRITONSERVER_InferenceTraceActivity as event to
@@ -285,6 +357,26 @@ class TraceManager {
     std::string GetSpanKeyForActivity(
         TRITONSERVER_InferenceTraceActivity activity, uint64_t trace_id);
 
+    /// Starts a compute or request span based on `activity` with the
+    /// details of the request provided by the caller.
+    ///
+    /// \param span_key Span's key to retrieve the corresponding span from the
+    /// OpenTelemetry context.
+    /// \param activity Trace activity.
+    /// \param timestamp_ns Steady timestamp of the start of the span.
+    /// \param trace_id Trace id.
+    /// \param parent_id Trace parent id.
+    /// \param model_name Model name, only used for request spans.
+    /// \param model_version Model version, only used for request spans.
+    void StartSpan(
+        std::string span_key, TRITONSERVER_InferenceTraceActivity activity,
+        uint64_t timestamp_ns, uint64_t trace_id, uint64_t parent_id,
+        const char* model_name, int64_t model_version);
+
+    /// Reports the records held for tail sampling as the spans and events
+    /// that would have been reported as the activities happened.
+    void ReplayToOpenTelemetry();
+
     /// Adds event to the span, which is retrieved from OpenTelemetry context
     /// with the provided `span_key`. If activity is
     /// TRITONSERVER_TRACE_REQUEST_START, or TRITONSERVER_TRACE_COMPUTE_START,
@@ -321,6 +413,10 @@ class TraceManager {
       const std::string& filepath, const InferenceTraceMode mode,
       const TraceConfigMap& config_map);
 
+  // Create a trace and the Triton trace object it is associated with.
+  static std::shared_ptr<Trace> NewTrace(
+      const TRITONSERVER_InferenceTraceLevel level);
+
   static void TraceActivity(
       TRITONSERVER_InferenceTrace* trace,
       TRITONSERVER_InferenceTraceActivity activity, uint64_t timestamp_ns,
@@ -338,10 +434,20 @@ class TraceManager {
   TRITONSERVER_Error* UpdateTraceSettingInternal(
       const std::string& model_name, const NewSetting& new_setting);
 
+  // Handle the trace records on the thread of 'writer_'. The records are
+  // grouped by trace in 'pending_traces_' until the END record of the
+  // trace, which hands the group to the trace setting.
+  void WriteRecords(std::vector<TraceRecord>& records);
+
   class TraceFile {
    public:
-    TraceFile(const std::string& file_name)
-        : file_name_(file_name), index_(0), first_write_(true)
+    TraceFile(
+        const std::string& file_name, const InferenceTraceFormat format,
+        const bool compress, const InferenceTraceFormat tensor_format,
+        const TensorWriter::Options& tensor_options)
+        : file_name_(file_name), format_(format), compress_(compress),
+          tensor_format_(tensor_format), tensor_options_(tensor_options),
+          index_(0), first_write_(true)
     {
     }
     ~TraceFile();
@@ -350,13 +456,30 @@ class TraceManager {
     // specifies whether the file name should be indexed, if true, the traces
     // will be written to 'file_name.index' where index will be incremented
     // every time the traces are written to a file with index. If false, the
-    // trace will be written to 'file_name'.
+    // trace will be written to 'file_name'. In binary format
+    // 'trace_stream' holds a block of BinaryTraceEncoder.
     void SaveTraces(std::stringstream& trace_stream, const bool to_index_file);
 
     const std::string& FileName() { return file_name_; }
+    InferenceTraceFormat Format() const { return format_; }
+    // Whether the blocks of a binary trace file are compressed.
+    bool Compress() const { return compress_; }
+    // The format of the traced tensors. In binary format the tensors are
+    // written to the file of Tensors() and the trace only refers to them.
+    InferenceTraceFormat TensorFormat() const { return tensor_format_; }
+
+    // Return the writer of the tensors traced to the file, creating it
+    // on first use. The tensors are written to 'file_name.tensors'.
+    TensorWriter* Tensors();
 
    private:
     const std::string file_name_;
+    const InferenceTraceFormat format_;
+    const bool compress_;
+    const InferenceTraceFormat tensor_format_;
+    const TensorWriter::Options tensor_options_;
+    std::mutex tensors_mu_;
+    std::unique_ptr<TensorWriter> tensors_;
     // The file index for the next index file write.
     std::atomic<uint32_t> index_;
 
@@ -386,26 +509,45 @@ class TraceManager {
         const TraceConfigMap& config_map, const bool level_specified,
         const bool rate_specified, const bool count_specified,
         const bool log_frequency_specified, const bool filepath_specified,
-        const bool mode_specified, const bool config_map_specified);
+        const bool mode_specified, const bool config_map_specified,
+        const std::shared_ptr<TraceWriter>& writer);
 
     ~TraceSetting();
 
-    bool Valid() { return invalid_reason_.empty() && (count_ != 0); }
+    bool Valid() const
+    {
+      return invalid_reason_.empty() &&
+             (count_.load(std::memory_order_relaxed) != 0);
+    }
     const std::string& Reason() { return invalid_reason_; }
 
+    // Write the records of the trace group 'group_id'.
     void WriteTrace(
-        const std::unordered_map<uint64_t, std::unique_ptr<std::stringstream>>&
-            streams);
+        const uint64_t group_id, const std::vector<TraceRecord>& records);
 
-    std::shared_ptr<Trace> SampleTrace();
+    // Return a new trace if the request should be traced. If
+    // 'tail_sampler' is given, the trace is only emitted if selected by
+    // the sampler when it completes and the trace count is applied then.
+    // Only the requests that are sampled take 'mu_'.
+    std::shared_ptr<Trace> SampleTrace(
+        const std::shared_ptr<TailSampler>& tail_sampler);
+
+    // Count a trace against 'count_', return false if the trace count
+    // is exhausted.
+    bool ClaimTrace();
 
     const TRITONSERVER_InferenceTraceLevel level_;
     const uint32_t rate_;
-    int32_t count_;
+    // Only modified with 'mu_' held, read without it to tell whether the
+    // setting is still valid.
+    std::atomic<int32_t> count_;
     const uint32_t log_frequency_;
     const std::shared_ptr<TraceFile> file_;
     const InferenceTraceMode mode_;
     const TraceConfigMap config_map_;
+    // The writer that the traces of the setting are queued to, nullptr
+    // if not in Triton trace mode.
+    const std::shared_ptr<TraceWriter> writer_;
 
     // Whether the field value is specified or mirror from upper level setting
     const bool level_specified_;
@@ -422,7 +564,7 @@ class TraceManager {
     std::mutex mu_;
 
     // use to sample a trace based on sampling rate.
-    uint64_t sample_;
+    std::atomic<uint64_t> sample_;
 
     // use to track the status of trace count feature
     uint64_t created_;
@@ -431,9 +573,32 @@ class TraceManager {
     // Tracking traces that haven't been saved to file
     uint32_t sample_in_stream_;
     std::stringstream trace_stream_;
+    // Holds the traces instead of 'trace_stream_' in binary format.
+    std::unique_ptr<BinaryTraceEncoder> encoder_;
+  };
+
+  // The trace settings used for sampling. The snapshot is never modified,
+  // an update publishes a new snapshot so that the requests look up their
+  // setting without locking.
+  struct TraceSettings {
+    // Return the setting of 'model_name'.
+    const std::shared_ptr<TraceSetting>& Find(
+        const std::string& model_name) const
+    {
+      const auto it = models_.find(model_name);
+      return (it == models_.end()) ? global_ : it->second;
+    }
+
+    std::shared_ptr<TraceSetting> global_;
+    std::unordered_map<std::string, std::shared_ptr<TraceSetting>> models_;
   };
 
-  // Trace settings
+  // Publish 'global_setting_' and 'model_settings_' as the snapshot of
+  // the settings, must be called with 'w_mu_' held.
+  void PublishSettings();
+
+  // Trace settings, only accessed with 'w_mu_' held once the manager is
+  // created.
   // Note that 'global_default_' doesn't use for actual trace sampling,
   // it is used to revert the field values when clearing fields in
   // 'global_setting_'
@@ -441,6 +606,8 @@ class TraceManager {
   std::shared_ptr<TraceSetting> global_setting_;
   std::unordered_map<std::string, std::shared_ptr<TraceSetting>>
       model_settings_;
+  // Read by the requests, only published with 'w_mu_' held.
+  EpochSnapshot<TraceSettings> settings_;
   // The collection of models that have their own trace setting while
   // some of the fields are mirroring global setting.
   std::set<std::string> fallback_used_models_;
@@ -449,10 +616,32 @@ class TraceManager {
   // avoid creating duplicate TraceFile objects for the same file path.
   std::unordered_map<std::string, std::weak_ptr<TraceFile>> trace_files_;
 
-  // lock for accessing trace setting. 'w_mu_' for write and
-  // 'r_mu_' for read / write
+  // lock for updating trace setting.
   std::mutex w_mu_;
-  std::mutex r_mu_;
+
+  // The trace file format of the Triton trace mode.
+  InferenceTraceFormat format_;
+  bool compress_;
+  // The format of the traced tensors and the options of their writer.
+  InferenceTraceFormat tensor_format_;
+  TensorWriter::Options tensor_options_;
+
+  // Selects the traces to emit if the traces are sampled on latency,
+  // nullptr otherwise.
+  std::shared_ptr<TailSampler> tail_sampler_;
+
+  // Keeps the timelines of the recent requests, nullptr if disabled.
+  std::shared_ptr<FlightRecorder> recorder_;
+
+  // Whether the per-stage breakdown of a request is reported to the
+  // client.
+  bool server_timing_;
+
+  // Writer formatting and saving the traces in Triton trace mode.
+  std::shared_ptr<TraceWriter> writer_;
+  // The records of the traces being written, grouped by trace group id.
+  // Only accessed by the thread of 'writer_'.
+  std::unordered_map<uint64_t, std::vector<TraceRecord>> pending_traces_;
 };
 
 }}  // namespace triton::server
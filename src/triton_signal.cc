@@ -31,7 +31,14 @@
 #ifdef _WIN32
 #include <windows.h>
 #else
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
 #include <csignal>
+#include <cstring>
+#include <string>
+#include <thread>
 #endif
 
 #define BOOST_STACKTRACE_USE_ADDR2LINE
@@ -100,6 +107,12 @@ RegisterSignalHandler()
   return nullptr;  // success
 }
 
+TRITONSERVER_Error*
+RegisterDumpSignalHandler(std::function<void()> handler)
+{
+  return nullptr;  // success
+}
+
 #else
 
 namespace {
@@ -124,6 +137,44 @@ ErrorSignalHandler(int signum)
   raise(signum);
 }
 
+// The function registered for SIGUSR2 and the pipe that the signal
+// handler writes to, a dedicated thread reads the pipe and calls the
+// function outside of the signal handler.
+std::mutex dump_mu_;
+std::function<void()> dump_handler_;
+int dump_pipe_[2] = {-1, -1};
+
+void
+DumpSignalHandler(int signum)
+{
+  const int saved_errno = errno;
+  const char byte = 0;
+  // The pipe doesn't block, signals arriving while the pipe is full are
+  // coalesced into the pending ones.
+  const ssize_t written = write(dump_pipe_[1], &byte, 1);
+  (void)written;
+  errno = saved_errno;
+}
+
+void
+DumpThread()
+{
+  char byte;
+  while (true) {
+    const ssize_t n = read(dump_pipe_[0], &byte, 1);
+    if ((n < 0) && (errno == EINTR)) {
+      continue;
+    }
+    if (n <= 0) {
+      break;
+    }
+    std::lock_guard<std::mutex> lk(dump_mu_);
+    if (dump_handler_) {
+      dump_handler_();
+    }
+  }
+}
+
 }  // namespace
 
 TRITONSERVER_Error*
@@ -140,6 +191,27 @@ RegisterSignalHandler()
   return nullptr;  // success
 }
 
+TRITONSERVER_Error*
+RegisterDumpSignalHandler(std::function<void()> handler)
+{
+  std::lock_guard<std::mutex> lk(dump_mu_);
+  if (dump_pipe_[0] == -1) {
+    if ((pipe(dump_pipe_) != 0) ||
+        (fcntl(dump_pipe_[1], F_SETFL, O_NONBLOCK) != 0)) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INTERNAL,
+          (std::string("failed to create pipe for SIGUSR2: ") +
+           strerror(errno))
+              .c_str());
+    }
+    std::thread(DumpThread).detach();
+    signal(SIGUSR2, DumpSignalHandler);
+  }
+  dump_handler_ = std::move(handler);
+
+  return nullptr;  // success
+}
+
 #endif
 
 }}  // namespace triton::server
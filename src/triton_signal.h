@@ -26,6 +26,7 @@
 #pragma once
 
 #include <condition_variable>
+#include <functional>
 #include <mutex>
 
 #include "triton/core/tritonserver.h"
@@ -41,4 +42,11 @@ extern std::condition_variable signal_exit_cv_;
 // Register signal handler. Return true if success, false if failure.
 TRITONSERVER_Error* RegisterSignalHandler();
 
+// Register the function to call when SIGUSR2 is received, replacing the
+// previously registered function. The function is called on a dedicated
+// thread, not in the signal handler, so it is not restricted to
+// async-signal-safe operations. Passing nullptr ignores the signal. The
+// signal is not supported on Windows and the call is a no-op.
+TRITONSERVER_Error* RegisterDumpSignalHandler(std::function<void()> handler);
+
 }}  // namespace triton::server